@@ -0,0 +1,38 @@
+/**
+ * @file AllocationCounter.h
+ * @brief Подсчёт выделений памяти через глобальный operator new в процессе замеров.
+ */
+#ifndef SLEEP_VISUALIZER_ALLOCATIONCOUNTER_H
+#define SLEEP_VISUALIZER_ALLOCATIONCOUNTER_H
+
+#include <cstddef>
+
+/**
+ * @class AllocationCounter
+ * @brief Количество вызовов operator new во всех потоках с момента запуска.
+ *
+ * sleep_bench заменяет глобальные operator new и operator delete, поэтому учитываются все выделения
+ * через стандартную библиотеку. ImGui и ImPlot выделяют память своим распределителем через malloc
+ * и в счёт не попадают: подсчёт показывает выделения кода приложения.
+ */
+class AllocationCounter {
+public:
+    AllocationCounter() = delete;
+
+    static std::size_t count();
+};
+
+/**
+ * @brief Считает выделения памяти в пределах области видимости.
+ */
+class AllocationScope {
+public:
+    AllocationScope() : start_(AllocationCounter::count()) {}
+
+    [[nodiscard]] std::size_t allocations() const { return AllocationCounter::count() - start_; }
+
+private:
+    std::size_t start_;
+};
+
+#endif //SLEEP_VISUALIZER_ALLOCATIONCOUNTER_H
@@ -0,0 +1,161 @@
+#include "AllocationCounter.h"
+#include "Benchmark.h"
+#include "DataLoader.h"
+#include "PlotData.h"
+#include "RecommendationRules.h"
+#include "SleepAnalyzer.h"
+#include "SleepPhaseStore.h"
+#include "SleepRecommender.h"
+#include "SyntheticHistory.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <memory_resource>
+
+namespace {
+
+std::string writeHistoryFile(const std::filesystem::path &path, const SyntheticHistoryOptions &options) {
+    std::ofstream ofs(path, std::ios::binary);
+    SyntheticHistory::writeJson(ofs, options);
+    return path.string();
+}
+
+} // namespace
+
+void runAnalysisBenchmarks() {
+    const auto directory = std::filesystem::temp_directory_path() / "sleep_bench_analysis";
+    std::filesystem::create_directories(directory);
+
+    SyntheticHistoryOptions weekOptions;
+    weekOptions.seed = 21;
+    weekOptions.nights = 7;
+    const std::string weekFile = writeHistoryFile(directory / "week.json", weekOptions);
+
+    SyntheticHistoryOptions historyOptions;
+    historyOptions.seed = 22;
+    historyOptions.nights = 20'000;
+    const std::string historyFile = writeHistoryFile(directory / "history.json", historyOptions);
+    const auto historyBytes = std::filesystem::file_size(historyFile);
+
+    constexpr std::size_t weekLoads = 2'000;
+    runBenchmark("DataLoader::loadFromJsonFile", weekLoads * 7, [&] {
+        for (std::size_t i = 0; i < weekLoads; ++i) {
+            doNotOptimize(DataLoader::loadFromJsonFile(weekFile).sleepDays[6].phases.size());
+        }
+    });
+
+    // фазы в арене загрузки против отдельного буфера в куче на каждую ночь; освобождение истории входит в замер
+    const auto arenaLoad = [&] {
+        return DataLoader::loadHistoryFromJsonFile(historyFile).nights.size();
+    };
+    const auto heapLoad = [&] {
+        return DataLoader::loadHistoryFromJsonFile(historyFile, std::pmr::new_delete_resource()).size();
+    };
+    const BenchmarkResult historyLoad = runBenchmark("DataLoader::loadHistoryFromJsonFile", historyOptions.nights, [&] {
+        doNotOptimize(arenaLoad());
+    });
+    std::printf("  %.1f MB/s\n", static_cast<double>(historyBytes) / (1024.0 * 1024.0) / historyLoad.seconds);
+    const BenchmarkResult heapHistoryLoad = runBenchmark("DataLoader::loadHistoryFromJsonFile, heap",
+                                                         historyOptions.nights, [&] {
+        doNotOptimize(heapLoad());
+    });
+    const auto loadAllocations = [](const auto &load) {
+        const AllocationScope allocations;
+        doNotOptimize(load());
+        return allocations.allocations();
+    };
+    std::printf("  allocations per load: arena %zu, heap %zu; arena time %.2fx of heap\n",
+                loadAllocations(arenaLoad), loadAllocations(heapLoad), historyLoad.seconds / heapHistoryLoad.seconds);
+
+    const std::vector<DailySleepData> history = SyntheticHistory::generate(historyOptions);
+    std::vector<SleepMetrics> metrics(history.size());
+    runBenchmark("SleepAnalyzer::CalculateDailyMetrics", history.size(), [&] {
+        std::transform(history.begin(), history.end(), metrics.begin(), [](const DailySleepData &day) {
+            return SleepAnalyzer::CalculateDailyMetrics(day);
+        });
+        doNotOptimize(metrics.data());
+    });
+
+    // архитектура сна: один проход по фазам ночи без выделения памяти
+    std::vector<SleepArchitecture> architecture(history.size());
+    runBenchmark("SleepAnalyzer::CalculateArchitecture", history.size(), [&] {
+        std::transform(history.begin(), history.end(), architecture.begin(), [](const DailySleepData &day) {
+            return SleepAnalyzer::CalculateArchitecture(day);
+        });
+        doNotOptimize(architecture.data());
+    });
+    SleepPhaseStore store;
+    for (const auto &day: history) store.append(day);
+    const SleepPhaseColumns columns = store.columns();
+    std::vector<SleepArchitecture> batchArchitecture(history.size());
+    runBenchmark("SleepAnalyzer::CalculateBatchArchitecture", history.size(), [&] {
+        SleepAnalyzer::CalculateBatchArchitecture(columns, batchArchitecture);
+        doNotOptimize(batchArchitecture.data());
+    });
+    {
+        const AllocationScope allocations;
+        SleepAnalyzer::CalculateBatchArchitecture(columns, batchArchitecture);
+        std::printf("  allocations per batch: %zu\n", allocations.allocations());
+    }
+    if (batchArchitecture != architecture) {
+        std::printf("  mismatch with per-night architecture!\n");
+        benchmarkFailures().emplace_back("batch architecture differs from per-night architecture");
+    }
+
+    std::vector<WeeklySleepData> weeks(history.size() / 7);
+    for (std::size_t w = 0; w < weeks.size(); ++w) {
+        std::copy_n(history.begin() + static_cast<std::ptrdiff_t>(w * 7), 7, weeks[w].sleepDays.begin());
+    }
+    runBenchmark("SleepAnalyzer::CalculateAverageMetrics", weeks.size() * 7, [&] {
+        for (const auto &week: weeks) {
+            const SleepMetrics average = SleepAnalyzer::CalculateAverageMetrics(week);
+            doNotOptimize(average);
+        }
+    });
+
+    runBenchmark("SleepRecommender::GenerateRecommendation", metrics.size(), [&] {
+        std::size_t length = 0;
+        for (const auto &m: metrics) {
+            length += SleepRecommender::GenerateRecommendation(m).size();
+        }
+        doNotOptimize(length);
+    });
+
+    const RecommendationRules &rules = RecommendationRules::Defaults();
+    std::vector<RuleMask> referenceMasks(metrics.size());
+    for (std::size_t i = 0; i < metrics.size(); ++i) {
+        referenceMasks[i] = rules.evaluate(metrics[i]);
+    }
+    for (const auto path: {RecommendationRules::Path::Scalar, RecommendationRules::Path::SSE2,
+                           RecommendationRules::Path::AVX2}) {
+        std::vector<RuleMask> masks(metrics.size());
+        runBenchmark(std::string("RecommendationRules::evaluate batch ") + PhaseAggregation::PathName(path),
+                     metrics.size(), [&] {
+                    rules.evaluate(metrics, masks, path);
+                    doNotOptimize(masks.data());
+                });
+        if (masks != referenceMasks) {
+            std::printf("  mismatch with per-night rules!\n");
+            benchmarkFailures().emplace_back(std::string("RecommendationRules::evaluate batch ") +
+                                             PhaseAggregation::PathName(path) + " differs from per-night rules");
+        }
+    }
+
+    runBenchmark("PlotData::DailyPhases", history.size(), [&] {
+        std::size_t segments = 0;
+        for (const auto &day: history) {
+            segments += PlotData::DailyPhases(day).segments.size();
+        }
+        doNotOptimize(segments);
+    });
+
+    runBenchmark("PlotData::MetricsSummary", metrics.size(), [&] {
+        double minutes = 0.0;
+        for (const auto &m: metrics) {
+            minutes += PlotData::MetricsSummary(m).minutes[0];
+        }
+        doNotOptimize(minutes);
+    });
+
+    std::filesystem::remove_all(directory);
+}
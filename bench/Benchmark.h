@@ -0,0 +1,89 @@
+/**
+ * @file Benchmark.h
+ * @brief Минимальный каркас для замеров производительности.
+ */
+#ifndef SLEEP_VISUALIZER_BENCHMARK_H
+#define SLEEP_VISUALIZER_BENCHMARK_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Результат одного замера.
+ */
+struct BenchmarkResult {
+    std::string name;  ///< Название замера
+    std::size_t items; ///< Количество обработанных элементов
+    double seconds;    ///< Затраченное время, с
+
+    [[nodiscard]] double itemsPerSecond() const { return seconds > 0.0 ? items / seconds : 0.0; }
+
+    [[nodiscard]] double nanosPerItem() const { return items > 0 ? seconds * 1e9 / items : 0.0; }
+};
+
+/**
+ * @brief Результаты всех замеров, выполненных в текущем запуске, в порядке выполнения.
+ */
+inline std::vector<BenchmarkResult> &benchmarkResults() {
+    static std::vector<BenchmarkResult> results;
+    return results;
+}
+
+/**
+ * @brief Проверки замеров, которые не прошли в текущем запуске; если они есть, sleep_bench завершается с кодом 1.
+ */
+inline std::vector<std::string> &benchmarkFailures() {
+    static std::vector<std::string> failures;
+    return failures;
+}
+
+/**
+ * @brief Не даёт компилятору выбросить вычисление результата.
+ */
+template<typename T>
+inline void doNotOptimize(const T &value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const void *sink;
+    sink = &value;
+#endif
+}
+
+/**
+ * @brief Замеряет время выполнения @p fn, печатает пропускную способность и сохраняет результат
+ * в benchmarkResults().
+ *
+ * После прогрева @p fn выполняется несколько раз, в результат идёт лучшее время: оно меньше
+ * подвержено шуму и лучше подходит для сравнения сборок.
+ *
+ * @param name Название замера.
+ * @param items Количество элементов, которое обрабатывает один вызов @p fn.
+ * @param fn Замеряемая функция.
+ * @return Результат замера.
+ */
+template<typename Fn>
+BenchmarkResult runBenchmark(const std::string &name, std::size_t items, Fn &&fn) {
+    constexpr int repetitions = 3;
+
+    fn(); // прогрев кэшей
+    double best = 0.0;
+    for (int i = 0; i < repetitions; ++i) {
+        const auto start = std::chrono::steady_clock::now();
+        fn();
+        const auto end = std::chrono::steady_clock::now();
+        const double seconds = std::chrono::duration<double>(end - start).count();
+        if (i == 0 || seconds < best) best = seconds;
+    }
+
+    BenchmarkResult result{name, items, best};
+    std::printf("%-40s %12.1f ns/item %12.3f M items/s\n", name.c_str(), result.nanosPerItem(),
+                result.itemsPerSecond() / 1e6);
+    benchmarkResults().push_back(result);
+    return result;
+}
+
+#endif //SLEEP_VISUALIZER_BENCHMARK_H
@@ -0,0 +1,75 @@
+#include "BenchmarkReport.h"
+#include <fstream>
+#include <stdexcept>
+#include <unordered_map>
+#include <nlohmann/json.hpp>
+
+namespace {
+
+std::string compilerName() {
+#if defined(__clang__)
+    return std::string("clang ") + __clang_version__;
+#elif defined(__GNUC__)
+    return std::string("gcc ") + __VERSION__;
+#elif defined(_MSC_VER)
+    return "msvc " + std::to_string(_MSC_VER);
+#else
+    return "unknown";
+#endif
+}
+
+} // namespace
+
+void BenchmarkReport::writeJson(const std::string &filename, std::span<const BenchmarkResult> results) {
+    nlohmann::json items = nlohmann::json::array();
+    for (const auto &result: results) {
+        items.push_back({
+                                {"name",           result.name},
+                                {"items",          result.items},
+                                {"seconds",        result.seconds},
+                                {"nsPerItem",      result.nanosPerItem()},
+                                {"itemsPerSecond", result.itemsPerSecond()}
+                        });
+    }
+
+    std::ofstream ofs(filename);
+    if (!ofs.is_open()) {
+        throw std::runtime_error("unable to create file: " + filename);
+    }
+    ofs << nlohmann::json{{"compiler", compilerName()},
+                          {"results",  std::move(items)}}.dump(2) << '\n';
+}
+
+std::size_t BenchmarkReport::compareWithBaseline(const std::string &filename, std::span<const BenchmarkResult> results,
+                                                 double thresholdPercent) {
+    std::ifstream ifs(filename);
+    if (!ifs.is_open()) {
+        throw std::runtime_error("unable to open file: " + filename);
+    }
+
+    std::unordered_map<std::string, double> baseline;
+    try {
+        const nlohmann::json report = nlohmann::json::parse(ifs);
+        for (const auto &item: report.at("results")) {
+            baseline[item.at("name").get<std::string>()] = item.at("nsPerItem").get<double>();
+        }
+    } catch (const nlohmann::json::exception &e) {
+        throw std::runtime_error("error parsing baseline: " + std::string(e.what()));
+    }
+
+    std::size_t regressions = 0;
+    std::printf("\n%-40s %12s %12s %9s\n", "comparison with baseline", "base ns", "ns", "change");
+    for (const auto &result: results) {
+        const auto it = baseline.find(result.name);
+        if (it == baseline.end() || it->second <= 0.0) {
+            std::printf("%-40s %12s %12.1f %9s\n", result.name.c_str(), "-", result.nanosPerItem(), "new");
+            continue;
+        }
+        const double change = (result.nanosPerItem() / it->second - 1.0) * 100.0;
+        const bool regression = change > thresholdPercent;
+        regressions += regression;
+        std::printf("%-40s %12.1f %12.1f %+8.1f%%%s\n", result.name.c_str(), it->second, result.nanosPerItem(),
+                    change, regression ? "  REGRESSION" : "");
+    }
+    return regressions;
+}
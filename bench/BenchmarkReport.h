@@ -0,0 +1,44 @@
+/**
+ * @file BenchmarkReport.h
+ * @brief Сохранение результатов замеров в JSON и сравнение с результатами другой сборки.
+ */
+#ifndef SLEEP_VISUALIZER_BENCHMARKREPORT_H
+#define SLEEP_VISUALIZER_BENCHMARKREPORT_H
+
+#include <span>
+#include <string>
+#include "Benchmark.h"
+
+/**
+ * @brief Машиночитаемые отчёты о замерах.
+ *
+ * Объекты этого класса создавать нельзя.
+ */
+class BenchmarkReport {
+public:
+    BenchmarkReport() = delete;
+
+    /**
+     * @brief Записывает результаты в JSON-файл.
+     *
+     * Формат: {"compiler": ..., "results": [{"name", "items", "seconds", "nsPerItem", "itemsPerSecond"}, ...]}.
+     *
+     * @throws std::runtime_error Если файл невозможно создать.
+     */
+    static void writeJson(const std::string &filename, std::span<const BenchmarkResult> results);
+
+    /**
+     * @brief Сравнивает результаты с сохранёнными через writeJson() и печатает изменения.
+     *
+     * @param filename JSON-файл с результатами другой сборки.
+     * @param results Текущие результаты.
+     * @param thresholdPercent Допустимое замедление, %; замер медленнее базового сильнее считается регрессией.
+     * @return Количество регрессий.
+     *
+     * @throws std::runtime_error Если файл невозможно открыть или разобрать.
+     */
+    static std::size_t compareWithBaseline(const std::string &filename, std::span<const BenchmarkResult> results,
+                                           double thresholdPercent);
+};
+
+#endif //SLEEP_VISUALIZER_BENCHMARKREPORT_H
@@ -0,0 +1,59 @@
+#include "Benchmark.h"
+#include "DateTimeParser.h"
+#include <ctime>
+#include <iomanip>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+/**
+ * Строки вида "YYYY-MM-DD HH:MM:SS" подряд в одном буфере, по 19 символов.
+ */
+std::string makeTimestamps(std::size_t count) {
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> year(2015, 2025), month(1, 12), day(1, 28), hour(0, 23), minute(0, 59);
+
+    std::string buffer;
+    buffer.reserve(count * 19);
+    char item[32];
+    for (std::size_t i = 0; i < count; ++i) {
+        std::snprintf(item, sizeof(item), "%04d-%02d-%02d %02d:%02d:%02d", year(rng), month(rng), day(rng), hour(rng),
+                      minute(rng), 0);
+        buffer.append(item, 19);
+    }
+    return buffer;
+}
+
+} // namespace
+
+void runDateTimeParserBenchmarks() {
+    constexpr std::size_t fastCount = 4'000'000;
+    constexpr std::size_t referenceCount = 200'000;
+    const std::string timestamps = makeTimestamps(fastCount);
+
+    runBenchmark("DateTimeParser::parseDateTime", fastCount, [&] {
+        std::int64_t checksum = 0;
+        std::chrono::system_clock::time_point tp;
+        for (std::size_t i = 0; i < fastCount; ++i) {
+            if (DateTimeParser::parseDateTime(std::string_view(timestamps).substr(i * 19, 19), tp) ==
+                DateTimeParseStatus::Ok) {
+                checksum += tp.time_since_epoch().count();
+            }
+        }
+        doNotOptimize(checksum);
+    });
+
+    runBenchmark("std::get_time + std::mktime", referenceCount, [&] {
+        std::int64_t checksum = 0;
+        for (std::size_t i = 0; i < referenceCount; ++i) {
+            std::tm tm = {};
+            std::istringstream ss(timestamps.substr(i * 19, 19));
+            ss >> std::get_time(&tm, "%Y-%m-%d %H:%M");
+            checksum += std::mktime(&tm);
+        }
+        doNotOptimize(checksum);
+    });
+}
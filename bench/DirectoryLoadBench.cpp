@@ -0,0 +1,34 @@
+#include "Benchmark.h"
+#include "DataLoader.h"
+#include "SyntheticHistory.h"
+#include "WorkStealingPool.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+void runDirectoryLoadBenchmarks() {
+    constexpr int fileCount = 2000;
+    const auto directory = std::filesystem::temp_directory_path() / "sleep_bench_directory";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+    // недели идут подряд, чтобы ночи разных файлов не совпадали по датам
+    SyntheticHistoryOptions options;
+    options.nights = 7;
+    for (int i = 0; i < fileCount; ++i) {
+        options.seed = static_cast<std::uint32_t>(i);
+        options.firstDay = SyntheticHistoryOptions{}.firstDay + i * 7;
+        std::ofstream ofs(directory / ("week_" + std::to_string(i) + ".json"), std::ios::binary);
+        SyntheticHistory::writeJson(ofs, options);
+    }
+
+    const std::size_t hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+    for (std::size_t threads = 1; threads <= hardwareThreads; threads *= 2) {
+        WorkStealingPool pool(threads);
+        runBenchmark("DataLoader::loadDirectory x" + std::to_string(threads), fileCount, [&] {
+            doNotOptimize(DataLoader::loadDirectory(directory.string(), pool).nights.size());
+        });
+    }
+
+    std::filesystem::remove_all(directory);
+}
@@ -0,0 +1,88 @@
+#include "Benchmark.h"
+#include "SleepAnalyzer.h"
+#include "SleepMetricsExporter.h"
+#include "SyntheticHistory.h"
+#include <chrono>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+namespace {
+
+std::int64_t toSeconds(DateTime t) {
+    return std::chrono::duration_cast<std::chrono::seconds>(t.time_since_epoch()).count();
+}
+
+} // namespace
+
+void runExportBenchmarks() {
+    // выгрузка когорты: 250 пользователей по 4096 ночей, около миллиона строк
+    SyntheticHistoryOptions options;
+    options.seed = 51;
+    options.nights = 4096;
+    const std::vector<DailySleepData> days = SyntheticHistory::generate(options);
+    constexpr std::size_t users = 250;
+    const std::size_t rows = users * days.size();
+
+    std::vector<std::int64_t> dates(days.size());
+    std::vector<SleepMetrics> nights(days.size());
+    std::vector<SleepArchitecture> architecture(days.size());
+    runBenchmark("analyzer, metrics and architecture", days.size(), [&] {
+        for (std::size_t i = 0; i < days.size(); ++i) {
+            dates[i] = toSeconds(days[i].date);
+            nights[i] = SleepAnalyzer::CalculateDailyMetrics(days[i]);
+            architecture[i] = SleepAnalyzer::CalculateArchitecture(days[i]);
+        }
+        doNotOptimize(nights.data());
+    });
+
+    std::vector<std::string> names(users);
+    for (std::size_t user = 0; user < users; ++user) {
+        names[user] = "user" + std::to_string(user);
+    }
+
+    const auto directory = std::filesystem::temp_directory_path();
+    const std::pair<const char *, ExportFormat> formats[] = {
+            {"columnar", ExportFormat::Columnar},
+            {"csv",      ExportFormat::Csv}
+    };
+    for (const auto &[name, format]: formats) {
+        const auto file = directory / (std::string("sleep_bench_export.") + name);
+        const BenchmarkResult result = runBenchmark(std::string("SleepMetricsExporter, ") + name, rows, [&] {
+            SleepMetricsExporter exporter(file.string(), format, names);
+            for (std::size_t user = 0; user < users; ++user) {
+                exporter.append(static_cast<std::uint32_t>(user), dates, nights, architecture);
+            }
+            exporter.close();
+        });
+        const double megabytes = static_cast<double>(std::filesystem::file_size(file)) / (1024.0 * 1024.0);
+        std::printf("  %.1f MB, %.1f MB/s\n", megabytes, megabytes / result.seconds);
+        std::filesystem::remove(file);
+    }
+
+    // для сравнения: строки CSV через std::format и поток, как в отчёте sleep_report
+    const auto file = directory / "sleep_bench_export_format.csv";
+    runBenchmark("CSV via std::format and ofstream", rows, [&] {
+        std::ofstream out(file, std::ios::binary);
+        std::string line;
+        for (std::size_t user = 0; user < users; ++user) {
+            for (std::size_t i = 0; i < days.size(); ++i) {
+                const SleepMetrics &m = nights[i];
+                const SleepArchitecture &a = architecture[i];
+                line.clear();
+                std::format_to(std::back_inserter(line),
+                               "\"{}\",{},{},{},{},{},{},{},{},{},{},{},{},{},{},{},{},{},{},{},{}\n",
+                               names[user], dates[i], m.timeInBed, m.totalSleepTime, m.sleepOnset,
+                               m.awakeningsCount, m.awakeDuration, m.deepSleepDuration, m.remSleepDuration,
+                               m.lightSleepDuration,
+                               m.lightSleepPercent, m.deepSleepPercent, m.remSleepPercent, m.efficiency,
+                               a.sleepOnsetLatency, a.remLatency, a.waso, a.cycleCount, a.meanCycleLength(),
+                               a.stageShifts, a.fragmentationIndex);
+                out << line;
+            }
+        }
+    });
+    std::filesystem::remove(file);
+}
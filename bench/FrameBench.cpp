@@ -0,0 +1,149 @@
+#include "AllocationCounter.h"
+#include "Benchmark.h"
+#include "DateUtils.h"
+#include "PlotData.h"
+#include "SleepAnalyzer.h"
+#include "SyntheticHistory.h"
+#include "Visualization.h"
+#include "imgui.h"
+#include "implot.h"
+#include <array>
+#include <cstdio>
+
+namespace {
+
+/**
+ * Контекст ImGui без окна и графического API: кадры собираются в списки отрисовки, но не выводятся.
+ */
+class HeadlessGui {
+public:
+    HeadlessGui() {
+        ImGui::CreateContext();
+        ImPlot::CreateContext();
+
+        ImGuiIO &io = ImGui::GetIO();
+        io.IniFilename = nullptr;
+        io.DisplaySize = {1280.0f, 720.0f};
+        io.DeltaTime = 1.0f / 60.0f;
+        unsigned char *pixels = nullptr;
+        int width = 0, height = 0;
+        io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);
+
+        // та же палитра, что регистрирует приложение
+        const ImVec4 colors[] = {
+                {0.42f, 0.79f, 0.47f, 1.0f},
+                {0.30f, 0.59f, 1.0f,  1.0f},
+                {0.65f, 0.42f, 1.0f,  1.0f},
+                {1.0f,  0.42f, 0.42f, 1.0f},
+        };
+        ImPlot::AddColormap("MySleepPalette", colors, 4);
+    }
+
+    ~HeadlessGui() {
+        ImPlot::DestroyContext();
+        ImGui::DestroyContext();
+    }
+
+    HeadlessGui(const HeadlessGui &) = delete;
+
+    HeadlessGui &operator=(const HeadlessGui &) = delete;
+
+    template<typename Draw>
+    void frame(Draw &&draw) {
+        ImGui::NewFrame();
+        draw();
+        ImGui::Render();
+        doNotOptimize(ImGui::GetDrawData()->TotalVtxCount);
+    }
+};
+
+} // namespace
+
+void runFrameBenchmarks() {
+    // ночи из сотен коротких фаз: таймлайн с таким количеством отрезков дороже всего перестраивать
+    SyntheticHistoryOptions options;
+    options.seed = 31;
+    options.nights = 2;
+    options.minPhases = 400;
+    options.maxPhases = 400;
+    options.minPhaseSeconds = 30;
+    options.maxPhaseSeconds = 120;
+    const std::vector<DailySleepData> nights = SyntheticHistory::generate(options);
+    const SleepMetrics metrics[] = {SleepAnalyzer::CalculateDailyMetrics(nights[0]),
+                                    SleepAnalyzer::CalculateDailyMetrics(nights[1])};
+
+    constexpr int labelCount = 100'000;
+    const DateTime labelTime = nights[0].bedtime;
+    runBenchmark("DateUtils::onlyTime string", labelCount, [&] {
+        for (int i = 0; i < labelCount; ++i) {
+            doNotOptimize(DateUtils::onlyTime(labelTime + std::chrono::minutes(i)));
+        }
+    });
+    std::array<char, DateUtils::kFormatBufferSize> labelBuffer{};
+    runBenchmark("DateUtils::onlyTime buffer", labelCount, [&] {
+        for (int i = 0; i < labelCount; ++i) {
+            doNotOptimize(DateUtils::onlyTime(labelTime + std::chrono::minutes(i), labelBuffer));
+        }
+    });
+    runBenchmark("DateUtils::timeLabel", labelCount, [&] {
+        for (int i = 0; i < labelCount; ++i) {
+            doNotOptimize(DateUtils::timeLabel(labelTime + std::chrono::minutes(i)));
+        }
+    });
+
+    DailyPhasesPlotCache cache;
+    runBenchmark("DailyPhasesPlotCache::update hit", 100'000, [&] {
+        std::size_t rebuilt = 0;
+        for (int i = 0; i < 100'000; ++i) {
+            rebuilt += cache.update(nights[0]);
+        }
+        doNotOptimize(rebuilt);
+    });
+    runBenchmark("DailyPhasesPlotCache::update rebuild", 10'000, [&] {
+        for (int i = 0; i < 10'000; ++i) {
+            cache.update(nights[i & 1]);
+        }
+        doNotOptimize(cache.phaseCount());
+    });
+
+    HeadlessGui gui;
+    constexpr int frames = 2'000;
+    runBenchmark("Visualization frame, same night", frames, [&] {
+        for (int i = 0; i < frames; ++i) {
+            gui.frame([&] {
+                Visualization::ShowDailyPhasesPlot(nights[0]);
+                Visualization::ShowMetricsSummary(metrics[0], false);
+            });
+        }
+    });
+    // данные меняются каждый кадр: к отрисовке добавляется перестроение кэшей
+    runBenchmark("Visualization frame, new night", frames, [&] {
+        for (int i = 0; i < frames; ++i) {
+            gui.frame([&] {
+                Visualization::ShowDailyPhasesPlot(nights[i & 1]);
+                Visualization::ShowMetricsSummary(metrics[i & 1], false);
+            });
+        }
+    });
+
+    // после прогрева кэши и буферы уже нужного размера, поэтому установившаяся отрисовка не выделяет память;
+    // при смене ночи допустимы только выделения ImGui, которые сюда не попадают
+    const auto frameAllocations = [&](bool alternate) {
+        const AllocationScope allocations;
+        for (int i = 0; i < frames; ++i) {
+            const int night = alternate ? i & 1 : 0;
+            gui.frame([&] {
+                Visualization::ShowDailyPhasesPlot(nights[night]);
+                Visualization::ShowMetricsSummary(metrics[night], false);
+            });
+        }
+        return static_cast<double>(allocations.allocations()) / frames;
+    };
+    const double sameNight = frameAllocations(false);
+    const double newNight = frameAllocations(true);
+    std::printf("  allocations per frame: same night %.2f, new night %.2f\n", sameNight, newNight);
+    if (sameNight > 0.0 || newNight > 0.0) {
+        std::printf("  steady-state frame allocates memory!\n");
+        benchmarkFailures().emplace_back("steady-state Visualization frame allocates memory");
+    }
+}
@@ -0,0 +1,92 @@
+#include "Benchmark.h"
+#include "DataLoader.h"
+#include "SleepAnalyzer.h"
+#include "SleepMetricsCache.h"
+#include "SyntheticHistory.h"
+#include <filesystem>
+#include <sstream>
+#include <vector>
+
+namespace {
+
+/**
+ * Меняет каждую period-ю запись документа, не меняя её смысла: в начало записи добавляется пробел.
+ * Для кэша это новая запись, которую придётся разобрать заново.
+ */
+std::string touchRecords(const std::string &json, std::size_t period) {
+    const std::vector<std::string_view> records = DataLoader::splitRecords(json);
+    std::string out = "[";
+    for (std::size_t i = 0; i < records.size(); ++i) {
+        if (i > 0) out += ',';
+        if (i % period == 0) out += "{ ";
+        out += i % period == 0 ? records[i].substr(1) : records[i];
+    }
+    out += ']';
+    return out;
+}
+
+} // namespace
+
+void runMetricsCacheBenchmarks() {
+    // ночной пакетный отчёт: сто пользователей по году ночей, с прошлого запуска изменился 1% записей
+    SyntheticHistoryOptions options;
+    options.seed = 41;
+    options.nights = 365;
+    options.users = 100;
+
+    std::vector<std::string> documents(options.users);
+    std::size_t nights = 0;
+    for (std::size_t user = 0; user < options.users; ++user) {
+        std::ostringstream oss;
+        SyntheticHistory::writeJson(oss, options, user);
+        documents[user] = oss.str();
+        nights += options.nights;
+    }
+    std::vector<std::string> touched(documents.size());
+    for (std::size_t user = 0; user < documents.size(); ++user) {
+        touched[user] = touchRecords(documents[user], 100);
+    }
+
+    runBenchmark("nightly batch without cache", nights, [&] {
+        std::int64_t sleep = 0;
+        for (const auto &document: touched) {
+            std::istringstream input(document);
+            DataLoader::streamFromJson(input, [&sleep](DailySleepData &&day) {
+                sleep += SleepAnalyzer::CalculateDailyMetrics(day).totalSleepTime;
+                sleep += SleepAnalyzer::CalculateArchitecture(day).waso;
+            });
+        }
+        doNotOptimize(sleep);
+    });
+
+    std::vector<NightMetrics> out;
+    runBenchmark("nightly batch, cold cache", nights, [&] {
+        SleepMetricsCache cache;
+        for (const auto &document: documents) {
+            SleepAnalyzer::CalculateRecordMetrics(document, cache, out);
+        }
+        doNotOptimize(out.data());
+    });
+
+    const auto file = std::filesystem::temp_directory_path() / "sleep_bench_metrics.cache";
+    {
+        SleepMetricsCache cache;
+        for (const auto &document: documents) {
+            SleepAnalyzer::CalculateRecordMetrics(document, cache, out);
+        }
+        cache.save(file.string());
+    }
+    std::size_t hits = 0, misses = 0;
+    runBenchmark("nightly batch, warm cache, 1% changed", nights, [&] {
+        SleepMetricsCache cache(file.string());
+        for (const auto &document: touched) {
+            SleepAnalyzer::CalculateRecordMetrics(document, cache, out);
+        }
+        doNotOptimize(out.data());
+        hits = cache.hits();
+        misses = cache.misses();
+    });
+    std::printf("  %zu hits, %zu misses, cache file %.1f MB\n", hits, misses,
+                static_cast<double>(std::filesystem::file_size(file)) / (1024.0 * 1024.0));
+    std::filesystem::remove(file);
+}
@@ -0,0 +1,103 @@
+#include "Benchmark.h"
+#include "DateTimeParser.h"
+#include "SleepMetricsIndex.h"
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace {
+
+struct RangeQuery {
+    std::int64_t firstDay;
+    std::int64_t lastDay;
+    std::uint8_t weekdays;
+};
+
+/**
+ * Прямой подсчёт по ночам диапазона - то, что пришлось бы делать без индекса.
+ */
+SleepMetricsTotals scanTotals(const std::vector<std::int64_t> &days, const std::vector<SleepMetrics> &metrics,
+                              const RangeQuery &query) {
+    SleepMetricsTotals totals;
+    for (std::size_t i = 0; i < days.size(); ++i) {
+        if (days[i] < query.firstDay || days[i] > query.lastDay) continue;
+        const unsigned weekday = std::chrono::weekday(std::chrono::sys_days(std::chrono::days(days[i]))).c_encoding();
+        if (query.weekdays & (1u << weekday)) totals.add(metrics[i]);
+    }
+    return totals;
+}
+
+} // namespace
+
+void runMetricsIndexBenchmarks() {
+    constexpr std::int64_t years = 12;
+    constexpr std::size_t queryCount = 1'000'000;
+    constexpr std::size_t scanQueryCount = 10'000;
+
+    std::mt19937 rng(11);
+    std::uniform_int_distribution<int> minutes(0, 600), awakenings(0, 8), skip(0, 19);
+    std::uniform_real_distribution<double> efficiency(1.0, 100.0);
+
+    // ночи за 12 лет, примерно каждая двадцатая пропущена
+    const std::int64_t firstDay = DateTimeParser::daysFromCivil(2014, 1, 1);
+    const std::int64_t dayCount = years * 365 + years / 4;
+    std::vector<std::int64_t> days;
+    std::vector<DateTime> dates;
+    std::vector<SleepMetrics> metrics;
+    for (std::int64_t day = firstDay; day < firstDay + dayCount; ++day) {
+        if (skip(rng) == 0) continue;
+        SleepMetrics m{};
+        m.timeInBed = minutes(rng);
+        m.lightSleepDuration = minutes(rng) / 2;
+        m.deepSleepDuration = minutes(rng) / 4;
+        m.remSleepDuration = minutes(rng) / 4;
+        m.totalSleepTime = m.lightSleepDuration + m.deepSleepDuration + m.remSleepDuration;
+        m.awakeningsCount = awakenings(rng);
+        m.sleepOnset = minutes(rng) / 10;
+        m.efficiency = efficiency(rng);
+        days.push_back(day);
+        dates.push_back(DateTime(std::chrono::seconds(DateTimeParser::localToUtc(day * 86400))));
+        metrics.push_back(m);
+    }
+
+    SleepMetricsIndex index;
+    runBenchmark("SleepMetricsIndex build", dates.size(), [&] {
+        index = SleepMetricsIndex(dates, metrics);
+        doNotOptimize(index);
+    });
+
+    std::uniform_int_distribution<std::int64_t> day(firstDay - 30, firstDay + dayCount + 30);
+    std::uniform_int_distribution<int> mask(0, 0xFF);
+    std::vector<RangeQuery> queries(queryCount);
+    for (auto &query: queries) {
+        std::int64_t a = day(rng), b = day(rng);
+        if (a > b) std::swap(a, b);
+        // половина запросов - по всем дням, остальные - по случайному набору дней недели
+        const int m = mask(rng);
+        query = {a, b, static_cast<std::uint8_t>(m & 0x80 ? SleepMetricsIndex::kAllWeekdays : m & 0x7F)};
+    }
+
+    runBenchmark("SleepMetricsIndex range query", queries.size(), [&] {
+        for (const auto &query: queries) {
+            const SleepMetricsTotals totals = index.totalsForDays(query.firstDay, query.lastDay, query.weekdays);
+            doNotOptimize(totals);
+        }
+    });
+
+    const std::span<const RangeQuery> scanQueries(queries.data(), scanQueryCount);
+    runBenchmark("Full scan range query", scanQueries.size(), [&] {
+        for (const auto &query: scanQueries) {
+            const SleepMetricsTotals totals = scanTotals(days, metrics, query);
+            doNotOptimize(totals);
+        }
+    });
+
+    for (const auto &query: scanQueries) {
+        const SleepMetricsTotals expected = scanTotals(days, metrics, query);
+        const SleepMetricsTotals actual = index.totalsForDays(query.firstDay, query.lastDay, query.weekdays);
+        if (std::memcmp(&expected, &actual, sizeof(SleepMetricsTotals)) != 0) {
+            std::printf("  mismatch with full scan!\n");
+            break;
+        }
+    }
+}
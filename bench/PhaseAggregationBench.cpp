@@ -0,0 +1,50 @@
+#include "Benchmark.h"
+#include "PhaseAggregation.h"
+#include "SyntheticHistory.h"
+#include <cstring>
+#include <vector>
+
+namespace {
+
+/**
+ * Случайная история: от 4 до 40 фаз за ночь, длительности не кратны минуте.
+ */
+SleepPhaseStore makeHistory(std::size_t nights) {
+    SyntheticHistoryOptions options;
+    options.seed = 7;
+    options.nights = nights;
+    options.maxPhases = 40;
+    options.minPhaseSeconds = 30;
+    options.maxPhaseSeconds = 90 * 60;
+    options.awakeningRate = 0.25;
+
+    SleepPhaseStore store;
+    SyntheticHistory::generate(options, 0, [&store](const DailySleepData &night) {
+        store.append(night);
+    });
+    return store;
+}
+
+} // namespace
+
+void runPhaseAggregationBenchmarks() {
+    constexpr std::size_t nights = 1'000'000;
+    const SleepPhaseStore store = makeHistory(nights);
+    const SleepPhaseColumns history = store.columns();
+
+    std::vector<PhaseTotals> reference(nights);
+    PhaseAggregation::Aggregate(history, reference, PhaseAggregation::Path::Scalar);
+
+    for (const auto path: {PhaseAggregation::Path::Scalar, PhaseAggregation::Path::SSE2,
+                           PhaseAggregation::Path::AVX2}) {
+        std::vector<PhaseTotals> totals(nights);
+        runBenchmark(std::string("PhaseAggregation::Aggregate ") + PhaseAggregation::PathName(path),
+                     history.phaseCount(), [&] {
+                    PhaseAggregation::Aggregate(history, totals, path);
+                    doNotOptimize(totals.data());
+                });
+        if (std::memcmp(totals.data(), reference.data(), nights * sizeof(PhaseTotals)) != 0) {
+            std::printf("  mismatch with scalar path!\n");
+        }
+    }
+}
@@ -0,0 +1,129 @@
+#include "Benchmark.h"
+#include "DataLoader.h"
+#include "PlotData.h"
+#include "SignalAnalysis.h"
+#include "SleepPhaseStore.h"
+#include "SyntheticHistory.h"
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+namespace {
+
+/**
+ * Год ночей с рядами пульса и дыхания раз в секунду.
+ */
+SyntheticHistoryOptions yearOptions() {
+    SyntheticHistoryOptions options;
+    options.seed = 31;
+    options.nights = 365;
+    options.signalInterval = 1;
+    return options;
+}
+
+bool sameSummary(const SignalSummary &a, const SignalSummary &b) {
+    return a.sum == b.sum && a.count == b.count && a.min == b.min && a.max == b.max;
+}
+
+} // namespace
+
+void runSignalBenchmarks() {
+    const SyntheticHistoryOptions options = yearOptions();
+    SleepPhaseStore store;
+    SyntheticHistory::generate(options, 0, [&store](const DailySleepData &night) {
+        store.append(night);
+    });
+    const SleepPhaseColumns history = store.columns();
+
+    std::size_t samples = 0, heartRateSamples = 0, encodedBytes = 0;
+    for (std::size_t i = 0; i < history.nightCount(); ++i) {
+        for (const SleepSignalView &signal: history.night(i).signals) {
+            samples += signal.size();
+            encodedBytes += signal.encoded.size();
+        }
+        heartRateSamples += history.night(i).signal(SleepSignalType::HeartRate).size();
+    }
+    std::printf("  %zu nights, %zu samples: %.2f bytes/sample, %.1f MB per year\n", history.nightCount(), samples,
+                static_cast<double>(encodedBytes) / static_cast<double>(samples),
+                static_cast<double>(encodedBytes) / (1024.0 * 1024.0));
+
+    std::vector<std::vector<SignalSample>> decoded(history.nightCount());
+    runBenchmark("SleepSignalView::decode", heartRateSamples, [&] {
+        for (std::size_t i = 0; i < history.nightCount(); ++i) {
+            history.night(i).signal(SleepSignalType::HeartRate).decode(decoded[i]);
+        }
+        doNotOptimize(decoded.back().data());
+    });
+
+    std::vector<SignalSummary> reference(decoded.size());
+    std::vector<RrVariability> referenceHrv(decoded.size());
+    for (std::size_t i = 0; i < decoded.size(); ++i) {
+        reference[i] = SignalAnalysis::Summarize(decoded[i], SignalAnalysis::Path::Scalar);
+        referenceHrv[i] = SignalAnalysis::Variability(decoded[i], SignalAnalysis::Path::Scalar);
+    }
+
+    for (const auto path: {SignalAnalysis::Path::Scalar, SignalAnalysis::Path::SSE2, SignalAnalysis::Path::AVX2}) {
+        std::vector<SignalSummary> summaries(decoded.size());
+        runBenchmark(std::string("SignalAnalysis::Summarize ") + PhaseAggregation::PathName(path),
+                     heartRateSamples, [&] {
+                    for (std::size_t i = 0; i < decoded.size(); ++i) {
+                        summaries[i] = SignalAnalysis::Summarize(decoded[i], path);
+                    }
+                    doNotOptimize(summaries.data());
+                });
+        std::vector<RrVariability> variability(decoded.size());
+        runBenchmark(std::string("SignalAnalysis::Variability ") + PhaseAggregation::PathName(path),
+                     heartRateSamples, [&] {
+                    for (std::size_t i = 0; i < decoded.size(); ++i) {
+                        variability[i] = SignalAnalysis::Variability(decoded[i], path);
+                    }
+                    doNotOptimize(variability.data());
+                });
+        for (std::size_t i = 0; i < decoded.size(); ++i) {
+            if (!sameSummary(summaries[i], reference[i]) || variability[i].pairs != referenceHrv[i].pairs ||
+                std::abs(variability[i].rmssd() - referenceHrv[i].rmssd()) > 1e-9 * referenceHrv[i].rmssd()) {
+                std::printf("  mismatch with scalar path!\n");
+                break;
+            }
+        }
+    }
+
+    std::vector<SignalSample> scratch;
+    runBenchmark("SignalAnalysis::AnalyzeNight", samples, [&] {
+        double rmssd = 0.0;
+        for (std::size_t i = 0; i < history.nightCount(); ++i) {
+            rmssd += SignalAnalysis::AnalyzeNight(history.night(i), scratch).hrv.rmssd();
+        }
+        doNotOptimize(rmssd);
+    });
+
+    // прорежение к ширине графика при каждом кадре с новым масштабом
+    NightSignalsPlotCache cache;
+    cache.update(history.night(history.nightCount() - 1));
+    constexpr std::size_t zoomSteps = 1'000;
+    runBenchmark("NightSignalsPlotCache::decimate", zoomSteps, [&] {
+        const double span = cache.endTime() - cache.startTime();
+        for (std::size_t k = 0; k < zoomSteps; ++k) {
+            const double shrink = span * 0.4 * static_cast<double>(k) / zoomSteps;
+            const DecimatedSignal &signal = cache.decimate(SleepSignalType::HeartRate, cache.startTime() + shrink,
+                                                           cache.endTime() - shrink, 1'600);
+            doNotOptimize(signal.xs.data());
+        }
+    });
+
+    const auto directory = std::filesystem::temp_directory_path() / "sleep_bench_signal";
+    std::filesystem::create_directories(directory);
+    const std::string file = (directory / "year.json").string();
+    {
+        std::ofstream ofs(file, std::ios::binary);
+        SyntheticHistory::writeJson(ofs, options);
+    }
+    const auto fileBytes = std::filesystem::file_size(file);
+    const BenchmarkResult load = runBenchmark("DataLoader::loadHistoryFromJsonFile, signals", samples, [&] {
+        doNotOptimize(DataLoader::loadHistoryFromJsonFile(file).nights.size());
+    });
+    std::printf("  %.1f MB/s\n", static_cast<double>(fileBytes) / (1024.0 * 1024.0) / load.seconds);
+    std::filesystem::remove_all(directory);
+}
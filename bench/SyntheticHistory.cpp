@@ -0,0 +1,203 @@
+#include "SyntheticHistory.h"
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include "DateTimeParser.h"
+
+namespace {
+
+constexpr std::int64_t kDatesPeriod = 36500;
+
+DateTime fromLocalSeconds(std::int64_t localSeconds) {
+    return DateTime(std::chrono::seconds(DateTimeParser::localToUtc(localSeconds)));
+}
+
+/**
+ * Печатает момент времени в местном часовом поясе: "YYYY-MM-DD HH:MM:SS" или только дату.
+ */
+int formatLocal(char *buffer, std::size_t size, const DateTime &tp, bool withTime) {
+    const std::int64_t utc = std::chrono::floor<std::chrono::seconds>(tp.time_since_epoch()).count();
+    const std::int64_t local = utc + DateTimeParser::utcOffsetAt(utc);
+    const std::chrono::sys_days day{std::chrono::days(DateTimeParser::localDayNumber(utc))};
+    const std::chrono::year_month_day ymd(day);
+    const std::int64_t secondsOfDay = local - DateTimeParser::localDayNumber(utc) * 86400;
+
+    if (!withTime) {
+        return std::snprintf(buffer, size, "%04d-%02u-%02u", static_cast<int>(ymd.year()),
+                             static_cast<unsigned>(ymd.month()), static_cast<unsigned>(ymd.day()));
+    }
+    return std::snprintf(buffer, size, "%04d-%02u-%02u %02d:%02d:%02d", static_cast<int>(ymd.year()),
+                         static_cast<unsigned>(ymd.month()), static_cast<unsigned>(ymd.day()),
+                         static_cast<int>(secondsOfDay / 3600), static_cast<int>(secondsOfDay / 60 % 60),
+                         static_cast<int>(secondsOfDay % 60));
+}
+
+/**
+ * Уровни пульса и дыхания, к которым ряды стремятся в каждой фазе; индекс - SleepPhaseType.
+ */
+constexpr double kHeartRateLevels[] = {58.0, 52.0, 64.0, 72.0};
+constexpr double kRespirationLevels[] = {14.0, 13.0, 16.0, 17.0};
+
+/**
+ * Заполняет ряды ночи отсчётами с шагом interval от отхода ко сну до пробуждения.
+ */
+void generateSignals(DailySleepData &night, int interval, std::mt19937 &rng) {
+    std::normal_distribution<double> heartNoise(0.0, 1.5);
+    std::normal_distribution<double> breathNoise(0.0, 0.3);
+    std::uniform_real_distribution<double> nightOffset(-6.0, 6.0);
+    std::bernoulli_distribution dropout(0.002);
+
+    SleepSignal &heartRate = night.signals[static_cast<std::size_t>(SleepSignalType::HeartRate)];
+    SleepSignal &respiration = night.signals[static_cast<std::size_t>(SleepSignalType::Respiration)];
+    heartRate.reset(night.bedtime, interval);
+    respiration.reset(night.bedtime, interval);
+
+    const double offset = nightOffset(rng);
+    double heart = kHeartRateLevels[0] + offset;
+    double breath = kRespirationLevels[0];
+    std::size_t phase = 0;
+    for (DateTime t = night.bedtime; t < night.wakeTime; t += std::chrono::seconds(interval)) {
+        while (phase + 1 < night.phases.size() && night.phases[phase].end <= t) ++phase;
+        const auto type = static_cast<std::size_t>(night.phases.empty() ? SleepPhaseType::Light
+                                                                        : night.phases[phase].type);
+        heart += (kHeartRateLevels[type] + offset - heart) * 0.05 + heartNoise(rng);
+        breath += (kRespirationLevels[type] - breath) * 0.05 + breathNoise(rng);
+        // пульс устройство передаёт целым, дыхание - с десятыми долями
+        const bool missing = dropout(rng);
+        heartRate.append(missing ? kMissingSample : static_cast<SignalSample>(std::lround(heart) * 10));
+        respiration.append(missing ? kMissingSample : static_cast<SignalSample>(std::lround(breath * kSignalScale)));
+    }
+}
+
+/**
+ * Печатает ряд в формате DataLoader: значения в единицах измерения, null - нет данных.
+ */
+void writeSignal(std::ostream &out, const char *name, const SleepSignal &signal, std::vector<SignalSample> &samples) {
+    char start[32];
+    formatLocal(start, sizeof(start), signal.view().start, true);
+    out << ",\"" << name << R"(":{"start":")" << start << R"(","interval":)" << signal.view().interval
+        << R"(,"values":[)";
+    signal.view().decode(samples);
+    for (std::size_t i = 0; i < samples.size(); ++i) {
+        const int value = samples[i];
+        if (i > 0) out << ',';
+        if (value == kMissingSample) {
+            out << "null";
+        } else {
+            out << value / 10;
+            if (value % 10 != 0) out << '.' << value % 10;
+        }
+    }
+    out << "]}";
+}
+
+const char *phaseName(SleepPhaseType type) {
+    switch (type) {
+        case SleepPhaseType::Awake:
+            return "Awake";
+        case SleepPhaseType::Light:
+            return "Light";
+        case SleepPhaseType::Deep:
+            return "Deep";
+        default:
+            return "REM";
+    }
+}
+
+} // namespace
+
+void SyntheticHistory::generate(const SyntheticHistoryOptions &options, std::size_t user,
+                                const NightCallback &onNight) {
+    std::mt19937 rng(options.seed + static_cast<std::uint32_t>(user) * 7919u);
+    std::mt19937 signalRng(options.seed * 31u + static_cast<std::uint32_t>(user));
+    std::uniform_int_distribution<int> phaseCount(options.minPhases, options.maxPhases);
+    std::uniform_int_distribution<int> phaseSeconds(options.minPhaseSeconds, options.maxPhaseSeconds);
+    std::uniform_int_distribution<int> bedtimeSeconds(22 * 3600, 25 * 3600);
+    std::bernoulli_distribution awake(options.awakeningRate);
+    std::discrete_distribution<int> sleepType({55.0, 25.0, 20.0}); // Light, Deep, REM
+
+    const SleepPhaseType sleepTypes[] = {SleepPhaseType::Light, SleepPhaseType::Deep, SleepPhaseType::REM};
+
+    DailySleepData night;
+    for (std::size_t n = 0; n < options.nights; ++n) {
+        const std::int64_t day = options.firstDay + static_cast<std::int64_t>(n) % kDatesPeriod;
+        night.date = fromLocalSeconds(day * 86400);
+        night.bedtime = fromLocalSeconds(day * 86400 + bedtimeSeconds(rng));
+        night.phases.clear();
+
+        DateTime t = night.bedtime;
+        for (int p = phaseCount(rng); p > 0; --p) {
+            const SleepPhaseType type = awake(rng) ? SleepPhaseType::Awake : sleepTypes[sleepType(rng)];
+            const DateTime end = t + std::chrono::seconds(phaseSeconds(rng));
+            night.phases.push_back({type, t, end});
+            t = end;
+        }
+        night.wakeTime = t;
+        if (options.signalInterval > 0) {
+            generateSignals(night, options.signalInterval, signalRng);
+        }
+        onNight(night);
+    }
+}
+
+std::vector<DailySleepData> SyntheticHistory::generate(const SyntheticHistoryOptions &options, std::size_t user) {
+    std::vector<DailySleepData> history;
+    history.reserve(options.nights);
+    generate(options, user, [&history](const DailySleepData &night) {
+        history.push_back(night);
+    });
+    return history;
+}
+
+void SyntheticHistory::writeJson(std::ostream &out, const SyntheticHistoryOptions &options, std::size_t user) {
+    char date[16], start[32], end[32];
+    std::vector<SignalSample> samples;
+    bool firstNight = true;
+    out << '[';
+    generate(options, user, [&](const DailySleepData &night) {
+        formatLocal(date, sizeof(date), night.date, false);
+        formatLocal(start, sizeof(start), night.bedtime, true);
+        formatLocal(end, sizeof(end), night.wakeTime, true);
+        out << (firstNight ? "" : ",") << R"({"date":")" << date << R"(","bedtime":")" << start
+            << R"(","wake_time":")" << end << R"(","phases":[)";
+        firstNight = false;
+
+        for (std::size_t p = 0; p < night.phases.size(); ++p) {
+            const SleepPhase &phase = night.phases[p];
+            formatLocal(start, sizeof(start), phase.start, true);
+            formatLocal(end, sizeof(end), phase.end, true);
+            out << (p ? "," : "") << R"({"type":")" << phaseName(phase.type) << R"(","start":")" << start
+                << R"(","end":")" << end << R"("})";
+        }
+        out << ']';
+        if (!night.signal(SleepSignalType::HeartRate).empty()) {
+            writeSignal(out, "heart_rate", night.signal(SleepSignalType::HeartRate), samples);
+        }
+        if (!night.signal(SleepSignalType::Respiration).empty()) {
+            writeSignal(out, "respiration", night.signal(SleepSignalType::Respiration), samples);
+        }
+        out << '}';
+    });
+    out << ']';
+}
+
+std::vector<std::string> SyntheticHistory::writeUsers(const std::string &directory,
+                                                      const SyntheticHistoryOptions &options) {
+    std::filesystem::create_directories(directory);
+    std::vector<std::string> paths;
+    paths.reserve(options.users);
+    for (std::size_t user = 0; user < options.users; ++user) {
+        const std::string path = (std::filesystem::path(directory) / ("user_" + std::to_string(user) + ".json"))
+                .string();
+        std::ofstream ofs(path, std::ios::binary);
+        if (!ofs.is_open()) {
+            throw std::runtime_error("unable to create file: " + path);
+        }
+        writeJson(ofs, options, user);
+        paths.push_back(path);
+    }
+    return paths;
+}
@@ -0,0 +1,76 @@
+/**
+ * @file SyntheticHistory.h
+ * @brief Генератор воспроизводимых синтетических историй сна для замеров.
+ */
+#ifndef SLEEP_VISUALIZER_SYNTHETICHISTORY_H
+#define SLEEP_VISUALIZER_SYNTHETICHISTORY_H
+
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "DataLoader.h"
+
+/**
+ * @brief Параметры генерации.
+ */
+struct SyntheticHistoryOptions {
+    std::uint32_t seed = 1;          ///< Зерно генератора; одинаковые параметры дают одинаковые истории
+    std::size_t nights = 365;        ///< Количество ночей у каждого пользователя
+    std::size_t users = 1;           ///< Количество пользователей
+    int minPhases = 4;               ///< Минимальное количество фаз за ночь
+    int maxPhases = 12;              ///< Максимальное количество фаз за ночь
+    double awakeningRate = 0.1;      ///< Вероятность того, что очередная фаза - бодрствование
+    int minPhaseSeconds = 5 * 60;    ///< Минимальная длительность фазы, с
+    int maxPhaseSeconds = 60 * 60;   ///< Максимальная длительность фазы, с
+    std::int64_t firstDay = 18262;   ///< Дата первой ночи, дни от эпохи (по умолчанию 2020-01-01)
+    int signalInterval = 0;          ///< Шаг рядов пульса и дыхания, с; 0 - ночи без рядов
+};
+
+/**
+ * @brief Генератор синтетических историй сна.
+ *
+ * Ночи начинаются между 22:00 и 01:00 по местному времени, фазы идут подряд без пропусков, длительности
+ * не кратны минуте. Поскольку DateTime хранит наносекунды и покрывает только ~292 года, даты
+ * повторяются каждые 100 лет: историю в миллион ночей можно сгенерировать, но даты в ней не уникальны.
+ * Ряды пульса и дыхания генерируются отдельным генератором, поэтому фазы от них не зависят: пульс
+ * и дыхание плавно стремятся к уровню текущей фазы, изредка датчик пропускает отсчёт.
+ * Объекты этого класса создавать нельзя.
+ */
+class SyntheticHistory {
+public:
+    using NightCallback = std::function<void(const DailySleepData &)>;
+
+    SyntheticHistory() = delete;
+
+    /**
+     * @brief Генерирует ночи пользователя по одной, не храня историю целиком.
+     *
+     * @param options Параметры генерации.
+     * @param user Номер пользователя, от 0 до options.users - 1.
+     * @param onNight Обработчик очередной ночи.
+     */
+    static void generate(const SyntheticHistoryOptions &options, std::size_t user, const NightCallback &onNight);
+
+    /**
+     * @brief Генерирует историю пользователя в памяти.
+     */
+    static std::vector<DailySleepData> generate(const SyntheticHistoryOptions &options, std::size_t user = 0);
+
+    /**
+     * @brief Записывает историю пользователя в формате, который читает DataLoader.
+     */
+    static void writeJson(std::ostream &out, const SyntheticHistoryOptions &options, std::size_t user = 0);
+
+    /**
+     * @brief Записывает истории всех пользователей в каталог, по файлу user_N.json на пользователя.
+     *
+     * @return Пути к записанным файлам.
+     *
+     * @throws std::runtime_error Если файл невозможно создать.
+     */
+    static std::vector<std::string> writeUsers(const std::string &directory, const SyntheticHistoryOptions &options);
+};
+
+#endif //SLEEP_VISUALIZER_SYNTHETICHISTORY_H
@@ -0,0 +1,70 @@
+#include "Benchmark.h"
+#include "CalendarHeatmap.h"
+#include "SleepPhaseStore.h"
+#include "SyntheticHistory.h"
+#include "TimelinePyramid.h"
+#include <algorithm>
+#include <array>
+#include <thread>
+
+void runTimelineBenchmarks() {
+    // два года ночей из сотен коротких фаз
+    SyntheticHistoryOptions options;
+    options.seed = 41;
+    options.nights = 730;
+    options.minPhases = 200;
+    options.maxPhases = 400;
+    options.minPhaseSeconds = 30;
+    options.maxPhaseSeconds = 120;
+    SleepPhaseStore store;
+    SyntheticHistory::generate(options, 0, [&](const DailySleepData &day) { store.append(day); });
+    const SleepPhaseColumns history = store.columns();
+
+    TimelinePyramid timeline;
+    runBenchmark("TimelinePyramid::build", history.phaseCount(), [&] {
+        timeline.build(history);
+        doNotOptimize(timeline.levelCount());
+    });
+    std::printf("  %zu phases, %zu levels\n", timeline.phaseCount(), timeline.levelCount());
+
+    // окно графика шириной 1280 пикселей при разных масштабах
+    constexpr std::size_t pixels = 1280;
+    struct Zoom {
+        const char *name;
+        double seconds;
+    };
+    constexpr Zoom zooms[] = {
+            {"all",   0.0},
+            {"month", 30 * 86400.0},
+            {"week",  7 * 86400.0},
+            {"night", 10 * 3600.0},
+            {"hour",  3600.0}
+    };
+    std::array<PhaseSegmentSeries, TimelinePyramid::kPhaseCount> series;
+    constexpr int frames = 1'000;
+    for (const auto &zoom: zooms) {
+        const double width = zoom.seconds > 0.0 ? zoom.seconds : timeline.endTime() - timeline.startTime();
+        // середина истории; первая ночь начинается в startTime(), поэтому через 4 часа после начала суток идёт сон
+        const double center = timeline.startTime() + 365 * 86400.0 + 4 * 3600.0;
+        std::size_t level = 0, points = 0;
+        runBenchmark(std::string("TimelinePyramid::visibleSegments ") + zoom.name, frames, [&] {
+            for (int i = 0; i < frames; ++i) {
+                // панорамирование: окно ходит вокруг середины истории на ±5% своей ширины
+                const double xMin = center - width / 2.0 + (i % 100 - 50) * width / 1000.0;
+                level = timeline.visibleSegments(xMin, xMin + width, pixels, series);
+            }
+            points = 0;
+            for (const auto &s: series) points += s.xs.size();
+            doNotOptimize(points);
+        });
+        std::printf("  level %zu, %zu points\n", level, points);
+    }
+
+    WorkStealingPool pool(std::max(1u, std::thread::hardware_concurrency()));
+    CalendarHeatmap calendar;
+    runBenchmark("CalendarHeatmap::build", history.nightCount(), [&] {
+        calendar.build(history, pool);
+        doNotOptimize(calendar.columns());
+    });
+    std::printf("  %zu nights, %d weeks\n", calendar.nights().size(), calendar.columns());
+}
@@ -0,0 +1,35 @@
+#include "Benchmark.h"
+#include "Trace.h"
+#include <cstdio>
+#include <vector>
+
+void runTraceBenchmarks() {
+    constexpr std::size_t scopeCount = 1'000'000;
+
+    // TraceScope используется напрямую, чтобы замер не зависел от SLEEP_TRACE_ENABLED
+    runBenchmark("TraceScope record", scopeCount, [&] {
+        for (std::size_t i = 0; i < scopeCount; ++i) {
+            const TraceScope scope("bench");
+        }
+    });
+
+    runBenchmark("Trace::nowNs", scopeCount, [&] {
+        for (std::size_t i = 0; i < scopeCount; ++i) {
+            doNotOptimize(Trace::nowNs());
+        }
+    });
+
+    std::vector<TraceEvent> events;
+    runBenchmark("Trace::collect full buffer", Trace::kBufferCapacity, [&] {
+        events = Trace::collect();
+        doNotOptimize(events);
+    });
+
+    runBenchmark("Trace::summarize", events.size(), [&] {
+        const std::vector<TraceScopeStats> stats = Trace::summarize(events);
+        doNotOptimize(stats);
+    });
+    if (!Trace::kCompiledIn) {
+        std::printf("  trace points are compiled out in this build (SLEEP_VISUALIZER_TRACING=OFF)\n");
+    }
+}
@@ -0,0 +1,188 @@
+/**
+ * @file
+ * @brief Запуск замеров производительности загрузки и анализа данных о сне.
+ *
+ * Использование: sleep_bench [--filter NAME] [--json FILE] [--baseline FILE] [--threshold PERCENT]
+ *                sleep_bench --generate DIR [--users N] [--nights N] [--seed N] [--min-phases N]
+ *                            [--max-phases N] [--awakening-rate P] [--signal-interval SECONDS]
+ *
+ * --filter запускает только группы замеров, в названии которых есть NAME; --json сохраняет результаты,
+ * --baseline сравнивает их с результатами другой сборки. Если какой-либо замер медленнее базового
+ * больше чем на --threshold процентов (по умолчанию 10) или не прошла проверка замера (например, установившийся
+ * кадр выделяет память), программа завершается с кодом 1.
+ *
+ * --generate вместо замеров записывает синтетические истории в каталог DIR, по файлу на пользователя;
+ * --signal-interval добавляет в ночи ряды пульса и дыхания с заданным шагом.
+ */
+#include <cstdio>
+#include <exception>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include "BenchmarkReport.h"
+#include "SyntheticHistory.h"
+
+void runDateTimeParserBenchmarks();
+
+void runDirectoryLoadBenchmarks();
+
+void runPhaseAggregationBenchmarks();
+
+void runMetricsIndexBenchmarks();
+
+void runAnalysisBenchmarks();
+
+void runFrameBenchmarks();
+
+void runTimelineBenchmarks();
+
+void runTraceBenchmarks();
+
+void runSignalBenchmarks();
+
+void runMetricsCacheBenchmarks();
+
+void runExportBenchmarks();
+
+namespace {
+
+struct BenchmarkGroup {
+    const char *name;
+    void (*run)();
+};
+
+constexpr BenchmarkGroup kGroups[] = {
+        {"datetime",    runDateTimeParserBenchmarks},
+        {"directory",   runDirectoryLoadBenchmarks},
+        {"aggregation", runPhaseAggregationBenchmarks},
+        {"index",       runMetricsIndexBenchmarks},
+        {"analysis",    runAnalysisBenchmarks},
+        {"frame",       runFrameBenchmarks},
+        {"timeline",    runTimelineBenchmarks},
+        {"trace",       runTraceBenchmarks},
+        {"signal",      runSignalBenchmarks},
+        {"cache",       runMetricsCacheBenchmarks},
+        {"export",      runExportBenchmarks}
+};
+
+void printUsage() {
+    std::fputs("usage: sleep_bench [--filter NAME] [--json FILE] [--baseline FILE] [--threshold PERCENT]\n"
+               "       sleep_bench --generate DIR [--users N] [--nights N] [--seed N] [--min-phases N]\n"
+               "                   [--max-phases N] [--awakening-rate P] [--signal-interval SECONDS]\n", stderr);
+}
+
+/**
+ * Разбирает числовое значение параметра целиком, как std::stoul/std::stoi/std::stod.
+ *
+ * @throws std::invalid_argument Если значение не число, содержит лишние символы или не помещается в тип.
+ */
+template<typename T, typename Convert>
+T parseNumber(const std::string &option, const std::string &value, Convert convert) {
+    std::size_t parsed = 0;
+    T number{};
+    try {
+        number = convert(value, &parsed);
+    } catch (const std::exception &) {
+        parsed = 0;
+    }
+    if (parsed == 0 || parsed != value.size() || (std::is_unsigned_v<T> && value.find('-') != std::string::npos)) {
+        throw std::invalid_argument("invalid value for " + option + ": " + value);
+    }
+    return number;
+}
+
+unsigned long parseUnsigned(const std::string &option, const std::string &value) {
+    return parseNumber<unsigned long>(option, value,
+                                      [](const std::string &s, std::size_t *parsed) { return std::stoul(s, parsed); });
+}
+
+int parseInt(const std::string &option, const std::string &value) {
+    return parseNumber<int>(option, value,
+                            [](const std::string &s, std::size_t *parsed) { return std::stoi(s, parsed); });
+}
+
+double parseDouble(const std::string &option, const std::string &value) {
+    return parseNumber<double>(option, value,
+                               [](const std::string &s, std::size_t *parsed) { return std::stod(s, parsed); });
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    std::string filter, jsonFile, baselineFile, generateDirectory;
+    double threshold = 10.0;
+    SyntheticHistoryOptions generateOptions;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg = argv[i];
+            if (i + 1 >= argc) throw std::invalid_argument("missing value for " + arg);
+            const std::string value = argv[++i];
+            if (arg == "--filter") {
+                filter = value;
+            } else if (arg == "--json") {
+                jsonFile = value;
+            } else if (arg == "--baseline") {
+                baselineFile = value;
+            } else if (arg == "--threshold") {
+                threshold = parseDouble(arg, value);
+            } else if (arg == "--generate") {
+                generateDirectory = value;
+            } else if (arg == "--users") {
+                generateOptions.users = parseUnsigned(arg, value);
+            } else if (arg == "--nights") {
+                generateOptions.nights = parseUnsigned(arg, value);
+            } else if (arg == "--seed") {
+                generateOptions.seed = static_cast<std::uint32_t>(parseUnsigned(arg, value));
+            } else if (arg == "--min-phases") {
+                generateOptions.minPhases = parseInt(arg, value);
+            } else if (arg == "--max-phases") {
+                generateOptions.maxPhases = parseInt(arg, value);
+            } else if (arg == "--awakening-rate") {
+                generateOptions.awakeningRate = parseDouble(arg, value);
+            } else if (arg == "--signal-interval") {
+                generateOptions.signalInterval = parseInt(arg, value);
+            } else {
+                throw std::invalid_argument("unknown option: " + arg);
+            }
+        }
+    } catch (const std::exception &e) {
+        std::fprintf(stderr, "error: %s\n", e.what());
+        printUsage();
+        return 2;
+    }
+
+    if (!generateDirectory.empty()) {
+        try {
+            const auto paths = SyntheticHistory::writeUsers(generateDirectory, generateOptions);
+            std::printf("wrote %zu files to %s\n", paths.size(), generateDirectory.c_str());
+        } catch (const std::exception &e) {
+            std::fprintf(stderr, "error: %s\n", e.what());
+            return 1;
+        }
+        return 0;
+    }
+
+    for (const auto &group: kGroups) {
+        if (filter.empty() || std::string(group.name).find(filter) != std::string::npos) {
+            group.run();
+        }
+    }
+
+    for (const auto &failure: benchmarkFailures()) {
+        std::fprintf(stderr, "failed: %s\n", failure.c_str());
+    }
+
+    try {
+        if (!jsonFile.empty()) {
+            BenchmarkReport::writeJson(jsonFile, benchmarkResults());
+        }
+        if (!baselineFile.empty() &&
+            BenchmarkReport::compareWithBaseline(baselineFile, benchmarkResults(), threshold) > 0) {
+            return 1;
+        }
+    } catch (const std::exception &e) {
+        std::fprintf(stderr, "error: %s\n", e.what());
+        return 1;
+    }
+    return benchmarkFailures().empty() ? 0 : 1;
+}
@@ -0,0 +1,147 @@
+#include "CalendarHeatmap.h"
+#include "DateTimeParser.h"
+#include "SleepAnalyzer.h"
+#include <algorithm>
+#include <chrono>
+#include <format>
+
+namespace {
+
+/// Количество ночей в одной задаче расчёта метрик
+constexpr std::size_t kNightsPerTask = 1024;
+
+/// Календарь длиннее этого количества недель подписывается по годам, а не по месяцам
+constexpr int kMonthLabelColumns = 60;
+
+/**
+ * День недели, начиная с понедельника (0) по воскресенье (6); 1970-01-01 - четверг.
+ */
+int weekdayIndex(std::int64_t day) {
+    return static_cast<int>(((day + 3) % 7 + 7) % 7);
+}
+
+} // namespace
+
+void CalendarHeatmap::build(const SleepPhaseColumns &history, WorkStealingPool &pool) {
+    const std::size_t nightCount = history.nightCount();
+    std::vector<SleepMetrics> metrics(nightCount);
+    const std::span<SleepMetrics> out(metrics);
+    pool.parallelFor((nightCount + kNightsPerTask - 1) / kNightsPerTask, [&](std::size_t task) {
+        const std::size_t first = task * kNightsPerTask;
+        const std::size_t count = std::min(kNightsPerTask, nightCount - first);
+        SleepAnalyzer::CalculateBatchMetrics(history.slice(first, count), out.subspan(first, count));
+    });
+
+    nights_.resize(nightCount);
+    for (std::size_t i = 0; i < nightCount; ++i) {
+        const SleepMetrics &m = metrics[i];
+        nights_[i] = {static_cast<std::int32_t>(DateTimeParser::localDayNumber(history.dates[i])),
+                      {static_cast<float>(m.efficiency), static_cast<float>(m.totalSleepTime / 60.0),
+                       static_cast<float>(m.deepSleepPercent)}};
+    }
+
+    // при совпадении дат остаётся ночь, загруженная последней
+    std::stable_sort(nights_.begin(), nights_.end(),
+                     [](const CalendarNight &a, const CalendarNight &b) { return a.day < b.day; });
+    std::size_t kept = 0;
+    for (std::size_t i = 0; i < nights_.size(); ++i) {
+        if (kept > 0 && nights_[kept - 1].day == nights_[i].day) {
+            nights_[kept - 1] = nights_[i];
+        } else {
+            nights_[kept++] = nights_[i];
+        }
+    }
+    nights_.resize(kept);
+    nights_.shrink_to_fit();
+
+    buildGrids();
+    buildPeriodTicks();
+}
+
+void CalendarHeatmap::buildGrids() {
+    cellNights_.clear();
+    for (auto &grid: grids_) grid.clear();
+    min_.fill(0.0f);
+    max_.fill(0.0f);
+    columns_ = 0;
+    firstDay_ = 0;
+    if (nights_.empty()) return;
+
+    firstDay_ = nights_.front().day - weekdayIndex(nights_.front().day);
+    columns_ = static_cast<int>((nights_.back().day - firstDay_) / 7 + 1);
+    const std::size_t cells = static_cast<std::size_t>(kRows) * static_cast<std::size_t>(columns_);
+
+    cellNights_.assign(cells, -1);
+    for (std::size_t i = 0; i < nights_.size(); ++i) {
+        const std::int64_t offset = nights_[i].day - firstDay_;
+        const auto cell = static_cast<std::size_t>(offset % 7 * columns_ + offset / 7);
+        cellNights_[cell] = static_cast<std::int32_t>(i);
+    }
+
+    for (std::size_t k = 0; k < kMetricCount; ++k) {
+        const auto [minIt, maxIt] = std::minmax_element(
+                nights_.begin(), nights_.end(),
+                [k](const CalendarNight &a, const CalendarNight &b) { return a.values[k] < b.values[k]; });
+        min_[k] = minIt->values[k];
+        max_[k] = maxIt->values[k];
+
+        grids_[k].resize(cells);
+        for (std::size_t cell = 0; cell < cells; ++cell) {
+            const std::int32_t night = cellNights_[cell];
+            grids_[k][cell] = night < 0 ? kEmptyCell : nights_[static_cast<std::size_t>(night)].values[k];
+        }
+    }
+}
+
+void CalendarHeatmap::buildPeriodTicks() {
+    periodTicks_.clear();
+    periodLabels_.clear();
+    periodLabelPtrs_.clear();
+    if (nights_.empty()) return;
+
+    const bool byYear = columns_ > kMonthLabelColumns;
+    const std::int64_t lastDay = firstDay_ + static_cast<std::int64_t>(columns_) * 7;
+    for (std::int64_t day = firstDay_; day < lastDay; ++day) {
+        const std::chrono::year_month_day date{std::chrono::sys_days{std::chrono::days{day}}};
+        const bool periodStart = date.day() == std::chrono::day{1} &&
+                                 (!byYear || date.month() == std::chrono::January);
+        if (!periodStart && day != firstDay_) continue;
+
+        const double tick = static_cast<double>((day - firstDay_) / 7) + 0.5;
+        const int year = static_cast<int>(date.year());
+        const unsigned month = static_cast<unsigned>(date.month());
+        std::string label = byYear ? std::format("{}", year) : std::format("{}-{:02}", year, month);
+        // начало периода в первом столбце заменяет подпись первого дня
+        if (!periodTicks_.empty() && periodTicks_.back() == tick) {
+            periodLabels_.back() = std::move(label);
+        } else {
+            periodTicks_.push_back(tick);
+            periodLabels_.push_back(std::move(label));
+        }
+    }
+    for (const auto &label: periodLabels_) {
+        periodLabelPtrs_.push_back(label.c_str());
+    }
+}
+
+const CalendarNight *CalendarHeatmap::nightAt(int row, int column) const {
+    if (row < 0 || row >= kRows || column < 0 || column >= columns_) return nullptr;
+    const std::int32_t night = cellNights_[static_cast<std::size_t>(row) * columns_ + column];
+    return night < 0 ? nullptr : &nights_[static_cast<std::size_t>(night)];
+}
+
+const char *CalendarHeatmap::metricName(CalendarMetric metric) {
+    switch (metric) {
+        case CalendarMetric::Efficiency:
+            return "Эффективность, %";
+        case CalendarMetric::TotalSleep:
+            return "Общее время сна, ч.";
+        case CalendarMetric::DeepShare:
+            return "Доля глубокого сна, %";
+    }
+    return "";
+}
+
+const char *CalendarHeatmap::metricFormat(CalendarMetric metric) {
+    return metric == CalendarMetric::TotalSleep ? "%.1f" : "%.0f";
+}
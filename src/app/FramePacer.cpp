@@ -0,0 +1,71 @@
+#include "FramePacer.h"
+#include "GLFW/glfw3.h"
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+FramePacer::FramePacer(FramePacerOptions options) : options_(options) {
+    startTime_ = glfwGetTime();
+    startCpu_ = std::clock();
+    nextFrameTime_ = startTime_;
+}
+
+void FramePacer::onInput(GLFWwindow *window) {
+    if (auto *pacer = static_cast<FramePacer *>(glfwGetWindowUserPointer(window))) {
+        pacer->inputReceived_ = true;
+    }
+}
+
+void FramePacer::attach(GLFWwindow *window) {
+    glfwSetWindowUserPointer(window, this);
+    glfwSetKeyCallback(window, [](GLFWwindow *w, int, int, int, int) { onInput(w); });
+    glfwSetCharCallback(window, [](GLFWwindow *w, unsigned int) { onInput(w); });
+    glfwSetMouseButtonCallback(window, [](GLFWwindow *w, int, int, int) { onInput(w); });
+    glfwSetCursorPosCallback(window, [](GLFWwindow *w, double, double) { onInput(w); });
+    glfwSetCursorEnterCallback(window, [](GLFWwindow *w, int) { onInput(w); });
+    glfwSetScrollCallback(window, [](GLFWwindow *w, double, double) { onInput(w); });
+    glfwSetWindowFocusCallback(window, [](GLFWwindow *w, int) { onInput(w); });
+    glfwSetWindowSizeCallback(window, [](GLFWwindow *w, int, int) { onInput(w); });
+    glfwSetWindowRefreshCallback(window, [](GLFWwindow *w) { onInput(w); });
+}
+
+void FramePacer::waitForFrame() {
+    if (options_.idle && pendingFrames_ == 0 && !frameRequested_.load(std::memory_order_acquire)) {
+        // кадр после таймаута всё равно рисуется: ожидание не должно длиться бесконечно
+        glfwWaitEventsTimeout(options_.idleTimeout);
+    } else {
+        glfwPollEvents();
+    }
+
+    if (inputReceived_ || frameRequested_.exchange(false, std::memory_order_acq_rel)) {
+        pendingFrames_ = std::max(pendingFrames_, options_.settleFrames);
+        inputReceived_ = false;
+    }
+
+    if (options_.maxFps > 0) {
+        const double now = glfwGetTime();
+        if (nextFrameTime_ > now) {
+            std::this_thread::sleep_for(std::chrono::duration<double>(nextFrameTime_ - now));
+        }
+        nextFrameTime_ = std::max(now, nextFrameTime_) + 1.0 / options_.maxFps;
+    }
+}
+
+void FramePacer::frameRendered(bool animating) {
+    ++frames_;
+    if (pendingFrames_ > 0) --pendingFrames_;
+    if (animating) pendingFrames_ = std::max(pendingFrames_, 1);
+}
+
+void FramePacer::requestFrame() {
+    frameRequested_.store(true, std::memory_order_release);
+    glfwPostEmptyEvent();
+}
+
+FramePacerStats FramePacer::stats() const {
+    FramePacerStats stats;
+    stats.frames = frames_;
+    stats.seconds = glfwGetTime() - startTime_;
+    stats.cpuSeconds = static_cast<double>(std::clock() - startCpu_) / CLOCKS_PER_SEC;
+    return stats;
+}
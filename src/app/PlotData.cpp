@@ -0,0 +1,259 @@
+#include "PlotData.h"
+#include "DateUtils.h"
+#include "Trace.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+constexpr PhaseVisualInfo kPhasesInfo[] = {
+        {1.0, "Awake"},
+        {2.0, "Light"},
+        {3.0, "Deep"},
+        {4.0, "REM"}
+};
+
+constexpr PhaseVisualInfo kUnknownPhaseInfo = {0.0, "Unknown"};
+
+/**
+ * Общая реализация для вектора фаз и для представления ночи из поколоночного хранилища.
+ */
+template<typename Phases>
+DailyPhasesPlotData dailyPhases(const DateTime &bedtime, const DateTime &wakeTime, const Phases &phases) {
+    DailyPhasesPlotData data;
+    data.startTime = DateUtils::timePointToUnix(bedtime);
+    data.endTime = DateUtils::timePointToUnix(wakeTime);
+    if (phases.empty()) return data;
+
+    data.xTicks.reserve(phases.size() + 1);
+    data.segments.reserve(phases.size());
+    data.xTicks.push_back(DateUtils::timePointToUnix(phases[0].start));
+    for (const auto &phase: phases) {
+        const double xEnd = DateUtils::timePointToUnix(phase.end);
+        data.xTicks.push_back(xEnd);
+        data.segments.push_back({DateUtils::timePointToUnix(phase.start), xEnd, PlotData::PhaseInfo(phase.type)});
+    }
+    return data;
+}
+
+} // namespace
+
+std::span<const PhaseVisualInfo> PlotData::PhasesInfo() {
+    return kPhasesInfo;
+}
+
+std::size_t PlotData::PhaseIndex(SleepPhaseType type) {
+    switch (type) {
+        case SleepPhaseType::Awake:
+            return 0;
+        case SleepPhaseType::Light:
+            return 1;
+        case SleepPhaseType::Deep:
+            return 2;
+        case SleepPhaseType::REM:
+            return 3;
+        default:
+            return std::size(kPhasesInfo);
+    }
+}
+
+const PhaseVisualInfo &PlotData::PhaseInfo(SleepPhaseType type) {
+    const std::size_t index = PhaseIndex(type);
+    return index < std::size(kPhasesInfo) ? kPhasesInfo[index] : kUnknownPhaseInfo;
+}
+
+DailyPhasesPlotData PlotData::DailyPhases(const DailySleepData &data) {
+    return dailyPhases(data.bedtime, data.wakeTime, data.phases);
+}
+
+DailyPhasesPlotData PlotData::DailyPhases(const SleepNightView &night) {
+    return dailyPhases(night.bedtime, night.wakeTime, night);
+}
+
+MetricsSummaryPlotData PlotData::MetricsSummary(const SleepMetrics &m) {
+    MetricsSummaryPlotData data;
+    data.labels = {"Light", "Deep", "REM"};
+    data.minutes = {static_cast<double>(m.lightSleepDuration), static_cast<double>(m.deepSleepDuration),
+                    static_cast<double>(m.remSleepDuration)};
+    data.percentages = {m.lightSleepPercent, m.deepSleepPercent, m.remSleepPercent};
+    for (std::size_t i = 0; i < MetricsSummaryPlotData::kPhaseCount; ++i) {
+        data.indices[i] = static_cast<double>(i);
+    }
+    return data;
+}
+
+bool DailyPhasesPlotCache::update(const DailySleepData &data) {
+    const DateTime lastPhaseEnd = data.phases.empty() ? DateTime{} : data.phases.back().end;
+    return updateFrom(Key{data.phases.data(), data.phases.size(), data.date, data.bedtime, data.wakeTime,
+                          lastPhaseEnd}, data.phases);
+}
+
+bool DailyPhasesPlotCache::update(const SleepNightView &night) {
+    const DateTime lastPhaseEnd = night.empty() ? DateTime{} : night[night.size() - 1].end;
+    return updateFrom(Key{night.types.data(), night.size(), night.date, night.bedtime, night.wakeTime,
+                          lastPhaseEnd}, night);
+}
+
+template<typename Phases>
+bool DailyPhasesPlotCache::updateFrom(const Key &key, const Phases &phases) {
+    if (valid_ && key == key_) return false;
+
+    SLEEP_TRACE_SCOPE("DailyPhasesPlotCache::rebuild");
+    rebuild(key, phases);
+    key_ = key;
+    valid_ = true;
+    ++rebuildCount_;
+    return true;
+}
+
+template<typename Phases>
+void DailyPhasesPlotCache::rebuild(const Key &key, const Phases &phases) {
+    phaseCount_ = phases.size();
+    DateUtils::onlyDate(key.date, title_);
+    startTime_ = DateUtils::timePointToUnix(key.bedtime);
+    endTime_ = DateUtils::timePointToUnix(key.wakeTime);
+
+    const auto phasesInfo = PlotData::PhasesInfo();
+    for (std::size_t i = 0; i < kYTickCount; ++i) {
+        yTicks_[i] = phasesInfo[i].yLevel;
+        yTickLabels_[i] = phasesInfo[i].name;
+    }
+    for (std::size_t i = 0; i < series_.size(); ++i) {
+        series_[i].info = i < phasesInfo.size() ? phasesInfo[i] : kUnknownPhaseInfo;
+        series_[i].colorIndex = static_cast<int>(i);
+        series_[i].xs.clear();
+        series_[i].ys.clear();
+    }
+
+    xTicks_.clear();
+    xTickLabels_.clear();
+    if (phases.empty()) return;
+
+    auto addTick = [this](const DateTime &time) {
+        xTicks_.push_back(DateUtils::timePointToUnix(time));
+        xTickLabels_.push_back(DateUtils::timeLabel(time));
+    };
+
+    xTicks_.reserve(phases.size() + 1);
+    xTickLabels_.reserve(phases.size() + 1);
+    addTick(phases[0].start);
+    for (const auto &phase: phases) {
+        auto &series = series_[PlotData::PhaseIndex(phase.type)];
+        const double xStart = DateUtils::timePointToUnix(phase.start);
+        const double xEnd = DateUtils::timePointToUnix(phase.end);
+        series.xs.push_back(xStart);
+        series.xs.push_back(xEnd);
+        series.ys.push_back(series.info.yLevel);
+        series.ys.push_back(series.info.yLevel);
+        addTick(phase.end);
+    }
+}
+
+bool MetricsSummaryPlotCache::update(const SleepMetrics &m) {
+    if (valid_ && m == metrics_) return false;
+
+    SLEEP_TRACE_SCOPE("MetricsSummaryPlotCache::rebuild");
+    metrics_ = m;
+    data_ = PlotData::MetricsSummary(m);
+    for (std::size_t i = 0; i < durations_.size(); ++i) {
+        DateUtils::formatTimeDiff(static_cast<int>(data_.minutes[i]), durations_[i]);
+    }
+    DateUtils::formatTimeDiff(m.timeInBed, timeInBed_);
+    DateUtils::formatTimeDiff(m.totalSleepTime, totalSleepTime_);
+    valid_ = true;
+    ++rebuildCount_;
+    return true;
+}
+
+bool NightSignalsPlotCache::update(const SleepNightView &night) {
+    Key key{{night.signals[0].encoded.data(), night.signals[1].encoded.data()},
+            {night.signals[0].count, night.signals[1].count},
+            night.bedtime, night.wakeTime, night.size()};
+    return updateFrom(key, night, night.signals);
+}
+
+bool NightSignalsPlotCache::update(const DailySleepData &day) {
+    const std::array<SleepSignalView, kSleepSignalCount> views = {day.signals[0].view(), day.signals[1].view()};
+    Key key{{views[0].encoded.data(), views[1].encoded.data()}, {views[0].count, views[1].count},
+            day.bedtime, day.wakeTime, day.phases.size()};
+    return updateFrom(key, day, views);
+}
+
+template<typename Night>
+bool NightSignalsPlotCache::updateFrom(const Key &key, const Night &night,
+                                       const std::array<SleepSignalView, kSleepSignalCount> &views) {
+    if (valid_ && key == key_) return false;
+
+    SLEEP_TRACE_SCOPE("NightSignalsPlotCache::rebuild");
+    startTime_ = DateUtils::timePointToUnix(key.bedtime);
+    endTime_ = DateUtils::timePointToUnix(key.wakeTime);
+    for (std::size_t s = 0; s < kSleepSignalCount; ++s) {
+        Signal &signal = signals_[s];
+        views[s].decode(signal.samples);
+        signal.start = DateUtils::timePointToUnix(views[s].start);
+        signal.interval = views[s].interval;
+        signal.decimatedValid = false;
+    }
+    stats_ = SignalAnalysis::AnalyzeNight(night, scratch_);
+
+    key_ = key;
+    valid_ = true;
+    ++rebuildCount_;
+    return true;
+}
+
+bool NightSignalsPlotCache::hasSignals() const {
+    return std::any_of(signals_.begin(), signals_.end(), [](const Signal &signal) {
+        return !signal.samples.empty();
+    });
+}
+
+const DecimatedSignal &NightSignalsPlotCache::decimate(SleepSignalType type, double xMin, double xMax,
+                                                       std::size_t maxPoints) {
+    Signal &signal = signals_[static_cast<std::size_t>(type)];
+    maxPoints = std::max<std::size_t>(maxPoints, 1);
+    if (signal.decimatedValid && signal.xMin == xMin && signal.xMax == xMax && signal.maxPoints == maxPoints) {
+        return signal.decimated;
+    }
+
+    SLEEP_TRACE_SCOPE("NightSignalsPlotCache::decimate");
+    DecimatedSignal &out = signal.decimated;
+    out.xs.clear();
+    out.means.clear();
+    out.mins.clear();
+    out.maxs.clear();
+
+    // видимый участок расширяется на отсчёт с каждой стороны, чтобы линия доходила до краёв графика
+    const auto sampleCount = static_cast<double>(signal.samples.size());
+    const double firstIndex = std::clamp(std::floor((xMin - signal.start) / signal.interval) - 1.0, 0.0, sampleCount);
+    const double lastIndex = std::clamp(std::ceil((xMax - signal.start) / signal.interval) + 2.0, firstIndex,
+                                        sampleCount);
+    const auto first = static_cast<std::size_t>(firstIndex);
+    const auto last = static_cast<std::size_t>(lastIndex);
+    const std::size_t width = (last - first + maxPoints - 1) / maxPoints;
+
+    if (width > 0) {
+        const std::size_t groups = (last - first + width - 1) / width;
+        out.xs.reserve(groups);
+        out.means.reserve(groups);
+        out.mins.reserve(groups);
+        out.maxs.reserve(groups);
+    }
+    const std::span<const SignalSample> samples(signal.samples);
+    constexpr double nan = std::numeric_limits<double>::quiet_NaN();
+    for (std::size_t lo = first; lo < last; lo += width) {
+        const std::size_t hi = std::min(last, lo + width);
+        const SignalSummary summary = SignalAnalysis::Summarize(samples.subspan(lo, hi - lo));
+        out.xs.push_back(signal.start + static_cast<double>(lo + hi - 1) * 0.5 * signal.interval);
+        out.means.push_back(summary.empty() ? nan : summary.mean());
+        out.mins.push_back(summary.empty() ? nan : summary.minValue());
+        out.maxs.push_back(summary.empty() ? nan : summary.maxValue());
+    }
+
+    signal.xMin = xMin;
+    signal.xMax = xMax;
+    signal.maxPoints = maxPoints;
+    signal.decimatedValid = true;
+    return out;
+}
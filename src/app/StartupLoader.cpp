@@ -0,0 +1,168 @@
+#include "StartupLoader.h"
+#include "../sleep_data_loader/DataLoader.h"
+#include "../sleep_data_loader/WorkStealingPool.h"
+#include "RecommendationRules.h"
+#include "Trace.h"
+#include <algorithm>
+#include <array>
+#include <iostream>
+#include <utility>
+
+namespace {
+
+/// Доля общего прогресса, с которой начинается каждый этап; последний элемент - готовность
+constexpr std::array<float, 6> kStageStart = {0.0f, 0.05f, 0.7f, 0.75f, 0.85f, 1.0f};
+
+/// Минимальное продвижение, о котором стоит будить поток отрисовки
+constexpr float kProgressStep = 0.01f;
+
+/// Исключение, которым обработчик суток прерывает разбор при остановке загрузчика
+struct LoadCancelled {
+};
+
+} // namespace
+
+StartupLoader::StartupLoader(std::string sourcePath, Clock::time_point startTime, ProgressCallback onProgress)
+        : sourcePath_(std::move(sourcePath)), startTime_(startTime), onProgress_(std::move(onProgress)) {
+    thread_ = std::thread([this] { run(); });
+}
+
+StartupLoader::~StartupLoader() {
+    stop_.store(true, std::memory_order_release);
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void StartupLoader::run() {
+    SLEEP_TRACE_THREAD_NAME("StartupLoader");
+    auto data = std::make_unique<AppData>();
+    bool snapshotStale;
+    try {
+        snapshotStale = loadHistory(*data);
+        analyze(*data);
+    } catch (const LoadCancelled &) {
+        return;
+    } catch (const std::exception &e) {
+        // иначе окно навсегда осталось бы на экране загрузки: публикуются пустые данные с текстом ошибки
+        std::cerr << "error processing data: " << e.what() << std::endl;
+        data = std::make_unique<AppData>();
+        data->error = e.what();
+        snapshotStale = false;
+    }
+
+    owned_ = std::move(data);
+    secondsToData_.store(std::chrono::duration<double>(Clock::now() - startTime_).count(),
+                         std::memory_order_release);
+    data_.store(owned_.get(), std::memory_order_release);
+    setProgress(StartupStage::Ready);
+
+    // снимок перестраивается уже после публикации: он нужен только следующему запуску
+    if (snapshotStale && !stop_.load(std::memory_order_acquire)) {
+        rebuildSnapshot(*owned_);
+    }
+}
+
+bool StartupLoader::loadHistory(AppData &data) {
+    setProgress(StartupStage::Opening);
+    try {
+        data.snapshot = SleepSnapshot::open(SleepSnapshot::pathFor(sourcePath_));
+        if (data.snapshot.isFreshFor(sourcePath_)) {
+            data.history = data.snapshot.columns();
+            return false;
+        }
+        data.snapshot = SleepSnapshot();
+    } catch (const std::exception &) {
+        // снимка нет или он повреждён: данные разбираются из исходного файла
+    }
+
+    setProgress(StartupStage::Parsing);
+    try {
+        DataLoader::streamFromJsonFile(
+                sourcePath_,
+                [this, &data](DailySleepData &&day) {
+                    if (stop_.load(std::memory_order_relaxed)) throw LoadCancelled{};
+                    data.store.append(day);
+                },
+                [this](std::uint64_t bytes, std::uint64_t totalBytes) {
+                    if (totalBytes > 0) {
+                        setProgress(StartupStage::Parsing,
+                                    static_cast<float>(static_cast<double>(bytes) / static_cast<double>(totalBytes)));
+                    }
+                });
+    } catch (const LoadCancelled &) {
+        throw;
+    } catch (const std::exception &e) {
+        std::cerr << "error loading data: " << e.what() << std::endl;
+        data.error = e.what();
+        data.store.clear();
+    }
+    data.history = data.store.columns();
+    return !data.store.empty();
+}
+
+void StartupLoader::analyze(AppData &data) {
+    const SleepPhaseColumns &history = data.history;
+
+    setProgress(StartupStage::Analyzing);
+    data.today = history.nightCount() > 0 ? history.night(0) : SleepNightView{};
+    data.week = history.slice(0, std::min<std::size_t>(7, history.nightCount()));
+    data.todayMetrics = SleepAnalyzer::CalculateDailyMetrics(data.today);
+    data.todayArchitecture = SleepAnalyzer::CalculateArchitecture(data.today);
+    data.weeklyMetrics = SleepAnalyzer::CalculateAverageMetrics(data.week);
+    data.recommendations = RecommendationRules::Defaults().evaluate(data.todayMetrics);
+
+    if (stop_.load(std::memory_order_acquire)) throw LoadCancelled{};
+    setProgress(StartupStage::Timeline);
+    {
+        SLEEP_TRACE_SCOPE("TimelinePyramid::build");
+        data.timeline.build(history);
+    }
+
+    if (stop_.load(std::memory_order_acquire)) throw LoadCancelled{};
+    setProgress(StartupStage::Calendar);
+    SLEEP_TRACE_SCOPE("CalendarHeatmap::build");
+    WorkStealingPool pool;
+    data.calendar.build(history, pool);
+}
+
+void StartupLoader::rebuildSnapshot(const AppData &data) {
+    SLEEP_TRACE_SCOPE("SleepSnapshot::write");
+    try {
+        SleepSnapshot::write(SleepSnapshot::pathFor(sourcePath_), data.history, SnapshotSource::of(sourcePath_));
+    } catch (const std::exception &e) {
+        std::cerr << "error writing snapshot: " << e.what() << std::endl;
+    }
+}
+
+void StartupLoader::setProgress(StartupStage stage, float stageFraction) {
+    const auto index = static_cast<std::size_t>(stage);
+    const float start = kStageStart[index];
+    const float end = index + 1 < kStageStart.size() ? kStageStart[index + 1] : 1.0f;
+    const float progress = start + (end - start) * std::clamp(stageFraction, 0.0f, 1.0f);
+
+    const bool stageChanged = stage_.exchange(stage, std::memory_order_relaxed) != stage;
+    progress_.store(progress, std::memory_order_relaxed);
+    if (stageChanged || progress - notifiedProgress_ >= kProgressStep) {
+        notifiedProgress_ = progress;
+        if (onProgress_) onProgress_();
+    }
+}
+
+const char *StartupLoader::stageName(StartupStage stage) {
+    switch (stage) {
+        case StartupStage::Opening:
+            return "Открытие снимка";
+        case StartupStage::Parsing:
+            return "Разбор данных";
+        case StartupStage::Analyzing:
+            return "Расчёт метрик";
+        case StartupStage::Timeline:
+            return "Построение таймлайна";
+        case StartupStage::Calendar:
+            return "Построение календаря";
+        case StartupStage::Ready:
+            return "Готово";
+    }
+    return "";
+}
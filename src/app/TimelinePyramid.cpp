@@ -0,0 +1,246 @@
+#include "TimelinePyramid.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace {
+
+std::int64_t floorDiv(std::int64_t value, std::int64_t divisor) {
+    const std::int64_t quotient = value / divisor;
+    return quotient * divisor > value ? quotient - 1 : quotient;
+}
+
+} // namespace
+
+void TimelinePyramid::clear() {
+    origin_ = end_ = 0;
+    starts_.clear();
+    ends_.clear();
+    maxEnds_.clear();
+    phases_.clear();
+    levels_.clear();
+}
+
+void TimelinePyramid::build(const SleepPhaseColumns &history) {
+    clear();
+
+    struct Phase {
+        std::int64_t start;
+        std::int64_t end;
+        std::uint8_t phase;
+    };
+    std::vector<Phase> phases;
+    phases.reserve(history.phaseCount());
+    for (std::size_t n = 0; n < history.nightCount(); ++n) {
+        for (std::uint32_t p = history.nightOffsets[n]; p < history.nightOffsets[n + 1]; ++p) {
+            const std::size_t index = PlotData::PhaseIndex(static_cast<SleepPhaseType>(history.types[p]));
+            if (index >= kPhaseCount || history.durations[p] <= 0) continue;
+            const std::int64_t start = history.bedtimes[n] + history.startOffsets[p];
+            phases.push_back({start, start + history.durations[p], static_cast<std::uint8_t>(index)});
+        }
+    }
+    if (phases.empty()) return;
+
+    // ночи в хранилище не обязательно упорядочены по дате
+    std::sort(phases.begin(), phases.end(), [](const Phase &a, const Phase &b) { return a.start < b.start; });
+
+    starts_.resize(phases.size());
+    ends_.resize(phases.size());
+    maxEnds_.resize(phases.size());
+    phases_.resize(phases.size());
+    std::int64_t maxEnd = phases.front().end;
+    for (std::size_t i = 0; i < phases.size(); ++i) {
+        starts_[i] = phases[i].start;
+        ends_[i] = phases[i].end;
+        phases_[i] = phases[i].phase;
+        maxEnd = std::max(maxEnd, phases[i].end);
+        maxEnds_[i] = maxEnd;
+    }
+    origin_ = floorDiv(starts_.front(), kBaseBucketSeconds) * kBaseBucketSeconds;
+    end_ = maxEnd;
+
+    // фаза раскладывается по всем интервалам, которые она задевает; пустые интервалы не хранятся
+    struct Chunk {
+        std::int64_t bucket;
+        std::uint8_t phase;
+        std::uint32_t seconds;
+    };
+    std::vector<Chunk> chunks;
+    chunks.reserve(phases.size());
+    for (const auto &phase: phases) {
+        for (std::int64_t t = phase.start; t < phase.end;) {
+            const std::int64_t bucket = (t - origin_) / kBaseBucketSeconds;
+            const std::int64_t chunkEnd = std::min(phase.end, origin_ + (bucket + 1) * kBaseBucketSeconds);
+            chunks.push_back({bucket, phase.phase, static_cast<std::uint32_t>(chunkEnd - t)});
+            t = chunkEnd;
+        }
+    }
+    // перекрывающиеся фазы дают интервалы не по порядку
+    std::stable_sort(chunks.begin(), chunks.end(),
+                     [](const Chunk &a, const Chunk &b) { return a.bucket < b.bucket; });
+
+    Level base;
+    base.bucketSeconds = kBaseBucketSeconds;
+    for (const auto &chunk: chunks) {
+        if (base.buckets.empty() || base.buckets.back() != chunk.bucket) {
+            base.buckets.push_back(chunk.bucket);
+            base.seconds.emplace_back();
+        }
+        base.seconds.back()[chunk.phase] += chunk.seconds;
+    }
+    levels_.push_back(std::move(base));
+
+    while (levels_.back().buckets.size() > 1) {
+        const Level &finer = levels_.back();
+        Level coarser;
+        coarser.bucketSeconds = finer.bucketSeconds * 2;
+        for (std::size_t b = 0; b < finer.buckets.size(); ++b) {
+            const std::int64_t bucket = finer.buckets[b] / 2;
+            if (coarser.buckets.empty() || coarser.buckets.back() != bucket) {
+                coarser.buckets.push_back(bucket);
+                coarser.seconds.emplace_back();
+            }
+            auto &target = coarser.seconds.back();
+            for (std::size_t k = 0; k < kPhaseCount; ++k) {
+                target[k] += finer.seconds[b][k];
+            }
+        }
+        levels_.push_back(std::move(coarser));
+    }
+
+    for (auto &level: levels_) {
+        level.dominant.resize(level.seconds.size());
+        std::transform(level.seconds.begin(), level.seconds.end(), level.dominant.begin(), dominantOf);
+    }
+}
+
+std::uint8_t TimelinePyramid::dominantOf(const std::array<std::uint32_t, kPhaseCount> &seconds) {
+    const auto it = std::max_element(seconds.begin(), seconds.end());
+    return *it == 0 ? kNoPhase : static_cast<std::uint8_t>(it - seconds.begin());
+}
+
+std::int64_t TimelinePyramid::bucketSeconds(std::size_t level) const {
+    return level == 0 ? 0 : levels_[level - 1].bucketSeconds;
+}
+
+std::size_t TimelinePyramid::firstBucketEndingAfter(const Level &level, double x) const {
+    const auto width = static_cast<double>(level.bucketSeconds);
+    const double bucket = std::floor((std::max(x, startTime()) - startTime()) / width);
+    return static_cast<std::size_t>(
+            std::lower_bound(level.buckets.begin(), level.buckets.end(), bucket,
+                             [](std::int64_t b, double value) { return static_cast<double>(b) < value; }) -
+            level.buckets.begin());
+}
+
+std::size_t TimelinePyramid::firstPhaseEndingAfter(double x) const {
+    // maxEnds_ не убывает, поэтому фазы, перекрытые более длинными, не теряются
+    return static_cast<std::size_t>(
+            std::upper_bound(maxEnds_.begin(), maxEnds_.end(), x,
+                             [](double value, std::int64_t end) { return value < static_cast<double>(end); }) -
+            maxEnds_.begin());
+}
+
+std::size_t TimelinePyramid::selectLevel(double xMin, double xMax, std::size_t maxSegments) const {
+    if (empty()) return 0;
+    maxSegments = std::max<std::size_t>(maxSegments, 1);
+    xMin = std::max(xMin, startTime());
+    xMax = std::min(xMax, endTime());
+    if (xMax <= xMin) return 0;
+
+    const std::size_t first = firstPhaseEndingAfter(xMin);
+    const auto last = static_cast<std::size_t>(
+            std::lower_bound(starts_.begin(), starts_.end(), xMax,
+                             [](std::int64_t start, double value) { return static_cast<double>(start) < value; }) -
+            starts_.begin());
+    if (last <= first || last - first <= maxSegments) return 0;
+
+    for (std::size_t level = 0; level < levels_.size(); ++level) {
+        const double buckets = std::ceil((xMax - xMin) / static_cast<double>(levels_[level].bucketSeconds)) + 1.0;
+        if (buckets <= static_cast<double>(maxSegments)) return level + 1;
+    }
+    return levels_.size();
+}
+
+std::size_t TimelinePyramid::visibleSegments(double xMin, double xMax, std::size_t maxSegments,
+                                             std::span<PhaseSegmentSeries, kPhaseCount> series) const {
+    const auto phasesInfo = PlotData::PhasesInfo();
+    for (std::size_t k = 0; k < kPhaseCount; ++k) {
+        series[k].info = phasesInfo[k];
+        series[k].colorIndex = static_cast<int>(k);
+        series[k].xs.clear();
+        series[k].ys.clear();
+    }
+
+    const std::size_t level = selectLevel(xMin, xMax, maxSegments);
+    if (empty() || xMax <= startTime() || xMin >= endTime()) return level;
+
+    // соседние отрезки одной фазы склеиваются в один
+    std::uint8_t previous = kNoPhase;
+    auto addSegment = [&](std::uint8_t phase, double start, double end) {
+        auto &target = series[phase];
+        if (phase == previous && target.xs.back() == start) {
+            target.xs.back() = end;
+        } else {
+            const double y = target.info.yLevel;
+            target.xs.insert(target.xs.end(), {start, end});
+            target.ys.insert(target.ys.end(), {y, y});
+        }
+        previous = phase;
+    };
+
+    if (level == 0) {
+        for (std::size_t i = firstPhaseEndingAfter(xMin); i < starts_.size() && starts_[i] < xMax; ++i) {
+            addSegment(phases_[i], static_cast<double>(starts_[i]), static_cast<double>(ends_[i]));
+        }
+        return level;
+    }
+
+    const Level &data = levels_[level - 1];
+    const auto width = static_cast<double>(data.bucketSeconds);
+    for (std::size_t b = firstBucketEndingAfter(data, xMin); b < data.buckets.size(); ++b) {
+        const double start = startTime() + static_cast<double>(data.buckets[b]) * width;
+        if (start > xMax) break;
+        const std::uint8_t phase = data.dominant[b];
+        if (phase == kNoPhase) {
+            previous = kNoPhase;
+            continue;
+        }
+        // между непустыми интервалами может быть пропуск: тогда addSegment не склеит отрезки
+        addSegment(phase, start, std::min(start + width, endTime()));
+    }
+    return level;
+}
+
+bool TimelinePyramid::sharesAt(double x, std::size_t level, TimelineShares &shares) const {
+    if (empty() || x < startTime() || x >= endTime()) return false;
+
+    if (level == 0) {
+        for (std::size_t i = firstPhaseEndingAfter(x); i < starts_.size() && static_cast<double>(starts_[i]) <= x; ++i) {
+            if (static_cast<double>(ends_[i]) <= x) continue;
+            shares.start = static_cast<double>(starts_[i]);
+            shares.end = static_cast<double>(ends_[i]);
+            shares.percentages.fill(0.0);
+            shares.percentages[phases_[i]] = 100.0;
+            return true;
+        }
+        return false;
+    }
+
+    const Level &data = levels_[std::min(level, levels_.size()) - 1];
+    const std::size_t b = firstBucketEndingAfter(data, x);
+    if (b == data.buckets.size()) return false;
+    const std::int64_t bucket = data.buckets[b];
+    if (static_cast<double>(bucket) != std::floor((x - startTime()) / static_cast<double>(data.bucketSeconds))) {
+        return false;
+    }
+    const auto &seconds = data.seconds[b];
+    const double total = std::accumulate(seconds.begin(), seconds.end(), 0.0);
+    if (total <= 0.0) return false;
+
+    shares.start = startTime() + static_cast<double>(bucket * data.bucketSeconds);
+    shares.end = std::min(shares.start + static_cast<double>(data.bucketSeconds), endTime());
+    for (std::size_t k = 0; k < kPhaseCount; ++k) {
+        shares.percentages[k] = seconds[k] * 100.0 / total;
+    }
+    return true;
+}
@@ -0,0 +1,105 @@
+#include "TraceOverlay.h"
+#include "implot.h"
+#include "imgui.h"
+#include <algorithm>
+#include <cstring>
+#include <exception>
+#include <utility>
+
+namespace {
+
+/// Количество столбцов гистограммы времени кадра
+constexpr int kFrameHistogramBins = 40;
+
+} // namespace
+
+TraceOverlay::TraceOverlay(std::string exportPath) : exportPath_(std::move(exportPath)) {}
+
+void TraceOverlay::refresh() {
+    const std::vector<TraceEvent> events = Trace::collect();
+    const std::uint64_t now = Trace::nowNs();
+    const auto window = static_cast<std::uint64_t>(kWindowSeconds * 1e9);
+    const std::uint64_t from = now > window ? now - window : 0;
+    const auto first = std::lower_bound(events.begin(), events.end(), from,
+                                        [](const TraceEvent &e, std::uint64_t start) { return e.startNs < start; });
+    const std::span<const TraceEvent> recent(first, events.end());
+
+    frameMs_.clear();
+    for (const TraceEvent &event: recent) {
+        if (std::strcmp(event.name, kFrameScope) == 0) {
+            frameMs_.push_back(static_cast<double>(event.durationNs) / 1e6);
+        }
+    }
+    stats_ = Trace::summarize(recent);
+}
+
+void TraceOverlay::exportTrace() {
+    try {
+        Trace::writeChromeTrace(exportPath_);
+        exportStatus_ = "Трасса сохранена: " + exportPath_;
+    } catch (const std::exception &e) {
+        exportStatus_ = e.what();
+    }
+}
+
+void TraceOverlay::draw() {
+    ImGui::SetNextWindowPos({ImGui::GetIO().DisplaySize.x - 620, 40}, ImGuiCond_FirstUseEver);
+    ImGui::SetNextWindowSize({600, 520}, ImGuiCond_FirstUseEver);
+    ImGui::Begin("Профилировщик");
+
+    if (!Trace::kCompiledIn) {
+        ImGui::TextUnformatted("Точки трассировки не включены в сборку (SLEEP_VISUALIZER_TRACING=ON).");
+        ImGui::End();
+        return;
+    }
+
+    const double time = ImGui::GetTime();
+    if (lastRefresh_ < 0.0 || time - lastRefresh_ >= kRefreshSeconds) {
+        refresh();
+        lastRefresh_ = time;
+    }
+
+    if (ImGui::Button("Сохранить трассу")) {
+        exportTrace();
+    }
+    ImGui::SameLine();
+    ImGui::TextUnformatted(exportStatus_.c_str());
+
+    ImGui::Text("Кадров за %.0f с: %zu", kWindowSeconds, frameMs_.size());
+    if (!frameMs_.empty() && ImPlot::BeginPlot("Время кадра", {-1, 180})) {
+        ImPlot::SetupAxes("мс", "кадры", ImPlotAxisFlags_AutoFit, ImPlotAxisFlags_AutoFit);
+        ImPlot::PlotHistogram("кадры", frameMs_.data(), static_cast<int>(frameMs_.size()), kFrameHistogramBins);
+        ImPlot::EndPlot();
+    }
+
+    if (ImGui::BeginTable("TraceScopes", 7, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+        ImGui::TableSetupColumn("Область");
+        ImGui::TableSetupColumn("Вызовы");
+        ImGui::TableSetupColumn("p50, мс");
+        ImGui::TableSetupColumn("p95, мс");
+        ImGui::TableSetupColumn("p99, мс");
+        ImGui::TableSetupColumn("max, мс");
+        ImGui::TableSetupColumn("Всего, мс");
+        ImGui::TableHeadersRow();
+        for (const TraceScopeStats &s: stats_) {
+            ImGui::TableNextRow();
+            ImGui::TableSetColumnIndex(0);
+            ImGui::TextUnformatted(s.name.c_str());
+            ImGui::TableSetColumnIndex(1);
+            ImGui::Text("%zu", s.count);
+            ImGui::TableSetColumnIndex(2);
+            ImGui::Text("%.3f", s.p50Ms);
+            ImGui::TableSetColumnIndex(3);
+            ImGui::Text("%.3f", s.p95Ms);
+            ImGui::TableSetColumnIndex(4);
+            ImGui::Text("%.3f", s.p99Ms);
+            ImGui::TableSetColumnIndex(5);
+            ImGui::Text("%.3f", s.maxMs);
+            ImGui::TableSetColumnIndex(6);
+            ImGui::Text("%.1f", s.totalMs);
+        }
+        ImGui::EndTable();
+    }
+
+    ImGui::End();
+}
@@ -1,115 +1,222 @@
 #include "Visualization.h"
-#include "DateUtils.h"
+#include "CalendarHeatmap.h"
+#include "PlotData.h"
 #include "SleepAnalyzer.h"
+#include "TimelinePyramid.h"
+#include "Trace.h"
 #include "implot.h"
 #include "imgui.h"
-#include <string>
-#include <unordered_map>
-
-struct PhaseVisualInfo {
-    double yLevel;
-    const char *name;
-
-    static const std::vector<PhaseVisualInfo> &getPhasesInfo() {
-        static const std::vector<PhaseVisualInfo> allPhasesInfo = {
-                {1.0, "Awake"},
-                {2.0, "Light"},
-                {3.0, "Deep"},
-                {4.0, "REM"}
-        };
-        return allPhasesInfo;
-    }
-
-    //todo убрать лишнее
-    static const PhaseVisualInfo &getPhaseInfo(SleepPhaseType phase) {
-        static const std::unordered_map<SleepPhaseType, PhaseVisualInfo> phaseMap = {
-                {SleepPhaseType::Awake, getPhasesInfo()[0]},
-                {SleepPhaseType::Light, getPhasesInfo()[1]},
-                {SleepPhaseType::Deep,  getPhasesInfo()[2]},
-                {SleepPhaseType::REM,   getPhasesInfo()[3]}
-        };
-        static const PhaseVisualInfo defaultInfo = {0.0, "Unknown"};
-        auto it = phaseMap.find(phase);
-        return (it != phaseMap.end()) ? it->second : defaultInfo;
-    }
-};
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <utility>
+
+namespace {
+
+/// Цвет дней календаря без ночи
+constexpr ImU32 kEmptyCalendarCellColor = IM_COL32(90, 90, 90, 255);
+
+/**
+ * Подготовленные данные графиков живут между кадрами и перестраиваются только при изменении данных.
+ */
+DailyPhasesPlotCache &dailyPhasesCache() {
+    static DailyPhasesPlotCache cache;
+    return cache;
+}
 
-struct PhaseDurationInfo {
-    const char *name;
-    int minutes;
-    double percentage;
-};
+MetricsSummaryPlotCache &metricsSummaryCache(bool isAverage) {
+    static MetricsSummaryPlotCache caches[2];
+    return caches[isAverage ? 1 : 0];
+}
 
-void Visualization::ShowDailyPhasesPlot(const DailySleepData &data) {
-    if (data.phases.empty()) return;
+void showDailyPhasesPlot(const DailyPhasesPlotCache &cache) {
+    if (cache.empty()) return;
     ImPlot::PushColormap("MySleepPalette");
     ImVec2 windowSize = {ImGui::GetIO().DisplaySize.x, 300};
     ImGui::SetNextWindowPos({0, 30}, ImGuiCond_Always);
     ImGui::SetNextWindowSize(windowSize, ImGuiCond_Always);
-    ImGui::Begin(DateUtils::onlyDate(data.date).c_str(), nullptr,
+    ImGui::Begin(cache.title(), nullptr,
                  ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoCollapse);
 
     if (ImPlot::BeginPlot("Визуализация фаз сна за день", ImGui::GetContentRegionAvail(), ImPlotFlags_NoInputs)) {
         ImPlot::SetupAxis(ImAxis_X1, "Время");
         ImPlot::SetupAxis(ImAxis_Y1, "Фаза");
 
-        const auto &allPhasesInfo = PhaseVisualInfo::getPhasesInfo();
-        std::vector<double> yTicks;
-        std::vector<const char *> yLabels;
-        for (const auto &phase: allPhasesInfo) {
-            yTicks.push_back(phase.yLevel);
-            yLabels.push_back(phase.name);
-        }
-        ImPlot::SetupAxisTicks(ImAxis_Y1, yTicks.data(), static_cast<int>(yTicks.size()), yLabels.data());
-
-        const double startTime = DateUtils::timePointToUnix(data.bedtime);
-        const double endTime = DateUtils::timePointToUnix(data.wakeTime);
+        ImPlot::SetupAxisTicks(ImAxis_Y1, cache.yTicks().data(), static_cast<int>(cache.yTicks().size()),
+                               cache.yTickLabels().data());
 
         //todo тоже хардкод, но эти значения не изменятся
-        ImPlot::SetupAxesLimits(startTime, endTime, 0.0, 4.5);
+        ImPlot::SetupAxesLimits(cache.startTime(), cache.endTime(), 0.0, 4.5);
         ImPlot::SetupAxisLimitsConstraints(ImAxis_Y1, 0, 4.5);
 
-        ImPlot::SetupAxisFormat(ImAxis_X1, [](double value, char *buff, int size, void *user_data) -> int {
-            auto tp = DateUtils::unixToTimePoint(value);
-            std::string formatted = DateUtils::onlyTime(tp);
-            int written = snprintf(buff, size, "%s", formatted.c_str());
-            return (written < 0) ? 0 : written;
-        });
-
-        std::vector<double> xTicks;
-        xTicks.push_back(DateUtils::timePointToUnix(data.phases.front().start));
-        for (const auto &phase: data.phases) {
-            const DateTime currentPhaseEnd = phase.end;
-            double xEnd = DateUtils::timePointToUnix(currentPhaseEnd);
-            xTicks.push_back(xEnd);
+        ImPlot::SetupAxisTicks(ImAxis_X1, cache.xTicks().data(), static_cast<int>(cache.xTicks().size()),
+                               cache.xTickLabels().data());
+
+        // один вызов на тип фазы: отрезки типа лежат парами точек в одной серии
+        for (const auto &series: cache.series()) {
+            if (series.xs.empty()) continue;
+            ImPlot::SetNextLineStyle(ImPlot::GetColormapColor(series.colorIndex), 10.0f);
+            ImPlot::PlotLine(series.info.name, series.xs.data(), series.ys.data(), series.pointCount(),
+                             ImPlotLineFlags_Segments);
         }
 
-        ImPlot::SetupAxisTicks(ImAxis_X1, xTicks.data(), static_cast<int>(xTicks.size()), nullptr);
+        ImPlot::EndPlot();
+    }
+    ImPlot::PopColormap();
+    ImGui::End();
+}
+
+NightSignalsPlotCache &nightSignalsCache() {
+    static NightSignalsPlotCache cache;
+    return cache;
+}
+
+struct SignalPlotInfo {
+    SleepSignalType type;
+    const char *title;
+    const char *unit;
+};
+
+constexpr std::array<SignalPlotInfo, kSleepSignalCount> kSignalPlots = {{
+        {SleepSignalType::HeartRate, "Пульс", "уд/мин"},
+        {SleepSignalType::Respiration, "Дыхание", "вдохов/мин"},
+}};
+
+void showSignalCells(const SignalSummary &summary) {
+    ImGui::TableNextColumn();
+    if (summary.empty()) {
+        ImGui::TextUnformatted("-");
+    } else {
+        ImGui::Text("%.1f", summary.mean());
+    }
+    ImGui::TableNextColumn();
+    if (summary.empty()) {
+        ImGui::TextUnformatted("-");
+    } else {
+        ImGui::Text("%.1f - %.1f", summary.minValue(), summary.maxValue());
+    }
+}
+
+void showSignalStatsRow(const char *label, const SignalSummary &heartRate, const RrVariability &hrv,
+                        const SignalSummary &respiration) {
+    ImGui::TableNextRow();
+    ImGui::TableNextColumn();
+    ImGui::TextUnformatted(label);
+    showSignalCells(heartRate);
+    ImGui::TableNextColumn();
+    if (hrv.pairs == 0) {
+        ImGui::TextUnformatted("-");
+    } else {
+        ImGui::Text("%.0f", hrv.rmssd());
+    }
+    showSignalCells(respiration);
+}
 
-        for (const auto &phase: data.phases) {
-            //todo не переводить два раза в юникс
-            const double xStart = DateUtils::timePointToUnix(phase.start);
-            const double xEnd = DateUtils::timePointToUnix(phase.end);
-            const auto &info = PhaseVisualInfo::getPhaseInfo(phase.type);
+void showNightSignals(NightSignalsPlotCache &cache, bool nightChanged) {
+    const ImVec2 displaySize = ImGui::GetIO().DisplaySize;
+    ImGui::SetNextWindowPos({0, 30}, ImGuiCond_Always);
+    ImGui::SetNextWindowSize({displaySize.x, displaySize.y - 30}, ImGuiCond_Always);
+    ImGui::Begin("Пульс и дыхание", nullptr,
+                 ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoCollapse);
 
-            const double xs[2] = {xStart, xEnd};
-            const double ys[2] = {info.yLevel, info.yLevel};
+    if (!cache.hasSignals()) {
+        ImGui::TextUnformatted("Устройство не передало пульс и дыхание за эту ночь.");
+        ImGui::End();
+        return;
+    }
 
-            ImPlot::PushStyleVar(ImPlotStyleVar_LineWeight, 10.0f);
-            ImPlot::PlotLine(info.name, xs, ys, 2);
-            ImPlot::PopStyleVar();
+    const float tableHeight = 150.0f;
+    const ImVec2 plotsSize = {-1, ImGui::GetContentRegionAvail().y - tableHeight};
+    if (ImPlot::BeginSubplots("##signals", static_cast<int>(kSignalPlots.size()), 1, plotsSize,
+                              ImPlotSubplotFlags_LinkAllX)) {
+        // при смене ночи масштаб сбрасывается на всю ночь, иначе остаётся выбранным пользователем
+        const ImPlotCond cond = nightChanged ? ImPlotCond_Always : ImPlotCond_Once;
+        for (const SignalPlotInfo &info: kSignalPlots) {
+            if (!ImPlot::BeginPlot(info.title)) continue;
+            ImPlot::SetupAxes("Время", info.unit, 0, ImPlotAxisFlags_AutoFit);
+            ImPlot::SetupAxisScale(ImAxis_X1, ImPlotScale_Time);
+            ImPlot::SetupAxisLimits(ImAxis_X1, cache.startTime(), cache.endTime(), cond);
+
+            // не больше одной группы отсчётов на пиксель
+            const ImPlotRect limits = ImPlot::GetPlotLimits();
+            const auto maxPoints = static_cast<std::size_t>(std::max(ImPlot::GetPlotSize().x, 1.0f));
+            const DecimatedSignal &signal = cache.decimate(info.type, limits.X.Min, limits.X.Max, maxPoints);
+            if (signal.pointCount() > 0) {
+                ImPlot::SetNextFillStyle(IMPLOT_AUTO_COL, 0.25f);
+                ImPlot::PlotShaded("Мин - макс", signal.xs.data(), signal.mins.data(), signal.maxs.data(),
+                                   signal.pointCount());
+                ImPlot::PlotLine("Среднее", signal.xs.data(), signal.means.data(), signal.pointCount(),
+                                 ImPlotLineFlags_SkipNaN);
+            }
+            ImPlot::EndPlot();
         }
+        ImPlot::EndSubplots();
+    }
 
-        ImPlot::EndPlot();
+    const NightSignalStats &stats = cache.stats();
+    const auto heartRate = static_cast<std::size_t>(SleepSignalType::HeartRate);
+    const auto respiration = static_cast<std::size_t>(SleepSignalType::Respiration);
+    if (ImGui::BeginTable("SignalsTable", 6, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+        ImGui::TableSetupColumn("Фаза");
+        ImGui::TableSetupColumn("Пульс, среднее");
+        ImGui::TableSetupColumn("Пульс, мин - макс");
+        ImGui::TableSetupColumn("RMSSD, мс");
+        ImGui::TableSetupColumn("Дыхание, среднее");
+        ImGui::TableSetupColumn("Дыхание, мин - макс");
+        ImGui::TableHeadersRow();
+
+        const auto phasesInfo = PlotData::PhasesInfo();
+        for (std::size_t k = 0; k < NightSignalStats::kPhaseTypeCount; ++k) {
+            const char *name = phasesInfo[PlotData::PhaseIndex(static_cast<SleepPhaseType>(k))].name;
+            showSignalStatsRow(name, stats.byPhase[heartRate][k], stats.hrvByPhase[k], stats.byPhase[respiration][k]);
+        }
+        showSignalStatsRow("Вся ночь", stats.night[heartRate], stats.hrv, stats.night[respiration]);
+        ImGui::EndTable();
     }
-    ImPlot::PopColormap();
     ImGui::End();
 }
 
-void Visualization::ShowMetricsSummary(const SleepMetrics &m, const bool isAverage) {
-    std::array<PhaseDurationInfo, 3> phases = {{{"Light", m.lightSleepDuration, m.lightSleepPercent},
-                                                {"Deep", m.deepSleepDuration, m.deepSleepPercent},
-                                                {"REM", m.remSleepDuration, m.remSleepPercent}}};
+/**
+ * Буферы отрезков таймлайна истории переиспользуются между кадрами.
+ */
+std::array<PhaseSegmentSeries, TimelinePyramid::kPhaseCount> &timelineSeries() {
+    static std::array<PhaseSegmentSeries, TimelinePyramid::kPhaseCount> series;
+    return series;
+}
+
+void setupPhaseAxis() {
+    static const auto ticks = [] {
+        std::pair<std::array<double, TimelinePyramid::kPhaseCount>,
+                std::array<const char *, TimelinePyramid::kPhaseCount>> result;
+        const auto phasesInfo = PlotData::PhasesInfo();
+        for (std::size_t i = 0; i < TimelinePyramid::kPhaseCount; ++i) {
+            result.first[i] = phasesInfo[i].yLevel;
+            result.second[i] = phasesInfo[i].name;
+        }
+        return result;
+    }();
+    ImPlot::SetupAxisTicks(ImAxis_Y1, ticks.first.data(), static_cast<int>(ticks.first.size()), ticks.second.data());
+    ImPlot::SetupAxisLimits(ImAxis_Y1, 0.0, 4.5, ImPlotCond_Always);
+}
+
+void showSleepArchitecture(const SleepArchitecture &a) {
+    ImGui::Separator();
+    ImGui::Text("Засыпание: %d мин", a.sleepOnsetLatency);
+    if (a.remLatency >= 0) {
+        ImGui::Text("До первой фазы REM: %d мин", a.remLatency);
+    } else {
+        ImGui::TextUnformatted("До первой фазы REM: REM не было");
+    }
+    ImGui::Text("Бодрствование после засыпания: %d мин", a.waso);
+    ImGui::Text("Циклов сна: %d, в среднем %.0f мин", a.cycleCount, a.meanCycleLength());
+    ImGui::Text("Фрагментация: %.1f переходов в час", a.fragmentationIndex);
+}
+
+void showMetricsSummary(const SleepMetrics &m, const bool isAverage, const SleepArchitecture *architecture) {
+    auto &cache = metricsSummaryCache(isAverage);
+    cache.update(m);
+    const MetricsSummaryPlotData &data = cache.data();
     ImPlot::PushColormap("MySleepPalette");
 
     ImVec2 windowSize = {ImGui::GetIO().DisplaySize.x, ImGui::GetIO().DisplaySize.y - 330};
@@ -131,44 +238,36 @@ void Visualization::ShowMetricsSummary(const SleepMetrics &m, const bool isAvera
         ImGui::TableSetupColumn(isAverage ? "Cредняя доля" : "Доля");
         ImGui::TableHeadersRow();
 
-        for (auto &p: phases) {
+        for (std::size_t i = 0; i < data.labels.size(); ++i) {
             ImGui::TableNextRow();
             ImGui::TableSetColumnIndex(0);
-            ImGui::TextUnformatted(p.name);
+            ImGui::TextUnformatted(data.labels[i]);
 
             ImGui::TableSetColumnIndex(1);
-            //todo возможно форматировать через встроенный форматтер, а не самописный
-            ImGui::Text("%s", DateUtils::formatTimeDiff(p.minutes).c_str());
+            ImGui::TextUnformatted(cache.durationText(i));
 
             ImGui::TableSetColumnIndex(2);
-            ImGui::Text("%.1f %%", p.percentage);
+            ImGui::Text("%.1f %%", data.percentages[i]);
         }
 
         ImGui::EndTable();
     }
 
-    ImGui::Text("Время в постели: %s", DateUtils::formatTimeDiff(m.timeInBed).c_str());
-    ImGui::Text("Общее время сна: %s", DateUtils::formatTimeDiff(m.totalSleepTime).c_str());
-    ImGui::Text("Количество пробуждений: %d", m.awakeningsCount);
+    ImGui::Text("Время в постели: %s", cache.timeInBedText());
+    ImGui::Text("Общее время сна: %s", cache.totalSleepTimeText());
+    ImGui::Text("Количество пробуждений: %d", cache.awakeningsCount());
+    if (architecture) {
+        showSleepArchitecture(*architecture);
+    }
 
     ImGui::NextColumn();
     if (ImPlot::BeginPlot("Доля каждой фазы в минутах", ImVec2(-1, -1), ImPlotFlags_NoLegend)) {
         ImPlot::SetupAxes("Фаза", "Минуты");
-        //todo выделять память на тики в других графиках
-        std::vector<double> yMinutes(phases.size());
-        std::vector<const char *> xLabels(phases.size());
-        std::vector<double> xIndices(phases.size());
-
-        for (int i = 0; i < phases.size(); i++) {
-            yMinutes[i] = phases[i].minutes;
-            xLabels[i] = phases[i].name;
-            xIndices[i] = (double) i;
-        }
-
-        ImPlot::SetupAxisTicks(ImAxis_X1, xIndices.data(), static_cast<int>(xIndices.size()), xLabels.data());
+        ImPlot::SetupAxisTicks(ImAxis_X1, data.indices.data(), static_cast<int>(data.indices.size()),
+                               data.labels.data());
 
-        for (int i = 0; i < phases.size(); i++) {
-            ImPlot::PlotBars(xLabels[i], &xIndices[i], &yMinutes[i], 1, 0.5);
+        for (std::size_t i = 0; i < data.labels.size(); ++i) {
+            ImPlot::PlotBars(data.labels[i], &data.indices[i], &data.minutes[i], 1, 0.5);
         }
         ImPlot::EndPlot();
     }
@@ -181,19 +280,194 @@ void Visualization::ShowMetricsSummary(const SleepMetrics &m, const bool isAvera
         ImPlot::SetupAxes(nullptr, nullptr, ImPlotAxisFlags_AutoFit | ImPlotAxisFlags_NoDecorations,
                           ImPlotAxisFlags_AutoFit | ImPlotAxisFlags_NoDecorations);
 
-        std::vector<double> percentages(phases.size());
-        std::vector<const char *> labels(phases.size());
+        ImPlot::PlotPieChart(data.labels.data(), data.percentages.data(), static_cast<int>(data.labels.size()),
+                             0.5, 0.5, 0.4, "%.1f %%", 90.0);
+        ImPlot::EndPlot();
+    }
+    ImPlot::PopColormap();
+    ImGui::End();
+
+}
+
+} // namespace
+
+void Visualization::ShowDailyPhasesPlot(const DailySleepData &data) {
+    SLEEP_TRACE_SCOPE("Visualization::ShowDailyPhasesPlot");
+    auto &cache = dailyPhasesCache();
+    cache.update(data);
+    showDailyPhasesPlot(cache);
+}
+
+void Visualization::ShowDailyPhasesPlot(const SleepNightView &night) {
+    SLEEP_TRACE_SCOPE("Visualization::ShowDailyPhasesPlot");
+    auto &cache = dailyPhasesCache();
+    cache.update(night);
+    showDailyPhasesPlot(cache);
+}
+
+void Visualization::ShowNightSignals(const DailySleepData &data) {
+    SLEEP_TRACE_SCOPE("Visualization::ShowNightSignals");
+    auto &cache = nightSignalsCache();
+    const bool changed = cache.update(data);
+    showNightSignals(cache, changed);
+}
+
+void Visualization::ShowNightSignals(const SleepNightView &night) {
+    SLEEP_TRACE_SCOPE("Visualization::ShowNightSignals");
+    auto &cache = nightSignalsCache();
+    const bool changed = cache.update(night);
+    showNightSignals(cache, changed);
+}
+
+void Visualization::ShowMetricsSummary(const SleepMetrics &m, const bool isAverage) {
+    SLEEP_TRACE_SCOPE("Visualization::ShowMetricsSummary");
+    showMetricsSummary(m, isAverage, nullptr);
+}
+
+void Visualization::ShowMetricsSummary(const SleepMetrics &m, const SleepArchitecture &architecture) {
+    SLEEP_TRACE_SCOPE("Visualization::ShowMetricsSummary");
+    showMetricsSummary(m, false, &architecture);
+}
+
+void Visualization::ShowHistoryTimeline(const TimelinePyramid &timeline) {
+    SLEEP_TRACE_SCOPE("Visualization::ShowHistoryTimeline");
+    if (timeline.empty()) return;
+    ImPlot::PushColormap("MySleepPalette");
+    const ImVec2 displaySize = ImGui::GetIO().DisplaySize;
+    ImGui::SetNextWindowPos({0, 30}, ImGuiCond_Always);
+    ImGui::SetNextWindowSize({displaySize.x, displaySize.y - 30}, ImGuiCond_Always);
+    ImGui::Begin("История", nullptr,
+                 ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoCollapse);
+
+    if (ImPlot::BeginPlot("Фазы сна за всю историю", ImGui::GetContentRegionAvail())) {
+        ImPlot::SetupAxis(ImAxis_X1, "Время");
+        ImPlot::SetupAxis(ImAxis_Y1, "Фаза", ImPlotAxisFlags_Lock);
+        ImPlot::SetupAxisScale(ImAxis_X1, ImPlotScale_Time);
+        ImPlot::SetupAxisLimits(ImAxis_X1, timeline.startTime(), timeline.endTime(), ImPlotCond_Once);
+        ImPlot::SetupAxisLimitsConstraints(ImAxis_X1, timeline.startTime(), timeline.endTime());
+        setupPhaseAxis();
+
+        // уровень детализации выбирается по текущему масштабу: не больше одного отрезка на пиксель
+        const ImPlotRect limits = ImPlot::GetPlotLimits();
+        const auto maxSegments = static_cast<std::size_t>(std::max(ImPlot::GetPlotSize().x, 1.0f));
+        auto &series = timelineSeries();
+        const std::size_t level = timeline.visibleSegments(limits.X.Min, limits.X.Max, maxSegments, series);
+
+        for (const auto &s: series) {
+            if (s.xs.empty()) continue;
+            ImPlot::SetNextLineStyle(ImPlot::GetColormapColor(s.colorIndex), 10.0f);
+            ImPlot::PlotLine(s.info.name, s.xs.data(), s.ys.data(), s.pointCount(), ImPlotLineFlags_Segments);
+        }
 
-        for (int i = 0; i < phases.size(); i++) {
-            percentages[i] = phases[i].percentage;
-            labels[i] = phases[i].name;
+        TimelineShares shares;
+        if (ImPlot::IsPlotHovered() && timeline.sharesAt(ImPlot::GetPlotMousePos().x, level, shares)) {
+            ImGui::BeginTooltip();
+            const auto phasesInfo = PlotData::PhasesInfo();
+            for (std::size_t k = 0; k < shares.percentages.size(); ++k) {
+                ImGui::Text("%s: %.1f %%", phasesInfo[k].name, shares.percentages[k]);
+            }
+            ImGui::EndTooltip();
         }
 
-        ImPlot::PlotPieChart(labels.data(), percentages.data(), static_cast<int>(phases.size()),
-                             0.5, 0.5, 0.4, "%.1f %%", 90.0);
         ImPlot::EndPlot();
     }
     ImPlot::PopColormap();
     ImGui::End();
+}
+
+void Visualization::ShowCalendarHeatmap(const CalendarHeatmap &calendar) {
+    SLEEP_TRACE_SCOPE("Visualization::ShowCalendarHeatmap");
+    if (calendar.empty()) return;
+    static CalendarMetric metric = CalendarMetric::Efficiency;
+
+    const ImVec2 displaySize = ImGui::GetIO().DisplaySize;
+    ImGui::SetNextWindowPos({0, 30}, ImGuiCond_Always);
+    ImGui::SetNextWindowSize({displaySize.x, displaySize.y - 30}, ImGuiCond_Always);
+    ImGui::Begin("Календарь", nullptr,
+                 ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoCollapse);
+
+    // смена метрики только выбирает другую готовую сетку
+    for (std::size_t k = 0; k < CalendarHeatmap::kMetricCount; ++k) {
+        const auto option = static_cast<CalendarMetric>(k);
+        if (k > 0) ImGui::SameLine();
+        if (ImGui::RadioButton(CalendarHeatmap::metricName(option), metric == option)) metric = option;
+    }
+
+    static constexpr double weekdayTicks[] = {6.5, 5.5, 4.5, 3.5, 2.5, 1.5, 0.5};
+    static constexpr const char *weekdayLabels[] = {"Пн", "Вт", "Ср", "Чт", "Пт", "Сб", "Вс"};
+    const float scaleWidth = 90.0f;
+    const double scaleMin = calendar.minValue(metric);
+    const double scaleMax = calendar.maxValue(metric);
+    const double columns = calendar.columns();
+
+    ImPlot::PushColormap(ImPlotColormap_Viridis);
+    if (ImPlot::BeginPlot("##calendar", {ImGui::GetContentRegionAvail().x - scaleWidth, -1},
+                          ImPlotFlags_NoLegend | ImPlotFlags_NoMouseText)) {
+        const ImPlotAxisFlags axisFlags = ImPlotAxisFlags_NoGridLines | ImPlotAxisFlags_NoTickMarks;
+        ImPlot::SetupAxes(nullptr, nullptr, axisFlags, axisFlags | ImPlotAxisFlags_Lock);
+        ImPlot::SetupAxisLimits(ImAxis_X1, 0.0, columns, ImPlotCond_Once);
+        ImPlot::SetupAxisLimitsConstraints(ImAxis_X1, 0.0, columns);
+        ImPlot::SetupAxisLimits(ImAxis_Y1, 0.0, CalendarHeatmap::kRows, ImPlotCond_Always);
+        ImPlot::SetupAxisTicks(ImAxis_X1, calendar.periodTicks().data(), static_cast<int>(calendar.periodTicks().size()),
+                               calendar.periodLabels().data());
+        ImPlot::SetupAxisTicks(ImAxis_Y1, weekdayTicks, CalendarHeatmap::kRows, weekdayLabels);
+
+        // вся история - один вызов, первая строка сетки (понедельник) рисуется сверху
+        ImPlot::PlotHeatmap("##values", calendar.values(metric).data(), CalendarHeatmap::kRows, calendar.columns(),
+                            scaleMin, scaleMax, nullptr, ImPlotPoint(0, 0), ImPlotPoint(columns, CalendarHeatmap::kRows));
+
+        // ImPlot окрашивает NaN первым цветом палитры, поэтому дни без ночи закрашиваются поверх нейтральным цветом;
+        // перебираются только видимые недели
+        const ImPlotRect limits = ImPlot::GetPlotLimits();
+        const int firstColumn = std::max(0, static_cast<int>(std::floor(limits.X.Min)));
+        const int lastColumn = std::min(calendar.columns(), static_cast<int>(std::ceil(limits.X.Max)));
+        ImDrawList *drawList = ImPlot::GetPlotDrawList();
+        ImPlot::PushPlotClipRect();
+        for (int column = firstColumn; column < lastColumn; ++column) {
+            for (int row = 0; row < CalendarHeatmap::kRows; ++row) {
+                if (calendar.nightAt(row, column)) continue;
+                const double top = CalendarHeatmap::kRows - row;
+                drawList->AddRectFilled(ImPlot::PlotToPixels(column, top), ImPlot::PlotToPixels(column + 1.0, top - 1.0),
+                                        kEmptyCalendarCellColor);
+            }
+        }
+        ImPlot::PopPlotClipRect();
+
+        if (ImPlot::IsPlotHovered()) {
+            const ImPlotPoint mouse = ImPlot::GetPlotMousePos();
+            const int column = static_cast<int>(std::floor(mouse.x));
+            const int row = CalendarHeatmap::kRows - 1 - static_cast<int>(std::floor(mouse.y));
+            if (const CalendarNight *night = calendar.nightAt(row, column)) {
+                const std::chrono::year_month_day date{std::chrono::sys_days{std::chrono::days{night->day}}};
+                ImGui::BeginTooltip();
+                ImGui::Text("%d-%02u-%02u", static_cast<int>(date.year()), static_cast<unsigned>(date.month()),
+                            static_cast<unsigned>(date.day()));
+                for (std::size_t k = 0; k < CalendarHeatmap::kMetricCount; ++k) {
+                    const auto option = static_cast<CalendarMetric>(k);
+                    ImGui::TextUnformatted(CalendarHeatmap::metricName(option));
+                    ImGui::SameLine();
+                    ImGui::Text(CalendarHeatmap::metricFormat(option), night->values[k]);
+                }
+                ImGui::EndTooltip();
+            }
+        }
+        ImPlot::EndPlot();
+    }
+    ImGui::SameLine();
+    ImPlot::ColormapScale(CalendarHeatmap::metricName(metric), scaleMin, scaleMax, {scaleWidth, -1},
+                          CalendarHeatmap::metricFormat(metric));
+    ImPlot::PopColormap();
+    ImGui::End();
+}
 
+void Visualization::ShowLoadingProgress(const char *stage, const float fraction) {
+    const ImVec2 available = ImGui::GetContentRegionAvail();
+    const float width = std::min(available.x, 480.0f);
+    ImGui::SetCursorPos({ImGui::GetCursorPosX() + (available.x - width) * 0.5f,
+                         ImGui::GetCursorPosY() + available.y * 0.45f});
+    ImGui::BeginGroup();
+    ImGui::TextUnformatted("Загрузка данных о сне...");
+    ImGui::ProgressBar(fraction, {width, 0.0f});
+    ImGui::TextUnformatted(stage);
+    ImGui::EndGroup();
 }
@@ -0,0 +1,105 @@
+#ifndef SLEEP_VISUALIZER_CALENDARHEATMAP_H
+#define SLEEP_VISUALIZER_CALENDARHEATMAP_H
+
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <string>
+#include <vector>
+#include "../../sleep_data_loader/SleepPhaseStore.h"
+#include "../../sleep_data_loader/WorkStealingPool.h"
+
+/**
+ * @brief Метрика, которой окрашиваются клетки календаря.
+ */
+enum class CalendarMetric : std::uint8_t {
+    Efficiency,  ///< Эффективность сна, %
+    TotalSleep,  ///< Общее время сна, ч.
+    DeepShare    ///< Доля глубокого сна, %
+};
+
+/**
+ * @brief Значения метрик одной ночи календаря.
+ */
+struct CalendarNight {
+    std::int32_t day;             ///< Номер локального дня от 1970-01-01
+    std::array<float, 3> values;  ///< Значения метрик в порядке CalendarMetric
+};
+
+/**
+ * @brief Календарь ночей: столбец - неделя, строка - день недели (сверху понедельник).
+ *
+ * Метрики ночей рассчитываются один раз при построении, параллельно по блокам ночей, и хранятся
+ * компактным массивом CalendarNight. Из него сразу строятся сетки значений для каждой метрики
+ * (по строкам, как ожидает ImPlot::PlotHeatmap), поэтому смена метрики - это только выбор другой
+ * сетки, а история любой длины рисуется одним вызовом. Клетки без ночи содержат kEmptyCell (NaN), чтобы
+ * их нельзя было спутать с ночью с минимальным значением метрики; рисовать их нужно отдельным цветом.
+ */
+class CalendarHeatmap {
+public:
+    static constexpr std::size_t kMetricCount = 3;
+    static constexpr int kRows = 7;
+
+    /// Значение клеток без ночи
+    static constexpr float kEmptyCell = std::numeric_limits<float>::quiet_NaN();
+
+    /**
+     * @brief Рассчитывает метрики всех ночей и строит сетки.
+     *
+     * Если на одну дату приходится несколько ночей, в календарь попадает последняя из них.
+     */
+    void build(const SleepPhaseColumns &history, WorkStealingPool &pool);
+
+    [[nodiscard]] bool empty() const { return nights_.empty(); }
+
+    /// Ночи по возрастанию даты.
+    [[nodiscard]] std::span<const CalendarNight> nights() const { return nights_; }
+
+    /// Количество недель-столбцов.
+    [[nodiscard]] int columns() const { return columns_; }
+
+    /// Номер дня, соответствующего клетке (0, 0); это всегда понедельник.
+    [[nodiscard]] std::int64_t firstDay() const { return firstDay_; }
+
+    /// Сетка kRows x columns() значений метрики по строкам; пустые клетки равны kEmptyCell.
+    [[nodiscard]] std::span<const float> values(CalendarMetric metric) const {
+        return grids_[static_cast<std::size_t>(metric)];
+    }
+
+    [[nodiscard]] float minValue(CalendarMetric metric) const { return min_[static_cast<std::size_t>(metric)]; }
+
+    [[nodiscard]] float maxValue(CalendarMetric metric) const { return max_[static_cast<std::size_t>(metric)]; }
+
+    /// Ночь в клетке или nullptr, если клетка пуста или вне календаря.
+    [[nodiscard]] const CalendarNight *nightAt(int row, int column) const;
+
+    /// Деления оси X: начала месяцев или, для истории длиннее года, начала лет.
+    [[nodiscard]] std::span<const double> periodTicks() const { return periodTicks_; }
+
+    [[nodiscard]] std::span<const char *const> periodLabels() const { return periodLabelPtrs_; }
+
+    static const char *metricName(CalendarMetric metric);
+
+    /// Формат значения метрики для printf.
+    static const char *metricFormat(CalendarMetric metric);
+
+private:
+    void buildGrids();
+
+    void buildPeriodTicks();
+
+    std::vector<CalendarNight> nights_;
+    std::vector<std::int32_t> cellNights_;  ///< Номер ночи в nights_ для каждой клетки или -1
+    std::array<std::vector<float>, kMetricCount> grids_;
+    std::array<float, kMetricCount> min_{};
+    std::array<float, kMetricCount> max_{};
+    std::int64_t firstDay_ = 0;
+    int columns_ = 0;
+
+    std::vector<double> periodTicks_;
+    std::vector<std::string> periodLabels_;
+    std::vector<const char *> periodLabelPtrs_;
+};
+
+#endif //SLEEP_VISUALIZER_CALENDARHEATMAP_H
@@ -0,0 +1,88 @@
+#ifndef SLEEP_VISUALIZER_FRAMEPACER_H
+#define SLEEP_VISUALIZER_FRAMEPACER_H
+
+#include <atomic>
+#include <ctime>
+
+struct GLFWwindow;
+
+/**
+ * @brief Параметры главного цикла отрисовки.
+ */
+struct FramePacerOptions {
+    bool idle = true;          ///< Ждать событий, когда перерисовывать нечего
+    int maxFps = 60;           ///< Ограничение частоты кадров; 0 - без ограничения, кроме vsync
+    double idleTimeout = 1.0;  ///< Максимальное ожидание события в режиме простоя, с
+    int settleFrames = 3;      ///< Сколько кадров рисовать после ввода, чтобы ImGui успел обновить состояние
+};
+
+/**
+ * @brief Статистика главного цикла для замеров нагрузки.
+ */
+struct FramePacerStats {
+    long long frames = 0;     ///< Количество нарисованных кадров
+    double seconds = 0.0;     ///< Время работы цикла, с
+    double cpuSeconds = 0.0;  ///< Процессорное время процесса за то же время, с
+
+    [[nodiscard]] double framesPerSecond() const { return seconds > 0.0 ? frames / seconds : 0.0; }
+
+    [[nodiscard]] double cpuPercent() const { return seconds > 0.0 ? cpuSeconds / seconds * 100.0 : 0.0; }
+};
+
+/**
+ * @brief Решает, когда главному циклу рисовать следующий кадр.
+ *
+ * Пока есть ввод, анимация или запрошенные кадры, цикл опрашивает события и рисует кадры не чаще maxFps.
+ * Когда перерисовывать нечего, цикл блокируется в glfwWaitEventsTimeout до ввода, запроса кадра или
+ * истечения idleTimeout. Фоновые потоки будят цикл через requestFrame(), который вызывает glfwPostEmptyEvent.
+ */
+class FramePacer {
+public:
+    explicit FramePacer(FramePacerOptions options);
+
+    FramePacer(const FramePacer &) = delete;
+
+    FramePacer &operator=(const FramePacer &) = delete;
+
+    /**
+     * @brief Подключает обработчики ввода окна.
+     *
+     * Вызывать до ImGui_ImplGlfw_InitForOpenGL: бэкенд ImGui сохраняет установленные обработчики
+     * и вызывает их по цепочке.
+     */
+    void attach(GLFWwindow *window);
+
+    /**
+     * @brief Обрабатывает события, при необходимости ожидая их, и выдерживает ограничение частоты кадров.
+     */
+    void waitForFrame();
+
+    /**
+     * @brief Отмечает нарисованный кадр.
+     *
+     * @param animating true, если на экране анимация или активный элемент ImGui и нужен следующий кадр.
+     */
+    void frameRendered(bool animating);
+
+    /**
+     * @brief Запрашивает кадр и будит главный цикл. Можно вызывать из любого потока.
+     */
+    void requestFrame();
+
+    [[nodiscard]] FramePacerStats stats() const;
+
+private:
+    static void onInput(GLFWwindow *window);
+
+    FramePacerOptions options_;
+    std::atomic<bool> frameRequested_{true};
+    bool inputReceived_ = false;
+    int pendingFrames_ = 0;
+    double nextFrameTime_ = 0.0;
+
+    long long frames_ = 0;
+    double startTime_ = 0.0;
+    std::clock_t startCpu_ = 0;
+};
+
+#endif //SLEEP_VISUALIZER_FRAMEPACER_H
@@ -0,0 +1,351 @@
+#ifndef SLEEP_VISUALIZER_PLOTDATA_H
+#define SLEEP_VISUALIZER_PLOTDATA_H
+
+#include <array>
+#include <span>
+#include <string>
+#include <vector>
+#include "../../sleep_data_loader/DataLoader.h"
+#include "../../sleep_data_loader/SleepPhaseStore.h"
+#include "DateUtils.h"
+#include "SignalAnalysis.h"
+#include "SleepAnalyzer.h"
+
+/**
+ * @brief Положение фазы сна на оси Y таймлайна и её подпись.
+ */
+struct PhaseVisualInfo {
+    double yLevel;
+    const char *name;
+};
+
+/**
+ * @brief Отрезок таймлайна, соответствующий одной фазе сна.
+ */
+struct PhaseSegment {
+    double xStart;        ///< Начало фазы, Unix-время
+    double xEnd;          ///< Окончание фазы, Unix-время
+    PhaseVisualInfo info; ///< Уровень и подпись фазы
+};
+
+/**
+ * @brief Данные для таймлайна фаз сна за одну ночь.
+ */
+struct DailyPhasesPlotData {
+    double startTime = 0.0;            ///< Время отхода ко сну, Unix-время
+    double endTime = 0.0;              ///< Время пробуждения, Unix-время
+    std::vector<double> xTicks;        ///< Деления оси X: начало первой фазы и окончания всех фаз
+    std::vector<PhaseSegment> segments; ///< Отрезки фаз в исходном порядке
+};
+
+/**
+ * @brief Данные для таблицы, столбчатой и круговой диаграмм по фазам сна.
+ */
+struct MetricsSummaryPlotData {
+    static constexpr std::size_t kPhaseCount = 3;
+
+    std::array<const char *, kPhaseCount> labels{}; ///< Названия фаз
+    std::array<double, kPhaseCount> minutes{};      ///< Длительности фаз, мин.
+    std::array<double, kPhaseCount> percentages{};  ///< Доли фаз, %
+    std::array<double, kPhaseCount> indices{};      ///< Положения столбцов на оси X
+};
+
+/**
+ * @brief Подготовка данных для графиков без обращения к ImGui и ImPlot.
+ *
+ * Отделена от Visualization, чтобы подготовку можно было замерять и проверять без графического контекста.
+ * Объекты этого класса создавать нельзя.
+ */
+class PlotData {
+public:
+    PlotData() = delete;
+
+    /**
+     * @brief Уровни и подписи всех фаз в порядке делений оси Y.
+     */
+    static std::span<const PhaseVisualInfo> PhasesInfo();
+
+    /**
+     * @brief Номер фазы заданного типа в PhasesInfo(); для неизвестного типа - PhasesInfo().size().
+     */
+    static std::size_t PhaseIndex(SleepPhaseType type);
+
+    /**
+     * @brief Уровень и подпись фазы заданного типа; для неизвестного типа - уровень 0 и подпись "Unknown".
+     */
+    static const PhaseVisualInfo &PhaseInfo(SleepPhaseType type);
+
+    /**
+     * @brief Готовит таймлайн фаз за сутки.
+     */
+    static DailyPhasesPlotData DailyPhases(const DailySleepData &data);
+
+    /**
+     * @brief Готовит таймлайн фаз за ночь из поколоночного хранилища.
+     */
+    static DailyPhasesPlotData DailyPhases(const SleepNightView &night);
+
+    /**
+     * @brief Готовит данные для сводки по фазам сна.
+     */
+    static MetricsSummaryPlotData MetricsSummary(const SleepMetrics &m);
+};
+
+/**
+ * @brief Отрезки фаз одного типа, подготовленные для ImPlotLineFlags_Segments.
+ *
+ * Точки 2i и 2i + 1 - начало и окончание i-й фазы этого типа, поэтому все фазы типа рисуются одним вызовом.
+ */
+struct PhaseSegmentSeries {
+    PhaseVisualInfo info{};  ///< Уровень и подпись фазы
+    int colorIndex = 0;      ///< Номер цвета в палитре
+    std::vector<double> xs;  ///< Unix-время концов отрезков
+    std::vector<double> ys;  ///< Уровни концов отрезков, равны info.yLevel
+
+    [[nodiscard]] int pointCount() const { return static_cast<int>(xs.size()); }
+};
+
+/**
+ * @brief Подготовленный таймлайн фаз ночи, перестраиваемый только при изменении данных.
+ *
+ * update() сравнивает ключ данных с ключом последнего построения и при совпадении ничего не делает,
+ * поэтому его можно вызывать каждый кадр. Ключ - адрес и количество фаз, даты ночи и окончание последней
+ * фазы; сравнение не зависит от количества фаз. Если фазы меняются на месте без изменения ключа,
+ * кэш нужно сбросить через invalidate(). Чтение подготовленных данных не выделяет память; буферы
+ * при перестроении переиспользуются.
+ */
+class DailyPhasesPlotCache {
+public:
+    /**
+     * @brief Перестраивает таймлайн, если данные изменились.
+     *
+     * @return true, если таймлайн перестроен.
+     */
+    bool update(const DailySleepData &data);
+
+    /**
+     * @brief Перестраивает таймлайн ночи из поколоночного хранилища, если данные изменились.
+     *
+     * @return true, если таймлайн перестроен.
+     */
+    bool update(const SleepNightView &night);
+
+    /**
+     * @brief Сбрасывает кэш; следующий update() перестроит таймлайн.
+     */
+    void invalidate() { valid_ = false; }
+
+    [[nodiscard]] bool empty() const { return phaseCount_ == 0; }
+
+    [[nodiscard]] std::size_t phaseCount() const { return phaseCount_; }
+
+    /// Дата ночи (YYYY-MM-DD), используется как заголовок окна.
+    [[nodiscard]] const char *title() const { return title_.data(); }
+
+    [[nodiscard]] double startTime() const { return startTime_; }
+
+    [[nodiscard]] double endTime() const { return endTime_; }
+
+    /// Деления оси X: начало первой фазы и окончания всех фаз.
+    [[nodiscard]] std::span<const double> xTicks() const { return xTicks_; }
+
+    /// Подписи делений оси X в формате ЧЧ:ММ; указывают в таблицу DateUtils::timeLabel().
+    [[nodiscard]] std::span<const char *const> xTickLabels() const { return xTickLabels_; }
+
+    /// Деления оси Y по уровням фаз.
+    [[nodiscard]] std::span<const double> yTicks() const { return yTicks_; }
+
+    /// Подписи делений оси Y.
+    [[nodiscard]] std::span<const char *const> yTickLabels() const { return yTickLabels_; }
+
+    /// Отрезки по типам фаз в порядке PlotData::PhasesInfo(); последняя серия - фазы неизвестного типа.
+    [[nodiscard]] std::span<const PhaseSegmentSeries> series() const { return series_; }
+
+    /// Сколько раз таймлайн перестраивался.
+    [[nodiscard]] std::size_t rebuildCount() const { return rebuildCount_; }
+
+private:
+    static constexpr std::size_t kSeriesCount = 5;
+    static constexpr std::size_t kYTickCount = kSeriesCount - 1;
+
+    /**
+     * @brief Признаки, по которым определяется, что на графике те же данные.
+     */
+    struct Key {
+        const void *phases = nullptr; ///< Начало хранилища фаз
+        std::size_t phaseCount = 0;
+        DateTime date;
+        DateTime bedtime;
+        DateTime wakeTime;
+        DateTime lastPhaseEnd;
+
+        bool operator==(const Key &) const = default;
+    };
+
+    template<typename Phases>
+    bool updateFrom(const Key &key, const Phases &phases);
+
+    template<typename Phases>
+    void rebuild(const Key &key, const Phases &phases);
+
+    Key key_;
+    bool valid_ = false;
+    std::size_t rebuildCount_ = 0;
+
+    std::size_t phaseCount_ = 0;
+    std::array<char, DateUtils::kFormatBufferSize> title_{};
+    double startTime_ = 0.0;
+    double endTime_ = 0.0;
+    std::vector<double> xTicks_;
+    std::vector<const char *> xTickLabels_;
+    std::array<double, kYTickCount> yTicks_{};
+    std::array<const char *, kYTickCount> yTickLabels_{};
+    std::array<PhaseSegmentSeries, kSeriesCount> series_;
+};
+
+/**
+ * @brief Подготовленная сводка по фазам сна, перестраиваемая только при изменении метрик.
+ *
+ * Кроме данных для диаграмм хранит уже отформатированные длительности, чтобы отрисовка кадра
+ * не собирала строки. Длительности форматируются в буферы внутри объекта, поэтому и перестроение
+ * не выделяет память.
+ */
+class MetricsSummaryPlotCache {
+public:
+    /**
+     * @brief Перестраивает сводку, если метрики изменились.
+     *
+     * @return true, если сводка перестроена.
+     */
+    bool update(const SleepMetrics &m);
+
+    void invalidate() { valid_ = false; }
+
+    [[nodiscard]] const MetricsSummaryPlotData &data() const { return data_; }
+
+    /// Длительность i-й фазы сводки в виде "X ч. Y мин.".
+    [[nodiscard]] const char *durationText(std::size_t i) const { return durations_[i].data(); }
+
+    [[nodiscard]] const char *timeInBedText() const { return timeInBed_.data(); }
+
+    [[nodiscard]] const char *totalSleepTimeText() const { return totalSleepTime_.data(); }
+
+    [[nodiscard]] int awakeningsCount() const { return metrics_.awakeningsCount; }
+
+    [[nodiscard]] std::size_t rebuildCount() const { return rebuildCount_; }
+
+private:
+    using TextBuffer = std::array<char, DateUtils::kFormatBufferSize>;
+
+    SleepMetrics metrics_{};
+    bool valid_ = false;
+    std::size_t rebuildCount_ = 0;
+
+    MetricsSummaryPlotData data_;
+    std::array<TextBuffer, MetricsSummaryPlotData::kPhaseCount> durations_{};
+    TextBuffer timeInBed_{};
+    TextBuffer totalSleepTime_{};
+};
+
+/**
+ * @brief Прорежённый ряд для графика: по точке на группу соседних отсчётов.
+ */
+struct DecimatedSignal {
+    std::vector<double> xs;    ///< Unix-время середины группы
+    std::vector<double> means; ///< Среднее группы в единицах измерения; NaN, если в группе нет данных
+    std::vector<double> mins;  ///< Минимум группы; NaN, если в группе нет данных
+    std::vector<double> maxs;  ///< Максимум группы; NaN, если в группе нет данных
+
+    [[nodiscard]] int pointCount() const { return static_cast<int>(xs.size()); }
+};
+
+/**
+ * @brief Ряды пульса и дыхания ночи и их статистика по фазам, подготовленные для графиков.
+ *
+ * update() распаковывает ряды и считает статистику только при смене ночи; ключ - адреса и размеры сжатых
+ * рядов и время сна. decimate() сводит видимый участок ряда не больше чем к maxPoints группам
+ * через SignalAnalysis::Summarize: минимум и максимум группы рисуются полосой, поэтому короткие
+ * всплески не пропадают при любом масштабе. Пока участок и ширина графика не меняются, decimate() ничего
+ * не пересчитывает.
+ */
+class NightSignalsPlotCache {
+public:
+    /**
+     * @brief Перестраивает данные, если ночь изменилась.
+     *
+     * @return true, если данные перестроены.
+     */
+    bool update(const SleepNightView &night);
+
+    /**
+     * @brief Перестраивает данные суток, если они изменились.
+     *
+     * @return true, если данные перестроены.
+     */
+    bool update(const DailySleepData &day);
+
+    /**
+     * @brief Возвращает видимый участок ряда, сведённый не больше чем к @p maxPoints точкам.
+     *
+     * @param type Вид ряда.
+     * @param xMin Начало видимого участка, Unix-время.
+     * @param xMax Окончание видимого участка, Unix-время.
+     * @param maxPoints Наибольшее количество точек, обычно ширина графика в пикселях.
+     */
+    const DecimatedSignal &decimate(SleepSignalType type, double xMin, double xMax, std::size_t maxPoints);
+
+    [[nodiscard]] bool empty(SleepSignalType type) const { return signal(type).samples.empty(); }
+
+    /// Есть ли у ночи хотя бы один ряд.
+    [[nodiscard]] bool hasSignals() const;
+
+    [[nodiscard]] double startTime() const { return startTime_; }
+
+    [[nodiscard]] double endTime() const { return endTime_; }
+
+    [[nodiscard]] const NightSignalStats &stats() const { return stats_; }
+
+    /// Сколько раз данные ночи перестраивались.
+    [[nodiscard]] std::size_t rebuildCount() const { return rebuildCount_; }
+
+private:
+    struct Key {
+        std::array<const void *, kSleepSignalCount> encoded{};
+        std::array<std::uint32_t, kSleepSignalCount> counts{};
+        DateTime bedtime;
+        DateTime wakeTime;
+        std::size_t phaseCount = 0;
+
+        bool operator==(const Key &) const = default;
+    };
+
+    struct Signal {
+        std::vector<SignalSample> samples; ///< Распакованные отсчёты
+        double start = 0.0;                ///< Unix-время первого отсчёта
+        double interval = 1.0;             ///< Шаг, с
+        DecimatedSignal decimated;
+        bool decimatedValid = false;
+        double xMin = 0.0;
+        double xMax = 0.0;
+        std::size_t maxPoints = 0;
+    };
+
+    [[nodiscard]] const Signal &signal(SleepSignalType type) const {
+        return signals_[static_cast<std::size_t>(type)];
+    }
+
+    template<typename Night>
+    bool updateFrom(const Key &key, const Night &night, const std::array<SleepSignalView, kSleepSignalCount> &views);
+
+    Key key_;
+    bool valid_ = false;
+    std::size_t rebuildCount_ = 0;
+
+    double startTime_ = 0.0;
+    double endTime_ = 0.0;
+    std::array<Signal, kSleepSignalCount> signals_;
+    std::vector<SignalSample> scratch_;
+    NightSignalStats stats_;
+};
+
+#endif //SLEEP_VISUALIZER_PLOTDATA_H
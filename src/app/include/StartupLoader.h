@@ -0,0 +1,133 @@
+#ifndef SLEEP_VISUALIZER_STARTUPLOADER_H
+#define SLEEP_VISUALIZER_STARTUPLOADER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include "../../sleep_data_loader/SleepPhaseStore.h"
+#include "../../sleep_data_loader/SleepSnapshot.h"
+#include "RecommendationRules.h"
+#include "SleepAnalyzer.h"
+#include "TimelinePyramid.h"
+#include "CalendarHeatmap.h"
+
+/**
+ * @brief Данные, которые показывает приложение; после публикации не изменяются.
+ */
+struct AppData {
+    SleepSnapshot snapshot;       ///< Снимок, если данные прочитаны из него
+    SleepPhaseStore store;        ///< Хранилище, если данные разобраны из JSON
+    SleepPhaseColumns history;    ///< Вся история: колонки снимка или хранилища
+    SleepNightView today;         ///< Последняя ночь
+    SleepPhaseColumns week;       ///< Последние семь ночей
+    SleepMetrics todayMetrics;
+    SleepArchitecture todayArchitecture;
+    SleepMetrics weeklyMetrics;
+    RuleMask recommendations = 0; ///< Правила, сработавшие по последней ночи; текст - через RecommendationRules::render()
+    TimelinePyramid timeline;
+    CalendarHeatmap calendar;
+    std::string error;            ///< Ошибка загрузки или обработки; при ошибке остальные данные пусты
+};
+
+/**
+ * @brief Этап фоновой загрузки данных.
+ */
+enum class StartupStage : std::uint8_t {
+    Opening,    ///< Открытие снимка
+    Parsing,    ///< Разбор исходного JSON
+    Analyzing,  ///< Расчёт метрик последней ночи и недели
+    Timeline,   ///< Построение таймлайна истории
+    Calendar,   ///< Расчёт метрик всех ночей для календаря
+    Ready       ///< Данные опубликованы
+};
+
+/**
+ * @brief Загружает и обрабатывает данные в фоновом потоке, пока главный цикл рисует окно.
+ *
+ * Поток открывает снимок или разбирает исходный JSON, рассчитывает метрики и строит таймлайн и календарь
+ * (метрики календаря - параллельно в WorkStealingPool), после чего публикует готовый AppData одной
+ * атомарной записью указателя. Главный цикл до публикации показывает этап и долю выполненной работы,
+ * а после - только читает данные, не синхронизируясь с потоком. Если снимок отсутствовал или устарел,
+ * после публикации тот же поток перестраивает его. Если загрузка или обработка завершилась ошибкой,
+ * публикуется пустой AppData с текстом ошибки в AppData::error.
+ */
+class StartupLoader {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief Обработчик, вызываемый в фоновом потоке при смене этапа, продвижении разбора и публикации.
+     */
+    using ProgressCallback = std::function<void()>;
+
+    /**
+     * @brief Запускает загрузку.
+     *
+     * @param sourcePath Путь к исходному JSON-файлу.
+     * @param startTime Момент запуска программы, от которого отсчитывается secondsToData().
+     * @param onProgress Обработчик, будящий поток отрисовки, например FramePacer::requestFrame().
+     */
+    StartupLoader(std::string sourcePath, Clock::time_point startTime, ProgressCallback onProgress = {});
+
+    /**
+     * @brief Прерывает незавершённый разбор и дожидается фонового потока.
+     */
+    ~StartupLoader();
+
+    StartupLoader(const StartupLoader &) = delete;
+
+    StartupLoader &operator=(const StartupLoader &) = delete;
+
+    /// Опубликованные данные или nullptr, пока загрузка не завершена.
+    [[nodiscard]] const AppData *data() const { return data_.load(std::memory_order_acquire); }
+
+    [[nodiscard]] StartupStage stage() const { return stage_.load(std::memory_order_relaxed); }
+
+    /// Доля выполненной работы от 0 до 1.
+    [[nodiscard]] float progress() const { return progress_.load(std::memory_order_relaxed); }
+
+    /// Время от запуска программы до публикации данных, с; отрицательно, пока данные не опубликованы.
+    [[nodiscard]] double secondsToData() const { return secondsToData_.load(std::memory_order_acquire); }
+
+    static const char *stageName(StartupStage stage);
+
+private:
+    void run();
+
+    /**
+     * @brief Загружает колонки из актуального снимка или из исходного файла.
+     *
+     * @return true, если данные разобраны из исходного файла и снимок нужно перестроить.
+     */
+    bool loadHistory(AppData &data);
+
+    void analyze(AppData &data);
+
+    void rebuildSnapshot(const AppData &data);
+
+    /**
+     * @brief Обновляет этап и долю выполненной работы.
+     *
+     * @param stageFraction Доля выполненной работы внутри этапа.
+     */
+    void setProgress(StartupStage stage, float stageFraction = 0.0f);
+
+    std::string sourcePath_;
+    Clock::time_point startTime_;
+    ProgressCallback onProgress_;
+
+    std::unique_ptr<AppData> owned_;  ///< Изменяется только фоновым потоком до публикации
+    std::atomic<const AppData *> data_{nullptr};
+    std::atomic<StartupStage> stage_{StartupStage::Opening};
+    std::atomic<float> progress_{0.0f};
+    std::atomic<double> secondsToData_{-1.0};
+    std::atomic<bool> stop_{false};
+    float notifiedProgress_ = 0.0f;   ///< Прогресс при последнем вызове onProgress_; только фоновый поток
+    std::thread thread_;
+};
+
+#endif //SLEEP_VISUALIZER_STARTUPLOADER_H
@@ -0,0 +1,113 @@
+#ifndef SLEEP_VISUALIZER_TIMELINEPYRAMID_H
+#define SLEEP_VISUALIZER_TIMELINEPYRAMID_H
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "PlotData.h"
+#include "../../sleep_data_loader/SleepPhaseStore.h"
+
+/**
+ * @brief Доли фаз в интервале таймлайна.
+ */
+struct TimelineShares {
+    double start = 0.0;                     ///< Начало интервала, Unix-время
+    double end = 0.0;                       ///< Окончание интервала, Unix-время
+    std::array<double, 4> percentages{};    ///< Доли фаз в порядке PlotData::PhasesInfo(), %
+};
+
+/**
+ * @brief Многоуровневый таймлайн фаз сна за всю историю.
+ *
+ * Уровень 0 - исходные фазы, отсортированные по началу. Уровень 1 - интервалы по kBaseBucketSeconds,
+ * каждый следующий уровень объединяет пары интервалов предыдущего. Для интервала хранится время каждой
+ * фазы в нём и преобладающая фаза. Хранятся только непустые интервалы, поэтому память зависит от суммарной
+ * длительности фаз, а не от промежутка между первой и последней ночью: ночь с ошибочным годом не заставляет
+ * выделять интервалы на тысячи лет. Пирамида строится один раз при загрузке данных; на кадре выбирается
+ * самый подробный уровень, на котором видимый диапазон укладывается в заданное количество отрезков
+ * (обычно ширина графика в пикселях), поэтому объём отрисовки не зависит от длины истории и масштаба.
+ */
+class TimelinePyramid {
+public:
+    static constexpr std::int64_t kBaseBucketSeconds = 5 * 60;
+    static constexpr std::size_t kPhaseCount = 4;
+
+    /**
+     * @brief Строит пирамиду по всем ночам хранилища. Фазы неизвестного типа пропускаются.
+     */
+    void build(const SleepPhaseColumns &history);
+
+    void clear();
+
+    [[nodiscard]] bool empty() const { return starts_.empty(); }
+
+    [[nodiscard]] std::size_t phaseCount() const { return starts_.size(); }
+
+    /// Количество уровней, включая уровень исходных фаз.
+    [[nodiscard]] std::size_t levelCount() const { return levels_.size() + 1; }
+
+    /// Начало первой фазы, Unix-время.
+    [[nodiscard]] double startTime() const { return static_cast<double>(origin_); }
+
+    /// Окончание последней фазы, Unix-время.
+    [[nodiscard]] double endTime() const { return static_cast<double>(end_); }
+
+    /// Длина интервала уровня @p level в секундах; 0 для уровня исходных фаз.
+    [[nodiscard]] std::int64_t bucketSeconds(std::size_t level) const;
+
+    /**
+     * @brief Выбирает самый подробный уровень, на котором в [xMin, xMax] не больше @p maxSegments отрезков.
+     */
+    [[nodiscard]] std::size_t selectLevel(double xMin, double xMax, std::size_t maxSegments) const;
+
+    /**
+     * @brief Заполняет отрезки видимого диапазона на уровне selectLevel().
+     *
+     * Соседние интервалы с одной преобладающей фазой объединяются в один отрезок. Буферы серий
+     * очищаются, но не освобождаются, поэтому после первых кадров заполнение не выделяет память.
+     *
+     * @param series Серии в порядке PlotData::PhasesInfo().
+     * @return Выбранный уровень.
+     */
+    std::size_t visibleSegments(double xMin, double xMax, std::size_t maxSegments,
+                                std::span<PhaseSegmentSeries, kPhaseCount> series) const;
+
+    /**
+     * @brief Доли фаз в интервале уровня @p level, содержащем момент @p x.
+     *
+     * @return false, если в этом месте нет данных.
+     */
+    bool sharesAt(double x, std::size_t level, TimelineShares &shares) const;
+
+private:
+    static constexpr std::uint8_t kNoPhase = 0xFF;
+
+    struct Level {
+        std::int64_t bucketSeconds = 0;
+        std::vector<std::int64_t> buckets;                           ///< Номера непустых интервалов от origin_
+        std::vector<std::array<std::uint32_t, kPhaseCount>> seconds; ///< Время каждой фазы в интервале, с
+        std::vector<std::uint8_t> dominant;                           ///< Преобладающая фаза или kNoPhase
+    };
+
+    static std::uint8_t dominantOf(const std::array<std::uint32_t, kPhaseCount> &seconds);
+
+    /// Позиция в level.buckets первого непустого интервала, который заканчивается позже @p x.
+    [[nodiscard]] std::size_t firstBucketEndingAfter(const Level &level, double x) const;
+
+    /// Номер первой фазы, которая заканчивается позже @p x.
+    [[nodiscard]] std::size_t firstPhaseEndingAfter(double x) const;
+
+    std::int64_t origin_ = 0;
+    std::int64_t end_ = 0;
+
+    // уровень 0: исходные фазы
+    std::vector<std::int64_t> starts_;
+    std::vector<std::int64_t> ends_;
+    std::vector<std::int64_t> maxEnds_;   ///< Наибольшее окончание среди фаз [0, i], для поиска при перекрытиях
+    std::vector<std::uint8_t> phases_;    ///< Номер фазы в PlotData::PhasesInfo()
+
+    std::vector<Level> levels_;           ///< Уровни начиная с 1
+};
+
+#endif //SLEEP_VISUALIZER_TIMELINEPYRAMID_H
@@ -0,0 +1,45 @@
+#ifndef SLEEP_VISUALIZER_TRACEOVERLAY_H
+#define SLEEP_VISUALIZER_TRACEOVERLAY_H
+
+#include <string>
+#include <vector>
+#include "Trace.h"
+
+/**
+ * @brief Окно профилировщика поверх приложения: распределение времени кадра и перцентили областей трассировки.
+ *
+ * Окно раз в kRefreshSeconds собирает события Trace за последние kWindowSeconds и пересчитывает статистику,
+ * поэтому на остальных кадрах его отрисовка не зависит от числа событий. Длительность кадра берётся
+ * из областей kFrameScope, которыми главный цикл обрамляет каждый кадр.
+ */
+class TraceOverlay {
+public:
+    /// Название области, охватывающей один кадр главного цикла.
+    static constexpr const char *kFrameScope = "Frame";
+
+    static constexpr double kRefreshSeconds = 0.5;
+    static constexpr double kWindowSeconds = 5.0;
+
+    /**
+     * @param exportPath Файл, в который кнопка окна сохраняет трассу.
+     */
+    explicit TraceOverlay(std::string exportPath);
+
+    /**
+     * @brief Отрисовывает окно профилировщика.
+     */
+    void draw();
+
+private:
+    void refresh();
+
+    void exportTrace();
+
+    std::string exportPath_;
+    double lastRefresh_ = -1.0;
+    std::vector<double> frameMs_;          ///< Длительности кадров за окно статистики, мс
+    std::vector<TraceScopeStats> stats_;   ///< Статистика областей за окно статистики
+    std::string exportStatus_;
+};
+
+#endif //SLEEP_VISUALIZER_TRACEOVERLAY_H
@@ -4,10 +4,16 @@
 #include <vector>
 #include <string>
 #include "../../sleep_data_loader/DataLoader.h"
+#include "../../sleep_data_loader/SleepPhaseStore.h"
 #include "SleepAnalyzer.h"
+#include "TimelinePyramid.h"
+#include "CalendarHeatmap.h"
 
 /**
 * @brief Класс, строящий графики ImPlot
+*
+* Данные графиков готовятся через DailyPhasesPlotCache, MetricsSummaryPlotCache и NightSignalsPlotCache и перестраиваются
+* только при изменении отображаемых данных, поэтому методы можно вызывать каждый кадр.
 */
 class Visualization {
 public:
@@ -18,6 +24,45 @@ public:
     */
     static void ShowDailyPhasesPlot(const DailySleepData &data);
 
+    /**
+    * @brief Отрисовывает таймлайн фаз сна за ночь из поколоночного хранилища
+    *
+    * @param night - SleepNightView - представление ночи
+    */
+    static void ShowDailyPhasesPlot(const SleepNightView &night);
+
+    /**
+    * @brief Отрисовывает пульс и дыхание за ночь и их статистику по фазам
+    *
+    * Ряды сводятся к ширине графика в пикселях: полоса показывает минимум и максимум, линия - среднее.
+    *
+    * @param data - DailySleepData - данные о сне за сутки
+    */
+    static void ShowNightSignals(const DailySleepData &data);
+
+    /**
+    * @brief Отрисовывает пульс и дыхание за ночь из поколоночного хранилища
+    *
+    * @param night - SleepNightView - представление ночи
+    */
+    static void ShowNightSignals(const SleepNightView &night);
+
+    /**
+    * @brief Отрисовывает таймлайн фаз сна за всю историю с детализацией по масштабу
+    *
+    * При наведении показывает доли фаз в интервале под курсором.
+    *
+    * @param timeline - TimelinePyramid - пирамида, построенная при загрузке данных
+    */
+    static void ShowHistoryTimeline(const TimelinePyramid &timeline);
+
+    /**
+    * @brief Отрисовывает календарь ночей, окрашенный выбранной метрикой
+    *
+    * @param calendar - CalendarHeatmap - календарь, построенный при загрузке данных
+    */
+    static void ShowCalendarHeatmap(const CalendarHeatmap &calendar);
+
     /**
     * @brief Отрисовывает таблицы и графики, отражающие метрики сна за день или неделю
     *
@@ -25,6 +70,22 @@ public:
     * @param isAverage - вид графика: за сутки(false) или за неделю (true)
     */
     static void ShowMetricsSummary(const SleepMetrics &m, bool isAverage);
+
+    /**
+    * @brief Отрисовывает метрики сна за день вместе с архитектурой сна
+    *
+    * @param m - SleepMetrics - посчитанные метрики сна
+    * @param architecture - SleepArchitecture - засыпание, циклы, WASO и фрагментация за ту же ночь
+    */
+    static void ShowMetricsSummary(const SleepMetrics &m, const SleepArchitecture &architecture);
+
+    /**
+    * @brief Отрисовывает этап и ход загрузки данных, пока они не готовы
+    *
+    * @param stage - название текущего этапа
+    * @param fraction - доля выполненной работы от 0 до 1
+    */
+    static void ShowLoadingProgress(const char *stage, float fraction);
 };
 
 #endif //SLEEP_VISUALIZER_VISUALIZATION_H
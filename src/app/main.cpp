@@ -5,13 +5,22 @@
 #include "backends/imgui_impl_glfw.h"
 #include "backends/imgui_impl_opengl3.h"
 
+#include <chrono>
+#include <cstdio>
+#include <stdexcept>
 #include <string>
 #include <iostream>
+#include <memory>
+#include <optional>
 
 #include "../sleep_data_loader/DataLoader.h"
+#include "../sleep_data_loader/SleepFeedTail.h"
 #include "SleepAnalyzer.h"
-#include "SleepRecommender.h"
 #include "Visualization.h"
+#include "FramePacer.h"
+#include "StartupLoader.h"
+#include "TraceOverlay.h"
+#include "Trace.h"
 
 /**
  * @file
@@ -20,6 +29,21 @@
  * Этот файл содержит функции для настройки окна GLFW и интеграции с ImGui для
  * рендеринга графического интерфейса. Приложение загружает данные о сне, анализирует
  * их и представляет результаты в виде графического интерфейса.
+ *
+ * Использование: SleepVisualizer [--max-fps N] [--no-idle] [--stats] [--live FILE] [--trace FILE] [--profiler]
+ *
+ * Без ввода и фоновой работы главный цикл ждёт событий и не перерисовывает окно (см. FramePacer).
+ * --max-fps ограничивает частоту кадров (0 - только vsync), --no-idle возвращает непрерывную отрисовку,
+ * --stats печатает при выходе количество кадров, загрузку процессора, время до первого кадра
+ * и до готовности данных.
+ *
+ * Данные загружаются в фоновом потоке (см. StartupLoader): первый кадр рисуется сразу после создания окна,
+ * а до публикации данных окно показывает этап и ход загрузки.
+ * --live следит за NDJSON-файлом, который дописывает устройство, и показывает на вкладке «Сегодня»
+ * последнюю ночь из него (см. SleepFeedTail).
+ * --trace при выходе сохраняет трассу в формате Chrome trace_event, --profiler показывает окно с временем
+ * кадра и перцентилями областей (см. Trace, TraceOverlay); точки трассировки есть только в сборке
+ * с SLEEP_VISUALIZER_TRACING=ON.
  */
 
 static const char *glsl_version = "#version 410";
@@ -84,6 +108,46 @@ void applyStyle() {
     ImPlot::AddColormap("MySleepPalette", colors, 4);
 }
 
+struct AppOptions {
+    FramePacerOptions pacer;
+    bool printStats = false;
+    std::string liveFeed;
+    std::string traceFile;
+    bool profiler = false;
+};
+
+/**
+ * Разбирает аргументы командной строки.
+ *
+ * @throws std::invalid_argument Если аргументы некорректны.
+ */
+AppOptions parseOptions(int argc, char **argv) {
+    AppOptions options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--max-fps") {
+            if (i + 1 >= argc) throw std::invalid_argument("missing value for " + arg);
+            options.pacer.maxFps = std::stoi(argv[++i]);
+            if (options.pacer.maxFps < 0) throw std::invalid_argument("invalid fps limit: " + std::string(argv[i]));
+        } else if (arg == "--no-idle") {
+            options.pacer.idle = false;
+        } else if (arg == "--stats") {
+            options.printStats = true;
+        } else if (arg == "--live") {
+            if (i + 1 >= argc) throw std::invalid_argument("missing value for " + arg);
+            options.liveFeed = argv[++i];
+        } else if (arg == "--trace") {
+            if (i + 1 >= argc) throw std::invalid_argument("missing value for " + arg);
+            options.traceFile = argv[++i];
+        } else if (arg == "--profiler") {
+            options.profiler = true;
+        } else {
+            throw std::invalid_argument("unknown option: " + arg);
+        }
+    }
+    return options;
+}
+
 void initGui(GLFWwindow *window) {
 
     IMGUI_CHECKVERSION();
@@ -119,14 +183,45 @@ void loadCyrillicFont() {
     ImGui_ImplOpenGL3_CreateFontsTexture();
 }
 
+/**
+ * @brief Забирает сутки, опубликованные потоком слежения, не блокируясь.
+ *
+ * @param today Самая поздняя ночь из потока; заменяется ночью с той же или более поздней датой.
+ * @return true, если @p today изменилась.
+ */
+bool drainLiveFeed(SleepFeedTail &feed, std::optional<DailySleepData> &today) {
+    bool updated = false;
+    while (auto day = feed.tryPop()) {
+        if (!today || day->date >= today->date) {
+            today = std::move(*day);
+            updated = true;
+        }
+    }
+    return updated;
+}
+
 /**
  * @brief Точка входа в программу.
  *
  * @details Загружает данные о сне и запускает главный цикл рендера приложения.
  */
-int main() {
+int main(int argc, char **argv) {
+    const StartupLoader::Clock::time_point startTime = StartupLoader::Clock::now();
+    SLEEP_TRACE_THREAD_NAME("Main");
+
+    AppOptions options;
+    try {
+        options = parseOptions(argc, argv);
+    } catch (const std::exception &e) {
+        std::cerr << "error: " << e.what() << std::endl;
+        return 2;
+    }
 
     GLFWwindow *window = initWindow();
+    if (!window) return 1;
+    // обработчики ввода ставятся до ImGui, который вызывает их по цепочке
+    FramePacer pacer(options.pacer);
+    pacer.attach(window);
     initGui(window);
 
     loadCyrillicFont();
@@ -134,22 +229,51 @@ int main() {
     std::string filePath = {
             "../data/example_data_week.json"
     };
-    WeeklySleepData weeklyData = DataLoader::loadFromJsonFile(filePath);
-    const DailySleepData todayData = weeklyData.sleepDays[0];
 
-    const SleepMetrics todayMetrics = SleepAnalyzer::CalculateDailyMetrics(todayData);
-    const SleepMetrics weeklyMetrics = SleepAnalyzer::CalculateAverageMetrics(weeklyData);
+    // данные загружаются в фоне; до их публикации окно показывает ход загрузки
+    auto loader = std::make_unique<StartupLoader>(filePath, startTime, [&pacer] { pacer.requestFrame(); });
+
+    // новые ночи из файла устройства приходят из фонового потока и будят главный цикл
+    std::unique_ptr<SleepFeedTail> liveFeed;
+    std::optional<DailySleepData> liveToday;
+    SleepMetrics liveMetrics;
+    SleepArchitecture liveArchitecture;
+    if (!options.liveFeed.empty()) {
+        try {
+            liveFeed = std::make_unique<SleepFeedTail>(options.liveFeed, [&pacer] { pacer.requestFrame(); });
+        } catch (const std::exception &e) {
+            std::cerr << "error: " << e.what() << std::endl;
+        }
+    }
+
+    std::optional<TraceOverlay> profiler;
+    if (options.profiler) {
+        profiler.emplace(options.traceFile.empty() ? "sleep_trace.json" : options.traceFile);
+    }
 
-    std::string recommendation = SleepRecommender::GenerateRecommendation(todayMetrics);
+    double secondsToFirstFrame = -1.0;
 
     //основной цикл рендера
     while (!glfwWindowShouldClose(window)) {
 
-        glfwPollEvents();
+        {
+            SLEEP_TRACE_SCOPE("FramePacer::waitForFrame");
+            pacer.waitForFrame();
+        }
+        SLEEP_TRACE_SCOPE(TraceOverlay::kFrameScope);
+
+        if (liveFeed && drainLiveFeed(*liveFeed, liveToday)) {
+            liveMetrics = SleepAnalyzer::CalculateDailyMetrics(*liveToday);
+            liveArchitecture = SleepAnalyzer::CalculateArchitecture(*liveToday);
+        }
+        const AppData *data = loader->data();
 
-        ImGui_ImplOpenGL3_NewFrame();
-        ImGui_ImplGlfw_NewFrame();
-        ImGui::NewFrame();
+        {
+            SLEEP_TRACE_SCOPE("ImGui::NewFrame");
+            ImGui_ImplOpenGL3_NewFrame();
+            ImGui_ImplGlfw_NewFrame();
+            ImGui::NewFrame();
+        }
 
         ImGui::SetNextWindowPos(ImVec2(0, 0));
         ImGui::SetNextWindowSize(ImGui::GetIO().DisplaySize);
@@ -159,28 +283,97 @@ int main() {
                      ImGuiWindowFlags_NoMove |
                      ImGuiWindowFlags_NoBringToFrontOnFocus);
 
-        if (ImGui::BeginTabBar("MainTabs")) {
-            if (ImGui::BeginTabItem("Сегодня")) {
-                Visualization::ShowDailyPhasesPlot(todayData);
-                Visualization::ShowMetricsSummary(todayMetrics, false);
-                ImGui::EndTabItem();
+        if (!data) {
+            Visualization::ShowLoadingProgress(StartupLoader::stageName(loader->stage()), loader->progress());
+        } else {
+            // вкладки остаются доступны: живая ночь из --live показывается и без истории
+            if (!data->error.empty()) ImGui::Text("Не удалось загрузить данные: %s", data->error.c_str());
+            if (ImGui::BeginTabBar("MainTabs")) {
+                if (ImGui::BeginTabItem("Сегодня")) {
+                    if (liveToday) {
+                        Visualization::ShowDailyPhasesPlot(*liveToday);
+                        Visualization::ShowMetricsSummary(liveMetrics, liveArchitecture);
+                    } else {
+                        Visualization::ShowDailyPhasesPlot(data->today);
+                        Visualization::ShowMetricsSummary(data->todayMetrics, data->todayArchitecture);
+                    }
+                    ImGui::EndTabItem();
+                }
+
+                if (ImGui::BeginTabItem("Пульс и дыхание")) {
+                    if (liveToday) {
+                        Visualization::ShowNightSignals(*liveToday);
+                    } else {
+                        Visualization::ShowNightSignals(data->today);
+                    }
+                    ImGui::EndTabItem();
+                }
+
+                if (ImGui::BeginTabItem("Неделя")) {
+                    Visualization::ShowMetricsSummary(data->weeklyMetrics, true);
+                    ImGui::EndTabItem();
+                }
+
+                if (ImGui::BeginTabItem("Календарь")) {
+                    Visualization::ShowCalendarHeatmap(data->calendar);
+                    ImGui::EndTabItem();
+                }
+
+                if (ImGui::BeginTabItem("История")) {
+                    Visualization::ShowHistoryTimeline(data->timeline);
+                    ImGui::EndTabItem();
+                }
+
+                ImGui::EndTabBar();
             }
+        }
 
-            if (ImGui::BeginTabItem("Неделя")) {
-                Visualization::ShowMetricsSummary(weeklyMetrics, true);
-                ImGui::EndTabItem();
-            }
+        ImGui::End();
 
-            ImGui::EndTabBar();
+        if (profiler) {
+            profiler->draw();
         }
 
-        ImGui::End();
+        {
+            SLEEP_TRACE_SCOPE("ImGui::Render");
+            ImGui::Render();
+            glClear(GL_COLOR_BUFFER_BIT);
+            ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        }
+
+        {
+            SLEEP_TRACE_SCOPE("glfwSwapBuffers");
+            glfwSwapBuffers(window);
+        }
+        if (secondsToFirstFrame < 0.0) {
+            secondsToFirstFrame = std::chrono::duration<double>(StartupLoader::Clock::now() - startTime).count();
+        }
+        pacer.frameRendered(ImGui::IsAnyItemActive() || ImGui::GetIO().WantTextInput);
+    }
 
-        ImGui::Render();
-        glClear(GL_COLOR_BUFFER_BIT);
-        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+    // поток слежения будит цикл через GLFW, поэтому останавливается до завершения GLFW
+    liveFeed.reset();
+
+    if (options.printStats) {
+        const FramePacerStats stats = pacer.stats();
+        std::printf("frames: %lld, %.1f fps, cpu %.1f%%\n", stats.frames, stats.framesPerSecond(), stats.cpuPercent());
+        std::printf("first frame: %.1f ms\n", secondsToFirstFrame * 1000.0);
+        if (loader->secondsToData() >= 0.0) {
+            std::printf("data ready: %.1f ms\n", loader->secondsToData() * 1000.0);
+        } else {
+            std::printf("data ready: not loaded\n");
+        }
+    }
 
-        glfwSwapBuffers(window);
+    // загрузчик тоже будит цикл через GLFW; при незавершённом разборе он прерывается
+    loader.reset();
+
+    if (!options.traceFile.empty()) {
+        try {
+            Trace::writeChromeTrace(options.traceFile);
+        } catch (const std::exception &e) {
+            std::cerr << "error: " << e.what() << std::endl;
+        }
     }
 
     disposeGui();
@@ -0,0 +1,172 @@
+#include "CohortAnalyzer.h"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <numeric>
+#include <stdexcept>
+#include "../sleep_data_loader/DataLoader.h"
+
+namespace {
+
+std::string trim(const std::string &str) {
+    const auto first = str.find_first_not_of(" \t\r");
+    if (first == std::string::npos) return {};
+    const auto last = str.find_last_not_of(" \t\r");
+    return str.substr(first, last - first + 1);
+}
+
+std::int64_t toSeconds(DateTime t) {
+    return std::chrono::duration_cast<std::chrono::seconds>(t.time_since_epoch()).count();
+}
+
+double percentile(const std::vector<double> &sorted, double p) {
+    const double rank = p * static_cast<double>(sorted.size() - 1);
+    const auto lower = static_cast<std::size_t>(rank);
+    const std::size_t upper = std::min(lower + 1, sorted.size() - 1);
+    return sorted[lower] + (sorted[upper] - sorted[lower]) * (rank - static_cast<double>(lower));
+}
+
+} // namespace
+
+std::vector<CohortMember> CohortAnalyzer::loadManifest(const std::string &filename) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        throw std::runtime_error("unable to open manifest: " + filename);
+    }
+
+    const std::filesystem::path base = std::filesystem::path(filename).parent_path();
+    std::vector<CohortMember> members;
+    std::string line;
+    while (std::getline(file, line)) {
+        line = trim(line);
+        if (line.empty() || line[0] == '#') continue;
+
+        const auto comma = line.find(',');
+        std::string path = trim(comma == std::string::npos ? line : line.substr(comma + 1));
+        std::string id = comma == std::string::npos ? path : trim(line.substr(0, comma));
+        if (std::filesystem::path(path).is_relative()) {
+            path = (base / path).string();
+        }
+        members.push_back({std::move(id), std::move(path)});
+    }
+    return members;
+}
+
+CohortMemberSummary CohortAnalyzer::analyzeMember(const CohortMember &member, SleepMetricsCache *cache,
+                                                  SleepMetricsExporter *exporter, std::uint32_t user) {
+    CohortMemberSummary summary;
+    summary.id = member.id;
+    summary.path = member.path;
+
+    SleepMetricsTotals totals;
+    std::vector<NightMetrics> cached;
+    // ночи файла для выгрузки; архитектура рассчитывается, только если она нужна выгрузке
+    std::vector<std::int64_t> dates;
+    std::vector<SleepMetrics> nights;
+    std::vector<SleepArchitecture> architecture;
+    try {
+        const std::vector<std::string> files = std::filesystem::is_directory(member.path)
+                                               ? DataLoader::findJsonFiles(member.path)
+                                               : std::vector<std::string>{member.path};
+        for (const auto &file: files) {
+            // ночи файла учитываются, только если он разобран целиком
+            SleepMetricsTotals fileTotals;
+            dates.clear();
+            nights.clear();
+            architecture.clear();
+            try {
+                if (cache != nullptr) {
+                    SleepAnalyzer::CalculateFileMetrics(file, *cache, cached);
+                    for (const NightMetrics &night: cached) {
+                        fileTotals.add(night.metrics);
+                        if (exporter == nullptr) continue;
+                        dates.push_back(night.date);
+                        nights.push_back(night.metrics);
+                        architecture.push_back(night.architecture);
+                    }
+                } else {
+                    DataLoader::streamFromJsonFile(file, [&](DailySleepData &&day) {
+                        const SleepMetrics metrics = SleepAnalyzer::CalculateDailyMetrics(day);
+                        fileTotals.add(metrics);
+                        if (exporter == nullptr) return;
+                        dates.push_back(toSeconds(day.date));
+                        nights.push_back(metrics);
+                        architecture.push_back(SleepAnalyzer::CalculateArchitecture(day));
+                    });
+                }
+            } catch (const std::exception &e) {
+                if (summary.error.empty()) summary.error = e.what();
+                continue;
+            }
+            totals += fileTotals;
+            if (exporter != nullptr) exporter->append(user, dates, nights, architecture);
+        }
+    } catch (const std::exception &e) {
+        summary.error = e.what();
+    }
+
+    summary.nights = static_cast<std::size_t>(totals.nights);
+    if (summary.nights > 0) {
+        summary.average = totals.average();
+    }
+    return summary;
+}
+
+CohortSummary CohortAnalyzer::analyze(std::span<const CohortMember> members, WorkStealingPool &pool,
+                                      const RecommendationRules &rules, SleepMetricsCache *cache,
+                                      SleepMetricsExporter *exporter) {
+    CohortSummary cohort;
+    cohort.members.resize(members.size());
+    pool.parallelFor(members.size(), [&](std::size_t i) {
+        cohort.members[i] = analyzeMember(members[i], cache, exporter, static_cast<std::uint32_t>(i));
+    });
+
+    std::vector<SleepMetrics> averages(cohort.members.size());
+    std::vector<RuleMask> recommendations(cohort.members.size());
+    for (std::size_t i = 0; i < cohort.members.size(); ++i) {
+        averages[i] = cohort.members[i].average;
+    }
+    rules.evaluate(averages, recommendations);
+    for (std::size_t i = 0; i < cohort.members.size(); ++i) {
+        if (cohort.members[i].nights > 0) cohort.members[i].recommendations = recommendations[i];
+    }
+
+    std::vector<double> efficiency, deepSleepPercent, remSleepPercent, totalSleepTime;
+    for (const auto &member: cohort.members) {
+        cohort.nights += member.nights;
+        if (member.nights == 0) continue;
+        efficiency.push_back(member.average.efficiency);
+        deepSleepPercent.push_back(member.average.deepSleepPercent);
+        remSleepPercent.push_back(member.average.remSleepPercent);
+        totalSleepTime.push_back(member.average.totalSleepTime);
+    }
+
+    const std::pair<std::vector<double> *, CohortDistribution *> distributions[] = {
+            {&efficiency,       &cohort.efficiency},
+            {&deepSleepPercent, &cohort.deepSleepPercent},
+            {&remSleepPercent,  &cohort.remSleepPercent},
+            {&totalSleepTime,   &cohort.totalSleepTime}
+    };
+    pool.parallelFor(std::size(distributions), [&](std::size_t i) {
+        *distributions[i].second = distributionOf(std::move(*distributions[i].first));
+    });
+    return cohort;
+}
+
+CohortDistribution CohortAnalyzer::distributionOf(std::vector<double> values) {
+    CohortDistribution distribution;
+    if (values.empty()) return distribution;
+
+    std::sort(values.begin(), values.end());
+    distribution.count = values.size();
+    distribution.mean = std::accumulate(values.begin(), values.end(), 0.0) / static_cast<double>(values.size());
+    distribution.min = values.front();
+    distribution.p10 = percentile(values, 0.10);
+    distribution.p25 = percentile(values, 0.25);
+    distribution.median = percentile(values, 0.50);
+    distribution.p75 = percentile(values, 0.75);
+    distribution.p90 = percentile(values, 0.90);
+    distribution.max = values.back();
+    return distribution;
+}
@@ -0,0 +1,124 @@
+#ifndef SLEEP_VISUALIZER_COHORTANALYZER_H
+#define SLEEP_VISUALIZER_COHORTANALYZER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+#include "RecommendationRules.h"
+#include "SleepAnalyzer.h"
+#include "SleepMetricsCache.h"
+#include "SleepMetricsExporter.h"
+#include "../sleep_data_loader/WorkStealingPool.h"
+
+/**
+ * @brief Участник когорты из манифеста.
+ */
+struct CohortMember {
+    std::string id;   ///< Идентификатор участника
+    std::string path; ///< JSON-файл или каталог с JSON-файлами участника
+};
+
+/**
+ * @brief Результат анализа одного участника.
+ */
+struct CohortMemberSummary {
+    std::string id;             ///< Идентификатор участника
+    std::string path;           ///< Путь к данным участника
+    std::size_t nights = 0;     ///< Количество разобранных ночей
+    SleepMetrics average{};     ///< Средние метрики по всем ночам участника
+    RuleMask recommendations = 0; ///< Правила, сработавшие по средним метрикам; 0, если ночей нет
+    std::string error;          ///< Текст ошибки; пустой, если данные загружены успешно
+};
+
+/**
+ * @brief Распределение показателя по участникам когорты.
+ *
+ * Процентили считаются линейной интерполяцией между соседними по рангу значениями.
+ */
+struct CohortDistribution {
+    std::size_t count = 0; ///< Количество участников с данными
+    double mean = 0.0;     ///< Среднее
+    double min = 0.0;      ///< Минимум
+    double p10 = 0.0;      ///< 10-й процентиль
+    double p25 = 0.0;      ///< 25-й процентиль
+    double median = 0.0;   ///< Медиана
+    double p75 = 0.0;      ///< 75-й процентиль
+    double p90 = 0.0;      ///< 90-й процентиль
+    double max = 0.0;      ///< Максимум
+};
+
+/**
+ * @brief Результат анализа когорты.
+ */
+struct CohortSummary {
+    std::vector<CohortMemberSummary> members; ///< Участники в порядке манифеста
+    std::size_t nights = 0;                   ///< Количество ночей всех участников
+    CohortDistribution efficiency;            ///< Средняя эффективность сна участников
+    CohortDistribution deepSleepPercent;      ///< Средняя доля глубокого сна участников, %
+    CohortDistribution remSleepPercent;       ///< Средняя доля REM сна участников, %
+    CohortDistribution totalSleepTime;        ///< Среднее время сна участников, мин.
+};
+
+/**
+ * @brief Анализ когорты участников (например, исследования в клинике).
+ *
+ * Данные каждого участника разбираются потоково через DataLoader::streamFromJsonFile, и ночи
+ * сразу сворачиваются в SleepMetricsTotals, поэтому в памяти одновременно находятся только ночи,
+ * разбираемые в данный момент, а не истории всех участников. Участники обрабатываются задачами пула.
+ * Объекты этого класса создавать нельзя.
+ */
+class CohortAnalyzer {
+public:
+    CohortAnalyzer() = delete;
+
+    /**
+     * @brief Читает манифест когорты.
+     *
+     * Каждая непустая строка, не начинающаяся с '#', имеет вид "id,путь" или "путь"; во втором случае
+     * идентификатором служит сам путь. Относительные пути отсчитываются от каталога манифеста.
+     *
+     * @param filename Путь к манифесту.
+     * @return Участники в порядке строк манифеста.
+     *
+     * @throws std::runtime_error Если манифест невозможно открыть.
+     */
+    static std::vector<CohortMember> loadManifest(const std::string &filename);
+
+    /**
+     * @brief Рассчитывает средние метрики одного участника.
+     *
+     * Файлы каталога читаются по порядку путей, ночи из них не объединяются. Ошибки загрузки
+     * не выбрасываются, а записываются в CohortMemberSummary::error.
+     *
+     * @param member Участник.
+     * @param cache Кэш метрик ночей; если nullptr, файлы разбираются потоково и все ночи рассчитываются.
+     * @param exporter Выгрузка, в которую добавляются ночи каждого разобранного файла, или nullptr.
+     * @param user Индекс участника в выгрузке.
+     */
+    static CohortMemberSummary analyzeMember(const CohortMember &member, SleepMetricsCache *cache = nullptr,
+                                             SleepMetricsExporter *exporter = nullptr, std::uint32_t user = 0);
+
+    /**
+     * @brief Анализирует всех участников и рассчитывает распределения по когорте.
+     *
+     * Средние метрики всех участников проверяются правилами одним пакетом.
+     *
+     * @param members Участники когорты.
+     * @param pool Пул потоков.
+     * @param rules Правила рекомендаций.
+     * @param cache Кэш метрик ночей или nullptr.
+     * @param exporter Выгрузка ночей всех участников или nullptr; индекс участника в ней - его номер в members.
+     */
+    static CohortSummary analyze(std::span<const CohortMember> members, WorkStealingPool &pool,
+                                 const RecommendationRules &rules, SleepMetricsCache *cache = nullptr,
+                                 SleepMetricsExporter *exporter = nullptr);
+
+    /**
+     * @brief Рассчитывает среднее и процентили набора значений.
+     */
+    static CohortDistribution distributionOf(std::vector<double> values);
+};
+
+#endif //SLEEP_VISUALIZER_COHORTANALYZER_H
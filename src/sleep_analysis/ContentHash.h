@@ -0,0 +1,31 @@
+/**
+ * @file ContentHash.h
+ * @brief Быстрый некриптографический хеш содержимого для ключей кэша.
+ */
+#ifndef SLEEP_VISUALIZER_CONTENTHASH_H
+#define SLEEP_VISUALIZER_CONTENTHASH_H
+
+#include <cstdint>
+#include <string_view>
+
+/**
+ * @brief 64-битный хеш XXH64.
+ *
+ * Результат совпадает с эталонной реализацией xxHash на little-endian процессорах, поэтому ключи,
+ * записанные на диск, не зависят от сборки. Скорость - несколько ГБ/с, что много быстрее разбора JSON.
+ * Объекты этого класса создавать нельзя.
+ */
+class ContentHash {
+public:
+    ContentHash() = delete;
+
+    /**
+     * @brief Хеширует байты.
+     *
+     * @param bytes Данные.
+     * @param seed Начальное значение; разные значения дают независимые хеши одних и тех же данных.
+     */
+    static std::uint64_t xxh64(std::string_view bytes, std::uint64_t seed = 0);
+};
+
+#endif //SLEEP_VISUALIZER_CONTENTHASH_H
@@ -0,0 +1,88 @@
+#include <array>
+#include <chrono>
+#include <format>
+#include <string>
+#include "DateUtils.h"
+
+namespace {
+
+constexpr int kMinutesPerDay = 24 * 60;
+
+/**
+ * Минута суток (0..1439) для любой временной точки, в том числе до 1970 года.
+ */
+int minuteOfDay(const std::chrono::system_clock::time_point &tp) {
+    const auto sinceMidnight = tp - std::chrono::floor<std::chrono::days>(tp);
+    return static_cast<int>(std::chrono::floor<std::chrono::minutes>(sinceMidnight).count());
+}
+
+/**
+ * Форматирует в буфер и завершает строку нулём; format_to_n с целыми числами не выделяет память.
+ */
+template<typename... Args>
+std::size_t formatTo(std::span<char> out, std::format_string<Args...> format, Args &&...args) {
+    if (out.empty()) return 0;
+    const auto result = std::format_to_n(out.data(), static_cast<std::ptrdiff_t>(out.size() - 1), format,
+                                         std::forward<Args>(args)...);
+    *result.out = '\0';
+    return static_cast<std::size_t>(result.out - out.data());
+}
+
+} // namespace
+
+std::string DateUtils::onlyTime(const std::chrono::system_clock::time_point &tp) {
+    std::array<char, kFormatBufferSize> buffer{};
+    return {buffer.data(), onlyTime(tp, buffer)};
+}
+
+std::size_t DateUtils::onlyTime(const std::chrono::system_clock::time_point &tp, std::span<char> out) {
+    const int minute = minuteOfDay(tp);
+    return formatTo(out, "{:02}:{:02}", minute / 60, minute % 60);
+}
+
+const char *DateUtils::timeLabel(const std::chrono::system_clock::time_point &tp) {
+    using Label = std::array<char, 6>;
+    static const std::array<Label, kMinutesPerDay> labels = [] {
+        std::array<Label, kMinutesPerDay> table{};
+        for (int minute = 0; minute < kMinutesPerDay; ++minute) {
+            formatTo(table[minute], "{:02}:{:02}", minute / 60, minute % 60);
+        }
+        return table;
+    }();
+    return labels[minuteOfDay(tp)].data();
+}
+
+std::string DateUtils::onlyDate(const std::chrono::system_clock::time_point &tp) {
+    std::array<char, kFormatBufferSize> buffer{};
+    return {buffer.data(), onlyDate(tp, buffer)};
+}
+
+std::size_t DateUtils::onlyDate(const std::chrono::system_clock::time_point &tp, std::span<char> out) {
+    const std::chrono::year_month_day date{std::chrono::floor<std::chrono::days>(tp)};
+    return formatTo(out, "{:04}-{:02}-{:02}", static_cast<int>(date.year()), static_cast<unsigned>(date.month()),
+                    static_cast<unsigned>(date.day()));
+}
+
+std::chrono::system_clock::time_point DateUtils::unixToTimePoint(const double &unixTime) {
+    return std::chrono::system_clock::time_point(std::chrono::milliseconds(static_cast<int64_t>(unixTime * 1000)));
+}
+
+double DateUtils::timePointToUnix(const std::chrono::system_clock::time_point &tp) {
+    auto duration = std::chrono::duration<double>(tp.time_since_epoch());
+    return duration.count();
+}
+
+int DateUtils::diffBetween(const std::chrono::system_clock::time_point &start,
+                           const std::chrono::system_clock::time_point &end) {
+
+    return std::chrono::duration_cast<std::chrono::minutes>(end - start).count();
+}
+
+std::string DateUtils::formatTimeDiff(const int &timeDiff) {
+    std::array<char, kFormatBufferSize> buffer{};
+    return {buffer.data(), formatTimeDiff(timeDiff, buffer)};
+}
+
+std::size_t DateUtils::formatTimeDiff(int timeDiff, std::span<char> out) {
+    return formatTo(out, "{} ч. {} мин.", timeDiff / 60, timeDiff % 60);
+}
@@ -2,6 +2,8 @@
 #define SLEEPVISUALIZER_DATE_FORMATTER_H
 
 #include <chrono>
+#include <cstddef>
+#include <span>
 #include <string>
 
 /**
@@ -10,9 +12,15 @@
  * Этот класс предоставляет статические методы для конвертации между разными представлениями времени
  * и форматирования.
  * Объекты этого класса создавать нельзя.
+ *
+ * Методы форматирования, возвращающие std::string, выделяют память на каждый вызов. Для текста, который
+ * строится при отрисовке, есть перегрузки, пишущие в буфер вызывающего, и timeLabel() с готовыми подписями.
  */
 class DateUtils {
 public:
+    /// Размер буфера, в который помещается любой результат форматирования вместе с завершающим нулём.
+    static constexpr std::size_t kFormatBufferSize = 40;
+
     DateUtils() = delete;
 
     DateUtils(const DateUtils &) = delete;
@@ -28,6 +36,26 @@ public:
     //todo возможно возвращать c_str()
     static std::string onlyTime(const std::chrono::system_clock::time_point &tp);
 
+    /**
+     * @brief Записывает время в формате ЧЧ:ММ в буфер, не выделяя память.
+     *
+     * @param tp Временная точка, которую нужно отформатировать.
+     * @param out Буфер; строка обрезается до out.size() - 1 символов и завершается нулём.
+     * @return Количество записанных символов без завершающего нуля.
+     */
+    static std::size_t onlyTime(const std::chrono::system_clock::time_point &tp, std::span<char> out);
+
+    /**
+     * @brief Возвращает подпись времени в формате ЧЧ:ММ из таблицы на все минуты суток.
+     *
+     * Таблица строится при первом вызове, поэтому подпись не нужно ни форматировать, ни хранить:
+     * указатель действителен до конца программы.
+     *
+     * @param tp Временная точка; секунды отбрасываются.
+     * @return Строка, завершённая нулём.
+     */
+    static const char *timeLabel(const std::chrono::system_clock::time_point &tp);
+
     /**
      * @brief Форматирует время в строку только с датой.
      *
@@ -36,6 +64,15 @@ public:
      */
     static std::string onlyDate(const std::chrono::system_clock::time_point &tp);
 
+    /**
+     * @brief Записывает дату в формате YYYY-MM-DD в буфер, не выделяя память.
+     *
+     * @param tp Временная точка, которую нужно отформатировать.
+     * @param out Буфер; строка обрезается до out.size() - 1 символов и завершается нулём.
+     * @return Количество записанных символов без завершающего нуля.
+     */
+    static std::size_t onlyDate(const std::chrono::system_clock::time_point &tp, std::span<char> out);
+
     /**
      * @brief Конвертирует Unix timestamp в time_point.
      *
@@ -70,6 +107,15 @@ public:
     * @return Стнрока вида X ч. Y мин.
     */
     static std::string formatTimeDiff(const int& timeDiff);
+
+    /**
+     * @brief Записывает разницу во времени в виде X ч. Y мин. в буфер, не выделяя память.
+     *
+     * @param timeDiff Разница во времени в минутах.
+     * @param out Буфер; строка обрезается до out.size() - 1 символов и завершается нулём.
+     * @return Количество записанных символов без завершающего нуля.
+     */
+    static std::size_t formatTimeDiff(int timeDiff, std::span<char> out);
 };
 
 #endif //SLEEPVISUALIZER_DATE_FORMATTER_H
@@ -0,0 +1,200 @@
+#include "PhaseAggregation.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define SLEEP_VISUALIZER_X86_KERNELS 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+constexpr int kTypeCount = 4;
+
+/**
+ * Суммы по типам фаз; индекс - значение SleepPhaseType.
+ */
+struct TypeSums {
+    int minutes[kTypeCount] = {};
+    int awakenings = 0;
+};
+
+void aggregateScalar(const std::uint8_t *types, const std::int32_t *durations, std::size_t first, std::size_t last,
+                     TypeSums &sums) {
+    for (std::size_t i = first; i < last; ++i) {
+        const unsigned type = types[i];
+        if (type >= kTypeCount) continue;
+        sums.minutes[type] += durations[i] / 60;
+        sums.awakenings += type == static_cast<unsigned>(SleepPhaseType::Awake);
+    }
+}
+
+#if defined(SLEEP_VISUALIZER_X86_KERNELS)
+
+// Деление на 60 выполняется в double: для любых int32 частное округляется к тому же целому,
+// что и целочисленное деление, поэтому результат совпадает со скалярным побитно.
+
+__attribute__((target("avx2")))
+void aggregateAvx2(const std::uint8_t *types, const std::int32_t *durations, std::size_t first, std::size_t last,
+                   TypeSums &sums) {
+    const __m256d sixty = _mm256_set1_pd(60.0);
+    const __m256i awake = _mm256_set1_epi32(static_cast<int>(SleepPhaseType::Awake));
+    __m256i acc[kTypeCount] = {_mm256_setzero_si256(), _mm256_setzero_si256(), _mm256_setzero_si256(),
+                               _mm256_setzero_si256()};
+    __m256i awakenings = _mm256_setzero_si256();
+
+    std::size_t i = first;
+    for (; i + 8 <= last; i += 8) {
+        const __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(durations + i));
+        const __m128i lo = _mm256_cvttpd_epi32(_mm256_div_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(d)), sixty));
+        const __m128i hi = _mm256_cvttpd_epi32(_mm256_div_pd(_mm256_cvtepi32_pd(_mm256_extracti128_si256(d, 1)), sixty));
+        const __m256i minutes = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+
+        const __m256i t = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(types + i)));
+
+        for (int k = 0; k < kTypeCount; ++k) {
+            const __m256i mask = _mm256_cmpeq_epi32(t, _mm256_set1_epi32(k));
+            acc[k] = _mm256_add_epi32(acc[k], _mm256_and_si256(mask, minutes));
+        }
+        // маска совпадения равна -1, поэтому вычитание считает количество
+        awakenings = _mm256_sub_epi32(awakenings, _mm256_cmpeq_epi32(t, awake));
+    }
+
+    alignas(32) int lanes[8];
+    for (int k = 0; k < kTypeCount; ++k) {
+        _mm256_store_si256(reinterpret_cast<__m256i *>(lanes), acc[k]);
+        for (int lane: lanes) sums.minutes[k] += lane;
+    }
+    _mm256_store_si256(reinterpret_cast<__m256i *>(lanes), awakenings);
+    for (int lane: lanes) sums.awakenings += lane;
+
+    aggregateScalar(types, durations, i, last, sums);
+}
+
+__attribute__((target("sse2")))
+void aggregateSse2(const std::uint8_t *types, const std::int32_t *durations, std::size_t first, std::size_t last,
+                   TypeSums &sums) {
+    const __m128d sixty = _mm_set1_pd(60.0);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i awake = _mm_set1_epi32(static_cast<int>(SleepPhaseType::Awake));
+    __m128i acc[kTypeCount] = {zero, zero, zero, zero};
+    __m128i awakenings = zero;
+
+    std::size_t i = first;
+    for (; i + 4 <= last; i += 4) {
+        const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i *>(durations + i));
+        const __m128i lo = _mm_cvttpd_epi32(_mm_div_pd(_mm_cvtepi32_pd(d), sixty));
+        const __m128i hi = _mm_cvttpd_epi32(_mm_div_pd(_mm_cvtepi32_pd(_mm_shuffle_epi32(d, 0x4E)), sixty));
+        const __m128i minutes = _mm_unpacklo_epi64(lo, hi);
+
+        std::int32_t packed;
+        std::memcpy(&packed, types + i, sizeof(packed));
+        const __m128i t = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(packed), zero), zero);
+
+        for (int k = 0; k < kTypeCount; ++k) {
+            const __m128i mask = _mm_cmpeq_epi32(t, _mm_set1_epi32(k));
+            acc[k] = _mm_add_epi32(acc[k], _mm_and_si128(mask, minutes));
+        }
+        awakenings = _mm_sub_epi32(awakenings, _mm_cmpeq_epi32(t, awake));
+    }
+
+    alignas(16) int lanes[4];
+    for (int k = 0; k < kTypeCount; ++k) {
+        _mm_store_si128(reinterpret_cast<__m128i *>(lanes), acc[k]);
+        for (int lane: lanes) sums.minutes[k] += lane;
+    }
+    _mm_store_si128(reinterpret_cast<__m128i *>(lanes), awakenings);
+    for (int lane: lanes) sums.awakenings += lane;
+
+    aggregateScalar(types, durations, i, last, sums);
+}
+
+#endif
+
+using Kernel = void (*)(const std::uint8_t *, const std::int32_t *, std::size_t, std::size_t, TypeSums &);
+
+Kernel kernelFor(PhaseAggregation::Path path) {
+    switch (path) {
+#if defined(SLEEP_VISUALIZER_X86_KERNELS)
+        case PhaseAggregation::Path::AVX2:
+            return aggregateAvx2;
+        case PhaseAggregation::Path::SSE2:
+            return aggregateSse2;
+#endif
+        default:
+            return aggregateScalar;
+    }
+}
+
+/**
+ * Минуты от отхода ко сну до первой фазы сна. Обычно это первая или вторая фаза ночи,
+ * поэтому векторизовать поиск незачем.
+ */
+int sleepOnsetMinutes(const SleepPhaseColumns &history, std::size_t n, int timeInBed) {
+    for (std::size_t k = history.nightOffsets[n]; k < history.nightOffsets[n + 1]; ++k) {
+        const auto type = static_cast<SleepPhaseType>(history.types[k]);
+        if (type == SleepPhaseType::Light || type == SleepPhaseType::Deep || type == SleepPhaseType::REM) {
+            return std::max(history.startOffsets[k], 0) / 60;
+        }
+    }
+    return timeInBed;
+}
+
+} // namespace
+
+bool PhaseAggregation::IsSupported(Path path) {
+    switch (path) {
+        case Path::Scalar:
+            return true;
+#if defined(SLEEP_VISUALIZER_X86_KERNELS)
+        case Path::SSE2:
+            return __builtin_cpu_supports("sse2");
+        case Path::AVX2:
+            return __builtin_cpu_supports("avx2");
+#endif
+        default:
+            return false;
+    }
+}
+
+PhaseAggregation::Path PhaseAggregation::BestPath() {
+    static const Path best = IsSupported(Path::AVX2) ? Path::AVX2
+                                                     : IsSupported(Path::SSE2) ? Path::SSE2 : Path::Scalar;
+    return best;
+}
+
+const char *PhaseAggregation::PathName(Path path) {
+    switch (path) {
+        case Path::AVX2:
+            return "AVX2";
+        case Path::SSE2:
+            return "SSE2";
+        default:
+            return "Scalar";
+    }
+}
+
+void PhaseAggregation::Aggregate(const SleepPhaseColumns &history, std::span<PhaseTotals> out, Path path) {
+    const Kernel kernel = kernelFor(IsSupported(path) ? path : BestPath());
+    const std::uint8_t *types = history.types.data();
+    const std::int32_t *durations = history.durations.data();
+
+    for (std::size_t n = 0; n < history.nightCount(); ++n) {
+        TypeSums sums;
+        kernel(types, durations, history.nightOffsets[n], history.nightOffsets[n + 1], sums);
+
+        PhaseTotals &totals = out[n];
+        totals.timeInBed = static_cast<int>((history.wakeTimes[n] - history.bedtimes[n]) / 60);
+        totals.lightSleepDuration = sums.minutes[static_cast<int>(SleepPhaseType::Light)];
+        totals.deepSleepDuration = sums.minutes[static_cast<int>(SleepPhaseType::Deep)];
+        totals.remSleepDuration = sums.minutes[static_cast<int>(SleepPhaseType::REM)];
+        totals.awakeDuration = sums.minutes[static_cast<int>(SleepPhaseType::Awake)];
+        totals.awakeningsCount = sums.awakenings;
+        totals.sleepOnset = sleepOnsetMinutes(history, n, totals.timeInBed);
+    }
+}
+
+void PhaseAggregation::Aggregate(const SleepPhaseColumns &history, std::span<PhaseTotals> out) {
+    Aggregate(history, out, BestPath());
+}
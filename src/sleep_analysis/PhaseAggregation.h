@@ -0,0 +1,71 @@
+#ifndef SLEEP_VISUALIZER_PHASEAGGREGATION_H
+#define SLEEP_VISUALIZER_PHASEAGGREGATION_H
+
+#include <span>
+#include "../sleep_data_loader/SleepPhaseStore.h"
+
+/**
+ * @brief Суммы длительностей фаз за одну ночь, в минутах.
+ *
+ * Длительность каждой фазы переводится в минуты с отбрасыванием дробной части,
+ * так же как в DateUtils::diffBetween.
+ */
+struct PhaseTotals {
+    int timeInBed;          /**< Время в постели, мин. */
+    int lightSleepDuration; /**< Продолжительность легкого сна, мин. */
+    int deepSleepDuration;  /**< Продолжительность глубокого сна, мин. */
+    int remSleepDuration;   /**< Продолжительность REM сна, мин. */
+    int awakeDuration;      /**< Продолжительность бодрствования, мин. */
+    int awakeningsCount;    /**< Количество фаз бодрствования. */
+    int sleepOnset;         /**< От отхода ко сну до первой фазы сна, мин; timeInBed, если сна не было. */
+};
+
+/**
+ * @brief Векторная агрегация фаз сна по непрерывным колонкам SleepPhaseColumns.
+ *
+ * Вместо цепочки if/else по типу фазы каждая колонка обрабатывается блоками: тип фазы сравнивается
+ * со всеми типами сразу, и длительность добавляется в сумму по маске. Реализация (AVX2, SSE2 или скалярная)
+ * выбирается во время выполнения; результат всех реализаций совпадает побитно.
+ */
+class PhaseAggregation {
+public:
+    /**
+     * @brief Доступные реализации агрегации.
+     */
+    enum class Path {
+        Scalar, ///< Скалярная реализация
+        SSE2,   ///< 128-битные векторы
+        AVX2    ///< 256-битные векторы
+    };
+
+    /**
+     * @brief Возвращает самую быструю реализацию, поддерживаемую процессором.
+     */
+    static Path BestPath();
+
+    /**
+     * @brief Проверяет, поддерживает ли процессор реализацию.
+     */
+    static bool IsSupported(Path path);
+
+    /**
+     * @brief Название реализации для отчётов.
+     */
+    static const char *PathName(Path path);
+
+    /**
+     * @brief Считает суммы по фазам для всех ночей.
+     *
+     * @param history Колонки с данными о сне.
+     * @param out Результат, по элементу на ночь; размер должен быть не меньше history.nightCount().
+     * @param path Реализация; если процессор её не поддерживает, используется BestPath().
+     */
+    static void Aggregate(const SleepPhaseColumns &history, std::span<PhaseTotals> out, Path path);
+
+    /**
+     * @brief Считает суммы по фазам для всех ночей самой быстрой доступной реализацией.
+     */
+    static void Aggregate(const SleepPhaseColumns &history, std::span<PhaseTotals> out);
+};
+
+#endif //SLEEP_VISUALIZER_PHASEAGGREGATION_H
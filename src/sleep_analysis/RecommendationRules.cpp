@@ -0,0 +1,302 @@
+#include "RecommendationRules.h"
+#include "Trace.h"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <nlohmann/json.hpp>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define SLEEP_VISUALIZER_X86_KERNELS 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+/// Метрик в одном столбце пакета: столбец помещается в L1 вместе с масками
+constexpr std::size_t kChunk = 256;
+
+constexpr std::array<const char *, kRuleMetricCount> kMetricNames = {
+        "timeInBed", "totalSleepTime", "sleepOnset", "awakeningsCount", "awakeDuration", "deepSleepDuration",
+        "remSleepDuration", "lightSleepDuration", "lightSleepPercent", "deepSleepPercent", "remSleepPercent",
+        "efficiency"
+};
+
+constexpr std::array<const char *, 4> kOpNames = {"<", "<=", ">", ">="};
+
+template<auto Field>
+void gather(const SleepMetrics *batch, std::size_t count, double *out) {
+    for (std::size_t i = 0; i < count; ++i) {
+        out[i] = static_cast<double>(batch[i].*Field);
+    }
+}
+
+using GatherFn = void (*)(const SleepMetrics *, std::size_t, double *);
+
+/// Выписывает столбец метрики; порядок совпадает с RuleMetric
+constexpr std::array<GatherFn, kRuleMetricCount> kGather = {
+        gather<&SleepMetrics::timeInBed>, gather<&SleepMetrics::totalSleepTime>, gather<&SleepMetrics::sleepOnset>,
+        gather<&SleepMetrics::awakeningsCount>, gather<&SleepMetrics::awakeDuration>,
+        gather<&SleepMetrics::deepSleepDuration>, gather<&SleepMetrics::remSleepDuration>,
+        gather<&SleepMetrics::lightSleepDuration>, gather<&SleepMetrics::lightSleepPercent>,
+        gather<&SleepMetrics::deepSleepPercent>, gather<&SleepMetrics::remSleepPercent>,
+        gather<&SleepMetrics::efficiency>
+};
+
+template<RuleOp Op>
+bool holds(double value, double threshold) {
+    if constexpr (Op == RuleOp::Less) return value < threshold;
+    else if constexpr (Op == RuleOp::LessEqual) return value <= threshold;
+    else if constexpr (Op == RuleOp::Greater) return value > threshold;
+    else return value >= threshold;
+}
+
+// Ядра взводят бит правила в fail[i], если условие для i-го значения не выполнено.
+
+template<RuleOp Op>
+void failScalar(const double *values, std::size_t count, double threshold, RuleMask bit, RuleMask *fail) {
+    for (std::size_t i = 0; i < count; ++i) {
+        fail[i] |= bit * static_cast<RuleMask>(!holds<Op>(values[i], threshold));
+    }
+}
+
+#if defined(SLEEP_VISUALIZER_X86_KERNELS)
+
+// Сравнения упорядоченные: с NaN условие не выполняется, как и в скалярной версии.
+
+template<RuleOp Op>
+__m128d compareSse2(__m128d values, __m128d threshold) {
+    if constexpr (Op == RuleOp::Less) return _mm_cmplt_pd(values, threshold);
+    else if constexpr (Op == RuleOp::LessEqual) return _mm_cmple_pd(values, threshold);
+    else if constexpr (Op == RuleOp::Greater) return _mm_cmpgt_pd(values, threshold);
+    else return _mm_cmpge_pd(values, threshold);
+}
+
+template<RuleOp Op>
+void failSse2(const double *values, std::size_t count, double threshold, RuleMask bit, RuleMask *fail) {
+    const __m128d limit = _mm_set1_pd(threshold);
+    const __m128d bits = _mm_castsi128_pd(_mm_set1_epi64x(static_cast<long long>(bit)));
+    std::size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        const __m128d pass = compareSse2<Op>(_mm_loadu_pd(values + i), limit);
+        const __m128d acc = _mm_loadu_pd(reinterpret_cast<const double *>(fail + i));
+        _mm_storeu_pd(reinterpret_cast<double *>(fail + i), _mm_or_pd(acc, _mm_andnot_pd(pass, bits)));
+    }
+    failScalar<Op>(values + i, count - i, threshold, bit, fail + i);
+}
+
+template<RuleOp Op>
+constexpr int kAvxPredicate = Op == RuleOp::Less ? _CMP_LT_OQ
+                              : Op == RuleOp::LessEqual ? _CMP_LE_OQ
+                              : Op == RuleOp::Greater ? _CMP_GT_OQ
+                              : _CMP_GE_OQ;
+
+template<RuleOp Op>
+__attribute__((target("avx2")))
+void failAvx2(const double *values, std::size_t count, double threshold, RuleMask bit, RuleMask *fail) {
+    const __m256d limit = _mm256_set1_pd(threshold);
+    const __m256d bits = _mm256_castsi256_pd(_mm256_set1_epi64x(static_cast<long long>(bit)));
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m256d pass = _mm256_cmp_pd(_mm256_loadu_pd(values + i), limit, kAvxPredicate<Op>);
+        const __m256d acc = _mm256_loadu_pd(reinterpret_cast<const double *>(fail + i));
+        _mm256_storeu_pd(reinterpret_cast<double *>(fail + i), _mm256_or_pd(acc, _mm256_andnot_pd(pass, bits)));
+    }
+    // без сброса верхних половин регистров скалярный хвост платит за переход AVX-SSE
+    _mm256_zeroupper();
+    failScalar<Op>(values + i, count - i, threshold, bit, fail + i);
+}
+
+#endif
+
+using FailKernel = void (*)(const double *, std::size_t, double, RuleMask, RuleMask *);
+
+template<RuleOp Op>
+FailKernel failKernelFor(RecommendationRules::Path path) {
+    switch (PhaseAggregation::IsSupported(path) ? path : PhaseAggregation::BestPath()) {
+#if defined(SLEEP_VISUALIZER_X86_KERNELS)
+        case RecommendationRules::Path::AVX2:
+            return failAvx2<Op>;
+        case RecommendationRules::Path::SSE2:
+            return failSse2<Op>;
+#endif
+        default:
+            return failScalar<Op>;
+    }
+}
+
+FailKernel failKernelFor(RecommendationRules::Path path, RuleOp op) {
+    switch (op) {
+        case RuleOp::Less:
+            return failKernelFor<RuleOp::Less>(path);
+        case RuleOp::LessEqual:
+            return failKernelFor<RuleOp::LessEqual>(path);
+        case RuleOp::Greater:
+            return failKernelFor<RuleOp::Greater>(path);
+        default:
+            return failKernelFor<RuleOp::GreaterEqual>(path);
+    }
+}
+
+template<typename Enum, std::size_t N>
+Enum parseName(const std::string &name, const std::array<const char *, N> &names, const char *what) {
+    for (std::size_t i = 0; i < N; ++i) {
+        if (name == names[i]) return static_cast<Enum>(i);
+    }
+    throw std::runtime_error(std::string("unknown rule ") + what + ": " + name);
+}
+
+RecommendationRule rule(std::string id, RuleMetric metric, double threshold, std::string text) {
+    return {std::move(id), {{metric, RuleOp::Less, threshold}}, std::move(text)};
+}
+
+} // namespace
+
+RecommendationRules::RecommendationRules(std::vector<RecommendationRule> rules, std::string header,
+                                         std::string fallback)
+        : rules_(std::move(rules)), header_(std::move(header)), fallback_(std::move(fallback)) {
+    if (rules_.size() > kMaxRules) {
+        throw std::invalid_argument("too many recommendation rules: " + std::to_string(rules_.size()));
+    }
+    for (std::size_t i = 0; i < rules_.size(); ++i) {
+        const RecommendationRule &r = rules_[i];
+        if (r.conditions.empty()) throw std::invalid_argument("recommendation rule has no conditions: " + r.id);
+        for (std::size_t j = 0; j < i; ++j) {
+            if (rules_[j].id == r.id) throw std::invalid_argument("duplicate recommendation rule: " + r.id);
+        }
+
+        const RuleMask bit = RuleMask{1} << i;
+        allRules_ |= bit;
+        for (const RuleCondition &c: r.conditions) {
+            if (static_cast<std::size_t>(c.metric) >= kRuleMetricCount) {
+                throw std::invalid_argument("invalid metric in recommendation rule: " + r.id);
+            }
+            predicates_.push_back({c.metric, c.op, c.threshold, bit});
+        }
+    }
+    // условия одной метрики идут подряд, и её столбец выписывается один раз на блок
+    std::stable_sort(predicates_.begin(), predicates_.end(), [](const Predicate &a, const Predicate &b) {
+        return a.metric < b.metric;
+    });
+}
+
+const RecommendationRules &RecommendationRules::Defaults() {
+    static const RecommendationRules defaults(
+            {
+                    rule("short_sleep", RuleMetric::TotalSleepTime, 420.0,
+                         "Старайтесь увеличить общее время сна, и перечислить рекомендации."),
+                    rule("short_rem", RuleMetric::RemSleepDuration, 60.0,
+                         "Рекомендации, чтобы улучшить длительность REM-фазы."),
+                    rule("short_deep", RuleMetric::DeepSleepDuration, 90.0,
+                         "рекомендации, чтобы улучшить глубокий сон."),
+                    rule("low_efficiency", RuleMetric::Efficiency, 70.0,
+                         "У вас низкая эффективность сна. Рекомендации.")
+            },
+            "Рекомендации:", "Ваш сон в порядке!");
+    return defaults;
+}
+
+RecommendationRules RecommendationRules::Parse(std::string_view text) {
+    using nlohmann::json;
+
+    std::vector<RecommendationRule> rules;
+    std::string header, fallback;
+    try {
+        const json config = json::parse(text.begin(), text.end());
+        header = config.value("header", Defaults().header_);
+        fallback = config.value("fallback", Defaults().fallback_);
+        for (const json &entry: config.at("rules")) {
+            RecommendationRule r;
+            r.id = entry.at("id").get<std::string>();
+            r.text = entry.at("text").get<std::string>();
+            for (const json &condition: entry.at("when")) {
+                RuleCondition c;
+                c.metric = parseName<RuleMetric>(condition.at("metric").get<std::string>(), kMetricNames, "metric");
+                c.op = parseName<RuleOp>(condition.at("op").get<std::string>(), kOpNames, "operator");
+                c.threshold = condition.at("value").get<double>();
+                r.conditions.push_back(c);
+            }
+            rules.push_back(std::move(r));
+        }
+    } catch (const json::exception &e) {
+        throw std::runtime_error(std::string("invalid recommendation rules: ") + e.what());
+    }
+    return {std::move(rules), std::move(header), std::move(fallback)};
+}
+
+RecommendationRules RecommendationRules::Load(const std::string &filename) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("unable to open file: " + filename);
+    }
+    std::ostringstream content;
+    content << file.rdbuf();
+    return Parse(content.view());
+}
+
+const char *RecommendationRules::MetricName(RuleMetric metric) {
+    const auto index = static_cast<std::size_t>(metric);
+    return index < kMetricNames.size() ? kMetricNames[index] : "unknown";
+}
+
+RuleMask RecommendationRules::evaluate(const SleepMetrics &metrics) const {
+    RuleMask fail = 0;
+    for (const Predicate &p: predicates_) {
+        double value;
+        kGather[static_cast<std::size_t>(p.metric)](&metrics, 1, &value);
+        failKernelFor(Path::Scalar, p.op)(&value, 1, p.threshold, p.bit, &fail);
+    }
+    return allRules_ & ~fail;
+}
+
+void RecommendationRules::evaluate(std::span<const SleepMetrics> batch, std::span<RuleMask> out, Path path) const {
+    SLEEP_TRACE_SCOPE("RecommendationRules::evaluate");
+
+    alignas(32) double values[kChunk];
+    for (std::size_t first = 0; first < batch.size(); first += kChunk) {
+        const std::size_t count = std::min(kChunk, batch.size() - first);
+        RuleMask *fail = out.data() + first;
+        std::fill(fail, fail + count, RuleMask{0});
+
+        std::size_t gathered = kRuleMetricCount;
+        for (const Predicate &p: predicates_) {
+            const auto metric = static_cast<std::size_t>(p.metric);
+            if (metric != gathered) {
+                kGather[metric](batch.data() + first, count, values);
+                gathered = metric;
+            }
+            failKernelFor(path, p.op)(values, count, p.threshold, p.bit, fail);
+        }
+        for (std::size_t i = 0; i < count; ++i) {
+            fail[i] = allRules_ & ~fail[i];
+        }
+    }
+}
+
+void RecommendationRules::evaluate(std::span<const SleepMetrics> batch, std::span<RuleMask> out) const {
+    evaluate(batch, out, PhaseAggregation::BestPath());
+}
+
+void RecommendationRules::render(RuleMask mask, std::string &out) const {
+    out += header_;
+    out += '\n';
+    if (mask == 0) {
+        out += "- ";
+        out += fallback_;
+        out += '\n';
+        return;
+    }
+    for (RuleMask rest = mask & allRules_; rest != 0; rest &= rest - 1) {
+        out += "- ";
+        out += rules_[static_cast<std::size_t>(std::countr_zero(rest))].text;
+        out += '\n';
+    }
+}
+
+std::string RecommendationRules::render(RuleMask mask) const {
+    std::string text;
+    render(mask, text);
+    return text;
+}
@@ -0,0 +1,181 @@
+/**
+ * @file RecommendationRules.h
+ * @brief Правила рекомендаций: загрузка из конфигурации и пакетная проверка метрик.
+ */
+#ifndef SLEEP_VISUALIZER_RECOMMENDATIONRULES_H
+#define SLEEP_VISUALIZER_RECOMMENDATIONRULES_H
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "PhaseAggregation.h"
+#include "SleepAnalyzer.h"
+
+/// Сработавшие правила: бит i соответствует правилу с номером i.
+using RuleMask = std::uint64_t;
+
+/**
+ * @enum RuleMetric
+ * @brief Поле SleepMetrics, которое проверяет условие правила.
+ */
+enum class RuleMetric : std::uint8_t {
+    TimeInBed,
+    TotalSleepTime,
+    SleepOnset,
+    AwakeningsCount,
+    AwakeDuration,
+    DeepSleepDuration,
+    RemSleepDuration,
+    LightSleepDuration,
+    LightSleepPercent,
+    DeepSleepPercent,
+    RemSleepPercent,
+    Efficiency
+};
+
+constexpr std::size_t kRuleMetricCount = 12;
+
+/**
+ * @enum RuleOp
+ * @brief Сравнение значения метрики с порогом.
+ */
+enum class RuleOp : std::uint8_t {
+    Less,        ///< "<"
+    LessEqual,   ///< "<="
+    Greater,     ///< ">"
+    GreaterEqual ///< ">="
+};
+
+/**
+ * @brief Условие правила: "метрика op порог". NaN не удовлетворяет ни одному условию.
+ */
+struct RuleCondition {
+    RuleMetric metric = RuleMetric::TotalSleepTime;
+    RuleOp op = RuleOp::Less;
+    double threshold = 0.0; ///< В единицах метрики: минуты, проценты или количество
+};
+
+/**
+ * @brief Правило рекомендации: срабатывает, если выполнены все условия.
+ */
+struct RecommendationRule {
+    std::string id;                       ///< Идентификатор правила
+    std::vector<RuleCondition> conditions; ///< Условия; хотя бы одно
+    std::string text;                     ///< Текст рекомендации
+};
+
+/**
+ * @brief Набор правил рекомендаций, скомпилированный в плоскую таблицу условий.
+ *
+ * Результат проверки - маска сработавших правил, а не текст: текст собирается через render()
+ * только для тех результатов, которые действительно показываются.
+ *
+ * Пакет метрик проверяется столбцами: значения одной метрики переписываются во временный массив,
+ * и каждое условие сравнивается сразу с 2 (SSE2) или 4 (AVX2) значениями без ветвлений.
+ * Маска сравнения double занимает те же 64 бита, что и RuleMask, поэтому сразу снимает бит правила.
+ * Реализация выбирается так же, как в PhaseAggregation; результаты всех реализаций совпадают.
+ *
+ * Конфигурация правил - JSON-объект:
+ * @code
+ * {
+ *   "header": "Рекомендации:",
+ *   "fallback": "Ваш сон в порядке!",
+ *   "rules": [
+ *     {"id": "short_sleep", "text": "...", "when": [{"metric": "totalSleepTime", "op": "<", "value": 420}]}
+ *   ]
+ * }
+ * @endcode
+ * Названия метрик совпадают с полями SleepMetrics; "header" и "fallback" необязательны.
+ */
+class RecommendationRules {
+public:
+    using Path = PhaseAggregation::Path;
+
+    /// Наибольшее количество правил: по биту RuleMask на правило.
+    static constexpr std::size_t kMaxRules = 64;
+
+    /**
+     * @brief Компилирует набор правил.
+     *
+     * @param rules Правила; номер правила в маске - его позиция в этом списке.
+     * @param header Первая строка текста рекомендации.
+     * @param fallback Текст, если не сработало ни одно правило.
+     *
+     * @throws std::invalid_argument Если правил больше kMaxRules, у правила нет условий
+     *         или идентификаторы повторяются.
+     */
+    RecommendationRules(std::vector<RecommendationRule> rules, std::string header, std::string fallback);
+
+    /**
+     * @brief Встроенные правила; совпадают с data/recommendation_rules.json.
+     */
+    static const RecommendationRules &Defaults();
+
+    /**
+     * @brief Разбирает конфигурацию правил.
+     *
+     * @throws std::runtime_error Если конфигурация не соответствует формату.
+     * @throws std::invalid_argument Если набор правил некорректен.
+     */
+    static RecommendationRules Parse(std::string_view text);
+
+    /**
+     * @brief Читает конфигурацию правил из файла.
+     *
+     * @throws std::runtime_error Если файл невозможно прочитать или он не соответствует формату.
+     * @throws std::invalid_argument Если набор правил некорректен.
+     */
+    static RecommendationRules Load(const std::string &filename);
+
+    /**
+     * @brief Название метрики в конфигурации, например "totalSleepTime".
+     */
+    static const char *MetricName(RuleMetric metric);
+
+    [[nodiscard]] std::span<const RecommendationRule> rules() const { return rules_; }
+
+    /**
+     * @brief Проверяет метрики одного периода.
+     */
+    [[nodiscard]] RuleMask evaluate(const SleepMetrics &metrics) const;
+
+    /**
+     * @brief Проверяет пакет метрик, например средние метрики участников когорты.
+     *
+     * @param batch Метрики.
+     * @param out Маски сработавших правил, по одной на элемент batch; размер не меньше batch.size().
+     * @param path Реализация; если процессор её не поддерживает, используется BestPath().
+     */
+    void evaluate(std::span<const SleepMetrics> batch, std::span<RuleMask> out, Path path) const;
+
+    void evaluate(std::span<const SleepMetrics> batch, std::span<RuleMask> out) const;
+
+    /**
+     * @brief Дописывает текст рекомендации: заголовок и строку "- текст" на каждое сработавшее правило.
+     *
+     * Если не сработало ни одно правило, вместо них дописывается строка с текстом fallback.
+     */
+    void render(RuleMask mask, std::string &out) const;
+
+    [[nodiscard]] std::string render(RuleMask mask) const;
+
+private:
+    /// Условие, скомпилированное в бит правила.
+    struct Predicate {
+        RuleMetric metric;
+        RuleOp op;
+        double threshold;
+        RuleMask bit;
+    };
+
+    std::vector<RecommendationRule> rules_;
+    std::vector<Predicate> predicates_; ///< Условия всех правил, упорядоченные по метрике
+    RuleMask allRules_ = 0;
+    std::string header_;
+    std::string fallback_;
+};
+
+#endif //SLEEP_VISUALIZER_RECOMMENDATIONRULES_H
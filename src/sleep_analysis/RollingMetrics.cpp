@@ -0,0 +1,104 @@
+#include "RollingMetrics.h"
+#include <algorithm>
+#include <stdexcept>
+#include "../sleep_data_loader/DateTimeParser.h"
+
+RollingMetrics::RollingMetrics(std::vector<int> windowDays) {
+    if (windowDays.empty()) {
+        throw std::invalid_argument("at least one rolling window is required");
+    }
+    int longest = 0;
+    windows_.reserve(windowDays.size());
+    for (int days: windowDays) {
+        if (days <= 0) {
+            throw std::invalid_argument("rolling window length must be positive");
+        }
+        windows_.push_back({days, {}});
+        longest = std::max(longest, days);
+    }
+    ring_.resize(static_cast<std::size_t>(longest));
+}
+
+void RollingMetrics::push(const DateTime &date, const SleepMetrics &metrics) {
+    const std::int64_t day = dayNumber(date);
+    if (!started_ || day > latestDay_) {
+        advanceTo(day);
+    }
+    if (day <= latestDay_ - static_cast<std::int64_t>(ring_.size())) return;
+
+    Slot &slot = slotFor(day);
+    for (auto &window: windows_) {
+        if (day <= latestDay_ - window.days) continue;
+        if (slot.occupied) window.totals.remove(slot.metrics);
+        window.totals.add(metrics);
+    }
+    slot.occupied = true;
+    slot.metrics = metrics;
+}
+
+void RollingMetrics::push(const DailySleepData &day) {
+    push(day.date, SleepAnalyzer::CalculateDailyMetrics(day));
+}
+
+void RollingMetrics::push(const SleepNightView &night) {
+    push(night.date, SleepAnalyzer::CalculateDailyMetrics(night));
+}
+
+bool RollingMetrics::retract(const DateTime &date) {
+    const std::int64_t day = dayNumber(date);
+    if (!started_ || day > latestDay_ || day <= latestDay_ - static_cast<std::int64_t>(ring_.size())) return false;
+
+    Slot &slot = slotFor(day);
+    if (!slot.occupied) return false;
+
+    for (auto &window: windows_) {
+        if (day > latestDay_ - window.days) window.totals.remove(slot.metrics);
+    }
+    slot.occupied = false;
+    return true;
+}
+
+void RollingMetrics::clear() {
+    for (auto &window: windows_) {
+        window.totals = {};
+    }
+    std::fill(ring_.begin(), ring_.end(), Slot{});
+    latestDay_ = 0;
+    started_ = false;
+}
+
+std::int64_t RollingMetrics::dayNumber(const DateTime &date) {
+    return DateTimeParser::localDayNumber(
+            std::chrono::floor<std::chrono::seconds>(date.time_since_epoch()).count());
+}
+
+RollingMetrics::Slot &RollingMetrics::slotFor(std::int64_t day) {
+    const auto size = static_cast<std::int64_t>(ring_.size());
+    return ring_[static_cast<std::size_t>((day % size + size) % size)];
+}
+
+void RollingMetrics::advanceTo(std::int64_t day) {
+    if (!started_) {
+        latestDay_ = day;
+        started_ = true;
+        return;
+    }
+
+    const std::int64_t gap = day - latestDay_;
+    for (auto &window: windows_) {
+        // из окна уходят дни (latestDay_ - days, min(latestDay_, day - days)]
+        const std::int64_t first = latestDay_ - window.days + 1;
+        const std::int64_t last = first + std::min<std::int64_t>(gap, window.days);
+        for (std::int64_t d = first; d < last; ++d) {
+            const Slot &slot = slotFor(d);
+            if (slot.occupied) window.totals.remove(slot.metrics);
+        }
+    }
+
+    // ячейки новых дней занимали дни, уже вытесненные из всех окон
+    const std::int64_t cleared = std::min<std::int64_t>(gap, static_cast<std::int64_t>(ring_.size()));
+    for (std::int64_t d = day - cleared + 1; d <= day; ++d) {
+        slotFor(d).occupied = false;
+    }
+    latestDay_ = day;
+}
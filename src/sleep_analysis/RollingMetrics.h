@@ -0,0 +1,103 @@
+#ifndef SLEEP_VISUALIZER_ROLLINGMETRICS_H
+#define SLEEP_VISUALIZER_ROLLINGMETRICS_H
+
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "SleepAnalyzer.h"
+
+/**
+ * @brief Скользящие средние метрик сна за несколько окон одновременно (например, 7/30/90/365 дней).
+ *
+ * Окно длиной N дней содержит ночи с датами из (последняя дата - N, последняя дата]. Для каждого окна
+ * хранятся SleepMetricsTotals, поэтому добавление ночи, вытеснение старой, исправление и удаление
+ * ночи обновляют все окна за O(число окон), без пересчёта истории. Результат average() совпадает
+ * с SleepMetricsTotals, собранными заново по тем же ночам.
+ *
+ * Метрики ночей хранятся в кольцевом буфере длиной в самое большое окно, индексированном номером дня.
+ */
+class RollingMetrics {
+public:
+    /**
+     * @brief Создаёт пустые окна.
+     *
+     * @param windowDays Длины окон в днях.
+     *
+     * @throws std::invalid_argument Если окон нет или длина окна не положительна.
+     */
+    explicit RollingMetrics(std::vector<int> windowDays);
+
+    /**
+     * @brief Добавляет ночь или заменяет уже добавленную ночь с той же датой.
+     *
+     * Если дата новее последней, окна сдвигаются и ночи, вышедшие за их пределы, вытесняются.
+     * Ночи старше самого большого окна игнорируются.
+     *
+     * @param date Дата ночи (локальная полночь, как в DailySleepData::date).
+     * @param metrics Метрики ночи.
+     */
+    void push(const DateTime &date, const SleepMetrics &metrics);
+
+    /**
+     * @brief Добавляет ночь, рассчитывая её метрики через SleepAnalyzer::CalculateDailyMetrics.
+     */
+    void push(const DailySleepData &day);
+
+    /**
+     * @brief Добавляет ночь из поколоночного хранилища.
+     */
+    void push(const SleepNightView &night);
+
+    /**
+     * @brief Удаляет ранее добавленную ночь, например, если данные за неё оказались ошибочными.
+     *
+     * @return false, если ночи с такой датой нет в самом большом окне.
+     */
+    bool retract(const DateTime &date);
+
+    /**
+     * @brief Удаляет все ночи.
+     */
+    void clear();
+
+    /**
+     * @brief Средние метрики окна с номером @p window (в порядке, переданном в конструктор).
+     */
+    [[nodiscard]] SleepMetrics average(std::size_t window) const { return windows_[window].totals.average(); }
+
+    /**
+     * @brief Суммы метрик окна с номером @p window.
+     */
+    [[nodiscard]] const SleepMetricsTotals &totals(std::size_t window) const { return windows_[window].totals; }
+
+    /**
+     * @brief Длина окна с номером @p window в днях.
+     */
+    [[nodiscard]] int windowDays(std::size_t window) const { return windows_[window].days; }
+
+    [[nodiscard]] std::size_t windowCount() const { return windows_.size(); }
+
+private:
+    struct Window {
+        int days;
+        SleepMetricsTotals totals;
+    };
+
+    struct Slot {
+        bool occupied = false;
+        SleepMetrics metrics{};
+    };
+
+    static std::int64_t dayNumber(const DateTime &date);
+
+    Slot &slotFor(std::int64_t day);
+
+    void advanceTo(std::int64_t day);
+
+    std::vector<Window> windows_;
+    std::vector<Slot> ring_;       ///< Метрики последних ring_.size() дней, индекс - номер дня по модулю
+    std::int64_t latestDay_ = 0;   ///< Номер последнего дня; окна заканчиваются им
+    bool started_ = false;
+};
+
+#endif //SLEEP_VISUALIZER_ROLLINGMETRICS_H
@@ -0,0 +1,311 @@
+#include "SignalAnalysis.h"
+#include "Trace.h"
+#include <algorithm>
+#include <cmath>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define SLEEP_VISUALIZER_X86_KERNELS 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+/// RR-интервал в мс равен kRrScale / отсчёт пульса в десятых долях уд/мин.
+/// Интервалы считаются во float: ошибка порядка 1e-4 мс, зато деление вдвое шире, чем в double.
+constexpr float kRrScale = 60000.0f * static_cast<float>(kSignalScale);
+
+/// Отсчётов в блоке, после которого 16-битные счётчики и 32-битные суммы векторов сбрасываются в 64-битные
+constexpr std::size_t kBlockSamples = 16384;
+
+void summarizeScalar(const SignalSample *samples, std::size_t first, std::size_t last, SignalSummary &out) {
+    for (std::size_t i = first; i < last; ++i) {
+        const SignalSample value = samples[i];
+        if (value <= kMissingSample) continue;
+        out.sum += value;
+        ++out.count;
+        out.min = std::min(out.min, value);
+        out.max = std::max(out.max, value);
+    }
+}
+
+void variabilityScalar(const SignalSample *samples, std::size_t first, std::size_t last, RrVariability &out) {
+    for (std::size_t i = first; i + 1 < last; ++i) {
+        if (samples[i] <= kMissingSample || samples[i + 1] <= kMissingSample) continue;
+        const double diff = kRrScale / static_cast<float>(samples[i + 1]) - kRrScale / static_cast<float>(samples[i]);
+        out.sumSquares += diff * diff;
+        ++out.pairs;
+    }
+}
+
+#if defined(SLEEP_VISUALIZER_X86_KERNELS)
+
+// Отсутствующие отсчёты исключаются маской: в сумму и максимум идёт 0, в минимум - наибольшее значение.
+
+__attribute__((target("avx2")))
+void summarizeAvx2(const SignalSample *samples, std::size_t first, std::size_t last, SignalSummary &out) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i ones = _mm256_set1_epi16(1);
+    const __m256i top = _mm256_set1_epi16(std::numeric_limits<SignalSample>::max());
+    __m256i minAcc = top;
+    __m256i maxAcc = zero;
+
+    alignas(32) std::int32_t lanes32[8];
+    std::size_t i = first;
+    while (i + 16 <= last) {
+        const std::size_t blockEnd = std::min(last, i + kBlockSamples);
+        __m256i sumAcc = zero;
+        __m256i countAcc = zero;
+        for (; i + 16 <= blockEnd; i += 16) {
+            const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(samples + i));
+            const __m256i valid = _mm256_cmpgt_epi16(v, zero);
+            const __m256i kept = _mm256_and_si256(valid, v);
+            sumAcc = _mm256_add_epi32(sumAcc, _mm256_madd_epi16(kept, ones));
+            // маска совпадения равна -1, поэтому вычитание считает количество
+            countAcc = _mm256_sub_epi16(countAcc, valid);
+            minAcc = _mm256_min_epi16(minAcc, _mm256_or_si256(kept, _mm256_andnot_si256(valid, top)));
+            maxAcc = _mm256_max_epi16(maxAcc, kept);
+        }
+        _mm256_store_si256(reinterpret_cast<__m256i *>(lanes32), sumAcc);
+        for (std::int32_t lane: lanes32) out.sum += lane;
+        _mm256_store_si256(reinterpret_cast<__m256i *>(lanes32), _mm256_madd_epi16(countAcc, ones));
+        for (std::int32_t lane: lanes32) out.count += static_cast<std::uint32_t>(lane);
+    }
+
+    alignas(32) SignalSample lanes16[16];
+    _mm256_store_si256(reinterpret_cast<__m256i *>(lanes16), minAcc);
+    for (SignalSample lane: lanes16) out.min = std::min(out.min, lane);
+    _mm256_store_si256(reinterpret_cast<__m256i *>(lanes16), maxAcc);
+    for (SignalSample lane: lanes16) out.max = std::max(out.max, lane);
+
+    // компилятор не сбрасывает верхние половины регистров перед хвостовым вызовом, и без этого
+    // SSE-код вызывающей стороны на коротких участках замедляется на порядок
+    _mm256_zeroupper();
+    summarizeScalar(samples, i, last, out);
+}
+
+__attribute__((target("sse2")))
+void summarizeSse2(const SignalSample *samples, std::size_t first, std::size_t last, SignalSummary &out) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i ones = _mm_set1_epi16(1);
+    const __m128i top = _mm_set1_epi16(std::numeric_limits<SignalSample>::max());
+    __m128i minAcc = top;
+    __m128i maxAcc = zero;
+
+    alignas(16) std::int32_t lanes32[4];
+    std::size_t i = first;
+    while (i + 8 <= last) {
+        const std::size_t blockEnd = std::min(last, i + kBlockSamples);
+        __m128i sumAcc = zero;
+        __m128i countAcc = zero;
+        for (; i + 8 <= blockEnd; i += 8) {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(samples + i));
+            const __m128i valid = _mm_cmpgt_epi16(v, zero);
+            const __m128i kept = _mm_and_si128(valid, v);
+            sumAcc = _mm_add_epi32(sumAcc, _mm_madd_epi16(kept, ones));
+            countAcc = _mm_sub_epi16(countAcc, valid);
+            minAcc = _mm_min_epi16(minAcc, _mm_or_si128(kept, _mm_andnot_si128(valid, top)));
+            maxAcc = _mm_max_epi16(maxAcc, kept);
+        }
+        _mm_store_si128(reinterpret_cast<__m128i *>(lanes32), sumAcc);
+        for (std::int32_t lane: lanes32) out.sum += lane;
+        _mm_store_si128(reinterpret_cast<__m128i *>(lanes32), _mm_madd_epi16(countAcc, ones));
+        for (std::int32_t lane: lanes32) out.count += static_cast<std::uint32_t>(lane);
+    }
+
+    alignas(16) SignalSample lanes16[8];
+    _mm_store_si128(reinterpret_cast<__m128i *>(lanes16), minAcc);
+    for (SignalSample lane: lanes16) out.min = std::min(out.min, lane);
+    _mm_store_si128(reinterpret_cast<__m128i *>(lanes16), maxAcc);
+    for (SignalSample lane: lanes16) out.max = std::max(out.max, lane);
+
+    summarizeScalar(samples, i, last, out);
+}
+
+// Для пар с отсутствующим отсчётом деление даёт бесконечность или NaN, и разность обнуляется маской.
+// Разности считаются во float, квадраты накапливаются в double, как в variabilityScalar.
+
+__attribute__((target("avx2")))
+void variabilityAvx2(const SignalSample *samples, std::size_t first, std::size_t last, RrVariability &out) {
+    const __m256 scale = _mm256_set1_ps(kRrScale);
+    const __m128i zero = _mm_setzero_si128();
+    __m256d accLow = _mm256_setzero_pd();
+    __m256d accHigh = _mm256_setzero_pd();
+
+    std::size_t i = first;
+    for (; i + 9 <= last; i += 8) {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(samples + i));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(samples + i + 1));
+        const __m128i valid16 = _mm_and_si128(_mm_cmpgt_epi16(a, zero), _mm_cmpgt_epi16(b, zero));
+        const __m256 valid = _mm256_castsi256_ps(_mm256_cvtepi16_epi32(valid16));
+        const __m256 rrA = _mm256_div_ps(scale, _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(a)));
+        const __m256 rrB = _mm256_div_ps(scale, _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(b)));
+        const __m256 diff = _mm256_and_ps(valid, _mm256_sub_ps(rrB, rrA));
+        const __m256d low = _mm256_cvtps_pd(_mm256_castps256_ps128(diff));
+        const __m256d high = _mm256_cvtps_pd(_mm256_extractf128_ps(diff, 1));
+        accLow = _mm256_add_pd(accLow, _mm256_mul_pd(low, low));
+        accHigh = _mm256_add_pd(accHigh, _mm256_mul_pd(high, high));
+        out.pairs += static_cast<std::uint32_t>(__builtin_popcount(_mm256_movemask_ps(valid)));
+    }
+
+    alignas(32) double lanes[4];
+    _mm256_store_pd(lanes, _mm256_add_pd(accLow, accHigh));
+    for (double lane: lanes) out.sumSquares += lane;
+
+    _mm256_zeroupper();
+    variabilityScalar(samples, i, last, out);
+}
+
+__attribute__((target("sse2")))
+void variabilitySse2(const SignalSample *samples, std::size_t first, std::size_t last, RrVariability &out) {
+    const __m128 scale = _mm_set1_ps(kRrScale);
+    const __m128i zero = _mm_setzero_si128();
+    __m128d accLow = _mm_setzero_pd();
+    __m128d accHigh = _mm_setzero_pd();
+
+    // знаковое расширение четырёх 16-битных значений до 32 бит
+    const auto widen = [](__m128i v) { return _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16); };
+
+    std::size_t i = first;
+    for (; i + 5 <= last; i += 4) {
+        const __m128i a = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(samples + i));
+        const __m128i b = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(samples + i + 1));
+        const __m128i valid16 = _mm_and_si128(_mm_cmpgt_epi16(a, zero), _mm_cmpgt_epi16(b, zero));
+        const __m128 valid = _mm_castsi128_ps(widen(valid16));
+        const __m128 rrA = _mm_div_ps(scale, _mm_cvtepi32_ps(widen(a)));
+        const __m128 rrB = _mm_div_ps(scale, _mm_cvtepi32_ps(widen(b)));
+        const __m128 diff = _mm_and_ps(valid, _mm_sub_ps(rrB, rrA));
+        const __m128d low = _mm_cvtps_pd(diff);
+        const __m128d high = _mm_cvtps_pd(_mm_movehl_ps(diff, diff));
+        accLow = _mm_add_pd(accLow, _mm_mul_pd(low, low));
+        accHigh = _mm_add_pd(accHigh, _mm_mul_pd(high, high));
+        out.pairs += static_cast<std::uint32_t>(__builtin_popcount(_mm_movemask_ps(valid)));
+    }
+
+    alignas(16) double lanes[2];
+    _mm_store_pd(lanes, _mm_add_pd(accLow, accHigh));
+    for (double lane: lanes) out.sumSquares += lane;
+
+    variabilityScalar(samples, i, last, out);
+}
+
+#endif
+
+using SummaryKernel = void (*)(const SignalSample *, std::size_t, std::size_t, SignalSummary &);
+using VariabilityKernel = void (*)(const SignalSample *, std::size_t, std::size_t, RrVariability &);
+
+SignalAnalysis::Path resolve(SignalAnalysis::Path path) {
+    return PhaseAggregation::IsSupported(path) ? path : PhaseAggregation::BestPath();
+}
+
+SummaryKernel summaryKernelFor(SignalAnalysis::Path path) {
+    switch (resolve(path)) {
+#if defined(SLEEP_VISUALIZER_X86_KERNELS)
+        case SignalAnalysis::Path::AVX2:
+            return summarizeAvx2;
+        case SignalAnalysis::Path::SSE2:
+            return summarizeSse2;
+#endif
+        default:
+            return summarizeScalar;
+    }
+}
+
+VariabilityKernel variabilityKernelFor(SignalAnalysis::Path path) {
+    switch (resolve(path)) {
+#if defined(SLEEP_VISUALIZER_X86_KERNELS)
+        case SignalAnalysis::Path::AVX2:
+            return variabilityAvx2;
+        case SignalAnalysis::Path::SSE2:
+            return variabilitySse2;
+#endif
+        default:
+            return variabilityScalar;
+    }
+}
+
+template<typename Phases>
+NightSignalStats analyzeNight(const Phases &phases, const std::array<SleepSignalView, kSleepSignalCount> &signals,
+                              std::vector<SignalSample> &scratch) {
+    NightSignalStats stats;
+    for (std::size_t s = 0; s < kSleepSignalCount; ++s) {
+        const SleepSignalView &signal = signals[s];
+        if (signal.empty()) continue;
+        signal.decode(scratch);
+        const std::span<const SignalSample> samples(scratch);
+        const bool heartRate = s == static_cast<std::size_t>(SleepSignalType::HeartRate);
+
+        stats.night[s] = SignalAnalysis::Summarize(samples);
+        if (heartRate) stats.hrv = SignalAnalysis::Variability(samples);
+
+        for (const SleepPhase phase: phases) {
+            const auto type = static_cast<std::size_t>(phase.type);
+            if (type >= NightSignalStats::kPhaseTypeCount) continue;
+            const auto [first, last] = SignalAnalysis::SampleRange(signal, phase.start, phase.end);
+            const std::span<const SignalSample> part = samples.subspan(first, last - first);
+            stats.byPhase[s][type].merge(SignalAnalysis::Summarize(part));
+            if (heartRate) stats.hrvByPhase[type].merge(SignalAnalysis::Variability(part));
+        }
+    }
+    return stats;
+}
+
+} // namespace
+
+void SignalSummary::merge(const SignalSummary &other) {
+    sum += other.sum;
+    count += other.count;
+    min = std::min(min, other.min);
+    max = std::max(max, other.max);
+}
+
+void RrVariability::merge(const RrVariability &other) {
+    sumSquares += other.sumSquares;
+    pairs += other.pairs;
+}
+
+double RrVariability::rmssd() const {
+    return pairs > 0 ? std::sqrt(sumSquares / pairs) : 0.0;
+}
+
+SignalSummary SignalAnalysis::Summarize(std::span<const SignalSample> samples, Path path) {
+    SignalSummary summary;
+    summaryKernelFor(path)(samples.data(), 0, samples.size(), summary);
+    return summary;
+}
+
+SignalSummary SignalAnalysis::Summarize(std::span<const SignalSample> samples) {
+    return Summarize(samples, PhaseAggregation::BestPath());
+}
+
+RrVariability SignalAnalysis::Variability(std::span<const SignalSample> heartRate, Path path) {
+    RrVariability variability;
+    variabilityKernelFor(path)(heartRate.data(), 0, heartRate.size(), variability);
+    return variability;
+}
+
+RrVariability SignalAnalysis::Variability(std::span<const SignalSample> heartRate) {
+    return Variability(heartRate, PhaseAggregation::BestPath());
+}
+
+std::pair<std::size_t, std::size_t> SignalAnalysis::SampleRange(const SleepSignalView &signal, DateTime start,
+                                                                DateTime end) {
+    // номер первого отсчёта, взятого не раньше момента t
+    const auto indexAt = [&signal](DateTime t) -> std::size_t {
+        const std::int64_t offset = std::chrono::duration_cast<std::chrono::seconds>(t - signal.start).count();
+        if (offset <= 0) return 0;
+        const std::int64_t index = (offset + signal.interval - 1) / signal.interval;
+        return static_cast<std::size_t>(std::min<std::int64_t>(index, signal.count));
+    };
+    const std::size_t first = indexAt(start);
+    return {first, std::max(first, indexAt(end))};
+}
+
+NightSignalStats SignalAnalysis::AnalyzeNight(const SleepNightView &night, std::vector<SignalSample> &scratch) {
+    SLEEP_TRACE_SCOPE("SignalAnalysis::AnalyzeNight");
+    return analyzeNight(night, night.signals, scratch);
+}
+
+NightSignalStats SignalAnalysis::AnalyzeNight(const DailySleepData &day, std::vector<SignalSample> &scratch) {
+    SLEEP_TRACE_SCOPE("SignalAnalysis::AnalyzeNight");
+    return analyzeNight(day.phases, {day.signals[0].view(), day.signals[1].view()}, scratch);
+}
@@ -0,0 +1,118 @@
+/**
+ * @file SignalAnalysis.h
+ * @brief Векторная статистика рядов пульса и дыхания по фазам сна.
+ */
+#ifndef SLEEP_VISUALIZER_SIGNALANALYSIS_H
+#define SLEEP_VISUALIZER_SIGNALANALYSIS_H
+
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <utility>
+#include <vector>
+#include "../sleep_data_loader/SleepPhaseStore.h"
+#include "PhaseAggregation.h"
+
+/**
+ * @brief Среднее, минимум и максимум отсчётов участка ряда; отсутствующие отсчёты не учитываются.
+ *
+ * Хранит сумму и количество, поэтому сводки соседних участков складываются через merge() без потери точности.
+ */
+struct SignalSummary {
+    std::int64_t sum = 0;                                         ///< Сумма отсчётов, десятые доли
+    std::uint32_t count = 0;                                      ///< Количество отсчётов с данными
+    SignalSample min = std::numeric_limits<SignalSample>::max();  ///< Минимальный отсчёт
+    SignalSample max = 0;                                         ///< Максимальный отсчёт
+
+    void merge(const SignalSummary &other);
+
+    [[nodiscard]] bool empty() const { return count == 0; }
+
+    /// Среднее в единицах измерения; 0, если данных нет.
+    [[nodiscard]] double mean() const { return count > 0 ? static_cast<double>(sum) / count / kSignalScale : 0.0; }
+
+    [[nodiscard]] double minValue() const { return count > 0 ? min / kSignalScale : 0.0; }
+
+    [[nodiscard]] double maxValue() const { return count > 0 ? max / kSignalScale : 0.0; }
+};
+
+/**
+ * @brief Накопитель RMSSD - среднеквадратичной разности соседних RR-интервалов.
+ *
+ * Устройство передаёт пульс, а не сами RR-интервалы, поэтому интервал восстанавливается как 60000 / пульс, мс.
+ * При отсчётах раз в секунду это оценка вариабельности, а не клиническое значение HRV.
+ */
+struct RrVariability {
+    double sumSquares = 0.0;  ///< Сумма квадратов разностей соседних интервалов, мс²
+    std::uint32_t pairs = 0;  ///< Количество пар соседних отсчётов, у обоих из которых есть данные
+
+    void merge(const RrVariability &other);
+
+    /// RMSSD, мс; 0, если пар нет.
+    [[nodiscard]] double rmssd() const;
+};
+
+/**
+ * @brief Статистика рядов за одну ночь по типам фаз.
+ */
+struct NightSignalStats {
+    static constexpr std::size_t kPhaseTypeCount = 4;
+
+    /// Сводки по виду ряда (SleepSignalType) и типу фазы (SleepPhaseType).
+    std::array<std::array<SignalSummary, kPhaseTypeCount>, kSleepSignalCount> byPhase{};
+    /// Сводки по всему ряду.
+    std::array<SignalSummary, kSleepSignalCount> night{};
+    /// Вариабельность пульса по типам фаз; разности на границах фаз не учитываются.
+    std::array<RrVariability, kPhaseTypeCount> hrvByPhase{};
+    /// Вариабельность пульса по всему ряду.
+    RrVariability hrv{};
+};
+
+/**
+ * @brief Статистика отсчётов рядов, вычисляемая блоками по 8 (SSE2) или 16 (AVX2) отсчётов.
+ *
+ * Реализация выбирается так же, как в PhaseAggregation. Сводки всех реализаций совпадают побитно,
+ * вариабельность - с точностью до порядка суммирования.
+ * Объекты этого класса создавать нельзя.
+ */
+class SignalAnalysis {
+public:
+    using Path = PhaseAggregation::Path;
+
+    SignalAnalysis() = delete;
+
+    /**
+     * @brief Считает среднее, минимум и максимум участка ряда.
+     */
+    static SignalSummary Summarize(std::span<const SignalSample> samples, Path path);
+
+    static SignalSummary Summarize(std::span<const SignalSample> samples);
+
+    /**
+     * @brief Накапливает разности соседних RR-интервалов участка ряда пульса.
+     */
+    static RrVariability Variability(std::span<const SignalSample> heartRate, Path path);
+
+    static RrVariability Variability(std::span<const SignalSample> heartRate);
+
+    /**
+     * @brief Номера отсчётов ряда, попадающих в интервал [start, end): первый и следующий за последним.
+     */
+    static std::pair<std::size_t, std::size_t> SampleRange(const SleepSignalView &signal, DateTime start, DateTime end);
+
+    /**
+     * @brief Считает статистику рядов ночи по фазам.
+     *
+     * @param night Ночь с фазами и рядами.
+     * @param scratch Буфер для распакованных отсчётов; переиспользуется между вызовами.
+     */
+    static NightSignalStats AnalyzeNight(const SleepNightView &night, std::vector<SignalSample> &scratch);
+
+    /**
+     * @brief Считает статистику рядов суток по фазам.
+     */
+    static NightSignalStats AnalyzeNight(const DailySleepData &day, std::vector<SignalSample> &scratch);
+};
+
+#endif //SLEEP_VISUALIZER_SIGNALANALYSIS_H
@@ -0,0 +1,313 @@
+#include "SleepAnalyzer.h"
+#include "DateUtils.h"
+#include "PhaseAggregation.h"
+#include "SleepMetricsCache.h"
+#include "Trace.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <ranges>
+#include <stdexcept>
+
+namespace {
+
+constexpr double kEfficiencyScale = 4294967296.0; // 2^32
+
+std::int64_t toFixedEfficiency(double efficiency) {
+    return std::llround(efficiency * kEfficiencyScale);
+}
+
+std::int64_t toSeconds(DateTime t) {
+    return std::chrono::duration_cast<std::chrono::seconds>(t.time_since_epoch()).count();
+}
+
+bool isSleepPhase(SleepPhaseType type) {
+    return type == SleepPhaseType::Light || type == SleepPhaseType::Deep || type == SleepPhaseType::REM;
+}
+
+/**
+ * Достраивает метрики из сумм по фазам. Общая часть скалярного и пакетного расчёта.
+ */
+SleepMetrics metricsFromTotals(const PhaseTotals &totals) {
+    //todo убрать высчитываемые поля
+    SleepMetrics m{};
+
+    m.timeInBed = totals.timeInBed;
+    m.awakeDuration = totals.awakeDuration;
+    m.lightSleepDuration = totals.lightSleepDuration;
+    m.deepSleepDuration = totals.deepSleepDuration;
+    m.remSleepDuration = totals.remSleepDuration;
+
+    const int totalSleepTimeMinutes = m.lightSleepDuration + m.deepSleepDuration + m.remSleepDuration;
+    m.totalSleepTime = totalSleepTimeMinutes;
+    m.lightSleepPercent = (double) m.lightSleepDuration / totalSleepTimeMinutes * 100.0;
+    m.deepSleepPercent = (double) m.deepSleepDuration / totalSleepTimeMinutes * 100.0;
+    m.remSleepPercent = (double) m.remSleepDuration / totalSleepTimeMinutes * 100.0;
+
+    m.awakeningsCount = totals.awakeningsCount;
+    m.sleepOnset = totals.sleepOnset;
+    m.efficiency = SleepAnalyzer::CalculateSleepEfficiency(m);
+
+    return m;
+}
+
+/**
+ * Общая реализация для вектора фаз и для представления ночи из поколоночного хранилища.
+ */
+template<typename Phases>
+SleepMetrics calculateDailyMetrics(const DateTime &bedtime, const DateTime &wakeTime, const Phases &phases) {
+    PhaseTotals totals{};
+    totals.timeInBed = DateUtils::diffBetween(bedtime, wakeTime);
+    totals.sleepOnset = -1;
+
+    for (const auto &phase: phases) {
+        int phaseDuration = DateUtils::diffBetween(phase.start, phase.end);
+
+        if (totals.sleepOnset < 0 && isSleepPhase(phase.type)) {
+            totals.sleepOnset = std::max(DateUtils::diffBetween(bedtime, phase.start), 0);
+        }
+
+        if (phase.type == SleepPhaseType::Awake) {
+            totals.awakeDuration += phaseDuration;
+            totals.awakeningsCount++;
+        } else if (phase.type == SleepPhaseType::Light) {
+            totals.lightSleepDuration += phaseDuration;
+        } else if (phase.type == SleepPhaseType::Deep) {
+            totals.deepSleepDuration += phaseDuration;
+        } else if (phase.type == SleepPhaseType::REM) {
+            totals.remSleepDuration += phaseDuration;
+        }
+    }
+
+    if (totals.sleepOnset < 0) totals.sleepOnset = totals.timeInBed;
+
+    return metricsFromTotals(totals);
+}
+
+/**
+ * Общая реализация расчёта архитектуры для вектора фаз и для представления ночи.
+ */
+template<typename Phases>
+SleepArchitecture calculateArchitecture(const DateTime &bedtime, const DateTime &wakeTime, const Phases &phases) {
+    using std::chrono::duration_cast;
+    using std::chrono::seconds;
+    SleepArchitectureExtractor extractor;
+    for (const auto &phase: phases) {
+        extractor.add(phase.type, duration_cast<seconds>(phase.start - bedtime).count(),
+                      duration_cast<seconds>(phase.end - phase.start).count());
+    }
+    return extractor.finish(duration_cast<seconds>(wakeTime - bedtime).count());
+}
+
+template<typename Nights, typename DailyMetrics>
+SleepMetrics calculateAverageMetrics(const Nights &nights, const DailyMetrics &dailyMetrics) {
+    SleepMetricsTotals totals;
+    for (const auto &night: nights) {
+        totals.add(dailyMetrics(night));
+    }
+    return totals.average();
+}
+
+} // namespace
+
+void SleepMetricsTotals::add(const SleepMetrics &m) {
+    ++nights;
+    timeInBed += m.timeInBed;
+    totalSleepTime += m.totalSleepTime;
+    sleepOnset += m.sleepOnset;
+    awakeningsCount += m.awakeningsCount;
+    awakeDuration += m.awakeDuration;
+    deepSleepDuration += m.deepSleepDuration;
+    remSleepDuration += m.remSleepDuration;
+    lightSleepDuration += m.lightSleepDuration;
+    efficiency += toFixedEfficiency(m.efficiency);
+}
+
+void SleepMetricsTotals::remove(const SleepMetrics &m) {
+    --nights;
+    timeInBed -= m.timeInBed;
+    totalSleepTime -= m.totalSleepTime;
+    sleepOnset -= m.sleepOnset;
+    awakeningsCount -= m.awakeningsCount;
+    awakeDuration -= m.awakeDuration;
+    deepSleepDuration -= m.deepSleepDuration;
+    remSleepDuration -= m.remSleepDuration;
+    lightSleepDuration -= m.lightSleepDuration;
+    efficiency -= toFixedEfficiency(m.efficiency);
+}
+
+SleepMetricsTotals &SleepMetricsTotals::operator+=(const SleepMetricsTotals &other) {
+    nights += other.nights;
+    timeInBed += other.timeInBed;
+    totalSleepTime += other.totalSleepTime;
+    sleepOnset += other.sleepOnset;
+    awakeningsCount += other.awakeningsCount;
+    awakeDuration += other.awakeDuration;
+    deepSleepDuration += other.deepSleepDuration;
+    remSleepDuration += other.remSleepDuration;
+    lightSleepDuration += other.lightSleepDuration;
+    efficiency += other.efficiency;
+    return *this;
+}
+
+SleepMetricsTotals &SleepMetricsTotals::operator-=(const SleepMetricsTotals &other) {
+    nights -= other.nights;
+    timeInBed -= other.timeInBed;
+    totalSleepTime -= other.totalSleepTime;
+    sleepOnset -= other.sleepOnset;
+    awakeningsCount -= other.awakeningsCount;
+    awakeDuration -= other.awakeDuration;
+    deepSleepDuration -= other.deepSleepDuration;
+    remSleepDuration -= other.remSleepDuration;
+    lightSleepDuration -= other.lightSleepDuration;
+    efficiency -= other.efficiency;
+    return *this;
+}
+
+SleepMetrics SleepMetricsTotals::average() const {
+    if (nights <= 0) return SleepMetrics{};
+
+    SleepMetrics avgMetrics = {};
+
+    const auto daysCount = static_cast<double>(nights);
+    auto avg = [daysCount](std::int64_t total) {
+        return static_cast<int>(std::round(static_cast<double>(total) / daysCount));
+    };
+
+    const auto sleepTime = static_cast<double>(totalSleepTime);
+    auto calculatePercentage = [sleepTime](std::int64_t duration) {
+        return static_cast<double>(duration) / sleepTime * 100.0;
+    };
+
+    avgMetrics.timeInBed = avg(timeInBed);
+    avgMetrics.awakeDuration = avg(awakeDuration);
+    avgMetrics.lightSleepDuration = avg(lightSleepDuration);
+    avgMetrics.deepSleepDuration = avg(deepSleepDuration);
+    avgMetrics.remSleepDuration = avg(remSleepDuration);
+    avgMetrics.totalSleepTime = avg(totalSleepTime);
+    avgMetrics.efficiency = static_cast<double>(efficiency) / kEfficiencyScale / daysCount;
+    avgMetrics.sleepOnset = avg(sleepOnset);
+    avgMetrics.awakeningsCount = avg(awakeningsCount);
+
+    avgMetrics.lightSleepPercent = calculatePercentage(lightSleepDuration);
+    avgMetrics.deepSleepPercent = calculatePercentage(deepSleepDuration);
+    avgMetrics.remSleepPercent = calculatePercentage(remSleepDuration);
+
+    return avgMetrics;
+}
+
+SleepMetrics SleepAnalyzer::CalculateDailyMetrics(const DailySleepData &data) {
+    SLEEP_TRACE_SCOPE("SleepAnalyzer::CalculateDailyMetrics");
+    return calculateDailyMetrics(data.bedtime, data.wakeTime, data.phases);
+}
+
+SleepMetrics SleepAnalyzer::CalculateDailyMetrics(const SleepNightView &night) {
+    SLEEP_TRACE_SCOPE("SleepAnalyzer::CalculateDailyMetrics");
+    return calculateDailyMetrics(night.bedtime, night.wakeTime, night);
+}
+
+void SleepAnalyzer::CalculateBatchMetrics(const SleepPhaseColumns &history, std::span<SleepMetrics> out) {
+    SLEEP_TRACE_SCOPE("SleepAnalyzer::CalculateBatchMetrics");
+    std::vector<PhaseTotals> totals(history.nightCount());
+    PhaseAggregation::Aggregate(history, totals);
+    for (std::size_t i = 0; i < totals.size(); ++i) {
+        out[i] = metricsFromTotals(totals[i]);
+    }
+}
+
+SleepArchitecture SleepAnalyzer::CalculateArchitecture(const DailySleepData &data) {
+    SLEEP_TRACE_SCOPE("SleepAnalyzer::CalculateArchitecture");
+    return calculateArchitecture(data.bedtime, data.wakeTime, data.phases);
+}
+
+SleepArchitecture SleepAnalyzer::CalculateArchitecture(const SleepNightView &night) {
+    SLEEP_TRACE_SCOPE("SleepAnalyzer::CalculateArchitecture");
+    return calculateArchitecture(night.bedtime, night.wakeTime, night);
+}
+
+void SleepAnalyzer::CalculateBatchArchitecture(const SleepPhaseColumns &history, std::span<SleepArchitecture> out) {
+    SLEEP_TRACE_SCOPE("SleepAnalyzer::CalculateBatchArchitecture");
+    SleepArchitectureExtractor extractor;
+    for (std::size_t n = 0; n < history.nightCount(); ++n) {
+        extractor.reset();
+        for (std::size_t k = history.nightOffsets[n]; k < history.nightOffsets[n + 1]; ++k) {
+            extractor.add(static_cast<SleepPhaseType>(history.types[k]), history.startOffsets[k], history.durations[k]);
+        }
+        out[n] = extractor.finish(history.wakeTimes[n] - history.bedtimes[n]);
+    }
+}
+
+void SleepAnalyzer::CalculateRecordMetrics(std::string_view json, SleepMetricsCache &cache,
+                                           std::vector<NightMetrics> &out) {
+    SLEEP_TRACE_SCOPE("SleepAnalyzer::CalculateRecordMetrics");
+    const std::vector<std::string_view> records = DataLoader::splitRecords(json);
+    out.resize(records.size());
+    for (std::size_t i = 0; i < records.size(); ++i) {
+        const std::uint64_t key = SleepMetricsCache::Key(records[i]);
+        NightMetrics &night = out[i];
+        if (cache.find(key, night)) continue;
+
+        DailySleepData day;
+        try {
+            day = DataLoader::parseDay(records[i]);
+        } catch (const std::exception &e) {
+            throw std::runtime_error("failed to parse day " + std::to_string(i + 1) + ": " + e.what());
+        }
+        night.date = toSeconds(day.date);
+        night.bedtime = toSeconds(day.bedtime);
+        night.wakeTime = toSeconds(day.wakeTime);
+        night.metrics = CalculateDailyMetrics(day);
+        night.architecture = CalculateArchitecture(day);
+        cache.insert(key, night);
+    }
+}
+
+void SleepAnalyzer::CalculateFileMetrics(const std::string &filename, SleepMetricsCache &cache,
+                                         std::vector<NightMetrics> &out) {
+    std::ifstream ifs(filename, std::ios::binary);
+    if (!ifs.is_open()) {
+        throw std::runtime_error("unable to open file: " + filename);
+    }
+    std::error_code ec;
+    const std::uintmax_t size = std::filesystem::file_size(filename, ec);
+    std::string content(ec ? 0 : static_cast<std::size_t>(size), '\0');
+    if (!ifs.read(content.data(), static_cast<std::streamsize>(content.size()))) {
+        throw std::runtime_error("unable to read file: " + filename);
+    }
+    CalculateRecordMetrics(content, cache, out);
+}
+
+double SleepAnalyzer::CalculateSleepEfficiency(const SleepMetrics &m) {
+
+    // 100*(totalSleepTime/timeInBed)-(0.5*awakeningsCount)-(sleepOnset/60)
+    // ограничим снизу 1, сверху 100
+    if (m.timeInBed <= 0) return 1.0;
+
+    double ratio = m.totalSleepTime / m.timeInBed;
+    double base = 100.0 * ratio;
+    double penaltyAwakenings = 0.5 * m.awakeningsCount;
+    double penaltyOnset = m.sleepOnset / 60.0; // в часах
+    double efficiency = base - penaltyAwakenings - penaltyOnset;
+    if (efficiency < 1.0) efficiency = 1.0;
+    if (efficiency > 100.0) efficiency = 100.0;
+    return efficiency;
+}
+
+SleepMetrics SleepAnalyzer::CalculateAverageMetrics(const WeeklySleepData &weeklyData) {
+    // ночи считаются внутренней функцией, чтобы не записывать в трассу область на каждую ночь
+    SLEEP_TRACE_SCOPE("SleepAnalyzer::CalculateAverageMetrics");
+    return calculateAverageMetrics(weeklyData.sleepDays, [](const DailySleepData &day) {
+        return calculateDailyMetrics(day.bedtime, day.wakeTime, day.phases);
+    });
+}
+
+SleepMetrics SleepAnalyzer::CalculateAverageMetrics(const SleepPhaseColumns &history) {
+    SLEEP_TRACE_SCOPE("SleepAnalyzer::CalculateAverageMetrics");
+    const auto nights = std::views::iota(std::size_t{0}, history.nightCount());
+    return calculateAverageMetrics(nights, [&history](std::size_t i) {
+        const SleepNightView night = history.night(i);
+        return calculateDailyMetrics(night.bedtime, night.wakeTime, night);
+    });
+}
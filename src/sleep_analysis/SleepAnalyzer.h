@@ -0,0 +1,204 @@
+#ifndef SLEEP_VISUALIZER_SLEEPANALYZER_H
+#define SLEEP_VISUALIZER_SLEEPANALYZER_H
+
+#include <cstdint>
+#include <span>
+#include <vector>
+#include <string>
+#include <string_view>
+#include "../sleep_data_loader/DataLoader.h"
+#include "../sleep_data_loader/SleepPhaseStore.h"
+#include "SleepArchitecture.h"
+
+/**
+ * @brief Структура для представления метрик сна.
+ *
+ * Для средних метрик за неделю полученные средние значения округляются.
+ */
+struct SleepMetrics {
+    int timeInBed;       /**< Время в постели, мин. */
+    int totalSleepTime;  /**< Общее время сна, мин. */
+    int sleepOnset;      /**< Время засыпания (от отхода ко сну до первой фазы сна), мин. */
+    int awakeningsCount; /**< Количество пробуждений. */
+
+    int awakeDuration;    /**< Продолжительность бодрствования, мин. */
+    int deepSleepDuration; /**< Продолжительность глубокого сна, мин. */
+    int remSleepDuration;  /**< Продолжительность REM сна, мин. */
+    int lightSleepDuration; /**< Продолжительность легкого сна, мин. */
+
+    double lightSleepPercent; /**< Процент легкого сна от общего времени сна. */
+    double deepSleepPercent;  /**< Процент глубокого сна от общего времени сна. */
+    double remSleepPercent;   /**< Процент REM сна от общего времени сна. */
+
+    double efficiency; /**< Метрика эффективности сна (от 1 до 100). */
+
+    bool operator==(const SleepMetrics &) const = default;
+};
+
+/**
+ * @brief Аддитивные суммы метрик по набору ночей.
+ *
+ * Ночи можно как добавлять, так и вычитать, поэтому суммы подходят для скользящих окон.
+ * Эффективность накапливается в фиксированной точке (2^-32), чтобы вычитание ночи было точным
+ * и среднее не зависело от порядка добавления и удаления ночей.
+ */
+struct SleepMetricsTotals {
+    std::int64_t nights = 0;             /**< Количество ночей. */
+    std::int64_t timeInBed = 0;          /**< Время в постели, мин. */
+    std::int64_t totalSleepTime = 0;     /**< Общее время сна, мин. */
+    std::int64_t sleepOnset = 0;         /**< Время засыпания, мин. */
+    std::int64_t awakeningsCount = 0;    /**< Количество пробуждений. */
+    std::int64_t awakeDuration = 0;      /**< Продолжительность бодрствования, мин. */
+    std::int64_t deepSleepDuration = 0;  /**< Продолжительность глубокого сна, мин. */
+    std::int64_t remSleepDuration = 0;   /**< Продолжительность REM сна, мин. */
+    std::int64_t lightSleepDuration = 0; /**< Продолжительность легкого сна, мин. */
+    std::int64_t efficiency = 0;         /**< Сумма эффективностей в единицах 2^-32. */
+
+    /**
+     * @brief Добавляет метрики одной ночи.
+     */
+    void add(const SleepMetrics &m);
+
+    /**
+     * @brief Вычитает метрики ночи, добавленной ранее через add().
+     */
+    void remove(const SleepMetrics &m);
+
+    /**
+     * @brief Добавляет суммы другого набора ночей.
+     */
+    SleepMetricsTotals &operator+=(const SleepMetricsTotals &other);
+
+    /**
+     * @brief Вычитает суммы набора ночей, входящего в текущий.
+     */
+    SleepMetricsTotals &operator-=(const SleepMetricsTotals &other);
+
+    /**
+     * @brief Средние метрики по накопленным ночам.
+     *
+     * @return SleepMetrics Средние значения, округлённые до целых минут; нулевые, если ночей нет.
+     */
+    [[nodiscard]] SleepMetrics average() const;
+};
+
+class SleepMetricsCache;
+struct NightMetrics;
+
+/**
+ * @brief Класс для анализа данных о сне.
+ */
+class SleepAnalyzer {
+public:
+
+    /**
+     * @brief Версия расчёта метрик и архитектуры сна.
+     *
+     * Входит в ключи SleepMetricsCache: увеличивается при любом изменении результатов расчёта,
+     * чтобы кэш не выдавал значения, посчитанные прежней версией.
+     */
+    static constexpr std::uint32_t kVersion = 1;
+
+    /**
+     * @brief Рассчитывает метрики сна за один день.
+     *
+     * @param data Данные за день
+     * @return SleepMetrics Метрики сна
+     */
+    static SleepMetrics CalculateDailyMetrics(const DailySleepData &data);
+
+    /**
+     * @brief Рассчитывает метрики сна за одну ночь из поколоночного хранилища.
+     *
+     * @param night Представление ночи
+     * @return SleepMetrics Метрики сна
+     */
+    static SleepMetrics CalculateDailyMetrics(const SleepNightView &night);
+
+    /**
+     * @brief Рассчитывает метрики сна для каждой ночи из набора колонок.
+     *
+     * Суммы по фазам считаются векторизованным ядром PhaseAggregation; результат побитно совпадает
+     * с вызовом CalculateDailyMetrics для каждой ночи.
+     *
+     * @param history Колонки с данными о сне.
+     * @param out Метрики по ночам; размер должен быть не меньше history.nightCount().
+     */
+    static void CalculateBatchMetrics(const SleepPhaseColumns &history, std::span<SleepMetrics> out);
+
+    /**
+     * @brief Рассчитывает архитектуру сна за один день за один проход по фазам.
+     *
+     * @param data Данные за день
+     * @return SleepArchitecture Показатели архитектуры сна
+     */
+    static SleepArchitecture CalculateArchitecture(const DailySleepData &data);
+
+    /**
+     * @brief Рассчитывает архитектуру сна за одну ночь из поколоночного хранилища.
+     *
+     * @param night Представление ночи
+     * @return SleepArchitecture Показатели архитектуры сна
+     */
+    static SleepArchitecture CalculateArchitecture(const SleepNightView &night);
+
+    /**
+     * @brief Рассчитывает архитектуру сна для каждой ночи из набора колонок.
+     *
+     * Колонки читаются напрямую, без восстановления SleepPhase, и память не выделяется.
+     *
+     * @param history Колонки с данными о сне.
+     * @param out Показатели по ночам; размер должен быть не меньше history.nightCount().
+     */
+    static void CalculateBatchArchitecture(const SleepPhaseColumns &history, std::span<SleepArchitecture> out);
+
+    /**
+     * @brief Рассчитывает метрики и архитектуру каждой ночи JSON-документа, пропуская ночи из кэша.
+     *
+     * Документ делится на записи суток через DataLoader::splitRecords() без разбора. Разбираются
+     * и рассчитываются только записи, которых нет в кэше; их результаты добавляются в кэш.
+     *
+     * @param json Документ в формате файлов с сутками.
+     * @param cache Кэш метрик.
+     * @param out Ночи в порядке записей документа; прежнее содержимое заменяется.
+     *
+     * @throws std::runtime_error Если документ или какая-либо запись некорректны.
+     */
+    static void CalculateRecordMetrics(std::string_view json, SleepMetricsCache &cache,
+                                       std::vector<NightMetrics> &out);
+
+    /**
+     * @brief Читает JSON-файл целиком и рассчитывает его ночи через CalculateRecordMetrics().
+     *
+     * @throws std::runtime_error Если файл невозможно прочитать или он некорректен.
+     */
+    static void CalculateFileMetrics(const std::string &filename, SleepMetricsCache &cache,
+                                     std::vector<NightMetrics> &out);
+
+    /**
+     * @brief Рассчитывает средние метрики сна за неделю.
+     *
+     * @param weeklyData Данные о сне за неделю.
+     * @return SleepMetrics Средние метрики сна.
+     */
+    static SleepMetrics CalculateAverageMetrics(const WeeklySleepData &weeklyData);
+
+    /**
+     * @brief Рассчитывает средние метрики сна по всем ночам набора колонок.
+     *
+     * @param history Колонки с данными о сне за произвольное число ночей.
+     * @return SleepMetrics Средние метрики сна; нулевые, если ночей нет.
+     */
+    static SleepMetrics CalculateAverageMetrics(const SleepPhaseColumns &history);
+
+    /**
+     * @brief Рассчитывает эффективность сна на основе метрик сна.
+     *
+     * @param m Метрики сна.
+     * @return double Эффективность сна от 1 до 100.
+     */
+    static double CalculateSleepEfficiency(const SleepMetrics &m);
+};
+
+
+#endif //SLEEP_VISUALIZER_SLEEPANALYZER_H
@@ -0,0 +1,97 @@
+#include "SleepArchitecture.h"
+#include <algorithm>
+
+namespace {
+
+/**
+ * Глубина фазы: переход к меньшей глубине считается сдвигом к более поверхностному сну.
+ * REM-сон по глубине приравнивается к лёгкому.
+ */
+int depth(SleepPhaseType type) {
+    switch (type) {
+        case SleepPhaseType::Deep:
+            return 2;
+        case SleepPhaseType::Light:
+        case SleepPhaseType::REM:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+int toMinutes(std::int64_t seconds) {
+    return static_cast<int>(seconds / 60);
+}
+
+} // namespace
+
+void SleepArchitectureExtractor::closeCycle(std::int64_t start, std::int64_t end, int &count, std::int64_t &total,
+                                            std::array<int, SleepArchitecture::kMaxCycles> &lengths) {
+    const std::int64_t length = std::max<std::int64_t>(end - start, 0);
+    if (static_cast<std::size_t>(count) < lengths.size()) {
+        lengths[static_cast<std::size_t>(count)] = toMinutes(length);
+    }
+    ++count;
+    total += length;
+}
+
+void SleepArchitectureExtractor::add(SleepPhaseType type, std::int64_t startOffset, std::int64_t duration) {
+    if (type != SleepPhaseType::Light && type != SleepPhaseType::Deep && type != SleepPhaseType::REM &&
+        type != SleepPhaseType::Awake) {
+        return;
+    }
+    duration = std::max<std::int64_t>(duration, 0);
+
+    if (state_ != State::AwaitingOnset && depth(type) < depth(previous_)) ++stageShifts_;
+    previous_ = type;
+
+    if (type == SleepPhaseType::Awake) {
+        // засчитывается в WASO, только если после него будет сон: последнее пробуждение не входит
+        if (state_ != State::AwaitingOnset) pendingAwake_ += duration;
+        return;
+    }
+
+    if (state_ == State::AwaitingOnset) {
+        onset_ = startOffset;
+        cycleStart_ = startOffset;
+        state_ = State::Nrem;
+    }
+    waso_ += pendingAwake_;
+    pendingAwake_ = 0;
+    sleepTime_ += duration;
+    lastSleepEnd_ = startOffset + duration;
+
+    if (type == SleepPhaseType::REM) {
+        if (firstRem_ < 0) firstRem_ = startOffset;
+        state_ = State::Rem;
+    } else if (state_ == State::Rem) {
+        // NREM после REM открывает следующий цикл
+        closeCycle(cycleStart_, startOffset, cycleCount_, totalCycleTime_, cycleLengths_);
+        cycleStart_ = startOffset;
+        state_ = State::Nrem;
+    }
+}
+
+SleepArchitecture SleepArchitectureExtractor::finish(std::int64_t timeInBed) const {
+    SleepArchitecture result;
+    if (state_ == State::AwaitingOnset) {
+        result.sleepOnsetLatency = toMinutes(timeInBed);
+        return result;
+    }
+
+    result.sleepOnsetLatency = toMinutes(std::max<std::int64_t>(onset_, 0));
+    result.remLatency = firstRem_ < 0 ? -1 : toMinutes(firstRem_ - onset_);
+    result.waso = toMinutes(waso_);
+
+    result.cycleCount = cycleCount_;
+    result.cycleLengths = cycleLengths_;
+    std::int64_t totalCycleTime = totalCycleTime_;
+    if (state_ == State::Rem) {
+        closeCycle(cycleStart_, lastSleepEnd_, result.cycleCount, totalCycleTime, result.cycleLengths);
+    }
+    result.totalCycleLength = toMinutes(totalCycleTime);
+
+    result.stageShifts = stageShifts_;
+    result.fragmentationIndex = sleepTime_ > 0 ? stageShifts_ * 3600.0 / static_cast<double>(sleepTime_) : 0.0;
+    return result;
+}
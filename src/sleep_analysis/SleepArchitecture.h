@@ -0,0 +1,97 @@
+/**
+ * @file SleepArchitecture.h
+ * @brief Архитектура сна за ночь: засыпание, циклы, бодрствование после засыпания, фрагментация.
+ */
+#ifndef SLEEP_VISUALIZER_SLEEPARCHITECTURE_H
+#define SLEEP_VISUALIZER_SLEEPARCHITECTURE_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include "../sleep_data_loader/DataLoader.h"
+
+/**
+ * @brief Показатели архитектуры сна за одну ночь.
+ *
+ * Засыпание - начало первой фазы сна (лёгкого, глубокого или REM). Цикл - период NREM-сна и следующий
+ * за ним период REM-сна; цикл заканчивается с началом следующего NREM-сна или, для последнего цикла,
+ * с концом последней фазы сна. NREM-сон в конце ночи без REM-сна циклом не считается.
+ */
+struct SleepArchitecture {
+    /// Сколько первых циклов хранится в cycleLengths.
+    static constexpr std::size_t kMaxCycles = 10;
+
+    int sleepOnsetLatency = 0; ///< От отхода ко сну до засыпания, мин; время в постели, если сна не было
+    int remLatency = -1;       ///< От засыпания до первой фазы REM, мин; -1, если REM не было
+    int waso = 0;              ///< Бодрствование после засыпания без последнего пробуждения, мин
+    int cycleCount = 0;        ///< Количество завершённых циклов
+    int totalCycleLength = 0;  ///< Суммарная длительность циклов, мин
+    std::array<int, kMaxCycles> cycleLengths{}; ///< Длительности первых циклов, мин
+    int stageShifts = 0;             ///< Переходы к более поверхностному сну или бодрствованию
+    double fragmentationIndex = 0.0; ///< Переходов stageShifts в час сна
+
+    /// Средняя длительность цикла, мин; 0, если циклов нет.
+    [[nodiscard]] double meanCycleLength() const {
+        return cycleCount > 0 ? static_cast<double>(totalCycleLength) / cycleCount : 0.0;
+    }
+
+    bool operator==(const SleepArchitecture &) const = default;
+};
+
+/**
+ * @brief Конечный автомат, вычисляющий SleepArchitecture за один проход по фазам ночи.
+ *
+ * Фазы передаются по одной в порядке времени; состояние занимает несколько десятков байт и не выделяет
+ * память, поэтому один объект можно переиспользовать для любого числа ночей через reset().
+ * Фазы неизвестного типа пропускаются. Время задаётся в секундах относительно отхода ко сну,
+ * как в SleepPhaseColumns.
+ */
+class SleepArchitectureExtractor {
+public:
+    /**
+     * @brief Начинает новую ночь.
+     */
+    void reset() { *this = SleepArchitectureExtractor{}; }
+
+    /**
+     * @brief Учитывает следующую фазу ночи.
+     *
+     * @param type Тип фазы.
+     * @param startOffset Начало фазы относительно отхода ко сну, с.
+     * @param duration Длительность фазы, с; отрицательная считается нулевой.
+     */
+    void add(SleepPhaseType type, std::int64_t startOffset, std::int64_t duration);
+
+    /**
+     * @brief Возвращает показатели ночи по переданным фазам; состояние не меняется.
+     *
+     * @param timeInBed Время в постели, с; нужно, если за ночь не было сна.
+     */
+    [[nodiscard]] SleepArchitecture finish(std::int64_t timeInBed) const;
+
+private:
+    enum class State : std::uint8_t {
+        AwaitingOnset, ///< Сна ещё не было
+        Nrem,          ///< Текущий цикл в NREM-периоде
+        Rem            ///< В текущем цикле уже был REM-сон
+    };
+
+    State state_ = State::AwaitingOnset;
+    SleepPhaseType previous_ = SleepPhaseType::Awake;
+    std::int64_t onset_ = 0;          ///< Засыпание, с
+    std::int64_t firstRem_ = -1;      ///< Начало первой фазы REM, с
+    std::int64_t waso_ = 0;           ///< Бодрствование между фазами сна, с
+    std::int64_t pendingAwake_ = 0;   ///< Бодрствование после последней фазы сна, с
+    std::int64_t sleepTime_ = 0;      ///< Суммарная длительность фаз сна, с
+    std::int64_t cycleStart_ = 0;     ///< Начало текущего цикла, с
+    std::int64_t lastSleepEnd_ = 0;   ///< Конец последней фазы сна, с
+    std::int64_t totalCycleTime_ = 0; ///< Суммарная длительность завершённых циклов, с
+    int cycleCount_ = 0;
+    int stageShifts_ = 0;
+    std::array<int, SleepArchitecture::kMaxCycles> cycleLengths_{};
+
+    static void closeCycle(std::int64_t start, std::int64_t end, int &count, std::int64_t &total,
+                           std::array<int, SleepArchitecture::kMaxCycles> &lengths);
+};
+
+#endif //SLEEP_VISUALIZER_SLEEPARCHITECTURE_H
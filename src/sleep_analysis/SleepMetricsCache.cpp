@@ -0,0 +1,198 @@
+#include "SleepMetricsCache.h"
+#include "ContentHash.h"
+#include "DateTimeParser.h"
+#include "Trace.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <type_traits>
+
+namespace {
+
+constexpr char kMagic[8] = {'S', 'L', 'P', 'M', 'E', 'T', 'R', '\0'};
+constexpr std::uint32_t kFormatVersion = 2;
+
+/// Границы, в которых сравниваются правила часового пояса: 1970-01-01 и 2100-01-01 UTC
+constexpr std::int64_t kZoneRulesBegin = 0;
+constexpr std::int64_t kZoneRulesEnd = 4102444800;
+/// Шаг, с которым проверяется смещение; смена смещения внутри шага уточняется двоичным поиском
+constexpr std::int64_t kZoneRulesStep = 7 * 86400;
+
+/**
+ * Заголовок файла кэша. Записи следуют сразу за ним; контрольная сумма считается по байтам записей.
+ */
+struct FileHeader {
+    char magic[8];
+    std::uint32_t formatVersion;
+    std::uint32_t analyzerVersion;
+    std::uint32_t headerSize;
+    std::uint32_t entrySize;
+    std::uint64_t entryCount;
+    std::uint64_t entriesChecksum;
+    std::uint64_t zoneFingerprint; ///< localZoneFingerprint() процесса, записавшего кэш
+};
+
+/**
+ * Хеш правил локального часового пояса: начальное смещение от UTC и все переходы (момент и новое смещение)
+ * в [kZoneRulesBegin, kZoneRulesEnd).
+ *
+ * Даты ночей и их метрики зависят от того, как локальное время записей переводится в UTC, поэтому кэш,
+ * записанный в другом поясе или с другой версией базы поясов, недействителен. Смещение проверяется раз
+ * в неделю, а момент смены находится двоичным поиском; переход, отменённый в ту же неделю, остаётся незамеченным.
+ * Смещения запрашиваются у системной базы напрямую, чтобы не заполнять таблицу переходов DateTimeParser
+ * ненужными годами; результат считается один раз за процесс.
+ */
+std::uint64_t computeLocalZoneFingerprint() {
+    std::vector<std::int64_t> rules;
+    std::int32_t offset = DateTimeParser::systemUtcOffsetAt(kZoneRulesBegin);
+    rules.push_back(offset);
+    for (std::int64_t t = kZoneRulesBegin; t < kZoneRulesEnd; t += kZoneRulesStep) {
+        const std::int32_t next = DateTimeParser::systemUtcOffsetAt(t + kZoneRulesStep);
+        if (next == offset) continue;
+
+        // смещение в момент lo ещё прежнее, в момент hi - уже новое
+        std::int64_t lo = t, hi = t + kZoneRulesStep;
+        while (hi - lo > 1) {
+            const std::int64_t mid = lo + (hi - lo) / 2;
+            (DateTimeParser::systemUtcOffsetAt(mid) == offset ? lo : hi) = mid;
+        }
+        rules.push_back(hi);
+        rules.push_back(next);
+        offset = next;
+    }
+    return ContentHash::xxh64({reinterpret_cast<const char *>(rules.data()), rules.size() * sizeof(std::int64_t)});
+}
+
+std::uint64_t localZoneFingerprint() {
+    static const std::uint64_t fingerprint = computeLocalZoneFingerprint();
+    return fingerprint;
+}
+
+} // namespace
+
+SleepMetricsCache::SleepMetricsCache(const std::string &filename) {
+    static_assert(std::is_trivially_copyable_v<Entry>);
+    SLEEP_TRACE_SCOPE("SleepMetricsCache::load");
+
+    std::ifstream ifs(filename, std::ios::binary);
+    FileHeader header{};
+    if (!ifs.read(reinterpret_cast<char *>(&header), sizeof(header))) return;
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.formatVersion != kFormatVersion ||
+        header.analyzerVersion != SleepAnalyzer::kVersion || header.headerSize != sizeof(FileHeader) ||
+        header.entrySize != sizeof(Entry) || header.zoneFingerprint != localZoneFingerprint()) {
+        return;
+    }
+    std::error_code ec;
+    const std::uintmax_t fileSize = std::filesystem::file_size(filename, ec);
+    if (ec || fileSize != sizeof(FileHeader) + header.entryCount * sizeof(Entry)) return;
+
+    std::vector<Entry> entries(header.entryCount);
+    const auto bytes = static_cast<std::streamsize>(entries.size() * sizeof(Entry));
+    if (!ifs.read(reinterpret_cast<char *>(entries.data()), bytes)) return;
+    if (ContentHash::xxh64({reinterpret_cast<const char *>(entries.data()), entries.size() * sizeof(Entry)}) !=
+        header.entriesChecksum) {
+        return;
+    }
+
+    loaded_ = std::move(entries);
+    used_ = std::make_unique<std::atomic<bool>[]>(loaded_.size());
+}
+
+std::uint64_t SleepMetricsCache::Key(std::string_view record) {
+    return ContentHash::xxh64(record, SleepAnalyzer::kVersion);
+}
+
+bool SleepMetricsCache::find(std::uint64_t key, NightMetrics &out) {
+    const auto it = std::lower_bound(loaded_.begin(), loaded_.end(), key, [](const Entry &entry, std::uint64_t k) {
+        return entry.key < k;
+    });
+    if (it != loaded_.end() && it->key == key) {
+        used_[static_cast<std::size_t>(it - loaded_.begin())].store(true, std::memory_order_relaxed);
+        out = it->night;
+        hits_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // одинаковые записи могут встретиться в нескольких источниках одного запуска
+    {
+        const std::lock_guard lock(mutex_);
+        const auto added = added_.find(key);
+        if (added != added_.end()) {
+            out = added->second;
+            hits_.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+void SleepMetricsCache::insert(std::uint64_t key, const NightMetrics &night) {
+    const std::lock_guard lock(mutex_);
+    added_.insert_or_assign(key, night);
+}
+
+void SleepMetricsCache::save(const std::string &filename) const {
+    SLEEP_TRACE_SCOPE("SleepMetricsCache::save");
+
+    std::vector<Entry> entries;
+    {
+        const std::lock_guard lock(mutex_);
+        entries.reserve(loaded_.size() + added_.size());
+        for (std::size_t i = 0; i < loaded_.size(); ++i) {
+            if (used_[i].load(std::memory_order_relaxed)) entries.push_back(loaded_[i]);
+        }
+        for (const auto &[key, night]: added_) {
+            Entry entry{};
+            entry.key = key;
+            entry.night = night;
+            entries.push_back(entry);
+        }
+    }
+    std::sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) {
+        return a.key < b.key;
+    });
+    // запись могла быть и загружена, и добавлена заново
+    entries.erase(std::unique(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) {
+        return a.key == b.key;
+    }), entries.end());
+
+    FileHeader header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.formatVersion = kFormatVersion;
+    header.analyzerVersion = SleepAnalyzer::kVersion;
+    header.headerSize = sizeof(FileHeader);
+    header.entrySize = sizeof(Entry);
+    header.entryCount = entries.size();
+    header.entriesChecksum = ContentHash::xxh64(
+            {reinterpret_cast<const char *>(entries.data()), entries.size() * sizeof(Entry)});
+    header.zoneFingerprint = localZoneFingerprint();
+
+    const std::string tmpPath = filename + ".tmp";
+    {
+        std::ofstream ofs(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!ofs.is_open()) {
+            throw std::runtime_error("unable to create metrics cache: " + tmpPath);
+        }
+        ofs.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        ofs.write(reinterpret_cast<const char *>(entries.data()),
+                  static_cast<std::streamsize>(entries.size() * sizeof(Entry)));
+        if (!ofs.flush()) {
+            throw std::runtime_error("unable to write metrics cache: " + tmpPath);
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tmpPath, filename, ec);
+    if (ec) {
+        std::filesystem::remove(tmpPath, ec);
+        throw std::runtime_error("unable to replace metrics cache: " + filename);
+    }
+}
+
+std::size_t SleepMetricsCache::size() const {
+    const std::lock_guard lock(mutex_);
+    return loaded_.size() + added_.size();
+}
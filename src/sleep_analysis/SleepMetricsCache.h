@@ -0,0 +1,112 @@
+/**
+ * @file SleepMetricsCache.h
+ * @brief Постоянный кэш метрик ночей с ключом по содержимому исходной записи.
+ */
+#ifndef SLEEP_VISUALIZER_SLEEPMETRICSCACHE_H
+#define SLEEP_VISUALIZER_SLEEPMETRICSCACHE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "SleepAnalyzer.h"
+#include "SleepArchitecture.h"
+
+/**
+ * @brief Метрики и архитектура одной ночи вместе с полями, по которым ночи упорядочиваются.
+ */
+struct NightMetrics {
+    std::int64_t date = 0;            ///< Дата, секунды от эпохи
+    std::int64_t bedtime = 0;         ///< Отход ко сну, секунды от эпохи
+    std::int64_t wakeTime = 0;        ///< Пробуждение, секунды от эпохи
+    SleepMetrics metrics{};           ///< Метрики ночи
+    SleepArchitecture architecture{}; ///< Архитектура сна ночи
+};
+
+/**
+ * @brief Кэш NightMetrics, сохраняемый между запусками.
+ *
+ * Ключ - хеш XXH64 исходного текста записи суток с начальным значением SleepAnalyzer::kVersion,
+ * поэтому изменённая запись или новая версия расчёта дают новый ключ, и устаревшее значение
+ * просто не находится. Даты и метрики ночей зависят ещё и от локального часового пояса, поэтому в заголовке
+ * файла хранится хеш его правил, и кэш, записанный в другом поясе, не загружается.
+ * Файл кэша - заголовок и записи фиксированного размера, упорядоченные по ключу;
+ * при загрузке он читается одним блоком, а поиск - двоичный.
+ *
+ * save() записывает только записи, найденные или добавленные с момента загрузки: ночи, которых больше
+ * нет во входных данных, не накапливаются. find() и insert() можно вызывать из нескольких потоков.
+ */
+class SleepMetricsCache {
+public:
+    /**
+     * @brief Создаёт пустой кэш.
+     */
+    SleepMetricsCache() = default;
+
+    /**
+     * @brief Загружает кэш из файла.
+     *
+     * Отсутствующий или повреждённый файл, а также файл другой версии расчёта или другого часового пояса
+     * дают пустой кэш: это только замедляет первый запуск.
+     */
+    explicit SleepMetricsCache(const std::string &filename);
+
+    SleepMetricsCache(const SleepMetricsCache &) = delete;
+
+    SleepMetricsCache &operator=(const SleepMetricsCache &) = delete;
+
+    /**
+     * @brief Ключ записи суток.
+     */
+    static std::uint64_t Key(std::string_view record);
+
+    /**
+     * @brief Ищет ночь по ключу и отмечает найденную запись для save().
+     *
+     * @return true, если ночь найдена и записана в out.
+     */
+    bool find(std::uint64_t key, NightMetrics &out);
+
+    /**
+     * @brief Добавляет рассчитанную ночь.
+     */
+    void insert(std::uint64_t key, const NightMetrics &night);
+
+    /**
+     * @brief Записывает используемые записи в файл.
+     *
+     * Файл заменяется целиком через временный файл, поэтому прерванная запись не портит прежний кэш.
+     *
+     * @throws std::runtime_error Если файл невозможно записать.
+     */
+    void save(const std::string &filename) const;
+
+    /// Количество записей: загруженных и добавленных.
+    [[nodiscard]] std::size_t size() const;
+
+    /// Количество успешных вызовов find().
+    [[nodiscard]] std::size_t hits() const { return hits_.load(std::memory_order_relaxed); }
+
+    /// Количество вызовов find(), не нашедших ночь.
+    [[nodiscard]] std::size_t misses() const { return misses_.load(std::memory_order_relaxed); }
+
+private:
+    struct Entry {
+        std::uint64_t key;
+        NightMetrics night;
+    };
+
+    std::vector<Entry> loaded_;                ///< Записи файла, упорядоченные по ключу; не меняются
+    std::unique_ptr<std::atomic<bool>[]> used_; ///< Отметки найденных записей loaded_
+    mutable std::mutex mutex_;
+    std::unordered_map<std::uint64_t, NightMetrics> added_; ///< Записи, добавленные после загрузки
+    std::atomic<std::size_t> hits_{0};
+    std::atomic<std::size_t> misses_{0};
+};
+
+#endif //SLEEP_VISUALIZER_SLEEPMETRICSCACHE_H
@@ -0,0 +1,499 @@
+#include "SleepMetricsExporter.h"
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include "DateTimeParser.h"
+#include "Trace.h"
+
+#if defined(_WIN32)
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <cerrno>
+#include <climits>
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr char kMagic[8] = {'S', 'L', 'P', 'C', 'O', 'L', 'S', '\0'};
+constexpr std::uint32_t kFormatVersion = 1;
+
+enum class ColumnType : std::uint32_t {
+    UInt32 = 1,
+    Int32 = 2,
+    Int64 = 3,
+    Float64 = 4
+};
+
+/// Колонки выгрузки в порядке их следования в файле
+enum Column : std::size_t {
+    User,
+    Date,
+    TimeInBed,
+    TotalSleepTime,
+    SleepOnset,
+    AwakeningsCount,
+    AwakeDuration,
+    DeepSleepDuration,
+    RemSleepDuration,
+    LightSleepDuration,
+    LightSleepPercent,
+    DeepSleepPercent,
+    RemSleepPercent,
+    Efficiency,
+    SleepOnsetLatency,
+    RemLatency,
+    Waso,
+    CycleCount,
+    MeanCycleLength,
+    StageShifts,
+    FragmentationIndex,
+    ColumnCount
+};
+
+struct ColumnInfo {
+    const char *name;
+    ColumnType type;
+    std::uint32_t width;
+};
+
+constexpr ColumnInfo kColumns[ColumnCount] = {
+        {"user",               ColumnType::UInt32,  4},
+        {"date",               ColumnType::Int64,   8},
+        {"timeInBed",          ColumnType::Int32,   4},
+        {"totalSleepTime",     ColumnType::Int32,   4},
+        {"sleepOnset",         ColumnType::Int32,   4},
+        {"awakeningsCount",    ColumnType::Int32,   4},
+        {"awakeDuration",      ColumnType::Int32,   4},
+        {"deepSleepDuration",  ColumnType::Int32,   4},
+        {"remSleepDuration",   ColumnType::Int32,   4},
+        {"lightSleepDuration", ColumnType::Int32,   4},
+        {"lightSleepPercent",  ColumnType::Float64, 8},
+        {"deepSleepPercent",   ColumnType::Float64, 8},
+        {"remSleepPercent",    ColumnType::Float64, 8},
+        {"efficiency",         ColumnType::Float64, 8},
+        {"sleepOnsetLatency",  ColumnType::Int32,   4},
+        {"remLatency",         ColumnType::Int32,   4},
+        {"waso",               ColumnType::Int32,   4},
+        {"cycleCount",         ColumnType::Int32,   4},
+        {"meanCycleLength",    ColumnType::Float64, 8},
+        {"stageShifts",        ColumnType::Int32,   4},
+        {"fragmentationIndex", ColumnType::Float64, 8}
+};
+
+struct FileHeader {
+    char magic[8];
+    std::uint32_t formatVersion;
+    std::uint32_t columnCount;
+};
+
+struct ColumnDescriptor {
+    char name[24];
+    std::uint32_t type;
+    std::uint32_t width;
+};
+
+struct FileTrailer {
+    std::uint64_t indexOffset;
+    std::uint64_t rowGroupCount;
+    std::uint64_t rowCount;
+    std::uint64_t userCount;
+    char magic[8];
+};
+
+/// Самая длинная строка CSV без имени пользователя
+constexpr std::size_t kMaxCsvRow = 512;
+
+constexpr std::byte kPadding[8] = {};
+
+std::uint64_t align8(std::uint64_t value) {
+    return (value + 7) & ~std::uint64_t{7};
+}
+
+struct Buffer {
+    const void *data;
+    std::size_t size;
+};
+
+#if defined(_WIN32)
+
+int openFile(const std::string &path) {
+    return ::_open(path.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+}
+
+bool closeFile(int fd) {
+    return ::_close(fd) == 0;
+}
+
+// без writev: буферы записываются по очереди
+bool writeBuffers(int fd, std::span<const Buffer> buffers) {
+    for (const Buffer &buffer: buffers) {
+        const auto *p = static_cast<const char *>(buffer.data);
+        std::size_t left = buffer.size;
+        while (left > 0) {
+            const int written = ::_write(fd, p, static_cast<unsigned>(std::min<std::size_t>(left, 1u << 30)));
+            if (written <= 0) return false;
+            p += written;
+            left -= static_cast<std::size_t>(written);
+        }
+    }
+    return true;
+}
+
+#else
+
+int openFile(const std::string &path) {
+    return ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+}
+
+bool closeFile(int fd) {
+    return ::close(fd) == 0;
+}
+
+bool writeBuffers(int fd, std::span<const Buffer> buffers) {
+    std::vector<iovec> iov;
+    iov.reserve(buffers.size());
+    for (const Buffer &buffer: buffers) {
+        if (buffer.size > 0) iov.push_back({const_cast<void *>(buffer.data), buffer.size});
+    }
+
+    // writev может записать только часть: оставшиеся буферы передаются повторно
+    std::size_t first = 0;
+    while (first < iov.size()) {
+        const auto count = static_cast<int>(std::min<std::size_t>(iov.size() - first, IOV_MAX));
+        const ssize_t written = ::writev(fd, iov.data() + first, count);
+        if (written < 0 && errno == EINTR) continue;
+        if (written <= 0) return false;
+
+        auto left = static_cast<std::size_t>(written);
+        while (first < iov.size() && left >= iov[first].iov_len) {
+            left -= iov[first].iov_len;
+            ++first;
+        }
+        if (left > 0) {
+            iov[first].iov_base = static_cast<char *>(iov[first].iov_base) + left;
+            iov[first].iov_len -= left;
+        }
+    }
+    return true;
+}
+
+#endif
+
+template<typename T>
+void put(std::vector<std::byte> &column, std::size_t row, T value) {
+    std::memcpy(column.data() + row * sizeof(T), &value, sizeof(T));
+}
+
+char *writeInt(char *p, std::int64_t value) {
+    return std::to_chars(p, p + 24, value).ptr;
+}
+
+char *writeDouble(char *p, double value) {
+    return std::to_chars(p, p + 32, value).ptr;
+}
+
+char *writeTwoDigits(char *p, unsigned value) {
+    p[0] = static_cast<char>('0' + value / 10);
+    p[1] = static_cast<char>('0' + value % 10);
+    return p + 2;
+}
+
+char *writeDate(char *p, std::int64_t seconds) {
+    const std::chrono::year_month_day date{std::chrono::sys_days{
+            std::chrono::days(DateTimeParser::localDayNumber(seconds))}};
+    const int year = static_cast<int>(date.year());
+    if (year >= 1000 && year <= 9999) {
+        p = writeTwoDigits(p, static_cast<unsigned>(year / 100));
+        p = writeTwoDigits(p, static_cast<unsigned>(year % 100));
+    } else {
+        p = writeInt(p, year);
+    }
+    *p++ = '-';
+    p = writeTwoDigits(p, static_cast<unsigned>(date.month()));
+    *p++ = '-';
+    return writeTwoDigits(p, static_cast<unsigned>(date.day()));
+}
+
+/**
+ * Дописывает строку CSV одной ночи; user - имя пользователя, подготовленное для CSV.
+ */
+void appendCsvRow(std::string &out, const std::string &user, std::int64_t date, const SleepMetrics &m,
+                  const SleepArchitecture &a) {
+    std::array<char, kMaxCsvRow> row;
+    char *p = writeDate(row.data(), date);
+    const int integers[] = {m.timeInBed, m.totalSleepTime, m.sleepOnset, m.awakeningsCount, m.awakeDuration,
+                            m.deepSleepDuration, m.remSleepDuration, m.lightSleepDuration};
+    for (int value: integers) {
+        *p++ = ',';
+        p = writeInt(p, value);
+    }
+    for (double value: {m.lightSleepPercent, m.deepSleepPercent, m.remSleepPercent, m.efficiency}) {
+        *p++ = ',';
+        p = writeDouble(p, value);
+    }
+    for (int value: {a.sleepOnsetLatency, a.remLatency, a.waso, a.cycleCount}) {
+        *p++ = ',';
+        p = writeInt(p, value);
+    }
+    *p++ = ',';
+    p = writeDouble(p, a.meanCycleLength());
+    *p++ = ',';
+    p = writeInt(p, a.stageShifts);
+    *p++ = ',';
+    p = writeDouble(p, a.fragmentationIndex);
+    *p++ = '\n';
+
+    out += user;
+    out.append(row.data(), static_cast<std::size_t>(p - row.data()));
+}
+
+} // namespace
+
+SleepMetricsExporter::SleepMetricsExporter(const std::string &filename, ExportFormat format,
+                                           std::vector<std::string> users, std::size_t rowGroupSize)
+        : filename_(filename), tmpPath_(filename + ".tmp"), format_(format), users_(std::move(users)),
+          rowGroupSize_(rowGroupSize) {
+    if (rowGroupSize_ == 0) {
+        throw std::invalid_argument("row group size must be positive");
+    }
+
+    std::vector<ColumnDescriptor> descriptors(ColumnCount);
+    std::string csvHeader;
+    for (std::size_t c = 0; c < ColumnCount; ++c) {
+        std::strncpy(descriptors[c].name, kColumns[c].name, sizeof(descriptors[c].name));
+        descriptors[c].type = static_cast<std::uint32_t>(kColumns[c].type);
+        descriptors[c].width = kColumns[c].width;
+        if (c > 0) csvHeader += ',';
+        csvHeader += kColumns[c].name;
+    }
+    csvHeader += '\n';
+
+    if (format_ == ExportFormat::Columnar) {
+        columns_.resize(ColumnCount);
+        for (std::size_t c = 0; c < ColumnCount; ++c) {
+            columns_[c].resize(rowGroupSize_ * kColumns[c].width);
+        }
+    } else {
+        csvUsers_.reserve(users_.size());
+        for (const auto &user: users_) {
+            std::string quoted = "\"";
+            for (char c: user) {
+                if (c == '"') quoted += '"';
+                quoted += c;
+            }
+            quoted += "\",";
+            csvUsers_.push_back(std::move(quoted));
+        }
+        csv_.reserve(csvHeader.size() + rowGroupSize_ * 200);
+        csv_ = csvHeader;
+    }
+
+    fd_ = openFile(tmpPath_);
+    if (fd_ < 0) {
+        throw std::runtime_error("unable to create export: " + tmpPath_);
+    }
+    if (format_ == ExportFormat::Columnar) {
+        FileHeader header{};
+        std::memcpy(header.magic, kMagic, sizeof(kMagic));
+        header.formatVersion = kFormatVersion;
+        header.columnCount = ColumnCount;
+        const Buffer buffers[] = {
+                {&header,             sizeof(header)},
+                {descriptors.data(), descriptors.size() * sizeof(ColumnDescriptor)}
+        };
+        if (!writeBuffers(fd_, buffers)) {
+            closeFile(fd_);
+            fd_ = -1;
+            std::error_code ec;
+            std::filesystem::remove(tmpPath_, ec);
+            throw std::runtime_error("unable to write export: " + tmpPath_);
+        }
+        offset_ = sizeof(header) + descriptors.size() * sizeof(ColumnDescriptor);
+    }
+}
+
+SleepMetricsExporter::~SleepMetricsExporter() {
+    if (fd_ < 0) return;
+    closeFile(fd_);
+    std::error_code ec;
+    std::filesystem::remove(tmpPath_, ec);
+}
+
+ExportFormat SleepMetricsExporter::parseFormat(const std::string &name) {
+    if (name == "columnar") return ExportFormat::Columnar;
+    if (name == "csv") return ExportFormat::Csv;
+    throw std::invalid_argument("unknown export format: " + name);
+}
+
+void SleepMetricsExporter::append(std::uint32_t user, std::span<const std::int64_t> dates,
+                                  std::span<const SleepMetrics> nights,
+                                  std::span<const SleepArchitecture> architecture) {
+    if (user >= users_.size()) {
+        throw std::invalid_argument("unknown export user: " + std::to_string(user));
+    }
+    if (dates.size() != nights.size() || architecture.size() != nights.size()) {
+        throw std::invalid_argument("export columns differ in size");
+    }
+
+    if (format_ == ExportFormat::Csv) {
+        appendCsv(user, dates, nights, architecture);
+        return;
+    }
+
+    const std::lock_guard lock(mutex_);
+    if (fd_ < 0) {
+        throw std::runtime_error("export is closed: " + filename_);
+    }
+    if (!error_.empty()) return;
+    for (std::size_t i = 0; i < nights.size(); ++i) {
+        appendColumnar(user, dates[i], nights[i], architecture[i]);
+        if (++pending_ == rowGroupSize_) flush();
+    }
+    rows_ += nights.size();
+}
+
+void SleepMetricsExporter::appendCsv(std::uint32_t user, std::span<const std::int64_t> dates,
+                                     std::span<const SleepMetrics> nights,
+                                     std::span<const SleepArchitecture> architecture) {
+    // строки форматируются без блокировки, в буфер потока; под mutex_ они только дописываются в группу
+    thread_local std::string rows;
+    rows.clear();
+    for (std::size_t i = 0; i < nights.size(); ++i) {
+        appendCsvRow(rows, csvUsers_[user], dates[i], nights[i], architecture[i]);
+    }
+
+    const std::lock_guard lock(mutex_);
+    if (fd_ < 0) {
+        throw std::runtime_error("export is closed: " + filename_);
+    }
+    if (!error_.empty()) return;
+    csv_ += rows;
+    pending_ += nights.size();
+    rows_ += nights.size();
+    if (pending_ >= rowGroupSize_) flush();
+}
+
+void SleepMetricsExporter::appendColumnar(std::uint32_t user, std::int64_t date, const SleepMetrics &m,
+                                          const SleepArchitecture &a) {
+    const std::size_t row = pending_;
+    put<std::uint32_t>(columns_[User], row, user);
+    put<std::int64_t>(columns_[Date], row, date);
+    put<std::int32_t>(columns_[TimeInBed], row, m.timeInBed);
+    put<std::int32_t>(columns_[TotalSleepTime], row, m.totalSleepTime);
+    put<std::int32_t>(columns_[SleepOnset], row, m.sleepOnset);
+    put<std::int32_t>(columns_[AwakeningsCount], row, m.awakeningsCount);
+    put<std::int32_t>(columns_[AwakeDuration], row, m.awakeDuration);
+    put<std::int32_t>(columns_[DeepSleepDuration], row, m.deepSleepDuration);
+    put<std::int32_t>(columns_[RemSleepDuration], row, m.remSleepDuration);
+    put<std::int32_t>(columns_[LightSleepDuration], row, m.lightSleepDuration);
+    put<double>(columns_[LightSleepPercent], row, m.lightSleepPercent);
+    put<double>(columns_[DeepSleepPercent], row, m.deepSleepPercent);
+    put<double>(columns_[RemSleepPercent], row, m.remSleepPercent);
+    put<double>(columns_[Efficiency], row, m.efficiency);
+    put<std::int32_t>(columns_[SleepOnsetLatency], row, a.sleepOnsetLatency);
+    put<std::int32_t>(columns_[RemLatency], row, a.remLatency);
+    put<std::int32_t>(columns_[Waso], row, a.waso);
+    put<std::int32_t>(columns_[CycleCount], row, a.cycleCount);
+    put<double>(columns_[MeanCycleLength], row, a.meanCycleLength());
+    put<std::int32_t>(columns_[StageShifts], row, a.stageShifts);
+    put<double>(columns_[FragmentationIndex], row, a.fragmentationIndex);
+}
+
+void SleepMetricsExporter::flush() {
+    SLEEP_TRACE_SCOPE("SleepMetricsExporter::flush");
+
+    if (format_ == ExportFormat::Csv) {
+        const Buffer buffer{csv_.data(), csv_.size()};
+        if (!csv_.empty() && !writeBuffers(fd_, {&buffer, 1})) {
+            error_ = "unable to write export: " + tmpPath_;
+        }
+        offset_ += csv_.size();
+        csv_.clear();
+        pending_ = 0;
+        return;
+    }
+
+    if (pending_ == 0) return;
+    // заголовок группы и по буферу на колонку; колонки по 4 байта дополняются до 8
+    const std::uint64_t rowCount = pending_;
+    std::array<Buffer, 1 + 2 * ColumnCount> buffers{};
+    std::size_t count = 0;
+    std::uint64_t size = sizeof(rowCount);
+    buffers[count++] = {&rowCount, sizeof(rowCount)};
+    for (std::size_t c = 0; c < ColumnCount; ++c) {
+        const std::size_t bytes = pending_ * kColumns[c].width;
+        buffers[count++] = {columns_[c].data(), bytes};
+        buffers[count++] = {kPadding, align8(bytes) - bytes};
+        size += align8(bytes);
+    }
+    if (!writeBuffers(fd_, {buffers.data(), count})) {
+        error_ = "unable to write export: " + tmpPath_;
+    }
+    rowGroups_.push_back({offset_, rowCount});
+    offset_ += size;
+    pending_ = 0;
+}
+
+void SleepMetricsExporter::writeIndex() {
+    std::string names;
+    for (const auto &user: users_) {
+        const auto length = static_cast<std::uint32_t>(user.size());
+        names.append(reinterpret_cast<const char *>(&length), sizeof(length));
+        names += user;
+    }
+    names.resize(align8(names.size()), '\0');
+
+    FileTrailer trailer{};
+    trailer.indexOffset = offset_;
+    trailer.rowGroupCount = rowGroups_.size();
+    trailer.rowCount = rows_;
+    trailer.userCount = users_.size();
+    std::memcpy(trailer.magic, kMagic, sizeof(kMagic));
+
+    const Buffer buffers[] = {
+            {rowGroups_.data(), rowGroups_.size() * sizeof(RowGroup)},
+            {names.data(),      names.size()},
+            {&trailer,          sizeof(trailer)}
+    };
+    if (!writeBuffers(fd_, buffers)) {
+        error_ = "unable to write export: " + tmpPath_;
+    }
+}
+
+void SleepMetricsExporter::close() {
+    SLEEP_TRACE_SCOPE("SleepMetricsExporter::close");
+
+    const std::lock_guard lock(mutex_);
+    if (fd_ < 0) return;
+    if (error_.empty()) flush();
+    if (error_.empty() && format_ == ExportFormat::Columnar) writeIndex();
+
+    const bool closed = closeFile(fd_);
+    fd_ = -1;
+    if (!closed && error_.empty()) error_ = "unable to write export: " + tmpPath_;
+
+    std::error_code ec;
+    if (!error_.empty()) {
+        std::filesystem::remove(tmpPath_, ec);
+        throw std::runtime_error(error_);
+    }
+    std::filesystem::rename(tmpPath_, filename_, ec);
+    if (ec) {
+        std::filesystem::remove(tmpPath_, ec);
+        throw std::runtime_error("unable to replace export: " + filename_);
+    }
+}
+
+std::uint64_t SleepMetricsExporter::rows() const {
+    const std::lock_guard lock(mutex_);
+    return rows_;
+}
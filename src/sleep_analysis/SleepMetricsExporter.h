@@ -0,0 +1,146 @@
+/**
+ * @file SleepMetricsExporter.h
+ * @brief Потоковая выгрузка метрик по ночам в колоночный двоичный файл или CSV.
+ */
+#ifndef SLEEP_VISUALIZER_SLEEPMETRICSEXPORTER_H
+#define SLEEP_VISUALIZER_SLEEPMETRICSEXPORTER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <span>
+#include <string>
+#include <vector>
+#include "SleepAnalyzer.h"
+#include "SleepArchitecture.h"
+
+/**
+ * @enum ExportFormat
+ * @brief Формат выгрузки.
+ */
+enum class ExportFormat {
+    Columnar, ///< Колоночный двоичный формат с группами строк
+    Csv       ///< Строка на ночь с заголовком
+};
+
+/**
+ * @brief Выгрузка метрик и архитектуры сна всех ночей всех пользователей.
+ *
+ * Строка - одна ночь: индекс пользователя, дата и поля SleepMetrics и SleepArchitecture. Строки копятся
+ * в буфере на rowGroupSize строк и записываются одной группой, поэтому память не зависит от объёма выгрузки.
+ * Группа записывается одним вызовом writev: в колоночном формате каждая колонка - отдельный буфер, и строки
+ * не копируются в общий буфер.
+ *
+ * Колоночный файл (все числа little-endian, каждая часть выровнена на 8 байт):
+ *  - заголовок: магия "SLPCOLS\0", версия формата (uint32), число колонок (uint32), затем описания колонок
+ *    по 32 байта: имя (24 байта, дополненное нулями), тип (uint32: 1 - uint32, 2 - int32, 3 - int64,
+ *    4 - float64) и ширина значения в байтах (uint32);
+ *  - группы строк: число строк (uint64), затем значения каждой колонки подряд, по колонке за раз;
+ *  - индекс: смещение и число строк каждой группы (по два uint64), затем имена пользователей
+ *    (длина uint32 и байты), на которые ссылается колонка user;
+ *  - концевик: смещение индекса, число групп, число строк, число пользователей (uint64) и магия.
+ * Читатель начинает с концевика в конце файла; файл без концевика выгружен не полностью.
+ *
+ * CSV содержит те же колонки, но пользователь записан именем, а дата - в виде ГГГГ-ММ-ДД. Строки CSV форматируются
+ * вне блокировки, и в буфер группы дописываются все строки вызова append() сразу, поэтому буфер может
+ * превысить rowGroupSize строк на строки одного вызова.
+ *
+ * Файл пишется во временный и получает своё имя в close(). append() можно вызывать из нескольких потоков;
+ * строки одного вызова идут подряд, а порядок вызовов разных потоков не определён.
+ */
+class SleepMetricsExporter {
+public:
+    /// Размер группы строк по умолчанию: около 7 МБ буферов колонок
+    static constexpr std::size_t kDefaultRowGroupSize = 65536;
+
+    /**
+     * @brief Создаёт временный файл выгрузки.
+     *
+     * @param filename Путь к файлу выгрузки.
+     * @param format Формат.
+     * @param users Имена пользователей; индексы в append() ссылаются на них.
+     * @param rowGroupSize Количество строк в группе.
+     *
+     * @throws std::invalid_argument Если rowGroupSize равен нулю.
+     * @throws std::runtime_error Если файл невозможно создать.
+     */
+    SleepMetricsExporter(const std::string &filename, ExportFormat format, std::vector<std::string> users,
+                         std::size_t rowGroupSize = kDefaultRowGroupSize);
+
+    /**
+     * @brief Удаляет временный файл, если выгрузка не завершена через close().
+     */
+    ~SleepMetricsExporter();
+
+    SleepMetricsExporter(const SleepMetricsExporter &) = delete;
+
+    SleepMetricsExporter &operator=(const SleepMetricsExporter &) = delete;
+
+    /**
+     * @brief Разбирает название формата ("columnar" или "csv").
+     *
+     * @throws std::invalid_argument Если формат неизвестен.
+     */
+    static ExportFormat parseFormat(const std::string &name);
+
+    /**
+     * @brief Добавляет ночи одного пользователя.
+     *
+     * Ошибка записи не выбрасывается: последующие вызовы ничего не делают, а ошибку сообщает close().
+     *
+     * @param user Индекс пользователя в списке, переданном конструктору.
+     * @param dates Даты ночей, секунды от эпохи.
+     * @param nights Метрики ночей.
+     * @param architecture Архитектура сна ночей.
+     *
+     * @throws std::invalid_argument Если индекс пользователя неизвестен или размеры массивов различаются.
+     */
+    void append(std::uint32_t user, std::span<const std::int64_t> dates, std::span<const SleepMetrics> nights,
+                std::span<const SleepArchitecture> architecture);
+
+    /**
+     * @brief Записывает оставшиеся строки и индекс и переименовывает временный файл.
+     *
+     * @throws std::runtime_error Если файл невозможно записать.
+     */
+    void close();
+
+    /// Количество добавленных строк.
+    [[nodiscard]] std::uint64_t rows() const;
+
+private:
+    struct RowGroup {
+        std::uint64_t offset;
+        std::uint64_t rowCount;
+    };
+
+    void appendColumnar(std::uint32_t user, std::int64_t date, const SleepMetrics &m, const SleepArchitecture &a);
+
+    void appendCsv(std::uint32_t user, std::span<const std::int64_t> dates, std::span<const SleepMetrics> nights,
+                   std::span<const SleepArchitecture> architecture);
+
+    /// Записывает накопленные строки; вызывается под mutex_.
+    void flush();
+
+    /// Записывает индекс и концевик колоночного файла.
+    void writeIndex();
+
+    std::string filename_;
+    std::string tmpPath_;
+    ExportFormat format_;
+    std::vector<std::string> users_;
+    std::vector<std::string> csvUsers_;   ///< Имена пользователей, подготовленные для CSV
+    std::size_t rowGroupSize_;
+
+    mutable std::mutex mutex_;
+    int fd_ = -1;
+    std::uint64_t offset_ = 0;            ///< Записано байт
+    std::uint64_t rows_ = 0;              ///< Добавлено строк
+    std::size_t pending_ = 0;             ///< Строк в буферах
+    std::vector<std::vector<std::byte>> columns_; ///< Буферы колонок текущей группы
+    std::string csv_;                     ///< Буфер строк CSV текущей группы
+    std::vector<RowGroup> rowGroups_;
+    std::string error_;                   ///< Первая ошибка записи
+};
+
+#endif //SLEEP_VISUALIZER_SLEEPMETRICSEXPORTER_H
@@ -0,0 +1,91 @@
+#include "SleepMetricsIndex.h"
+#include <algorithm>
+#include <stdexcept>
+#include "../sleep_data_loader/DateTimeParser.h"
+
+namespace {
+
+std::int64_t dayOf(const DateTime &date) {
+    return DateTimeParser::localDayNumber(std::chrono::floor<std::chrono::seconds>(date.time_since_epoch()).count());
+}
+
+unsigned weekdayOf(std::int64_t day) {
+    return std::chrono::weekday(std::chrono::sys_days(std::chrono::days(day))).c_encoding();
+}
+
+} // namespace
+
+SleepMetricsIndex::SleepMetricsIndex(const SleepPhaseColumns &history) {
+    std::vector<SleepMetrics> metrics(history.nightCount());
+    SleepAnalyzer::CalculateBatchMetrics(history, metrics);
+
+    std::vector<std::int64_t> days(history.nightCount());
+    for (std::size_t i = 0; i < days.size(); ++i) {
+        days[i] = DateTimeParser::localDayNumber(history.dates[i]);
+    }
+    build(days, metrics);
+}
+
+SleepMetricsIndex::SleepMetricsIndex(std::span<const DateTime> dates, std::span<const SleepMetrics> metrics) {
+    if (dates.size() != metrics.size()) {
+        throw std::invalid_argument("dates and metrics sizes differ");
+    }
+    std::vector<std::int64_t> days(dates.size());
+    std::transform(dates.begin(), dates.end(), days.begin(), dayOf);
+    build(days, metrics);
+}
+
+void SleepMetricsIndex::build(std::span<const std::int64_t> days, std::span<const SleepMetrics> metrics) {
+    if (days.empty()) return;
+
+    const auto [minDay, maxDay] = std::minmax_element(days.begin(), days.end());
+    firstDay_ = *minDay;
+    const auto dayCount = static_cast<std::size_t>(*maxDay - *minDay + 1);
+
+    weekPrefix_.assign(dayCount, SleepMetricsTotals{});
+    for (std::size_t i = 0; i < days.size(); ++i) {
+        weekPrefix_[static_cast<std::size_t>(days[i] - firstDay_)].add(metrics[i]);
+    }
+
+    prefix_.assign(dayCount + 1, SleepMetricsTotals{});
+    for (std::size_t i = 0; i < dayCount; ++i) {
+        prefix_[i + 1] = prefix_[i];
+        prefix_[i + 1] += weekPrefix_[i];
+    }
+    for (std::size_t i = 7; i < dayCount; ++i) {
+        weekPrefix_[i] += weekPrefix_[i - 7];
+    }
+}
+
+SleepMetricsTotals SleepMetricsIndex::totals(const DateTime &from, const DateTime &to, std::uint8_t weekdays) const {
+    return totalsForDays(dayOf(from), dayOf(to), weekdays);
+}
+
+SleepMetricsTotals SleepMetricsIndex::totalsForDays(std::int64_t firstDay, std::int64_t lastDay,
+                                                    std::uint8_t weekdays) const {
+    if (empty()) return {};
+    const std::int64_t first = std::max(firstDay, firstDay_) - firstDay_;
+    const std::int64_t last = std::min(lastDay, this->lastDay()) - firstDay_;
+    if (first > last) return {};
+
+    if ((weekdays & kAllWeekdays) == kAllWeekdays) {
+        SleepMetricsTotals result = prefix_[static_cast<std::size_t>(last + 1)];
+        result -= prefix_[static_cast<std::size_t>(first)];
+        return result;
+    }
+
+    SleepMetricsTotals result;
+    const unsigned lastWeekday = weekdayOf(firstDay_ + last);
+    for (unsigned weekday = 0; weekday < 7; ++weekday) {
+        if ((weekdays & (1u << weekday)) == 0) continue;
+
+        // последний день с этим днём недели внутри диапазона и последний такой же день перед ним
+        const std::int64_t end = last - static_cast<std::int64_t>((lastWeekday + 7 - weekday) % 7);
+        if (end < first) continue;
+        const std::int64_t before = end - 7 * ((end - first) / 7 + 1);
+
+        result += weekPrefix_[static_cast<std::size_t>(end)];
+        if (before >= 0) result -= weekPrefix_[static_cast<std::size_t>(before)];
+    }
+    return result;
+}
@@ -0,0 +1,99 @@
+#ifndef SLEEP_VISUALIZER_SLEEPMETRICSINDEX_H
+#define SLEEP_VISUALIZER_SLEEPMETRICSINDEX_H
+
+#include <chrono>
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "SleepAnalyzer.h"
+
+/**
+ * @brief Индекс префиксных сумм метрик для запросов по произвольным диапазонам дат за O(1).
+ *
+ * Строится один раз по загруженной истории. Для каждого календарного дня от первой до последней ночи
+ * хранятся SleepMetricsTotals всех ночей до этого дня включительно, поэтому суммы за диапазон
+ * равны разности двух префиксов. Для запросов по дням недели («все понедельники 2025 года») хранятся
+ * префиксные суммы с шагом 7 дней: сумма по одному дню недели - тоже разность двух элементов.
+ *
+ * Индекс неизменяем; для часто меняющихся последних ночей подходит RollingMetrics.
+ */
+class SleepMetricsIndex {
+public:
+    /// Маска всех дней недели для запросов.
+    static constexpr std::uint8_t kAllWeekdays = 0x7F;
+
+    /**
+     * @brief Бит дня недели в маске запроса.
+     */
+    static constexpr std::uint8_t weekdayBit(std::chrono::weekday weekday) {
+        return static_cast<std::uint8_t>(1u << weekday.c_encoding());
+    }
+
+    /**
+     * @brief Создаёт пустой индекс.
+     */
+    SleepMetricsIndex() = default;
+
+    /**
+     * @brief Строит индекс по всем ночам набора колонок.
+     */
+    explicit SleepMetricsIndex(const SleepPhaseColumns &history);
+
+    /**
+     * @brief Строит индекс по уже рассчитанным метрикам ночей.
+     *
+     * @param dates Даты ночей (локальная полночь), в любом порядке.
+     * @param metrics Метрики ночей, по элементу на дату.
+     *
+     * @throws std::invalid_argument Если размеры @p dates и @p metrics различаются.
+     */
+    SleepMetricsIndex(std::span<const DateTime> dates, std::span<const SleepMetrics> metrics);
+
+    /**
+     * @brief Суммы метрик ночей с датами из [@p from, @p to].
+     *
+     * @param from Первая дата диапазона.
+     * @param to Последняя дата диапазона (включительно).
+     * @param weekdays Маска дней недели, см. weekdayBit().
+     * @return Суммы; пустые, если в диапазоне нет ночей.
+     */
+    [[nodiscard]] SleepMetricsTotals totals(const DateTime &from, const DateTime &to,
+                                            std::uint8_t weekdays = kAllWeekdays) const;
+
+    /**
+     * @brief Суммы метрик ночей за дни [@p firstDay, @p lastDay] в шкале DateTimeParser::localDayNumber.
+     */
+    [[nodiscard]] SleepMetricsTotals totalsForDays(std::int64_t firstDay, std::int64_t lastDay,
+                                                   std::uint8_t weekdays = kAllWeekdays) const;
+
+    /**
+     * @brief Средние метрики ночей с датами из [@p from, @p to].
+     */
+    [[nodiscard]] SleepMetrics average(const DateTime &from, const DateTime &to,
+                                       std::uint8_t weekdays = kAllWeekdays) const {
+        return totals(from, to, weekdays).average();
+    }
+
+    [[nodiscard]] bool empty() const { return weekPrefix_.empty(); }
+
+    /**
+     * @brief Номер первого дня индекса.
+     */
+    [[nodiscard]] std::int64_t firstDay() const { return firstDay_; }
+
+    /**
+     * @brief Номер последнего дня индекса.
+     */
+    [[nodiscard]] std::int64_t lastDay() const {
+        return firstDay_ + static_cast<std::int64_t>(weekPrefix_.size()) - 1;
+    }
+
+private:
+    void build(std::span<const std::int64_t> days, std::span<const SleepMetrics> metrics);
+
+    std::int64_t firstDay_ = 0;
+    std::vector<SleepMetricsTotals> prefix_;     ///< prefix_[i] - суммы за дни [firstDay_, firstDay_ + i)
+    std::vector<SleepMetricsTotals> weekPrefix_; ///< weekPrefix_[i] - суммы за дни i, i - 7, i - 14, ...
+};
+
+#endif //SLEEP_VISUALIZER_SLEEPMETRICSINDEX_H
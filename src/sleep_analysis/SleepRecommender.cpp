@@ -0,0 +1,26 @@
+#include "SleepRecommender.h"
+#include "Trace.h"
+#include <sstream>
+
+std::string SleepRecommender::GenerateRecommendation(const SleepMetrics &m) {
+    SLEEP_TRACE_SCOPE("SleepRecommender::GenerateRecommendation");
+
+    const RecommendationRules &rules = RecommendationRules::Defaults();
+    return rules.render(rules.evaluate(m));
+}
+
+std::string SleepRecommender::GenerateInsight(const SleepMetrics &today, const SleepMetrics &yesterday) {
+    SLEEP_TRACE_SCOPE("SleepRecommender::GenerateInsight");
+    double diff = today.totalSleepTime - yesterday.totalSleepTime;
+
+    std::ostringstream oss;
+    if (diff > 0.0) {
+        oss << "Сегодня вы спали на " << diff << " ч. больше, чем вчера.\n";
+    } else if (diff < 0.0) {
+        oss << "Сегодня вы спали на " << (-diff) << " ч. меньше, чем вчера.\n";
+    } else {
+        oss << "Сегодня вы спали столько же, сколько и вчера.\n";
+    }
+
+    return oss.str();
+}
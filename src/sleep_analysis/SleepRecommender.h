@@ -2,13 +2,17 @@
 #define SLEEP_VISUALIZER_SLEEPRECOMMENDER_H
 
 #include <string>
+#include "RecommendationRules.h"
 #include "SleepAnalyzer.h"
 
 
 class SleepRecommender {
 public:
     /**
-    * @brief Генерирует текстовую рекомендацию, как улучшить сон
+    * @brief Генерирует текстовую рекомендацию, как улучшить сон, по встроенным правилам
+    *
+    * Для многих периодов сразу удобнее RecommendationRules::evaluate() по пакету метрик
+    * и RecommendationRules::render() только для показываемых результатов.
     *
     * @param  metrics - данные о сне за любой промежуток времени
     */
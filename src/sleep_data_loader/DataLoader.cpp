@@ -1,8 +1,410 @@
 #include "DataLoader.h"
+#include "DateTimeParser.h"
+#include "SleepPhaseStore.h"
+#include "Trace.h"
+#include "WorkStealingPool.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
 #include <fstream>
 #include "nlohmann/json.hpp"
 #include <iostream>
-#include <sstream>
+#include <memory>
+
+namespace {
+
+std::int64_t toSeconds(DateTime t) {
+    return std::chrono::duration_cast<std::chrono::seconds>(t.time_since_epoch()).count();
+}
+
+bool isJsonSpace(char c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+/**
+ * Находит закрывающую кавычку строки, открывающая кавычка которой - json[begin].
+ * Кавычки ищутся через memchr; экранированная кавычка узнаётся по нечётному числу обратных косых черт перед ней.
+ */
+std::size_t stringEnd(std::string_view json, std::size_t begin) {
+    std::size_t i = begin + 1;
+    while (i < json.size()) {
+        const void *quote = std::memchr(json.data() + i, '"', json.size() - i);
+        if (quote == nullptr) break;
+        i = static_cast<std::size_t>(static_cast<const char *>(quote) - json.data());
+        std::size_t backslashes = 0;
+        while (json[i - 1 - backslashes] == '\\') ++backslashes;
+        if (backslashes % 2 == 0) return i;
+        ++i;
+    }
+    throw std::runtime_error("error parsing JSON: unexpected end of input");
+}
+
+/**
+ * Находит конец значения-объекта или массива, начинающегося с json[begin]: позицию после закрывающей скобки.
+ */
+std::size_t skipComposite(std::string_view json, std::size_t begin) {
+    int depth = 0;
+    for (std::size_t i = begin; i < json.size(); ++i) {
+        switch (json[i]) {
+            case '"':
+                i = stringEnd(json, i);
+                break;
+            case '{':
+            case '[':
+                ++depth;
+                break;
+            case '}':
+            case ']':
+                if (--depth == 0) return i + 1;
+                break;
+            default:
+                break;
+        }
+    }
+    throw std::runtime_error("error parsing JSON: unexpected end of input");
+}
+
+} // namespace
+
+/**
+ * Обработчик не строит JSON-дерево: значения полей сразу разбираются в поля DailySleepData,
+ * поэтому в памяти одновременно находятся только текущие сутки.
+ * Неизвестные ключи (вместе с вложенными объектами и массивами) пропускаются.
+ *
+ * Фазы и сигналы выделяются из переданного ресурса. Буферы текущих суток переиспользуются: если обработчик
+ * забрал сутки, новые буферы сразу резервируются по размерам предыдущей ночи.
+ */
+class DataLoader::DaySaxHandler {
+public:
+    using json = nlohmann::json;
+    using number_integer_t = json::number_integer_t;
+    using number_unsigned_t = json::number_unsigned_t;
+    using number_float_t = json::number_float_t;
+    using string_t = json::string_t;
+    using binary_t = json::binary_t;
+
+    DaySaxHandler(const DayCallback &onDay, std::pmr::memory_resource *resource)
+            : onDay_(onDay),
+              current_{{}, {}, {}, std::pmr::vector<SleepPhase>(resource), {SleepSignal(resource), SleepSignal(resource)}} {}
+
+    [[nodiscard]] std::size_t daysCount() const { return daysCount_; }
+
+    bool null() {
+        if (skipDepth_ == 0 && state_ == State::Samples) {
+            signal_->append(kMissingSample);
+            return true;
+        }
+        return scalar();
+    }
+
+    bool boolean(bool) { return scalar(); }
+
+    bool number_integer(number_integer_t val) { return number(static_cast<double>(val)); }
+
+    bool number_unsigned(number_unsigned_t val) { return number(static_cast<double>(val)); }
+
+    bool number_float(number_float_t val, const string_t &) { return number(val); }
+
+    bool binary(binary_t &) { return scalar(); }
+
+    bool string(string_t &val) {
+        if (skipDepth_ > 0) return true;
+        if (state_ == State::Day && isSignalField(field_)) {
+            failDay("expected a signal object");
+        }
+        if (state_ == State::Samples || (state_ == State::Signal && field_ != Field::Start && field_ != Field::None)) {
+            failDay("expected a number");
+        }
+        try {
+            if (state_ == State::Day) {
+                if (field_ == Field::Date) {
+                    current_.date = parseDate(val);
+                } else if (field_ == Field::Bedtime) {
+                    current_.bedtime = parseDateTime(val);
+                } else if (field_ == Field::WakeTime) {
+                    current_.wakeTime = parseDateTime(val);
+                }
+                seen_ |= static_cast<unsigned>(field_);
+            } else if (state_ == State::Signal) {
+                if (field_ == Field::Start) {
+                    signal_->setStart(parseDateTime(val));
+                }
+                seenSignal_ |= static_cast<unsigned>(field_);
+            } else if (state_ == State::Phase) {
+                if (field_ == Field::Type) {
+                    phase_.type = fromString(val);
+                } else if (field_ == Field::Start) {
+                    phase_.start = parseDateTime(val);
+                } else if (field_ == Field::End) {
+                    phase_.end = parseDateTime(val);
+                }
+                seenPhase_ |= static_cast<unsigned>(field_);
+            } else {
+                return scalar();
+            }
+        } catch (const std::exception &e) {
+            failDay(e.what());
+        }
+        return true;
+    }
+
+    bool start_object(std::size_t) {
+        if (skipDepth_ > 0 || isSkippedContainer()) {
+            ++skipDepth_;
+            return true;
+        }
+        if (state_ == State::Day && isSignalField(field_)) {
+            beginSignal();
+            return true;
+        }
+        switch (state_) {
+            case State::Root:
+            case State::Days:
+                parent_ = state_;
+                state_ = State::Day;
+                resetDay();
+                seen_ = 0;
+                return true;
+            case State::Phases:
+                state_ = State::Phase;
+                phase_ = SleepPhase{};
+                seenPhase_ = 0;
+                return true;
+            case State::Samples:
+                failDay("expected a number");
+            default:
+                failDay("expected a string value");
+        }
+    }
+
+    bool key(string_t &val) {
+        if (skipDepth_ > 0) return true;
+        if (state_ == State::Day) {
+            if (val == "date") field_ = Field::Date;
+            else if (val == "bedtime") field_ = Field::Bedtime;
+            else if (val == "wake_time") field_ = Field::WakeTime;
+            else if (val == "phases") field_ = Field::Phases;
+            else if (val == "heart_rate") field_ = Field::HeartRate;
+            else if (val == "respiration") field_ = Field::Respiration;
+            else field_ = Field::None;
+        } else if (state_ == State::Signal) {
+            if (val == "start") field_ = Field::Start;
+            else if (val == "interval") field_ = Field::Interval;
+            else if (val == "values") field_ = Field::Values;
+            else field_ = Field::None;
+        } else {
+            if (val == "type") field_ = Field::Type;
+            else if (val == "start") field_ = Field::Start;
+            else if (val == "end") field_ = Field::End;
+            else field_ = Field::None;
+        }
+        return true;
+    }
+
+    bool end_object() {
+        if (skipDepth_ > 0) {
+            --skipDepth_;
+            return true;
+        }
+        if (state_ == State::Signal) {
+            requireField(seenSignal_, Field::Start, "start");
+            requireField(seenSignal_, Field::Values, "values");
+            lastSignalBytes_[signalIndex_] = signal_->encodedSize();
+            state_ = State::Day;
+            field_ = Field::None;
+            return true;
+        }
+        if (state_ == State::Phase) {
+            requireField(seenPhase_, Field::Type, "type");
+            requireField(seenPhase_, Field::Start, "start");
+            requireField(seenPhase_, Field::End, "end");
+            current_.phases.push_back(phase_);
+            state_ = State::Phases;
+            field_ = Field::None;
+            return true;
+        }
+        requireField(seen_, Field::Date, "date");
+        requireField(seen_, Field::Bedtime, "bedtime");
+        requireField(seen_, Field::WakeTime, "wake_time");
+        state_ = parent_;
+        field_ = Field::None;
+        ++daysCount_;
+        lastPhaseCount_ = current_.phases.size();
+        onDay_(std::move(current_));
+        resetDay();
+        return true;
+    }
+
+    bool start_array(std::size_t) {
+        if (skipDepth_ > 0) {
+            ++skipDepth_;
+            return true;
+        }
+        if (state_ == State::Root) {
+            state_ = State::Days;
+            return true;
+        }
+        if (state_ == State::Day && field_ == Field::Phases) {
+            state_ = State::Phases;
+            return true;
+        }
+        if (state_ == State::Signal && field_ == Field::Values) {
+            state_ = State::Samples;
+            seenSignal_ |= static_cast<unsigned>(Field::Values);
+            return true;
+        }
+        if (isSkippedContainer()) {
+            ++skipDepth_;
+            return true;
+        }
+        if (state_ == State::Days) {
+            throw std::runtime_error("invalid data format: expected an array of days");
+        }
+        if (state_ == State::Signal || state_ == State::Samples) {
+            failDay("expected a number");
+        }
+        failDay(state_ == State::Phases ? "expected a phase object" : "expected a string value");
+    }
+
+    bool end_array() {
+        if (skipDepth_ > 0) {
+            --skipDepth_;
+            return true;
+        }
+        state_ = state_ == State::Phases ? State::Day : state_ == State::Samples ? State::Signal : State::Root;
+        field_ = Field::None;
+        return true;
+    }
+
+    bool parse_error(std::size_t, const std::string &, const nlohmann::detail::exception &ex) {
+        throw std::runtime_error(std::string("error parsing JSON: ") + ex.what());
+    }
+
+private:
+    enum class State {
+        Root,   ///< Вне данных
+        Days,   ///< Внутри массива суток верхнего уровня
+        Day,    ///< Внутри объекта суток
+        Phases, ///< Внутри массива фаз
+        Phase,  ///< Внутри объекта фазы
+        Signal, ///< Внутри объекта ряда пульса или дыхания
+        Samples ///< Внутри массива отсчётов ряда
+    };
+
+    enum class Field : unsigned {
+        None = 0,
+        Date = 1u << 0,
+        Bedtime = 1u << 1,
+        WakeTime = 1u << 2,
+        Phases = 1u << 3,
+        Type = 1u << 4,
+        Start = 1u << 5,
+        End = 1u << 6,
+        HeartRate = 1u << 7,
+        Respiration = 1u << 8,
+        Interval = 1u << 9,
+        Values = 1u << 10
+    };
+
+    static bool isSignalField(Field field) {
+        return field == Field::HeartRate || field == Field::Respiration;
+    }
+
+    /// Значение в единицах измерения переводится в десятые доли; неположительное - отсутствие данных.
+    static SignalSample toSample(double value) {
+        if (!(value > 0.0)) return kMissingSample;
+        const double scaled = std::round(value * kSignalScale);
+        return static_cast<SignalSample>(std::clamp(scaled, 1.0, 32767.0));
+    }
+
+    /// Неизвестные поля и поле phases, не являющееся массивом, пропускаются целиком.
+    [[nodiscard]] bool isSkippedContainer() const {
+        if (state_ == State::Day) return field_ == Field::None || field_ == Field::Phases;
+        return (state_ == State::Phase || state_ == State::Signal) && field_ == Field::None;
+    }
+
+    bool number(double val) {
+        if (skipDepth_ > 0) return true;
+        if (state_ == State::Samples) {
+            signal_->append(toSample(val));
+            return true;
+        }
+        if (state_ == State::Signal && field_ == Field::Interval) {
+            if (val != std::floor(val) || val < 1.0 || val > 86400.0) {
+                failDay("invalid signal interval");
+            }
+            signal_->setInterval(static_cast<std::int32_t>(val));
+            seenSignal_ |= static_cast<unsigned>(Field::Interval);
+            return true;
+        }
+        return scalar();
+    }
+
+    void beginSignal() {
+        signalIndex_ = static_cast<std::size_t>(field_ == Field::HeartRate ? SleepSignalType::HeartRate
+                                                                           : SleepSignalType::Respiration);
+        signal_ = &current_.signals[signalIndex_];
+        signal_->reset({}, 1);
+        signal_->reserveBytes(lastSignalBytes_[signalIndex_]);
+        state_ = State::Signal;
+        seenSignal_ = 0;
+    }
+
+    bool scalar() {
+        if (skipDepth_ > 0 || isSkippedContainer()) return true;
+        if (state_ == State::Samples || (state_ == State::Signal && field_ != Field::Start)) {
+            failDay("expected a number");
+        }
+        if (state_ == State::Day || state_ == State::Phase || state_ == State::Signal) {
+            failDay("expected a string value");
+        }
+        if (state_ == State::Phases) {
+            failDay("expected a phase object");
+        }
+        throw std::runtime_error("invalid data format: expected an array of days");
+    }
+
+    void requireField(unsigned seen, Field field, const char *name) const {
+        if ((seen & static_cast<unsigned>(field)) == 0) {
+            failDay(std::string("missing field: ") + name);
+        }
+    }
+
+    /// Присваивание DailySleepData{} не годится: перемещающее присваивание сохранило бы ресурс прежнего буфера
+    void resetDay() {
+        current_.date = {};
+        current_.bedtime = {};
+        current_.wakeTime = {};
+        current_.phases.clear();
+        if (current_.phases.capacity() == 0) {
+            current_.phases.reserve(lastPhaseCount_);
+        }
+        for (auto &signal: current_.signals) {
+            signal.reset({}, 1);
+        }
+    }
+
+    [[noreturn]] void failDay(const std::string &what) const {
+        throw std::runtime_error("failed to parse day " + std::to_string(daysCount_ + 1) + ": " + what);
+    }
+
+    const DayCallback &onDay_;
+    State state_ = State::Root;
+    State parent_ = State::Root;
+    Field field_ = Field::None;
+    std::size_t skipDepth_ = 0;
+    std::size_t daysCount_ = 0;
+    std::size_t lastPhaseCount_ = 0;
+    std::array<std::size_t, kSleepSignalCount> lastSignalBytes_{};
+    unsigned seen_ = 0;
+    unsigned seenPhase_ = 0;
+    unsigned seenSignal_ = 0;
+    std::size_t signalIndex_ = 0;
+    SleepSignal *signal_ = nullptr;
+    DailySleepData current_;
+    SleepPhase phase_{};
+};
 
 WeeklySleepData DataLoader::loadFromJsonFile(const std::string &filename) {
     WeeklySleepData weeklySleepData;
@@ -12,11 +414,20 @@ WeeklySleepData DataLoader::loadFromJsonFile(const std::string &filename) {
         throw std::runtime_error("unable to open file: " + filename);
     }
 
-    nlohmann::json j;
-    ifs >> j;
-
     try {
-        weeklySleepData = DataLoader::parseWeeklyData(j);
+        // неделя принимается только целиком: при ошибке результат остаётся пустым
+        WeeklySleepData parsed;
+        std::size_t i = 0;
+        streamFromJson(ifs, [&](DailySleepData &&day) {
+            if (i >= parsed.sleepDays.size()) {
+                throw std::runtime_error("invalid weekly data format: expected an array of 7 days");
+            }
+            parsed.sleepDays[i++] = std::move(day);
+        });
+        if (i != parsed.sleepDays.size()) {
+            throw std::runtime_error("invalid weekly data format: expected an array of 7 days");
+        }
+        weeklySleepData = std::move(parsed);
     } catch (const std::exception &e) {
         std::cerr << "error parsing JSON: " << e.what() << std::endl;
     }
@@ -24,59 +435,271 @@ WeeklySleepData DataLoader::loadFromJsonFile(const std::string &filename) {
     return weeklySleepData;
 }
 
-SleepPhaseType DataLoader::fromString(const std::string &phaseStr) {
-    if (phaseStr == "Light") return SleepPhaseType::Light;
-    if (phaseStr == "Deep") return SleepPhaseType::Deep;
-    if (phaseStr == "REM") return SleepPhaseType::REM;
-    if (phaseStr == "Awake") return SleepPhaseType::Awake;
-    throw std::invalid_argument("invalid sleep phase string");
+SleepHistory DataLoader::loadHistoryFromJsonFile(const std::string &filename) {
+    SleepHistory history;
+    history.nights = loadHistoryFromJsonFile(filename, history.arena.get());
+    return history;
 }
 
-DateTime DataLoader::parseDateTime(const std::string &dateTimeStr, const std::string &format) {
-    std::tm tm = {};
-    std::istringstream ss(dateTimeStr);
-    ss >> std::get_time(&tm, format.c_str());
+std::pmr::vector<DailySleepData> DataLoader::loadHistoryFromJsonFile(const std::string &filename,
+                                                                     std::pmr::memory_resource *resource) {
+    std::pmr::vector<DailySleepData> history(resource);
+    streamFromJsonFile(filename, [&history](DailySleepData &&day) {
+        history.push_back(std::move(day));
+    }, {}, resource);
+    return history;
+}
+
+std::size_t DataLoader::loadStoreFromJsonFile(const std::string &filename, SleepPhaseStore &store) {
+    return streamFromJsonFile(filename, [&store](DailySleepData &&day) {
+        store.append(day);
+    });
+}
 
-    if (ss.fail()) {
-        throw std::invalid_argument("invalid date format: " + dateTimeStr);
+std::vector<std::string> DataLoader::findJsonFiles(const std::string &directory) {
+    std::vector<std::filesystem::path> paths;
+    try {
+        for (const auto &entry: std::filesystem::recursive_directory_iterator(directory)) {
+            if (entry.is_regular_file() && entry.path().extension() == ".json") {
+                paths.push_back(entry.path());
+            }
+        }
+    } catch (const std::filesystem::filesystem_error &e) {
+        throw std::runtime_error("unable to read directory: " + directory + ": " + e.what());
     }
-    return std::chrono::system_clock::from_time_t(std::mktime(&tm));
+    std::sort(paths.begin(), paths.end());
+
+    std::vector<std::string> files;
+    files.reserve(paths.size());
+    for (const auto &path: paths) {
+        files.push_back(path.string());
+    }
+    return files;
 }
 
-DailySleepData DataLoader::parseDailyData(const nlohmann::json &j) {
-    DailySleepData result;
-    result.date = parseDateTime(j.value("date", ""), "%Y-%m-%d");
-    result.bedtime = parseDateTime(j.value("bedtime", ""));
-    result.wakeTime = parseDateTime(j.value("wake_time", ""));
+DirectoryLoadResult DataLoader::loadDirectory(const std::string &directory, WorkStealingPool &pool) {
+    SLEEP_TRACE_SCOPE("DataLoader::loadDirectory");
+    const std::vector<std::string> paths = findJsonFiles(directory);
+
+    DirectoryLoadResult result;
+    result.files.resize(paths.size());
+    result.arenas.resize(paths.size());
+    std::vector<std::vector<DailySleepData>> perFile(paths.size());
 
-    if (j.contains("phases") && j["phases"].is_array()) {
-        for (auto &phase: j["phases"]) {
-            //todo try?
-            SleepPhase sp;
+    pool.parallelFor(paths.size(), [&](std::size_t i) {
+        FileLoadStats &stats = result.files[i];
+        stats.path = paths[i];
+        std::error_code ec;
+        stats.bytes = std::filesystem::file_size(paths[i], ec);
 
-            //todo заменить на at?
-            sp.type = fromString(phase.value("type", ""));
-            sp.start = parseDateTime(phase.value("start", ""));
-            sp.end = parseDateTime(phase.value("end", ""));
-            result.phases.push_back(sp);
+        // арена своя у каждого файла: monotonic_buffer_resource не потокобезопасен
+        const auto start = std::chrono::steady_clock::now();
+        result.arenas[i] = std::make_unique<LoadArena>();
+        try {
+            streamFromJsonFile(stats.path, [&nights = perFile[i]](DailySleepData &&day) {
+                nights.push_back(std::move(day));
+            }, {}, result.arenas[i].get());
+        } catch (const std::exception &e) {
+            stats.error = e.what();
+            perFile[i].clear();
+        }
+        stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        stats.nights = perFile[i].size();
+    });
+
+    std::vector<NightOrigin> origins;
+    for (std::size_t f = 0; f < perFile.size(); ++f) {
+        for (std::size_t n = 0; n < perFile[f].size(); ++n) {
+            const DailySleepData &night = perFile[f][n];
+            origins.push_back({f, n, toSeconds(night.date), toSeconds(night.bedtime), toSeconds(night.wakeTime)});
         }
     }
+    const std::vector<std::size_t> kept = mergeNights(origins, result.droppedNights);
+
+    result.nights.reserve(kept.size());
+    for (const std::size_t k: kept) {
+        result.nights.push_back(std::move(perFile[origins[k].file][origins[k].index]));
+    }
     return result;
 }
 
-WeeklySleepData DataLoader::parseWeeklyData(const nlohmann::json &weeklyJson) {
-    WeeklySleepData weeklySleepData;
+std::vector<std::size_t> DataLoader::mergeNights(std::span<const NightOrigin> nights, std::size_t &dropped) {
+    // (файл, запись) - порядок приоритета: при совпадении дат или пересечении побеждает более поздняя запись
+    auto isLater = [&nights](std::size_t a, std::size_t b) {
+        return nights[a].file != nights[b].file ? nights[a].file > nights[b].file : nights[a].index > nights[b].index;
+    };
+    std::vector<std::size_t> order(nights.size());
+    for (std::size_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+        if (nights[a].date != nights[b].date) return nights[a].date < nights[b].date;
+        return isLater(b, a);
+    });
 
-    if (!weeklyJson.is_array() || weeklyJson.size() != 7) {
-        throw std::runtime_error("invalid weekly data format: expected an array of 7 days");
+    auto conflicts = [&nights](std::size_t previous, std::size_t current) {
+        // пересечения внутри одного файла - свойство самих данных, их не трогаем
+        const bool overlapsOtherFile = nights[current].file != nights[previous].file &&
+                                       nights[current].bedtime < nights[previous].wakeTime;
+        return nights[current].date == nights[previous].date || overlapsOtherFile;
+    };
+
+    std::vector<std::size_t> kept;
+    kept.reserve(order.size());
+    for (const std::size_t i: order) {
+        kept.push_back(i);
+        // ночь, заменившая предыдущую, может сама пересечься с ночью перед ней: проверяем, пока есть конфликт
+        while (kept.size() >= 2 && conflicts(kept[kept.size() - 2], kept.back())) {
+            ++dropped;
+            const std::size_t current = kept.back();
+            kept.pop_back();
+            if (isLater(current, kept.back())) kept.back() = current;
+        }
     }
+    return kept;
+}
 
-    for (size_t i = 0; i < 7; ++i) {
-        try {
-            weeklySleepData.sleepDays[i] = parseDailyData(weeklyJson[i]);
-        } catch (const std::exception &e) {
-            throw std::runtime_error("failed to parse day " + std::to_string(i + 1) + ": " + e.what());
+DirectoryLoadResult DataLoader::loadDirectory(const std::string &directory) {
+    WorkStealingPool pool;
+    return loadDirectory(directory, pool);
+}
+
+std::size_t DataLoader::streamFromJsonFile(const std::string &filename, const DayCallback &onDay,
+                                          const ProgressCallback &onProgress, std::pmr::memory_resource *resource) {
+    SLEEP_TRACE_SCOPE("DataLoader::streamFromJsonFile");
+    // крупный буфер чтения: SAX-парсер забирает символы по одному, а системных вызовов должно быть мало;
+    // для небольших файлов буфер не больше самого файла
+    constexpr std::uintmax_t maxBufferSize = 1 << 20;
+    std::error_code ec;
+    const std::uintmax_t fileSize = std::filesystem::file_size(filename, ec);
+    const auto bufferSize = static_cast<std::size_t>(
+            ec ? maxBufferSize : std::clamp<std::uintmax_t>(fileSize + 1, 4096, maxBufferSize));
+    const auto buffer = std::make_unique_for_overwrite<char[]>(bufferSize);
+    std::ifstream ifs;
+    ifs.rdbuf()->pubsetbuf(buffer.get(), static_cast<std::streamsize>(bufferSize));
+    ifs.open(filename, std::ios::binary);
+    if (!ifs.is_open()) {
+        throw std::runtime_error("unable to open file: " + filename);
+    }
+    if (!onProgress) {
+        return streamFromJson(ifs, onDay, resource);
+    }
+
+    // позиция запрашивается не на каждых сутках: tellg у файлового потока - системный вызов
+    constexpr std::size_t progressInterval = 256;
+    const std::uint64_t totalBytes = ec ? 0 : fileSize;
+    std::size_t days = 0;
+    const DayCallback reporting = [&](DailySleepData &&day) {
+        onDay(std::move(day));
+        if (++days % progressInterval == 0) {
+            const std::streamoff position = ifs.tellg();
+            if (position >= 0) onProgress(static_cast<std::uint64_t>(position), totalBytes);
         }
+    };
+    const std::size_t count = streamFromJson(ifs, reporting, resource);
+    onProgress(totalBytes, totalBytes);
+    return count;
+}
+
+std::size_t DataLoader::streamFromJson(std::istream &input, const DayCallback &onDay,
+                                      std::pmr::memory_resource *resource) {
+    DaySaxHandler handler(onDay, resource);
+    nlohmann::json::sax_parse(input, &handler);
+    return handler.daysCount();
+}
+
+DailySleepData DataLoader::parseDay(std::string_view record) {
+    SLEEP_TRACE_SCOPE("DataLoader::parseDay");
+    DailySleepData day;
+    std::size_t count = 0;
+    const DayCallback onDay = [&](DailySleepData &&parsed) {
+        day = std::move(parsed);
+        ++count;
+    };
+    DaySaxHandler handler(onDay, std::pmr::get_default_resource());
+    nlohmann::json::sax_parse(record.begin(), record.end(), &handler);
+    if (count != 1) {
+        throw std::runtime_error("invalid data format: expected exactly one day per record");
     }
-    return weeklySleepData;
-}
\ No newline at end of file
+    return day;
+}
+
+std::vector<std::string_view> DataLoader::splitRecords(std::string_view json) {
+    SLEEP_TRACE_SCOPE("DataLoader::splitRecords");
+    std::vector<std::string_view> records;
+    std::size_t i = 0;
+    auto skipSpace = [&] {
+        while (i < json.size() && isJsonSpace(json[i])) ++i;
+    };
+    auto expectEnd = [&] {
+        skipSpace();
+        if (i != json.size()) throw std::runtime_error("error parsing JSON: unexpected data after the document");
+    };
+
+    skipSpace();
+    if (i < json.size() && json[i] == '{') {
+        const std::size_t end = skipComposite(json, i);
+        records.push_back(json.substr(i, end - i));
+        i = end;
+        expectEnd();
+        return records;
+    }
+    if (i >= json.size() || json[i] != '[') {
+        throw std::runtime_error("invalid data format: expected an array of days");
+    }
+
+    ++i;
+    skipSpace();
+    if (i < json.size() && json[i] == ']') {
+        ++i;
+        expectEnd();
+        return records;
+    }
+    while (true) {
+        skipSpace();
+        if (i >= json.size() || json[i] != '{') {
+            throw std::runtime_error("failed to parse day " + std::to_string(records.size() + 1) +
+                                     ": expected an object");
+        }
+        const std::size_t end = skipComposite(json, i);
+        records.push_back(json.substr(i, end - i));
+        i = end;
+        skipSpace();
+        if (i < json.size() && json[i] == ',') {
+            ++i;
+            continue;
+        }
+        if (i < json.size() && json[i] == ']') {
+            ++i;
+            break;
+        }
+        throw std::runtime_error("error parsing JSON: expected ',' or ']' after day " +
+                                 std::to_string(records.size()));
+    }
+    expectEnd();
+    return records;
+}
+
+SleepPhaseType DataLoader::fromString(const std::string &phaseStr) {
+    if (phaseStr == "Light") return SleepPhaseType::Light;
+    if (phaseStr == "Deep") return SleepPhaseType::Deep;
+    if (phaseStr == "REM") return SleepPhaseType::REM;
+    if (phaseStr == "Awake") return SleepPhaseType::Awake;
+    throw std::invalid_argument("invalid sleep phase string");
+}
+
+DateTime DataLoader::parseDateTime(std::string_view dateTimeStr) {
+    DateTime result;
+    if (DateTimeParser::parseDateTime(dateTimeStr, result) != DateTimeParseStatus::Ok) {
+        throw std::invalid_argument("invalid date format: " + std::string(dateTimeStr));
+    }
+    return result;
+}
+
+DateTime DataLoader::parseDate(std::string_view dateStr) {
+    DateTime result;
+    if (DateTimeParser::parseDate(dateStr, result) != DateTimeParseStatus::Ok) {
+        throw std::invalid_argument("invalid date format: " + std::string(dateStr));
+    }
+    return result;
+}
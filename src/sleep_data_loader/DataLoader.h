@@ -5,10 +5,19 @@
 #ifndef SLEEP_VISUALIZER_DATALOADER_H
 #define SLEEP_VISUALIZER_DATALOADER_H
 
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <istream>
+#include <memory>
+#include <memory_resource>
+#include <span>
 #include <string>
+#include <string_view>
 #include <vector>
-#include <chrono>
-#include "nlohmann/json.hpp"
+#include "SleepSignal.h"
 
 /**
  * @typedef DataTime
@@ -20,7 +29,7 @@ using DateTime = std::chrono::system_clock::time_point;
  * @enum SleepPhaseType
  * @brief Перечисления возможных типов фаз сна
  */
-enum class SleepPhaseType {
+enum class SleepPhaseType : std::uint8_t {
     Light,  ///< Лёгкий сон
     Deep,   ///< Глубокий сон
     REM,    ///< Быстрый сон
@@ -40,15 +49,21 @@ struct SleepPhase {
 /**
  * @struct DailySleepData
  * @brief Структура для хранения информации о сне за одни сутки.
+ *
+ * Фазы и сигналы размещаются в ресурсе памяти, переданном загрузчику. При копировании копия получает ресурс
+ * по умолчанию, а при перемещении данные остаются в исходном ресурсе, поэтому перемещённые сутки
+ * не должны переживать арену загрузки.
 */
 struct DailySleepData {
-    DateTime date;                  ///< Дата, соответствующая данным о сне
-    DateTime bedtime;               ///< Время отхода ко сну
-    DateTime wakeTime;              ///< Время пробуждения в этот день
-    std::vector<SleepPhase> phases; ///< Список фаз сна за ночь
-//    для будущих визуализаций
-//    int averageHeartRate;
-//    int respirationRate;
+    DateTime date;                        ///< Дата, соответствующая данным о сне
+    DateTime bedtime;                     ///< Время отхода ко сну
+    DateTime wakeTime;                    ///< Время пробуждения в этот день
+    std::pmr::vector<SleepPhase> phases;  ///< Список фаз сна за ночь
+    std::array<SleepSignal, kSleepSignalCount> signals; ///< Пульс и дыхание; индекс - SleepSignalType
+
+    [[nodiscard]] const SleepSignal &signal(SleepSignalType type) const {
+        return signals[static_cast<std::size_t>(type)];
+    }
 };
 
 /**
@@ -58,35 +73,268 @@ struct WeeklySleepData {
     std::array<DailySleepData, 7> sleepDays;
 };
 
+/**
+ * @typedef LoadArena
+ * @brief Арена, из которой выделяется память под фазы всех ночей одной загрузки.
+ *
+ * Память арены не освобождается по одной ночи, а возвращается целиком при уничтожении арены,
+ * поэтому выделение сводится к сдвигу указателя, а освобождение истории - к нескольким крупным блокам.
+ */
+using LoadArena = std::pmr::monotonic_buffer_resource;
+
+/**
+ * @struct SleepHistory
+ * @brief История ночей вместе с ареной, в которой размещены их фазы.
+ *
+ * Арена находится в куче, поэтому историю можно перемещать без копирования фаз. Присваивание запрещено:
+ * оно уничтожило бы арену раньше размещённых в ней ночей.
+ */
+struct SleepHistory {
+    std::unique_ptr<LoadArena> arena = std::make_unique<LoadArena>(); ///< Арена; объявлена первой, уничтожается последней
+    std::pmr::vector<DailySleepData> nights{arena.get()};            ///< Ночи в порядке их следования в файле
+
+    SleepHistory() = default;
+
+    SleepHistory(SleepHistory &&) = default;
+
+    SleepHistory &operator=(SleepHistory &&) = delete;
+};
+
+/**
+ * @struct FileLoadStats
+ * @brief Статистика загрузки одного файла при загрузке каталога.
+ */
+struct FileLoadStats {
+    std::string path;        ///< Путь к файлу
+    std::uintmax_t bytes;    ///< Размер файла, байт
+    std::size_t nights;      ///< Количество разобранных ночей
+    double seconds;          ///< Время чтения и разбора, с
+    std::string error;       ///< Текст ошибки; пустой, если файл загружен успешно
+
+    /**
+     * @brief Пропускная способность разбора файла, МБ/с.
+     */
+    [[nodiscard]] double megabytesPerSecond() const {
+        return seconds > 0.0 ? static_cast<double>(bytes) / (1024.0 * 1024.0) / seconds : 0.0;
+    }
+};
+
+/**
+ * @struct DirectoryLoadResult
+ * @brief Результат загрузки каталога с JSON-файлами.
+ */
+struct DirectoryLoadResult {
+    std::vector<std::unique_ptr<LoadArena>> arenas; ///< Арены файлов, в которых размещены фазы ночей
+    std::vector<DailySleepData> nights;             ///< Ночи из всех файлов, упорядоченные по дате
+    std::vector<FileLoadStats> files;               ///< Статистика по файлам в порядке их путей
+    std::size_t droppedNights = 0;                  ///< Количество отброшенных повторяющихся или пересекающихся ночей
+
+    DirectoryLoadResult() = default;
+
+    DirectoryLoadResult(DirectoryLoadResult &&) = default;
+
+    /// Присваивание запрещено: оно уничтожило бы арены раньше размещённых в них ночей.
+    DirectoryLoadResult &operator=(DirectoryLoadResult &&) = delete;
+};
+
+/**
+ * @struct NightOrigin
+ * @brief Положение ночи среди файлов каталога и поля, по которым DataLoader::mergeNights() выбирает ночи.
+ */
+struct NightOrigin {
+    std::size_t file;       ///< Номер файла в порядке путей
+    std::size_t index;      ///< Номер записи в файле
+    std::int64_t date;      ///< Дата, секунды от эпохи
+    std::int64_t bedtime;   ///< Отход ко сну, секунды от эпохи
+    std::int64_t wakeTime;  ///< Пробуждение, секунды от эпохи
+};
+
+class SleepPhaseStore;
+class WorkStealingPool;
+
 /**
  * @class DataLoader
  * @brief Класс для загрузки и парсинга информации о сне из JSON-файлов.
+ *
+ * Файлы читаются потоково через SAX-интерфейс nlohmann::json: JSON-дерево целиком не строится,
+ * а каждые сутки передаются обработчику сразу после разбора. Поэтому потребление памяти не зависит
+ * от размера файла, и можно загружать истории за несколько лет.
+ *
+ * Кроме фаз сутки могут содержать ряды "heart_rate" и "respiration" - объекты с временем первого отсчёта
+ * "start", шагом "interval" в секундах (по умолчанию 1) и массивом значений "values". null или
+ * неположительное значение означает отсутствие данных. Значения сразу сжимаются в SleepSignal.
  */
 class DataLoader {
 public:
 
+    /**
+     * @typedef DayCallback
+     * @brief Обработчик, получающий очередные разобранные сутки.
+     */
+    using DayCallback = std::function<void(DailySleepData &&)>;
+
+    /**
+     * @typedef ProgressCallback
+     * @brief Обработчик, получающий количество разобранных байт файла и размер файла (0, если неизвестен).
+     */
+    using ProgressCallback = std::function<void(std::uint64_t, std::uint64_t)>;
+
     /**
      * @brief Загружает данные о сне за неделю из указанного JSON-файла.
      *
+     * Тонкая обёртка над streamFromJson(), требующая ровно 7 суток в файле.
+     *
      * @param filename Путь к JSON-файлу, содержащему данные о сне.
      * @return Структура с данными о сне за неделю.
      *
      * @throws std::runtime_error Если невозможно открыть файл или возникла ошибка в процессе парсинга JSON.
      */
-
     static WeeklySleepData loadFromJsonFile(const std::string &filename);
 
-private:
+    /**
+     * @brief Загружает все сутки из JSON-файла в порядке их следования в файле.
+     *
+     * Фазы всех ночей размещаются в одной арене, которой владеет результат.
+     *
+     * @param filename Путь к JSON-файлу с массивом суток или с одним объектом суток.
+     * @return Список данных о сне по суткам вместе с ареной.
+     *
+     * @throws std::runtime_error Если невозможно открыть файл или возникла ошибка в процессе парсинга JSON.
+     */
+    static SleepHistory loadHistoryFromJsonFile(const std::string &filename);
 
     /**
-     * @brief Парсит JSON-объект с данными сна за один день.
+     * @brief Загружает все сутки из JSON-файла, выделяя память под ночи и их фазы из указанного ресурса.
      *
-     * @param j JSON-объект с дневными данными о сне.
-     * @return DailySleepData - данные сна за один день.
+     * @param filename Путь к JSON-файлу с массивом суток или с одним объектом суток.
+     * @param resource Ресурс памяти; должен пережить результат.
+     * @return Список данных о сне по суткам.
      *
-     * @throws std::invalid_argument Если формат какой-либо из строк даты или времени некорректен.
+     * @throws std::runtime_error Если невозможно открыть файл или возникла ошибка в процессе парсинга JSON.
      */
-    static DailySleepData parseDailyData(const nlohmann::json &j);
+    static std::pmr::vector<DailySleepData> loadHistoryFromJsonFile(const std::string &filename,
+                                                                     std::pmr::memory_resource *resource);
+
+    /**
+     * @brief Загружает все сутки из JSON-файла в конец поколоночного хранилища.
+     *
+     * @param filename Путь к JSON-файлу с массивом суток или с одним объектом суток.
+     * @param store Хранилище, в которое добавляются ночи.
+     * @return Количество добавленных ночей.
+     *
+     * @throws std::runtime_error Если невозможно открыть файл или возникла ошибка в процессе парсинга JSON.
+     */
+    static std::size_t loadStoreFromJsonFile(const std::string &filename, SleepPhaseStore &store);
+
+    /**
+     * @brief Находит все JSON-файлы каталога, включая подкаталоги.
+     *
+     * @param directory Путь к каталогу.
+     * @return Пути к файлам, упорядоченные лексикографически.
+     *
+     * @throws std::runtime_error Если каталог невозможно прочитать.
+     */
+    static std::vector<std::string> findJsonFiles(const std::string &directory);
+
+    /**
+     * @brief Параллельно загружает все JSON-файлы каталога (включая подкаталоги) в одну историю.
+     *
+     * Файлы разбираются задачами пула, каждый - в собственную арену, которой владеет результат.
+     * Результат не зависит от порядка выполнения задач:
+     * файлы упорядочиваются по пути, и из ночей с одной датой остаётся ночь из последнего файла
+     * (а внутри файла - последняя запись). Ночь, пересекающаяся по времени с предыдущей ночью
+     * из другого файла, разрешается тем же правилом. Ошибка в отдельном файле не прерывает загрузку,
+     * а записывается в его статистику.
+     *
+     * @param directory Путь к каталогу.
+     * @param pool Пул потоков для разбора файлов.
+     * @return Упорядоченная по дате история и статистика по файлам.
+     *
+     * @throws std::runtime_error Если каталог невозможно прочитать.
+     */
+    static DirectoryLoadResult loadDirectory(const std::string &directory, WorkStealingPool &pool);
+
+    /**
+     * @brief Параллельно загружает каталог, используя пул по числу аппаратных потоков.
+     *
+     * @see loadDirectory(const std::string &, WorkStealingPool &)
+     */
+    static DirectoryLoadResult loadDirectory(const std::string &directory);
+
+    /**
+     * @brief Потоково разбирает JSON-файл и передаёт сутки обработчику по одним.
+     *
+     * @param filename Путь к JSON-файлу с массивом суток или с одним объектом суток.
+     * @param onDay Обработчик, вызываемый для каждых разобранных суток.
+     * @param onProgress Необязательный обработчик хода разбора; вызывается после каждых 256 суток
+     * и по окончании файла.
+     * @param resource Ресурс памяти для фаз; должен пережить сутки, которые обработчик забирает себе.
+     * @return Количество переданных обработчику суток.
+     *
+     * @throws std::runtime_error Если невозможно открыть файл или возникла ошибка в процессе парсинга JSON.
+     */
+    static std::size_t streamFromJsonFile(const std::string &filename, const DayCallback &onDay,
+                                          const ProgressCallback &onProgress = {},
+                                          std::pmr::memory_resource *resource = std::pmr::get_default_resource());
+
+    /**
+     * @brief Потоково разбирает JSON из входного потока и передаёт сутки обработчику по одним.
+     *
+     * Если обработчик не забирает фазы суток, их буфер переиспользуется следующими сутками,
+     * и разбор не выделяет память на каждую ночь.
+     *
+     * @param input Поток с JSON-массивом суток или с одним объектом суток.
+     * @param onDay Обработчик, вызываемый для каждых разобранных суток.
+     * @param resource Ресурс памяти для фаз; должен пережить сутки, которые обработчик забирает себе.
+     * @return Количество переданных обработчику суток.
+     *
+     * @throws std::runtime_error Если JSON некорректен или какие-либо сутки не удалось разобрать.
+     */
+    static std::size_t streamFromJson(std::istream &input, const DayCallback &onDay,
+                                      std::pmr::memory_resource *resource = std::pmr::get_default_resource());
+
+    /**
+     * @brief Разбирает одну запись с сутками, например строку файла NDJSON.
+     *
+     * @param record JSON-объект суток.
+     * @return Разобранные сутки.
+     *
+     * @throws std::runtime_error Если JSON некорректен или запись содержит не ровно одни сутки.
+     */
+    static DailySleepData parseDay(std::string_view record);
+
+    /**
+     * @brief Делит JSON-документ на записи суток, не разбирая их.
+     *
+     * Записи - элементы массива верхнего уровня или сам документ, если это один объект. Проверяется
+     * только вложенность скобок и строк, поэтому деление на порядок быстрее разбора; содержимое
+     * каждой записи можно затем разобрать через parseDay().
+     *
+     * @param json Документ в формате файлов с сутками.
+     * @return Тексты записей в порядке следования; указывают внутрь json.
+     *
+     * @throws std::runtime_error Если документ не массив и не объект или скобки не сбалансированы.
+     */
+    static std::vector<std::string_view> splitRecords(std::string_view json);
+
+    /**
+     * @brief Выбирает ночи нескольких файлов так же, как loadDirectory().
+     *
+     * Из ночей с одной датой и из ночей, пересекающихся по времени с предыдущей ночью из другого
+     * файла, остаётся ночь из более позднего файла, а внутри файла - более поздняя запись.
+     *
+     * @param nights Ночи всех файлов.
+     * @param dropped Увеличивается на количество отброшенных ночей.
+     * @return Номера оставленных ночей в nights, упорядоченные по дате.
+     */
+    static std::vector<std::size_t> mergeNights(std::span<const NightOrigin> nights, std::size_t &dropped);
+
+private:
+
+    /**
+     * @brief SAX-обработчик, собирающий DailySleepData напрямую из событий парсера.
+     */
+    class DaySaxHandler;
 
     /**
      * @brief Конвертирует строку с фазой сна в соответствующий enum.
@@ -99,25 +347,24 @@ private:
     static SleepPhaseType fromString(const std::string &phaseStr);
 
     /**
-     * @brief Парсит дату и время из строки по заданному формату.
+     * @brief Парсит локальные дату и время из строки формата "YYYY-MM-DD HH:MM[:SS]".
      *
      * @param dateTimeStr Строка с датой и временем.
-     * @param format Формат парсинга (например, "%Y-%m-%d %H:%M:%S").
      * @return DateTime Преобразованные в DateTime дату и время.
      *
      * @throws std::invalid_argument Если формат строки некорректный или парсинг даты не удался.
      */
-    static DateTime parseDateTime(const std::string &dateTimeStr, const std::string &format = "%Y-%m-%d %H:%M");
+    static DateTime parseDateTime(std::string_view dateTimeStr);
 
     /**
-     * @brief Парсит JSON-массив с данными за неделю.
+     * @brief Парсит локальную дату из строки формата "YYYY-MM-DD".
      *
-     * @param weeklyJson JSON-массив из 7 элементов.
-     * @return WeeklySleepData - данные сна за неделю.
+     * @param dateStr Строка с датой.
+     * @return DateTime Полночь указанной даты.
      *
-     * @throws std::runtime_error Если формат JSON-массива некорректный или число элементов не равно семи, если произошла ошибка парсинга.
+     * @throws std::invalid_argument Если формат строки некорректный или парсинг даты не удался.
      */
-    static WeeklySleepData parseWeeklyData(const nlohmann::json &weeklyJson);
+    static DateTime parseDate(std::string_view dateStr);
 };
 
 #endif //SLEEP_VISUALIZER_DATALOADER_H
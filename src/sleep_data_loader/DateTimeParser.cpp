@@ -0,0 +1,217 @@
+#include "DateTimeParser.h"
+#include <array>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+
+namespace {
+
+constexpr std::int64_t kSecondsPerDay = 86400;
+// размер блока таблицы переходов; за 32 дня часовой пояс меняет смещение не более одного раза
+constexpr std::int64_t kBlockSeconds = 32 * kSecondsPerDay;
+
+std::int64_t floorDiv(std::int64_t a, std::int64_t b) {
+    const std::int64_t q = a / b;
+    return (a % b != 0 && (a < 0) != (b < 0)) ? q - 1 : q;
+}
+
+/**
+ * Запрашивает смещение у системной базы часовых поясов. Медленно, поэтому при разборе вызывается только
+ * при заполнении таблицы переходов.
+ */
+std::int32_t systemUtcOffset(std::int64_t utcSeconds) {
+    const auto t = static_cast<std::time_t>(utcSeconds);
+    std::tm local{};
+#if defined(_WIN32)
+    if (localtime_s(&local, &t) != 0) return 0;
+#else
+    if (localtime_r(&t, &local) == nullptr) return 0;
+#endif
+    const std::int64_t localSeconds =
+            DateTimeParser::daysFromCivil(local.tm_year + 1900, local.tm_mon + 1, local.tm_mday) * kSecondsPerDay +
+            local.tm_hour * 3600 + local.tm_min * 60 + local.tm_sec;
+    return static_cast<std::int32_t>(localSeconds - utcSeconds);
+}
+
+/**
+ * Таблица интервалов постоянного смещения часового пояса.
+ *
+ * Интервалы хранятся блоками по 32 дня в кэше прямого отображения фиксированного размера, поэтому таблица
+ * не выделяет память. Блок заполняется при первом обращении; точный момент перехода ищется бинарным поиском.
+ * Вытесненный блок при следующем обращении просто заполняется заново.
+ */
+class LocalOffsetTable {
+public:
+    std::int32_t offsetAt(std::int64_t utc) {
+        if (utc >= last_.from && utc < last_.until) return last_.offset;
+
+        const std::int64_t index = floorDiv(utc, kBlockSeconds);
+        Block &block = blocks_[static_cast<std::uint64_t>(index) % kBlockSlots];
+        if (block.index != index) loadBlock(block, index);
+        // в блоке больше переходов, чем помещается: смещение запрашивается напрямую
+        if (block.count == 0) return systemUtcOffset(utc);
+
+        std::int64_t from = index * kBlockSeconds;
+        std::size_t i = 0;
+        while (utc >= block.until[i]) {
+            from = block.until[i++];
+        }
+        last_ = {from, block.until[i], block.offsets[i]};
+        return last_.offset;
+    }
+
+private:
+    struct Span {
+        std::int64_t from;   ///< Начало интервала (UTC, включительно)
+        std::int64_t until;  ///< Конец интервала (UTC, не включительно)
+        std::int32_t offset; ///< Смещение от UTC, с
+    };
+
+    /// Интервалов в блоке; обычно их один или два
+    static constexpr std::size_t kMaxSpans = 4;
+    /// Блоков в кэше: около 90 лет подряд, 64 КБ на поток
+    static constexpr std::size_t kBlockSlots = 1024;
+
+    /// Интервалы одного блока: i-й заканчивается в until[i], следующий начинается там же
+    struct Block {
+        std::int64_t index = INT64_MIN; ///< Номер блока; INT64_MIN - слот пуст
+        std::array<std::int64_t, kMaxSpans> until{};
+        std::array<std::int32_t, kMaxSpans> offsets{};
+        std::uint32_t count = 0;        ///< Количество интервалов; 0 - не поместились
+    };
+
+    static void loadBlock(Block &block, std::int64_t index) {
+        const std::int64_t blockStart = index * kBlockSeconds;
+        const std::int64_t blockEnd = blockStart + kBlockSeconds;
+
+        block.index = index;
+        block.count = 0;
+        std::uint32_t count = 0;
+        std::int32_t spanOffset = systemUtcOffset(blockStart);
+        for (std::int64_t t = blockStart + kSecondsPerDay; t <= blockEnd; t += kSecondsPerDay) {
+            const std::int32_t offset = systemUtcOffset(t);
+            if (offset == spanOffset) continue;
+
+            // первая секунда с новым смещением лежит в (t - сутки, t]
+            std::int64_t lo = t - kSecondsPerDay;
+            std::int64_t hi = t;
+            while (hi - lo > 1) {
+                const std::int64_t mid = lo + (hi - lo) / 2;
+                (systemUtcOffset(mid) == spanOffset ? lo : hi) = mid;
+            }
+            if (count + 1 == kMaxSpans) return;
+            block.until[count] = hi;
+            block.offsets[count++] = spanOffset;
+            spanOffset = systemUtcOffset(hi);
+        }
+        block.until[count] = blockEnd;
+        block.offsets[count++] = spanOffset;
+        block.count = count;
+    }
+
+    std::array<Block, kBlockSlots> blocks_{};
+    Span last_{0, 0, 0};
+};
+
+LocalOffsetTable &offsetTable() {
+    // своя таблица в каждом потоке: обращения к ней не требуют синхронизации
+    thread_local LocalOffsetTable table;
+    return table;
+}
+
+inline bool parseDigits(const char *p, int count, int &out) {
+    int value = 0;
+    for (int i = 0; i < count; ++i) {
+        const auto digit = static_cast<unsigned>(p[i] - '0');
+        if (digit > 9) return false;
+        value = value * 10 + static_cast<int>(digit);
+    }
+    out = value;
+    return true;
+}
+
+constexpr bool isLeapYear(int y) {
+    return y % 4 == 0 && (y % 100 != 0 || y % 400 == 0);
+}
+
+constexpr int daysInMonth(int y, int m) {
+    constexpr int days[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    return (m == 2 && isLeapYear(y)) ? 29 : days[m - 1];
+}
+
+/**
+ * Разбирает "YYYY-MM-DD" в начале строки и возвращает число дней от эпохи.
+ */
+DateTimeParseStatus parseDatePart(const char *p, std::int64_t &days) {
+    int y, m, d;
+    if (!parseDigits(p, 4, y) || p[4] != '-' || !parseDigits(p + 5, 2, m) || p[7] != '-' ||
+        !parseDigits(p + 8, 2, d)) {
+        return DateTimeParseStatus::InvalidFormat;
+    }
+    if (m < 1 || m > 12 || d < 1 || d > daysInMonth(y, m)) {
+        return DateTimeParseStatus::InvalidValue;
+    }
+    days = DateTimeParser::daysFromCivil(y, static_cast<unsigned>(m), static_cast<unsigned>(d));
+    return DateTimeParseStatus::Ok;
+}
+
+std::chrono::system_clock::time_point fromLocalSeconds(std::int64_t localSeconds) {
+    return std::chrono::system_clock::time_point(std::chrono::seconds(DateTimeParser::localToUtc(localSeconds)));
+}
+
+} // namespace
+
+DateTimeParseStatus DateTimeParser::parseDateTime(std::string_view str,
+                                                  std::chrono::system_clock::time_point &out) noexcept {
+    if (str.size() != 16 && str.size() != 19) return DateTimeParseStatus::InvalidFormat;
+
+    const char *p = str.data();
+    std::int64_t days;
+    const DateTimeParseStatus status = parseDatePart(p, days);
+    if (status != DateTimeParseStatus::Ok) return status;
+
+    int hours, minutes, seconds = 0;
+    if (p[10] != ' ' || !parseDigits(p + 11, 2, hours) || p[13] != ':' || !parseDigits(p + 14, 2, minutes)) {
+        return DateTimeParseStatus::InvalidFormat;
+    }
+    if (str.size() == 19 && (p[16] != ':' || !parseDigits(p + 17, 2, seconds))) {
+        return DateTimeParseStatus::InvalidFormat;
+    }
+    if (hours > 23 || minutes > 59 || seconds > 59) return DateTimeParseStatus::InvalidValue;
+
+    out = fromLocalSeconds(days * kSecondsPerDay + hours * 3600 + minutes * 60 + seconds);
+    return DateTimeParseStatus::Ok;
+}
+
+DateTimeParseStatus DateTimeParser::parseDate(std::string_view str,
+                                              std::chrono::system_clock::time_point &out) noexcept {
+    if (str.size() != 10) return DateTimeParseStatus::InvalidFormat;
+
+    std::int64_t days;
+    const DateTimeParseStatus status = parseDatePart(str.data(), days);
+    if (status != DateTimeParseStatus::Ok) return status;
+
+    out = fromLocalSeconds(days * kSecondsPerDay);
+    return DateTimeParseStatus::Ok;
+}
+
+std::int64_t DateTimeParser::localToUtc(std::int64_t localSeconds) noexcept {
+    // смещение зависит от момента UTC, который и ищем, поэтому уточняем его за две итерации
+    LocalOffsetTable &table = offsetTable();
+    const std::int64_t guess = localSeconds - table.offsetAt(localSeconds);
+    return localSeconds - table.offsetAt(guess);
+}
+
+std::int32_t DateTimeParser::utcOffsetAt(std::int64_t utcSeconds) noexcept {
+    return offsetTable().offsetAt(utcSeconds);
+}
+
+std::int32_t DateTimeParser::systemUtcOffsetAt(std::int64_t utcSeconds) noexcept {
+    return systemUtcOffset(utcSeconds);
+}
+
+std::int64_t DateTimeParser::localDayNumber(std::int64_t utcSeconds) noexcept {
+    const std::int64_t local = utcSeconds + utcOffsetAt(utcSeconds);
+    return local >= 0 ? local / 86400 : (local - 86399) / 86400;
+}
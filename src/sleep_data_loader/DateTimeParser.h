@@ -0,0 +1,105 @@
+/**
+ * @file DateTimeParser.h
+ * @brief Быстрый разбор даты и времени фиксированного формата без аллокаций и исключений.
+ */
+#ifndef SLEEP_VISUALIZER_DATETIMEPARSER_H
+#define SLEEP_VISUALIZER_DATETIMEPARSER_H
+
+#include <chrono>
+#include <cstdint>
+#include <string_view>
+
+/**
+ * @enum DateTimeParseStatus
+ * @brief Результат разбора строки с датой.
+ */
+enum class DateTimeParseStatus {
+    Ok,            ///< Строка успешно разобрана
+    InvalidFormat, ///< Строка не соответствует формату
+    InvalidValue   ///< Формат верный, но значение поля вне допустимого диапазона
+};
+
+/**
+ * @brief Разбор строк вида "YYYY-MM-DD HH:MM[:SS]" и "YYYY-MM-DD" в локальном часовом поясе.
+ *
+ * В отличие от std::get_time и std::mktime не обращается к локали, не выделяет память
+ * и не бросает исключений. Перевод в эпоху выполняется через число дней гражданского календаря,
+ * а смещение часового пояса берётся из таблицы переходов, кэшируемой в каждом потоке.
+ * Объекты этого класса создавать нельзя.
+ */
+class DateTimeParser {
+public:
+    DateTimeParser() = delete;
+
+    /**
+     * @brief Разбирает локальные дату и время в формате "YYYY-MM-DD HH:MM" или "YYYY-MM-DD HH:MM:SS".
+     *
+     * @param str Строка с датой и временем.
+     * @param out Результат; изменяется только при успешном разборе.
+     * @return Статус разбора.
+     */
+    static DateTimeParseStatus parseDateTime(std::string_view str,
+                                             std::chrono::system_clock::time_point &out) noexcept;
+
+    /**
+     * @brief Разбирает локальную дату в формате "YYYY-MM-DD" (время - полночь).
+     *
+     * @param str Строка с датой.
+     * @param out Результат; изменяется только при успешном разборе.
+     * @return Статус разбора.
+     */
+    static DateTimeParseStatus parseDate(std::string_view str,
+                                         std::chrono::system_clock::time_point &out) noexcept;
+
+    /**
+     * @brief Переводит локальное время в секундах от эпохи в UTC.
+     *
+     * @param localSeconds Локальное время как число секунд от 1970-01-01 00:00.
+     * @return Время UTC в секундах от эпохи.
+     */
+    static std::int64_t localToUtc(std::int64_t localSeconds) noexcept;
+
+    /**
+     * @brief Возвращает смещение локального часового пояса от UTC в заданный момент.
+     *
+     * @param utcSeconds Время UTC в секундах от эпохи.
+     * @return Смещение в секундах (положительное к востоку от Гринвича).
+     */
+    static std::int32_t utcOffsetAt(std::int64_t utcSeconds) noexcept;
+
+    /**
+     * @brief То же, что utcOffsetAt(), но запрашивает системную базу часовых поясов напрямую, минуя таблицу переходов.
+     *
+     * Медленнее при запросах подряд, зато не заполняет таблицу при редких запросах по большому интервалу времени.
+     */
+    static std::int32_t systemUtcOffsetAt(std::int64_t utcSeconds) noexcept;
+
+    /**
+     * @brief Возвращает номер локального календарного дня, в который попадает момент времени.
+     *
+     * @param utcSeconds Время UTC в секундах от эпохи.
+     * @return Число дней от 1970-01-01 (в шкале daysFromCivil).
+     */
+    static std::int64_t localDayNumber(std::int64_t utcSeconds) noexcept;
+
+    /**
+     * @brief Число дней от 1970-01-01 до заданной даты пролептического григорианского календаря.
+     *
+     * Алгоритм days_from_civil Говарда Хиннанта.
+     *
+     * @param y Год.
+     * @param m Месяц (1-12).
+     * @param d День месяца (1-31).
+     * @return Число дней от эпохи (отрицательное для дат раньше эпохи).
+     */
+    static constexpr std::int64_t daysFromCivil(std::int64_t y, unsigned m, unsigned d) noexcept {
+        y -= m <= 2;
+        const std::int64_t era = (y >= 0 ? y : y - 399) / 400;
+        const auto yoe = static_cast<unsigned>(y - era * 400);
+        const unsigned doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+        const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+        return era * 146097 + static_cast<std::int64_t>(doe) - 719468;
+    }
+};
+
+#endif //SLEEP_VISUALIZER_DATETIMEPARSER_H
@@ -0,0 +1,160 @@
+#include "SleepFeedTail.h"
+#include "Trace.h"
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+#if defined(__linux__)
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+/// Размер блока чтения дописанных байт
+constexpr std::size_t kReadChunk = 64 * 1024;
+
+/// Интервал проверки размера файла там, где нет inotify
+constexpr auto kPollInterval = std::chrono::milliseconds(200);
+
+/// Пауза перед повторной попыткой, если поток отрисовки не успевает забирать сутки
+constexpr auto kQueueFullRetry = std::chrono::milliseconds(1);
+
+} // namespace
+
+SleepFeedTail::SleepFeedTail(std::string path, WakeCallback onNewData, std::size_t queueCapacity)
+        : path_(std::move(path)), onNewData_(std::move(onNewData)), queue_(queueCapacity) {
+#if defined(__linux__)
+    // следим за каталогом, а не за файлом: так замечаются и создание файла, и его замена
+    std::filesystem::path directory = std::filesystem::path(path_).parent_path();
+    if (directory.empty()) directory = ".";
+    notifyFd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (notifyFd_ < 0 ||
+        inotify_add_watch(notifyFd_, directory.c_str(),
+                          IN_MODIFY | IN_CLOSE_WRITE | IN_CREATE | IN_MOVED_TO | IN_DELETE) < 0 ||
+        pipe2(stopPipe_, O_CLOEXEC) != 0) {
+        if (notifyFd_ >= 0) close(notifyFd_);
+        throw std::runtime_error("unable to watch file: " + path_);
+    }
+#endif
+    thread_ = std::thread([this] { run(); });
+}
+
+SleepFeedTail::~SleepFeedTail() {
+    stop_.store(true, std::memory_order_release);
+#if defined(__linux__)
+    const char wake = 0;
+    [[maybe_unused]] const auto written = write(stopPipe_[1], &wake, 1);
+#endif
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+#if defined(__linux__)
+    close(notifyFd_);
+    close(stopPipe_[0]);
+    close(stopPipe_[1]);
+#endif
+}
+
+void SleepFeedTail::run() {
+    SLEEP_TRACE_THREAD_NAME("SleepFeedTail");
+    readAppended();
+
+#if defined(__linux__)
+    const std::string name = std::filesystem::path(path_).filename().string();
+    alignas(inotify_event) char events[4096];
+    pollfd fds[2] = {{notifyFd_, POLLIN, 0},
+                     {stopPipe_[0], POLLIN, 0}};
+    while (!stop_.load(std::memory_order_acquire)) {
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            return;
+        }
+        if (fds[1].revents != 0) return;
+
+        bool changed = false, recreated = false;
+        ssize_t length;
+        while ((length = read(notifyFd_, events, sizeof(events))) > 0) {
+            for (const char *p = events; p < events + length;) {
+                const auto *event = reinterpret_cast<const inotify_event *>(p);
+                if (event->len > 0 && name == event->name) {
+                    changed = true;
+                    recreated |= (event->mask & (IN_CREATE | IN_MOVED_TO | IN_DELETE)) != 0;
+                }
+                p += sizeof(inotify_event) + event->len;
+            }
+        }
+        if (recreated) restartFromBeginning();
+        if (changed) readAppended();
+    }
+#else
+    while (!stop_.load(std::memory_order_acquire)) {
+        std::this_thread::sleep_for(kPollInterval);
+        readAppended();
+    }
+#endif
+}
+
+void SleepFeedTail::restartFromBeginning() {
+    offset_ = 0;
+    pending_.clear();
+}
+
+void SleepFeedTail::readAppended() {
+    SLEEP_TRACE_SCOPE("SleepFeedTail::readAppended");
+    std::error_code ec;
+    const std::uintmax_t size = std::filesystem::file_size(path_, ec);
+    if (ec) return; // файл ещё не создан или удалён
+    if (size < offset_) restartFromBeginning();
+    if (size == offset_) return;
+
+    std::ifstream ifs(path_, std::ios::binary);
+    if (!ifs.is_open()) return;
+    ifs.seekg(static_cast<std::streamoff>(offset_));
+
+    const auto chunk = std::make_unique_for_overwrite<char[]>(kReadChunk);
+    while (ifs.read(chunk.get(), kReadChunk) || ifs.gcount() > 0) {
+        const auto count = static_cast<std::size_t>(ifs.gcount());
+        offset_ += count;
+        bytesRead_.fetch_add(count, std::memory_order_relaxed);
+        pending_.append(chunk.get(), count);
+
+        // разбираются только завершённые строки, хвост ждёт следующей записи
+        std::size_t lineStart = 0;
+        for (std::size_t newline; (newline = pending_.find('\n', lineStart)) != std::string::npos;) {
+            parseLine(std::string_view(pending_).substr(lineStart, newline - lineStart));
+            lineStart = newline + 1;
+        }
+        pending_.erase(0, lineStart);
+    }
+
+    if (published_) {
+        published_ = false;
+        if (onNewData_) onNewData_();
+    }
+}
+
+void SleepFeedTail::parseLine(std::string_view line) {
+    if (line.find_first_not_of(" \t\r") == std::string_view::npos) return;
+    try {
+        publish(DataLoader::parseDay(line));
+    } catch (const std::exception &) {
+        skipped_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void SleepFeedTail::publish(DailySleepData &&day) {
+    while (!queue_.tryPush(std::move(day))) {
+        if (stop_.load(std::memory_order_acquire)) return;
+        // очередь заполнена: будим поток отрисовки, чтобы он её разобрал
+        if (onNewData_) onNewData_();
+        std::this_thread::sleep_for(kQueueFullRetry);
+    }
+    published_ = true;
+}
@@ -0,0 +1,98 @@
+/**
+ * @file SleepFeedTail.h
+ * @brief Слежение за дописываемым NDJSON-файлом с данными о сне.
+ */
+#ifndef SLEEP_VISUALIZER_SLEEPFEEDTAIL_H
+#define SLEEP_VISUALIZER_SLEEPFEEDTAIL_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <thread>
+#include "DataLoader.h"
+#include "SpscQueue.h"
+
+/**
+ * @class SleepFeedTail
+ * @brief Фоновый поток, читающий новые строки NDJSON-файла, в который устройство дописывает сутки.
+ *
+ * Каждая строка - объект суток в формате DataLoader. Во время ночи устройство может дописывать
+ * промежуточные записи с уже завершившимися фазами; каждая следующая запись с той же датой заменяет
+ * предыдущую. Поток ждёт изменений файла через inotify (на других платформах - периодически проверяет
+ * размер), читает только байты после уже прочитанных, разбирает завершённые строки через
+ * DataLoader::parseDay() и передаёт сутки потоку отрисовки через очередь без блокировок.
+ * Если файл стал короче прочитанного или был создан заново, он читается с начала.
+ * Некорректные строки пропускаются и учитываются в skippedRecords().
+ */
+class SleepFeedTail {
+public:
+    /**
+     * @brief Обработчик, вызываемый в фоновом потоке после публикации новых суток.
+     */
+    using WakeCallback = std::function<void()>;
+
+    /**
+     * @brief Читает уже записанные строки файла и запускает слежение за ним.
+     *
+     * @param path Путь к NDJSON-файлу; файл может появиться позже.
+     * @param onNewData Обработчик, будящий поток отрисовки, например FramePacer::requestFrame().
+     * @param queueCapacity Вместимость очереди суток.
+     *
+     * @throws std::runtime_error Если не удалось запустить слежение.
+     */
+    explicit SleepFeedTail(std::string path, WakeCallback onNewData = {}, std::size_t queueCapacity = 1024);
+
+    /**
+     * @brief Останавливает фоновый поток.
+     */
+    ~SleepFeedTail();
+
+    SleepFeedTail(const SleepFeedTail &) = delete;
+
+    SleepFeedTail &operator=(const SleepFeedTail &) = delete;
+
+    /**
+     * @brief Забирает очередные разобранные сутки. Вызывается только одним потоком-потребителем.
+     */
+    std::optional<DailySleepData> tryPop() { return queue_.tryPop(); }
+
+    /// Количество пропущенных некорректных строк.
+    [[nodiscard]] std::size_t skippedRecords() const { return skipped_.load(std::memory_order_relaxed); }
+
+    /// Количество прочитанных из файла байт с момента запуска.
+    [[nodiscard]] std::uint64_t bytesRead() const { return bytesRead_.load(std::memory_order_relaxed); }
+
+private:
+    void run();
+
+    /**
+     * @brief Читает байты, дописанные после последнего чтения, и публикует завершённые строки.
+     */
+    void readAppended();
+
+    void parseLine(std::string_view line);
+
+    void publish(DailySleepData &&day);
+
+    void restartFromBeginning();
+
+    std::string path_;
+    WakeCallback onNewData_;
+    SpscQueue<DailySleepData> queue_;
+    std::atomic<bool> stop_{false};
+    std::atomic<std::size_t> skipped_{0};
+    std::atomic<std::uint64_t> bytesRead_{0};
+
+    // состояние фонового потока
+    std::uint64_t offset_ = 0;  ///< Сколько байт файла уже прочитано
+    std::string pending_;       ///< Начало строки, конец которой ещё не записан
+    bool published_ = false;    ///< Были ли опубликованы сутки после последнего вызова onNewData_
+
+    int notifyFd_ = -1;         ///< Дескриптор inotify
+    int stopPipe_[2] = {-1, -1}; ///< Канал, будящий поток при остановке
+    std::thread thread_;
+};
+
+#endif //SLEEP_VISUALIZER_SLEEPFEEDTAIL_H
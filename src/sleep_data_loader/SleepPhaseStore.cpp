@@ -0,0 +1,182 @@
+#include "SleepPhaseStore.h"
+#include <limits>
+#include <stdexcept>
+
+namespace {
+
+std::int64_t toSeconds(const DateTime &tp) {
+    return std::chrono::duration_cast<std::chrono::seconds>(tp.time_since_epoch()).count();
+}
+
+DateTime fromSeconds(std::int64_t seconds) {
+    return DateTime(std::chrono::seconds(seconds));
+}
+
+std::int32_t toOffset(std::int64_t seconds) {
+    if (seconds < std::numeric_limits<std::int32_t>::min() || seconds > std::numeric_limits<std::int32_t>::max()) {
+        throw std::invalid_argument("sleep phase is too far from bedtime");
+    }
+    return static_cast<std::int32_t>(seconds);
+}
+
+} // namespace
+
+SleepSignalView SleepSignalColumns::night(std::size_t i, DateTime bedtime) const {
+    if (empty()) return {};
+    const std::size_t first = byteOffsets[i];
+    return {bedtime + std::chrono::seconds(startOffsets[i]),
+            intervals[i],
+            sampleCounts[i],
+            bytes.subspan(first, byteOffsets[i + 1] - first)};
+}
+
+SleepSignalColumns SleepSignalColumns::slice(std::size_t first, std::size_t count) const {
+    if (empty()) return {};
+    return {startOffsets.subspan(first, count),
+            intervals.subspan(first, count),
+            sampleCounts.subspan(first, count),
+            byteOffsets.subspan(first, count + 1),
+            bytes};
+}
+
+SleepNightView SleepPhaseColumns::night(std::size_t i) const {
+    const std::size_t first = nightOffsets[i];
+    const std::size_t count = nightOffsets[i + 1] - first;
+    const DateTime bedtime = fromSeconds(bedtimes[i]);
+    return {fromSeconds(dates[i]),
+            bedtime,
+            fromSeconds(wakeTimes[i]),
+            types.subspan(first, count),
+            startOffsets.subspan(first, count),
+            durations.subspan(first, count),
+            {signals[0].night(i, bedtime), signals[1].night(i, bedtime)}};
+}
+
+SleepPhaseColumns SleepPhaseColumns::slice(std::size_t first, std::size_t count) const {
+    return {dates.subspan(first, count),
+            bedtimes.subspan(first, count),
+            wakeTimes.subspan(first, count),
+            nightOffsets.subspan(first, count + 1),
+            types,
+            startOffsets,
+            durations,
+            {signals[0].slice(first, count), signals[1].slice(first, count)}};
+}
+
+void SleepPhaseStore::reserve(std::size_t nights, std::size_t phases) {
+    dates_.reserve(nights);
+    bedtimes_.reserve(nights);
+    wakeTimes_.reserve(nights);
+    nightOffsets_.reserve(nights + 1);
+    types_.reserve(phases);
+    startOffsets_.reserve(phases);
+    durations_.reserve(phases);
+}
+
+std::size_t SleepPhaseStore::append(const DailySleepData &day) {
+    if (types_.size() + day.phases.size() > std::numeric_limits<std::uint32_t>::max()) {
+        throw std::length_error("too many sleep phases in store");
+    }
+
+    // смещения проверяются до записи, чтобы отклонённая ночь не оставила колонки разной длины
+    const std::int64_t bedtime = toSeconds(day.bedtime);
+    std::array<std::int32_t, kSleepSignalCount> signalOffsets{};
+    for (std::size_t s = 0; s < kSleepSignalCount; ++s) {
+        if (!day.signals[s].empty()) {
+            signalOffsets[s] = toOffset(toSeconds(day.signals[s].view().start) - bedtime);
+        }
+    }
+    for (const auto &phase: day.phases) {
+        const std::int64_t start = toSeconds(phase.start);
+        toOffset(start - bedtime);
+        toOffset(toSeconds(phase.end) - start);
+    }
+
+    const std::size_t nights = dates_.size();
+    const std::size_t phases = types_.size();
+    std::array<std::size_t, kSleepSignalCount> signalBytes{};
+    for (std::size_t s = 0; s < kSleepSignalCount; ++s) {
+        signalBytes[s] = signals_[s].bytes.size();
+    }
+    try {
+        for (const auto &phase: day.phases) {
+            const std::int64_t start = toSeconds(phase.start);
+            types_.push_back(static_cast<std::uint8_t>(phase.type));
+            startOffsets_.push_back(static_cast<std::int32_t>(start - bedtime));
+            durations_.push_back(static_cast<std::int32_t>(toSeconds(phase.end) - start));
+        }
+
+        dates_.push_back(toSeconds(day.date));
+        bedtimes_.push_back(bedtime);
+        wakeTimes_.push_back(toSeconds(day.wakeTime));
+        nightOffsets_.push_back(static_cast<std::uint32_t>(types_.size()));
+        for (std::size_t s = 0; s < kSleepSignalCount; ++s) {
+            const SleepSignalView signal = day.signals[s].view();
+            SignalStore &store = signals_[s];
+            store.startOffsets.push_back(signalOffsets[s]);
+            store.intervals.push_back(signal.interval);
+            store.sampleCounts.push_back(signal.count);
+            store.bytes.insert(store.bytes.end(), signal.encoded.begin(), signal.encoded.end());
+            store.byteOffsets.push_back(store.bytes.size());
+        }
+    } catch (...) {
+        // нехватка памяти посреди записи: колонки возвращаются к прежней длине
+        types_.resize(phases);
+        startOffsets_.resize(phases);
+        durations_.resize(phases);
+        dates_.resize(nights);
+        bedtimes_.resize(nights);
+        wakeTimes_.resize(nights);
+        nightOffsets_.resize(nights + 1);
+        for (std::size_t s = 0; s < kSleepSignalCount; ++s) {
+            SignalStore &store = signals_[s];
+            store.startOffsets.resize(nights);
+            store.intervals.resize(nights);
+            store.sampleCounts.resize(nights);
+            store.byteOffsets.resize(nights + 1);
+            store.bytes.resize(signalBytes[s]);
+        }
+        throw;
+    }
+    return dates_.size() - 1;
+}
+
+void SleepPhaseStore::clear() {
+    dates_.clear();
+    bedtimes_.clear();
+    wakeTimes_.clear();
+    nightOffsets_.assign(1, 0);
+    types_.clear();
+    startOffsets_.clear();
+    durations_.clear();
+    for (auto &store: signals_) {
+        store.startOffsets.clear();
+        store.intervals.clear();
+        store.sampleCounts.clear();
+        store.byteOffsets.assign(1, 0);
+        store.bytes.clear();
+    }
+}
+
+SleepPhaseColumns SleepPhaseStore::columns() const {
+    SleepPhaseColumns columns{dates_, bedtimes_, wakeTimes_, nightOffsets_, types_, startOffsets_, durations_};
+    for (std::size_t s = 0; s < kSleepSignalCount; ++s) {
+        const SignalStore &store = signals_[s];
+        columns.signals[s] = {store.startOffsets, store.intervals, store.sampleCounts, store.byteOffsets, store.bytes};
+    }
+    return columns;
+}
+
+DailySleepData SleepPhaseStore::toDailySleepData(std::size_t i) const {
+    const SleepNightView view = night(i);
+
+    DailySleepData result;
+    result.date = view.date;
+    result.bedtime = view.bedtime;
+    result.wakeTime = view.wakeTime;
+    result.phases.assign(view.begin(), view.end());
+    for (std::size_t s = 0; s < kSleepSignalCount; ++s) {
+        result.signals[s].assign(view.signals[s]);
+    }
+    return result;
+}
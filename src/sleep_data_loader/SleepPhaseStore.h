@@ -0,0 +1,227 @@
+/**
+ * @file SleepPhaseStore.h
+ * @brief Поколоночное (struct-of-arrays) хранилище фаз сна за много ночей.
+ */
+#ifndef SLEEP_VISUALIZER_SLEEPPHASESTORE_H
+#define SLEEP_VISUALIZER_SLEEPPHASESTORE_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <span>
+#include <vector>
+#include "DataLoader.h"
+#include "SleepSignal.h"
+
+/**
+ * @struct SleepNightView
+ * @brief Легковесное представление одной ночи поверх колонок хранилища.
+ *
+ * Не владеет данными. При обходе возвращает фазы как SleepPhase, восстанавливая время начала
+ * и окончания из смещений относительно времени отхода ко сну.
+ */
+struct SleepNightView {
+    DateTime date;                               ///< Дата, соответствующая данным о сне
+    DateTime bedtime;                            ///< Время отхода ко сну
+    DateTime wakeTime;                           ///< Время пробуждения
+    std::span<const std::uint8_t> types;         ///< Типы фаз (значения SleepPhaseType)
+    std::span<const std::int32_t> startOffsets;  ///< Начало фаз относительно bedtime, с
+    std::span<const std::int32_t> durations;     ///< Длительности фаз, с
+    std::array<SleepSignalView, kSleepSignalCount> signals{}; ///< Пульс и дыхание; индекс - SleepSignalType
+
+    /**
+     * @brief Итератор по фазам ночи, возвращающий SleepPhase по значению.
+     */
+    class Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = SleepPhase;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = SleepPhase;
+
+        Iterator() = default;
+
+        Iterator(const SleepNightView *view, std::size_t index) : view_(view), index_(index) {}
+
+        SleepPhase operator*() const { return (*view_)[index_]; }
+
+        Iterator &operator++() {
+            ++index_;
+            return *this;
+        }
+
+        Iterator operator++(int) {
+            Iterator copy = *this;
+            ++index_;
+            return copy;
+        }
+
+        bool operator==(const Iterator &other) const { return index_ == other.index_; }
+
+    private:
+        const SleepNightView *view_ = nullptr;
+        std::size_t index_ = 0;
+    };
+
+    [[nodiscard]] std::size_t size() const { return types.size(); }
+
+    [[nodiscard]] bool empty() const { return types.empty(); }
+
+    /**
+     * @brief Восстанавливает фазу с номером @p i.
+     */
+    SleepPhase operator[](std::size_t i) const {
+        const DateTime start = bedtime + std::chrono::seconds(startOffsets[i]);
+        return {static_cast<SleepPhaseType>(types[i]), start, start + std::chrono::seconds(durations[i])};
+    }
+
+    [[nodiscard]] Iterator begin() const { return {this, 0}; }
+
+    [[nodiscard]] Iterator end() const { return {this, size()}; }
+
+    [[nodiscard]] const SleepSignalView &signal(SleepSignalType type) const {
+        return signals[static_cast<std::size_t>(type)];
+    }
+};
+
+/**
+ * @struct SleepSignalColumns
+ * @brief Невладеющие колонки одного вида рядов за много ночей.
+ *
+ * Сжатые ряды всех ночей лежат подряд; ряд ночи i занимает байты [byteOffsets[i], byteOffsets[i + 1]).
+ * У ночи без ряда количество отсчётов равно нулю. Если колонки пусты, рядов нет ни у одной ночи.
+ */
+struct SleepSignalColumns {
+    std::span<const std::int32_t> startOffsets;  ///< Время первого отсчёта относительно bedtime своей ночи, с
+    std::span<const std::int32_t> intervals;     ///< Шаг между отсчётами, с
+    std::span<const std::uint32_t> sampleCounts; ///< Количество отсчётов
+    std::span<const std::uint64_t> byteOffsets;  ///< Начало ряда каждой ночи в bytes, nightCount() + 1 элементов
+    std::span<const std::uint8_t> bytes;         ///< Сжатые ряды (формат SleepSignalView)
+
+    [[nodiscard]] bool empty() const { return sampleCounts.empty(); }
+
+    /**
+     * @brief Возвращает ряд ночи с номером @p i; пустой, если колонки пусты.
+     *
+     * @param bedtime Время отхода ко сну этой ночи, от которого отсчитывается начало ряда.
+     */
+    [[nodiscard]] SleepSignalView night(std::size_t i, DateTime bedtime) const;
+
+    /**
+     * @brief Возвращает колонки для ночей [first, first + count); bytes не обрезается.
+     */
+    [[nodiscard]] SleepSignalColumns slice(std::size_t first, std::size_t count) const;
+};
+
+/**
+ * @struct SleepPhaseColumns
+ * @brief Невладеющий набор колонок с данными о сне за много ночей.
+ *
+ * Фазы всех ночей лежат подряд; фазы ночи i занимают диапазон [nightOffsets[i], nightOffsets[i + 1]).
+ * Моменты времени хранятся как число секунд от эпохи.
+ */
+struct SleepPhaseColumns {
+    std::span<const std::int64_t> dates;         ///< Даты ночей
+    std::span<const std::int64_t> bedtimes;      ///< Время отхода ко сну
+    std::span<const std::int64_t> wakeTimes;     ///< Время пробуждения
+    std::span<const std::uint32_t> nightOffsets; ///< Индекс первой фазы каждой ночи, nightCount() + 1 элементов
+    std::span<const std::uint8_t> types;         ///< Типы фаз (значения SleepPhaseType)
+    std::span<const std::int32_t> startOffsets;  ///< Начало фаз относительно bedtime своей ночи, с
+    std::span<const std::int32_t> durations;     ///< Длительности фаз, с
+    std::array<SleepSignalColumns, kSleepSignalCount> signals{}; ///< Пульс и дыхание; индекс - SleepSignalType
+
+    [[nodiscard]] std::size_t nightCount() const { return dates.size(); }
+
+    [[nodiscard]] std::size_t phaseCount() const { return types.size(); }
+
+    /**
+     * @brief Возвращает представление ночи с номером @p i.
+     */
+    [[nodiscard]] SleepNightView night(std::size_t i) const;
+
+    /**
+     * @brief Возвращает колонки для ночей [first, first + count).
+     *
+     * Колонки фаз не обрезаются: смещения в nightOffsets остаются абсолютными.
+     */
+    [[nodiscard]] SleepPhaseColumns slice(std::size_t first, std::size_t count) const;
+};
+
+/**
+ * @class SleepPhaseStore
+ * @brief Владеющее поколоночное хранилище ночей.
+ *
+ * Вместо отдельного std::vector<SleepPhase> на каждую ночь фазы всех ночей хранятся в трёх
+ * непрерывных колонках: тип (1 байт), начало и длительность (по 4 байта, секунды относительно
+ * времени отхода ко сну). Такой формат удобен для векторной агрегации и отображения в память.
+ * Ряды пульса и дыхания хранятся сжатыми, около байта на отсчёт: год ночей с отсчётами раз в секунду
+ * занимает около 11 МБ.
+ */
+class SleepPhaseStore {
+public:
+
+    /**
+     * @brief Резервирует память под заданное количество ночей и фаз.
+     */
+    void reserve(std::size_t nights, std::size_t phases);
+
+    /**
+     * @brief Добавляет ночь в конец хранилища.
+     *
+     * Если ночь отклонена или не хватило памяти, хранилище остаётся прежним.
+     *
+     * @param day Данные о сне за сутки.
+     * @return Номер добавленной ночи.
+     *
+     * @throws std::invalid_argument Если фаза или начало ряда отстоит от времени отхода ко сну больше чем на 68 лет.
+     */
+    std::size_t append(const DailySleepData &day);
+
+    /**
+     * @brief Удаляет все ночи.
+     */
+    void clear();
+
+    [[nodiscard]] std::size_t nightCount() const { return dates_.size(); }
+
+    [[nodiscard]] std::size_t phaseCount() const { return types_.size(); }
+
+    [[nodiscard]] bool empty() const { return dates_.empty(); }
+
+    /**
+     * @brief Возвращает представление ночи с номером @p i.
+     */
+    [[nodiscard]] SleepNightView night(std::size_t i) const { return columns().night(i); }
+
+    /**
+     * @brief Возвращает невладеющий набор всех колонок.
+     */
+    [[nodiscard]] SleepPhaseColumns columns() const;
+
+    /**
+     * @brief Восстанавливает ночь с номером @p i в виде DailySleepData.
+     */
+    [[nodiscard]] DailySleepData toDailySleepData(std::size_t i) const;
+
+private:
+    std::vector<std::int64_t> dates_;
+    std::vector<std::int64_t> bedtimes_;
+    std::vector<std::int64_t> wakeTimes_;
+    std::vector<std::uint32_t> nightOffsets_{0};
+    std::vector<std::uint8_t> types_;
+    std::vector<std::int32_t> startOffsets_;
+    std::vector<std::int32_t> durations_;
+
+    struct SignalStore {
+        std::vector<std::int32_t> startOffsets;
+        std::vector<std::int32_t> intervals;
+        std::vector<std::uint32_t> sampleCounts;
+        std::vector<std::uint64_t> byteOffsets{0};
+        std::vector<std::uint8_t> bytes;
+    };
+    std::array<SignalStore, kSleepSignalCount> signals_;
+};
+
+#endif //SLEEP_VISUALIZER_SLEEPPHASESTORE_H
@@ -0,0 +1,96 @@
+#include "SleepSignal.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+/// Байт, за которым следует отсчёт целиком
+constexpr std::uint8_t kEscape = 0x80;
+
+/**
+ * Распаковывает не больше out.size() отсчётов и возвращает их количество.
+ */
+std::size_t decodeInto(std::span<const std::uint8_t> encoded, std::span<SignalSample> out) {
+    const std::uint8_t *p = encoded.data();
+    const std::uint8_t *const end = p + encoded.size();
+    SignalSample value = 0;
+    std::size_t i = 0;
+    for (; i < out.size() && p < end; ++i) {
+        const std::uint8_t byte = *p++;
+        if (byte != kEscape) {
+            value = static_cast<SignalSample>(value + static_cast<std::int8_t>(byte));
+        } else {
+            if (end - p < 2) break;
+            value = static_cast<SignalSample>(static_cast<std::uint16_t>(p[0] | (p[1] << 8)));
+            p += 2;
+        }
+        out[i] = value;
+    }
+    return i;
+}
+
+/**
+ * Последний отсчёт сжатого ряда; нужен, чтобы дописывать ряд дальше.
+ */
+SignalSample lastSample(std::span<const std::uint8_t> encoded) {
+    SignalSample value = 0;
+    for (std::size_t i = 0; i < encoded.size(); ++i) {
+        if (encoded[i] != kEscape) {
+            value = static_cast<SignalSample>(value + static_cast<std::int8_t>(encoded[i]));
+        } else if (i + 2 < encoded.size()) {
+            value = static_cast<SignalSample>(static_cast<std::uint16_t>(encoded[i + 1] | (encoded[i + 2] << 8)));
+            i += 2;
+        }
+    }
+    return value;
+}
+
+} // namespace
+
+void SleepSignalView::decode(std::span<SignalSample> out) const {
+    const std::span<SignalSample> samples = out.first(count);
+    const std::size_t decoded = decodeInto(encoded, samples);
+    std::fill(samples.begin() + static_cast<std::ptrdiff_t>(decoded), samples.end(), kMissingSample);
+}
+
+void SleepSignalView::decode(std::vector<SignalSample> &out) const {
+    out.resize(count);
+    decode(std::span<SignalSample>(out));
+}
+
+void SleepSignal::reset(std::chrono::system_clock::time_point start, std::int32_t interval) {
+    start_ = start;
+    setInterval(interval);
+    count_ = 0;
+    last_ = 0;
+    bytes_.clear();
+}
+
+void SleepSignal::setInterval(std::int32_t interval) {
+    if (interval <= 0) {
+        throw std::invalid_argument("signal interval must be positive");
+    }
+    interval_ = interval;
+}
+
+void SleepSignal::append(SignalSample sample) {
+    const int delta = sample - last_;
+    if (delta > -128 && delta < 128) {
+        bytes_.push_back(static_cast<std::uint8_t>(static_cast<std::int8_t>(delta)));
+    } else {
+        const auto raw = static_cast<std::uint16_t>(sample);
+        bytes_.push_back(kEscape);
+        bytes_.push_back(static_cast<std::uint8_t>(raw & 0xFF));
+        bytes_.push_back(static_cast<std::uint8_t>(raw >> 8));
+    }
+    last_ = sample;
+    ++count_;
+}
+
+void SleepSignal::assign(const SleepSignalView &view) {
+    start_ = view.start;
+    interval_ = view.interval;
+    count_ = view.count;
+    bytes_.assign(view.encoded.begin(), view.encoded.end());
+    last_ = lastSample(bytes_);
+}
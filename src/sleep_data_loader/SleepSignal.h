@@ -0,0 +1,135 @@
+/**
+ * @file SleepSignal.h
+ * @brief Компактное хранение рядов пульса и дыхания с постоянным шагом.
+ */
+#ifndef SLEEP_VISUALIZER_SLEEPSIGNAL_H
+#define SLEEP_VISUALIZER_SLEEPSIGNAL_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <span>
+#include <vector>
+
+/**
+ * @enum SleepSignalType
+ * @brief Ряды, которые записывает устройство во время сна; значение - индекс ряда в массивах сигналов.
+ */
+enum class SleepSignalType : std::uint8_t {
+    HeartRate,   ///< Пульс, уд/мин
+    Respiration  ///< Частота дыхания, вдохов/мин
+};
+
+/// Количество видов рядов.
+inline constexpr std::size_t kSleepSignalCount = 2;
+
+/**
+ * @typedef SignalSample
+ * @brief Отсчёт ряда в десятых долях единицы измерения; kMissingSample - нет данных.
+ */
+using SignalSample = std::int16_t;
+
+/// Отсчёт, для которого устройство не передало значение.
+inline constexpr SignalSample kMissingSample = 0;
+
+/// Во сколько раз отсчёт больше значения в единицах измерения.
+inline constexpr double kSignalScale = 10.0;
+
+/**
+ * @struct SleepSignalView
+ * @brief Невладеющее представление сжатого ряда.
+ *
+ * Формат: по байту на отсчёт с разностью к предыдущему отсчёту (-127..127, первый отсчёт считается
+ * от нуля). Байт -128 означает, что отсчёт не поместился в разность и записан следом целиком,
+ * двумя байтами в порядке little-endian. Соседние отсчёты пульса и дыхания в десятых долях
+ * почти всегда отличаются меньше чем на 12.7, поэтому ряд занимает около байта на отсчёт.
+ */
+struct SleepSignalView {
+    std::chrono::system_clock::time_point start; ///< Время первого отсчёта
+    std::int32_t interval = 1;                   ///< Шаг между отсчётами, с
+    std::uint32_t count = 0;                     ///< Количество отсчётов
+    std::span<const std::uint8_t> encoded;       ///< Сжатые отсчёты
+
+    [[nodiscard]] std::size_t size() const { return count; }
+
+    [[nodiscard]] bool empty() const { return count == 0; }
+
+    /**
+     * @brief Распаковывает отсчёты.
+     *
+     * Если сжатые данные закончились раньше времени (повреждённый снимок), оставшиеся отсчёты
+     * считаются отсутствующими.
+     *
+     * @param out Буфер не меньше size() элементов.
+     */
+    void decode(std::span<SignalSample> out) const;
+
+    /**
+     * @brief Распаковывает отсчёты в вектор, переиспользуя его память.
+     */
+    void decode(std::vector<SignalSample> &out) const;
+};
+
+/**
+ * @class SleepSignal
+ * @brief Владеющий сжатый ряд, в который отсчёты дописываются по одному.
+ *
+ * Память выделяется из ресурса, переданного при создании, как и у фаз DailySleepData.
+ */
+class SleepSignal {
+public:
+    SleepSignal() = default;
+
+    explicit SleepSignal(std::pmr::memory_resource *resource) : bytes_(resource) {}
+
+    /**
+     * @brief Удаляет отсчёты и задаёт начало и шаг ряда; память сохраняется.
+     */
+    void reset(std::chrono::system_clock::time_point start, std::int32_t interval);
+
+    /**
+     * @brief Задаёт время первого отсчёта, не трогая отсчёты.
+     */
+    void setStart(std::chrono::system_clock::time_point start) { start_ = start; }
+
+    /**
+     * @brief Задаёт шаг ряда, не трогая отсчёты.
+     *
+     * @throws std::invalid_argument Если шаг не положителен.
+     */
+    void setInterval(std::int32_t interval);
+
+    /**
+     * @brief Дописывает отсчёт в конец ряда.
+     */
+    void append(SignalSample sample);
+
+    /**
+     * @brief Резервирует память под сжатые данные.
+     */
+    void reserveBytes(std::size_t bytes) { bytes_.reserve(bytes); }
+
+    /**
+     * @brief Заменяет ряд уже сжатыми отсчётами, например из поколоночного хранилища.
+     */
+    void assign(const SleepSignalView &view);
+
+    [[nodiscard]] std::size_t size() const { return count_; }
+
+    [[nodiscard]] bool empty() const { return count_ == 0; }
+
+    /// Размер сжатых данных, байт.
+    [[nodiscard]] std::size_t encodedSize() const { return bytes_.size(); }
+
+    [[nodiscard]] SleepSignalView view() const { return {start_, interval_, count_, bytes_}; }
+
+private:
+    std::chrono::system_clock::time_point start_;
+    std::int32_t interval_ = 1;
+    std::uint32_t count_ = 0;
+    SignalSample last_ = 0;
+    std::pmr::vector<std::uint8_t> bytes_;
+};
+
+#endif //SLEEP_VISUALIZER_SLEEPSIGNAL_H
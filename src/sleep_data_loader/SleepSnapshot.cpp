@@ -0,0 +1,546 @@
+#include "SleepSnapshot.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <climits>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#if defined(_WIN32)
+#include <cstdlib>
+#include <fcntl.h>
+#include <io.h>
+#include <process.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr char kMagic[8] = {'S', 'L', 'P', 'S', 'N', 'A', 'P', '\0'};
+constexpr std::uint32_t kVersion = 2;
+
+/// Колонки одного вида рядов в порядке их следования в файле
+enum SignalColumn : std::size_t {
+    SignalStartOffsets,
+    SignalIntervals,
+    SignalSampleCounts,
+    SignalByteOffsets,
+    SignalBytes,
+    SignalColumnCount
+};
+
+enum Section : std::size_t {
+    Dates,
+    Bedtimes,
+    WakeTimes,
+    NightOffsets,
+    Types,
+    StartOffsets,
+    Durations,
+    Signals,  ///< Начало колонок рядов: SignalColumnCount колонок на каждый вид ряда
+    SectionCount = Signals + kSleepSignalCount * SignalColumnCount
+};
+
+constexpr Section signalSection(std::size_t signal, SignalColumn column) {
+    return static_cast<Section>(Signals + signal * SignalColumnCount + column);
+}
+
+/**
+ * Заголовок файла снимка. Контрольная сумма заголовка считается по всем полям до headerChecksum.
+ */
+struct FileHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t headerSize;
+    std::uint64_t nightCount;
+    std::uint64_t phaseCount;
+    std::uint64_t signalByteCounts[kSleepSignalCount];
+    std::uint64_t sourceSize;
+    std::int64_t sourceMtime;
+    std::uint64_t sectionOffsets[SectionCount];
+    std::uint64_t fileSize;
+    std::uint64_t indexChecksum;
+    std::uint64_t phasesChecksum;
+    std::uint64_t signalsChecksum;
+    std::uint64_t headerChecksum;
+};
+
+constexpr std::size_t kElementSizes[Signals] = {
+        sizeof(std::int64_t), sizeof(std::int64_t), sizeof(std::int64_t), sizeof(std::uint32_t),
+        sizeof(std::uint8_t), sizeof(std::int32_t), sizeof(std::int32_t)
+};
+
+constexpr std::size_t kSignalElementSizes[SignalColumnCount] = {
+        sizeof(std::int32_t), sizeof(std::int32_t), sizeof(std::uint32_t), sizeof(std::uint64_t),
+        sizeof(std::uint8_t)
+};
+
+constexpr std::uint64_t align8(std::uint64_t value) {
+    return (value + 7) & ~std::uint64_t{7};
+}
+
+std::uint64_t sectionLength(Section section, const FileHeader &header) {
+    if (section >= Signals) {
+        const std::size_t signal = (section - Signals) / SignalColumnCount;
+        const auto column = static_cast<SignalColumn>((section - Signals) % SignalColumnCount);
+        const std::uint64_t count = column == SignalBytes ? header.signalByteCounts[signal]
+                                                          : column == SignalByteOffsets ? header.nightCount + 1
+                                                                                        : header.nightCount;
+        return count * kSignalElementSizes[column];
+    }
+    const std::uint64_t count = section < NightOffsets ? header.nightCount
+                                                       : section == NightOffsets ? header.nightCount + 1
+                                                                                 : header.phaseCount;
+    return count * kElementSizes[section];
+}
+
+/**
+ * Быстрая 64-битная контрольная сумма: слова по 8 байт перемешиваются умножением.
+ */
+std::uint64_t checksum(const void *data, std::size_t size, std::uint64_t seed = 0) {
+    constexpr std::uint64_t prime = 0x100000001B3ull;
+    const auto *bytes = static_cast<const unsigned char *>(data);
+    std::uint64_t h = 0x9E3779B97F4A7C15ull ^ seed ^ size;
+
+    std::size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        std::uint64_t word;
+        std::memcpy(&word, bytes + i, sizeof(word));
+        h = (h ^ word) * prime;
+        h ^= h >> 29;
+    }
+    for (; i < size; ++i) {
+        h = (h ^ bytes[i]) * prime;
+    }
+    return h ^ (h >> 32);
+}
+
+std::uint64_t headerChecksum(const FileHeader &header) {
+    return checksum(&header, offsetof(FileHeader, headerChecksum));
+}
+
+template<typename T>
+std::span<const T> sectionSpan(const std::byte *base, const FileHeader &header, Section section, std::size_t count) {
+    return {reinterpret_cast<const T *>(base + header.sectionOffsets[section]), count};
+}
+
+/**
+ * Свёртка контрольных сумм диапазона колонок [first, last).
+ */
+template<typename Columns>
+std::uint64_t sectionsChecksum(const Columns &sections, Section first, Section last) {
+    std::uint64_t h = 0;
+    for (std::size_t s = first; s < last; ++s) {
+        h = checksum(sections[s].data, sections[s].size, h);
+    }
+    return h;
+}
+
+/**
+ * Проверяет индекс вида [0, ..., total]: смещения не убывают, поэтому каждая ночь лежит внутри колонки.
+ */
+template<typename T>
+bool isValidIndex(std::span<const T> offsets, std::uint64_t total) {
+    return offsets.front() == 0 && offsets.back() == total && std::is_sorted(offsets.begin(), offsets.end());
+}
+
+/// Индекс, который ссылается на диапазон [offsets.front(), offsets.back()] из @p total элементов
+template<typename T>
+bool isIndexWithin(std::span<const T> offsets, std::uint64_t total) {
+    return !offsets.empty() && offsets.back() <= total && std::is_sorted(offsets.begin(), offsets.end());
+}
+
+/// Индекс среза с абсолютными смещениями, отсчитанный от его первого элемента
+template<typename T>
+std::span<const T> rebasedIndex(std::span<const T> offsets, std::vector<T> &storage) {
+    if (offsets.front() == 0) return offsets;
+    storage.resize(offsets.size());
+    std::transform(offsets.begin(), offsets.end(), storage.begin(),
+                   [first = offsets.front()](T offset) { return offset - first; });
+    return storage;
+}
+
+struct RawSection {
+    const void *data;
+    std::size_t size;
+};
+
+template<typename T>
+RawSection rawSection(std::span<const T> column) {
+    return {column.data(), column.size_bytes()};
+}
+
+std::array<RawSection, SectionCount> rawSections(const SleepPhaseColumns &columns) {
+    std::array<RawSection, SectionCount> sections = {
+            rawSection(columns.dates),
+            rawSection(columns.bedtimes),
+            rawSection(columns.wakeTimes),
+            rawSection(columns.nightOffsets),
+            rawSection(columns.types),
+            rawSection(columns.startOffsets),
+            rawSection(columns.durations),
+    };
+    for (std::size_t s = 0; s < kSleepSignalCount; ++s) {
+        const SleepSignalColumns &signal = columns.signals[s];
+        sections[signalSection(s, SignalStartOffsets)] = rawSection(signal.startOffsets);
+        sections[signalSection(s, SignalIntervals)] = rawSection(signal.intervals);
+        sections[signalSection(s, SignalSampleCounts)] = rawSection(signal.sampleCounts);
+        sections[signalSection(s, SignalByteOffsets)] = rawSection(signal.byteOffsets);
+        sections[signalSection(s, SignalBytes)] = rawSection(signal.bytes);
+    }
+    return sections;
+}
+
+#if defined(_WIN32)
+
+int createFile(const std::string &path) {
+    return ::_open(path.c_str(), _O_WRONLY | _O_CREAT | _O_EXCL | _O_BINARY, _S_IREAD | _S_IWRITE);
+}
+
+int processId() {
+    return ::_getpid();
+}
+
+bool writeAll(int fd, const void *data, std::size_t size) {
+    const auto *p = static_cast<const char *>(data);
+    while (size > 0) {
+        const int written = ::_write(fd, p, static_cast<unsigned>(std::min<std::size_t>(size, INT_MAX)));
+        if (written <= 0) return false;
+        p += written;
+        size -= static_cast<std::size_t>(written);
+    }
+    return true;
+}
+
+bool syncAndClose(int fd) {
+    const bool synced = ::_commit(fd) == 0;
+    return ::_close(fd) == 0 && synced;
+}
+
+void syncDirectory(const std::string &) {
+    // переименование на NTFS журналируется самой файловой системой
+}
+
+#else
+
+int createFile(const std::string &path) {
+    return ::open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+}
+
+int processId() {
+    return static_cast<int>(::getpid());
+}
+
+bool writeAll(int fd, const void *data, std::size_t size) {
+    const auto *p = static_cast<const char *>(data);
+    while (size > 0) {
+        const ssize_t written = ::write(fd, p, std::min<std::size_t>(size, SSIZE_MAX));
+        if (written < 0 && errno == EINTR) continue;
+        if (written <= 0) return false;
+        p += written;
+        size -= static_cast<std::size_t>(written);
+    }
+    return true;
+}
+
+bool syncAndClose(int fd) {
+    const bool synced = ::fsync(fd) == 0;
+    return ::close(fd) == 0 && synced;
+}
+
+void syncDirectory(const std::string &path) {
+    // новое имя файла сохраняется на диске только вместе с каталогом; не все файловые системы это
+    // поддерживают, поэтому ошибка не считается ошибкой записи
+    std::string directory = std::filesystem::path(path).parent_path().string();
+    if (directory.empty()) directory = ".";
+    const int fd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) return;
+    ::fsync(fd);
+    ::close(fd);
+}
+
+#endif
+
+/**
+ * Создаёт временный файл рядом с @p path. Имя уникально для процесса и вызова, поэтому одновременные
+ * записи одного снимка не пишут в один и тот же файл.
+ */
+int createTmpFile(const std::string &path, std::string &tmpPath) {
+    static std::atomic<unsigned> counter{0};
+    for (int attempt = 0; attempt < 100; ++attempt) {
+        tmpPath = path + ".tmp." + std::to_string(processId()) + "." +
+                  std::to_string(counter.fetch_add(1, std::memory_order_relaxed));
+        const int fd = createFile(tmpPath);
+        // файл с таким именем мог остаться от упавшего процесса с тем же pid
+        if (fd >= 0 || errno != EEXIST) return fd;
+    }
+    return -1;
+}
+
+} // namespace
+
+SnapshotSource SnapshotSource::of(const std::string &path) {
+    std::error_code ec;
+    SnapshotSource source;
+    const auto size = std::filesystem::file_size(path, ec);
+    if (ec) return source;
+    const auto mtime = std::filesystem::last_write_time(path, ec);
+    if (ec) return source;
+    source.size = size;
+    source.mtime = static_cast<std::int64_t>(mtime.time_since_epoch().count());
+    return source;
+}
+
+SleepSnapshot::SleepSnapshot(SleepSnapshot &&other) noexcept
+        : data_(std::exchange(other.data_, nullptr)),
+          size_(std::exchange(other.size_, 0)),
+          columns_(std::exchange(other.columns_, {})),
+          source_(other.source_) {}
+
+SleepSnapshot &SleepSnapshot::operator=(SleepSnapshot &&other) noexcept {
+    if (this != &other) {
+        release();
+        data_ = std::exchange(other.data_, nullptr);
+        size_ = std::exchange(other.size_, 0);
+        columns_ = std::exchange(other.columns_, {});
+        source_ = other.source_;
+    }
+    return *this;
+}
+
+SleepSnapshot::~SleepSnapshot() {
+    release();
+}
+
+void SleepSnapshot::release() {
+    if (data_ == nullptr) return;
+#if defined(_WIN32)
+    std::free(const_cast<std::byte *>(data_));
+#else
+    ::munmap(const_cast<std::byte *>(data_), size_);
+#endif
+    data_ = nullptr;
+    size_ = 0;
+    columns_ = {};
+}
+
+SleepSnapshot SleepSnapshot::open(const std::string &path) {
+    SleepSnapshot snapshot;
+
+#if defined(_WIN32)
+    // без mmap: файл читается целиком
+    std::ifstream ifs(path, std::ios::binary | std::ios::ate);
+    if (!ifs.is_open()) {
+        throw std::runtime_error("unable to open snapshot: " + path);
+    }
+    snapshot.size_ = static_cast<std::size_t>(ifs.tellg());
+    auto *buffer = static_cast<std::byte *>(std::malloc(snapshot.size_ ? snapshot.size_ : 1));
+    ifs.seekg(0);
+    ifs.read(reinterpret_cast<char *>(buffer), static_cast<std::streamsize>(snapshot.size_));
+    snapshot.data_ = buffer;
+#else
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("unable to open snapshot: " + path);
+    }
+    struct stat st{};
+    if (::fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(FileHeader))) {
+        ::close(fd);
+        throw std::runtime_error("invalid snapshot: " + path);
+    }
+    void *mapped = ::mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        throw std::runtime_error("unable to map snapshot: " + path);
+    }
+    snapshot.data_ = static_cast<const std::byte *>(mapped);
+    snapshot.size_ = static_cast<std::size_t>(st.st_size);
+#endif
+
+    if (snapshot.size_ < sizeof(FileHeader)) {
+        throw std::runtime_error("invalid snapshot: " + path);
+    }
+    FileHeader header{};
+    std::memcpy(&header, snapshot.data_, sizeof(header));
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.headerSize != sizeof(FileHeader) ||
+        header.headerChecksum != headerChecksum(header)) {
+        throw std::runtime_error("invalid snapshot: " + path);
+    }
+    if (header.version != kVersion) {
+        throw std::runtime_error("unsupported snapshot version: " + path);
+    }
+    if (header.fileSize != snapshot.size_) {
+        throw std::runtime_error("truncated snapshot: " + path);
+    }
+    // каждый элемент занимает хотя бы байт; без этой проверки длина секции может переполниться
+    bool countsFit = header.nightCount < header.fileSize && header.phaseCount <= header.fileSize;
+    for (const std::uint64_t bytes: header.signalByteCounts) {
+        countsFit = countsFit && bytes <= header.fileSize;
+    }
+    if (!countsFit) {
+        throw std::runtime_error("invalid snapshot: " + path);
+    }
+    for (std::size_t s = 0; s < SectionCount; ++s) {
+        const std::uint64_t offset = header.sectionOffsets[s];
+        const std::uint64_t length = sectionLength(static_cast<Section>(s), header);
+        if (offset % 8 != 0 || offset < sizeof(FileHeader) || offset > header.fileSize ||
+            length > header.fileSize - offset) {
+            throw std::runtime_error("invalid snapshot: " + path);
+        }
+    }
+
+    const auto nights = static_cast<std::size_t>(header.nightCount);
+    const auto phases = static_cast<std::size_t>(header.phaseCount);
+    const std::byte *base = snapshot.data_;
+    SleepPhaseColumns &c = snapshot.columns_;
+    c.dates = sectionSpan<std::int64_t>(base, header, Dates, nights);
+    c.bedtimes = sectionSpan<std::int64_t>(base, header, Bedtimes, nights);
+    c.wakeTimes = sectionSpan<std::int64_t>(base, header, WakeTimes, nights);
+    c.nightOffsets = sectionSpan<std::uint32_t>(base, header, NightOffsets, nights + 1);
+    c.types = sectionSpan<std::uint8_t>(base, header, Types, phases);
+    c.startOffsets = sectionSpan<std::int32_t>(base, header, StartOffsets, phases);
+    c.durations = sectionSpan<std::int32_t>(base, header, Durations, phases);
+    if (!isValidIndex(c.nightOffsets, phases)) {
+        throw std::runtime_error("invalid snapshot: " + path);
+    }
+    for (std::size_t s = 0; s < kSleepSignalCount; ++s) {
+        const auto bytes = static_cast<std::size_t>(header.signalByteCounts[s]);
+        SleepSignalColumns &signal = c.signals[s];
+        signal.startOffsets = sectionSpan<std::int32_t>(base, header, signalSection(s, SignalStartOffsets), nights);
+        signal.intervals = sectionSpan<std::int32_t>(base, header, signalSection(s, SignalIntervals), nights);
+        signal.sampleCounts = sectionSpan<std::uint32_t>(base, header, signalSection(s, SignalSampleCounts), nights);
+        signal.byteOffsets = sectionSpan<std::uint64_t>(base, header, signalSection(s, SignalByteOffsets), nights + 1);
+        signal.bytes = sectionSpan<std::uint8_t>(base, header, signalSection(s, SignalBytes), bytes);
+        if (!isValidIndex(signal.byteOffsets, bytes)) {
+            throw std::runtime_error("invalid snapshot: " + path);
+        }
+    }
+
+    snapshot.source_.size = header.sourceSize;
+    snapshot.source_.mtime = header.sourceMtime;
+    return snapshot;
+}
+
+void SleepSnapshot::write(const std::string &path, const SleepPhaseColumns &columns, const SnapshotSource &source) {
+    if (columns.nightOffsets.size() != columns.nightCount() + 1 ||
+        !isIndexWithin(columns.nightOffsets, columns.phaseCount()) ||
+        columns.startOffsets.size() != columns.phaseCount() || columns.durations.size() != columns.phaseCount()) {
+        throw std::runtime_error("invalid night index for snapshot");
+    }
+
+    // срез (SleepPhaseColumns::slice) ссылается на фазы и ряды по абсолютным смещениям: в файл пишутся
+    // только его фазы и байты рядов, а индексы отсчитываются от нуля, как их проверяет open()
+    SleepPhaseColumns complete = columns;
+    std::vector<std::uint32_t> nightOffsets;
+    complete.nightOffsets = rebasedIndex(columns.nightOffsets, nightOffsets);
+    const std::size_t firstPhase = columns.nightOffsets.front();
+    const std::size_t phases = columns.nightOffsets.back() - firstPhase;
+    complete.types = columns.types.subspan(firstPhase, phases);
+    complete.startOffsets = columns.startOffsets.subspan(firstPhase, phases);
+    complete.durations = columns.durations.subspan(firstPhase, phases);
+
+    // колонки без рядов записываются как ряды нулевой длины у каждой ночи
+    const std::vector<std::int32_t> noStarts(columns.nightCount(), 0);
+    const std::vector<std::int32_t> unitIntervals(columns.nightCount(), 1);
+    const std::vector<std::uint32_t> noSamples(columns.nightCount(), 0);
+    const std::vector<std::uint64_t> noBytes(columns.nightCount() + 1, 0);
+    std::array<std::vector<std::uint64_t>, kSleepSignalCount> byteOffsets;
+    for (std::size_t s = 0; s < kSleepSignalCount; ++s) {
+        SleepSignalColumns &signal = complete.signals[s];
+        if (signal.empty()) {
+            signal = {noStarts, unitIntervals, noSamples, noBytes, {}};
+            continue;
+        }
+        if (signal.byteOffsets.size() != columns.nightCount() + 1 ||
+            !isIndexWithin(signal.byteOffsets, signal.bytes.size())) {
+            throw std::runtime_error("invalid signal index for snapshot");
+        }
+        const auto firstByte = static_cast<std::size_t>(signal.byteOffsets.front());
+        signal.bytes = signal.bytes.subspan(firstByte, static_cast<std::size_t>(signal.byteOffsets.back()) - firstByte);
+        signal.byteOffsets = rebasedIndex(signal.byteOffsets, byteOffsets[s]);
+    }
+    const std::array<RawSection, SectionCount> sections = rawSections(complete);
+
+    FileHeader header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.headerSize = sizeof(FileHeader);
+    header.nightCount = columns.nightCount();
+    header.phaseCount = complete.phaseCount();
+    for (std::size_t s = 0; s < kSleepSignalCount; ++s) {
+        header.signalByteCounts[s] = complete.signals[s].bytes.size();
+    }
+    header.sourceSize = source.size;
+    header.sourceMtime = source.mtime;
+
+    std::uint64_t offset = align8(sizeof(FileHeader));
+    for (std::size_t s = 0; s < SectionCount; ++s) {
+        header.sectionOffsets[s] = offset;
+        offset = align8(offset + sections[s].size);
+    }
+    header.fileSize = offset;
+    header.indexChecksum = sectionsChecksum(sections, Dates, Types);
+    header.phasesChecksum = sectionsChecksum(sections, Types, Signals);
+    header.signalsChecksum = sectionsChecksum(sections, Signals, SectionCount);
+    header.headerChecksum = headerChecksum(header);
+
+    std::string tmpPath;
+    const int fd = createTmpFile(path, tmpPath);
+    if (fd < 0) {
+        throw std::runtime_error("unable to create snapshot: " + path);
+    }
+
+    static constexpr char padding[8] = {};
+    bool written = writeAll(fd, &header, sizeof(header));
+    std::uint64_t end = sizeof(header);
+    for (std::size_t s = 0; s < SectionCount && written; ++s) {
+        written = writeAll(fd, padding, header.sectionOffsets[s] - end) &&
+                  writeAll(fd, sections[s].data, sections[s].size);
+        end = header.sectionOffsets[s] + sections[s].size;
+    }
+    written = written && writeAll(fd, padding, header.fileSize - end);
+    // данные должны быть на диске до переименования, иначе после сбоя под именем снимка окажется обрезанный файл
+    written = syncAndClose(fd) && written;
+
+    std::error_code ec;
+    if (!written) {
+        std::filesystem::remove(tmpPath, ec);
+        throw std::runtime_error("unable to write snapshot: " + tmpPath);
+    }
+    std::filesystem::rename(tmpPath, path, ec);
+    if (ec) {
+        std::filesystem::remove(tmpPath, ec);
+        throw std::runtime_error("unable to replace snapshot: " + path);
+    }
+    syncDirectory(path);
+}
+
+std::string SleepSnapshot::pathFor(const std::string &sourcePath) {
+    return sourcePath + ".snap";
+}
+
+bool SleepSnapshot::isFreshFor(const std::string &sourcePath) const {
+    return data_ != nullptr && SnapshotSource::of(sourcePath) == source_;
+}
+
+bool SleepSnapshot::verify() const {
+    if (data_ == nullptr) return false;
+
+    FileHeader header{};
+    std::memcpy(&header, data_, sizeof(header));
+    const std::array<RawSection, SectionCount> sections = rawSections(columns_);
+    return header.indexChecksum == sectionsChecksum(sections, Dates, Types) &&
+           header.phasesChecksum == sectionsChecksum(sections, Types, Signals) &&
+           header.signalsChecksum == sectionsChecksum(sections, Signals, SectionCount);
+}
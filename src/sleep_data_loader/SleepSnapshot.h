@@ -0,0 +1,121 @@
+/**
+ * @file SleepSnapshot.h
+ * @brief Бинарный снимок разобранных данных о сне, открываемый через отображение файла в память.
+ */
+#ifndef SLEEP_VISUALIZER_SLEEPSNAPSHOT_H
+#define SLEEP_VISUALIZER_SLEEPSNAPSHOT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "SleepPhaseStore.h"
+
+/**
+ * @struct SnapshotSource
+ * @brief Отпечаток исходного JSON-файла, по которому определяется устаревание снимка.
+ */
+struct SnapshotSource {
+    std::uint64_t size = 0;  ///< Размер исходного файла, байт
+    std::int64_t mtime = 0;  ///< Время последнего изменения исходного файла (тики file_clock)
+
+    /**
+     * @brief Снимает отпечаток файла.
+     *
+     * @param path Путь к исходному файлу.
+     * @return Отпечаток; нулевой, если файл недоступен.
+     */
+    static SnapshotSource of(const std::string &path);
+
+    bool operator==(const SnapshotSource &) const = default;
+};
+
+/**
+ * @class SleepSnapshot
+ * @brief Снимок данных о сне в бинарном формате, читаемый без десериализации.
+ *
+ * Формат файла: заголовок (сигнатура, версия, количество ночей, фаз и байт рядов, отпечаток источника,
+ * смещения колонок, контрольные суммы), затем индекс ночей (даты, время отхода ко сну и пробуждения,
+ * смещения фаз), колонки фаз и колонки сжатых рядов пульса и дыхания. Все колонки выровнены на 8 байт
+ * и хранятся в порядке байтов платформы.
+ *
+ * При открытии файл целиком отображается в память и проверяется только заголовок, поэтому страницы
+ * с данными читаются с диска лишь при обращении к соответствующим ночам.
+ */
+class SleepSnapshot {
+public:
+    SleepSnapshot() = default;
+
+    SleepSnapshot(const SleepSnapshot &) = delete;
+
+    SleepSnapshot &operator=(const SleepSnapshot &) = delete;
+
+    SleepSnapshot(SleepSnapshot &&other) noexcept;
+
+    SleepSnapshot &operator=(SleepSnapshot &&other) noexcept;
+
+    ~SleepSnapshot();
+
+    /**
+     * @brief Открывает снимок, отображая файл в память.
+     *
+     * Индексы ночей и рядов проверяются целиком: смещения не убывают и не выходят за колонки, поэтому
+     * любая ночь открытого снимка читается внутри файла. Контрольные суммы данных проверяет verify().
+     *
+     * @param path Путь к файлу снимка.
+     * @return Открытый снимок.
+     *
+     * @throws std::runtime_error Если файл невозможно открыть, он повреждён или имеет другую версию формата.
+     */
+    static SleepSnapshot open(const std::string &path);
+
+    /**
+     * @brief Записывает снимок колонок в файл.
+     *
+     * Запись идёт в уникальный временный файл, который сбрасывается на диск и затем атомарно заменяет @p path,
+     * поэтому одновременные записи и сбой не оставляют под этим именем смешанный или обрезанный снимок.
+     *
+     * @param path Путь к файлу снимка.
+     * @param columns Данные для записи; может быть срезом SleepPhaseColumns::slice().
+     * @param source Отпечаток исходного файла, из которого получены данные.
+     *
+     * @throws std::runtime_error Если запись не удалась.
+     */
+    static void write(const std::string &path, const SleepPhaseColumns &columns, const SnapshotSource &source);
+
+    /**
+     * @brief Возвращает путь к снимку, соответствующему исходному файлу.
+     */
+    static std::string pathFor(const std::string &sourcePath);
+
+    /**
+     * @brief Проверяет, что снимок построен из текущей версии исходного файла.
+     *
+     * @param sourcePath Путь к исходному JSON-файлу.
+     */
+    [[nodiscard]] bool isFreshFor(const std::string &sourcePath) const;
+
+    /**
+     * @brief Проверяет контрольные суммы индекса, колонок фаз и рядов.
+     *
+     * Читает весь файл, поэтому не вызывается при открытии.
+     */
+    [[nodiscard]] bool verify() const;
+
+    [[nodiscard]] const SleepPhaseColumns &columns() const { return columns_; }
+
+    [[nodiscard]] std::size_t nightCount() const { return columns_.nightCount(); }
+
+    [[nodiscard]] SleepNightView night(std::size_t i) const { return columns_.night(i); }
+
+    [[nodiscard]] const SnapshotSource &source() const { return source_; }
+
+private:
+    void release();
+
+    const std::byte *data_ = nullptr;
+    std::size_t size_ = 0;
+    SleepPhaseColumns columns_;
+    SnapshotSource source_;
+};
+
+#endif //SLEEP_VISUALIZER_SLEEPSNAPSHOT_H
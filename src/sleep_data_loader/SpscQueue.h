@@ -0,0 +1,84 @@
+/**
+ * @file SpscQueue.h
+ * @brief Ограниченная очередь без блокировок для одного производителя и одного потребителя.
+ */
+#ifndef SLEEP_VISUALIZER_SPSCQUEUE_H
+#define SLEEP_VISUALIZER_SPSCQUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+
+/**
+ * @class SpscQueue
+ * @brief Кольцевой буфер, в который пишет ровно один поток и из которого читает ровно один другой поток.
+ *
+ * Индексы записи и чтения растут монотонно и лежат в разных кэш-линиях; каждый поток меняет только свой
+ * индекс, поэтому tryPush() и tryPop() не блокируются и не используют взаимных исключений.
+ */
+template<typename T>
+class SpscQueue {
+public:
+    /**
+     * @brief Создаёт очередь.
+     *
+     * @param capacity Вместимость; округляется вверх до степени двойки.
+     *
+     * @throws std::invalid_argument Если вместимость равна нулю.
+     */
+    explicit SpscQueue(std::size_t capacity) {
+        if (capacity == 0) {
+            throw std::invalid_argument("queue capacity must be positive");
+        }
+        std::size_t rounded = 1;
+        while (rounded < capacity) rounded <<= 1;
+        mask_ = rounded - 1;
+        slots_ = std::make_unique<std::optional<T>[]>(rounded);
+    }
+
+    SpscQueue(const SpscQueue &) = delete;
+
+    SpscQueue &operator=(const SpscQueue &) = delete;
+
+    /**
+     * @brief Добавляет элемент. Вызывается только потоком-производителем.
+     *
+     * @return false, если очередь заполнена; тогда @p value не изменяется.
+     */
+    bool tryPush(T &&value) {
+        const std::size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_.load(std::memory_order_acquire) > mask_) return false;
+        slots_[tail & mask_].emplace(std::move(value));
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Забирает элемент. Вызывается только потоком-потребителем.
+     *
+     * @return Элемент или std::nullopt, если очередь пуста.
+     */
+    std::optional<T> tryPop() {
+        const std::size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_.load(std::memory_order_acquire)) return std::nullopt;
+        std::optional<T> value = std::move(slots_[head & mask_]);
+        slots_[head & mask_].reset();
+        head_.store(head + 1, std::memory_order_release);
+        return value;
+    }
+
+    [[nodiscard]] std::size_t capacity() const { return mask_ + 1; }
+
+private:
+    static constexpr std::size_t kCacheLine = 64;
+
+    std::unique_ptr<std::optional<T>[]> slots_;
+    std::size_t mask_ = 0;
+    alignas(kCacheLine) std::atomic<std::size_t> head_{0}; ///< Следующий элемент для чтения
+    alignas(kCacheLine) std::atomic<std::size_t> tail_{0}; ///< Следующая ячейка для записи
+};
+
+#endif //SLEEP_VISUALIZER_SPSCQUEUE_H
@@ -0,0 +1,169 @@
+#include "WorkStealingPool.h"
+#include "Trace.h"
+#include <algorithm>
+#include <utility>
+
+namespace {
+
+// пул и очередь, к которым относится текущий поток; у потоков вне пула currentPool == nullptr
+thread_local const void *currentPool = nullptr;
+thread_local std::size_t currentQueue = 0;
+
+} // namespace
+
+WorkStealingPool::WorkStealingPool(std::size_t threadCount) {
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    queues_.reserve(threadCount);
+    for (std::size_t i = 0; i < threadCount; ++i) {
+        queues_.push_back(std::make_unique<Queue>());
+    }
+    try {
+        threads_.reserve(threadCount);
+        for (std::size_t i = 0; i < threadCount; ++i) {
+            threads_.emplace_back([this, i] { workerLoop(i); });
+        }
+    } catch (...) {
+        // деструктор не вызовется: уже запущенные потоки нужно остановить здесь, иначе std::terminate
+        {
+            std::lock_guard lock(sleepMutex_);
+            stop_ = true;
+        }
+        workAvailable_.notify_all();
+        for (auto &thread: threads_) {
+            thread.join();
+        }
+        throw;
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    try {
+        wait();
+    } catch (...) {
+        // ошибки задач уже некому передать
+    }
+    {
+        std::lock_guard lock(sleepMutex_);
+        stop_ = true;
+    }
+    workAvailable_.notify_all();
+    for (auto &thread: threads_) {
+        thread.join();
+    }
+}
+
+void WorkStealingPool::submit(Task task) {
+    const std::size_t index = currentPool == this ? currentQueue
+                                                  : nextQueue_.fetch_add(1, std::memory_order_relaxed) % queues_.size();
+    unfinished_.fetch_add(1, std::memory_order_relaxed);
+    {
+        std::lock_guard lock(queues_[index]->mutex);
+        queues_[index]->tasks.push_back(std::move(task));
+    }
+    {
+        // инкремент под мьютексом ожидания, чтобы поток не уснул, пропустив задачу
+        std::lock_guard lock(sleepMutex_);
+        queued_.fetch_add(1, std::memory_order_release);
+        // ждущие в helpUntilDone() тоже берут задачи: если все потоки пула ждут, выполнить её больше некому
+        if (waiters_ > 0) allDone_.notify_all();
+    }
+    workAvailable_.notify_one();
+}
+
+void WorkStealingPool::wait() {
+    const std::size_t home = currentPool == this ? currentQueue : 0;
+    while (unfinished_.load(std::memory_order_acquire) > 0) {
+        if (tryRunTask(home)) continue;
+
+        std::unique_lock lock(sleepMutex_);
+        ++waiters_;
+        allDone_.wait(lock, [this] {
+            return unfinished_.load(std::memory_order_acquire) == 0 || queued_.load(std::memory_order_acquire) > 0;
+        });
+        --waiters_;
+    }
+
+    std::lock_guard lock(errorMutex_);
+    if (error_) {
+        std::rethrow_exception(std::exchange(error_, nullptr));
+    }
+}
+
+void WorkStealingPool::helpUntilDone(const std::atomic<std::size_t> &remaining) {
+    const std::size_t home = currentPool == this ? currentQueue : 0;
+    while (remaining.load(std::memory_order_acquire) > 0) {
+        if (tryRunTask(home)) continue;
+
+        // оставшиеся задачи уже выполняются другими потоками: ждём их завершения или новых задач
+        std::unique_lock lock(sleepMutex_);
+        ++waiters_;
+        allDone_.wait(lock, [this, &remaining] {
+            return remaining.load(std::memory_order_acquire) == 0 || queued_.load(std::memory_order_acquire) > 0;
+        });
+        --waiters_;
+    }
+}
+
+void WorkStealingPool::notifyWaiters() {
+    // под мьютексом, чтобы ждущий не пропустил уведомление между проверкой условия и засыпанием
+    std::lock_guard lock(sleepMutex_);
+    allDone_.notify_all();
+}
+
+void WorkStealingPool::workerLoop(std::size_t index) {
+    SLEEP_TRACE_THREAD_NAME("WorkStealingPool");
+    currentPool = this;
+    currentQueue = index;
+    while (true) {
+        if (tryRunTask(index)) continue;
+
+        std::unique_lock lock(sleepMutex_);
+        workAvailable_.wait(lock, [this] { return stop_ || queued_.load(std::memory_order_acquire) > 0; });
+        if (stop_ && queued_.load(std::memory_order_acquire) == 0) return;
+    }
+}
+
+bool WorkStealingPool::tryRunTask(std::size_t home) {
+    Task task;
+    if (!popLocal(home, task) && !steal(home, task)) return false;
+    run(task);
+    return true;
+}
+
+bool WorkStealingPool::popLocal(std::size_t index, Task &task) {
+    Queue &queue = *queues_[index];
+    std::lock_guard lock(queue.mutex);
+    if (queue.tasks.empty()) return false;
+    task = std::move(queue.tasks.back());
+    queue.tasks.pop_back();
+    queued_.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool WorkStealingPool::steal(std::size_t thief, Task &task) {
+    for (std::size_t k = 1; k < queues_.size(); ++k) {
+        Queue &queue = *queues_[(thief + k) % queues_.size()];
+        std::unique_lock lock(queue.mutex, std::try_to_lock);
+        if (!lock.owns_lock() || queue.tasks.empty()) continue;
+        task = std::move(queue.tasks.front());
+        queue.tasks.pop_front();
+        queued_.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+void WorkStealingPool::run(Task &task) {
+    try {
+        task();
+    } catch (...) {
+        std::lock_guard lock(errorMutex_);
+        if (!error_) error_ = std::current_exception();
+    }
+    if (unfinished_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        std::lock_guard lock(sleepMutex_);
+        allDone_.notify_all();
+    }
+}
@@ -0,0 +1,128 @@
+/**
+ * @file WorkStealingPool.h
+ * @brief Пул потоков с очередью задач у каждого потока и кражей работы у соседей.
+ */
+#ifndef SLEEP_VISUALIZER_WORKSTEALINGPOOL_H
+#define SLEEP_VISUALIZER_WORKSTEALINGPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @class WorkStealingPool
+ * @brief Пул потоков для параллельной загрузки и анализа.
+ *
+ * У каждого потока своя очередь: задачи, порождённые внутри пула, кладутся в очередь текущего потока
+ * и берутся с её конца, а свободный поток забирает задачи с начала чужих очередей. Задачи извне
+ * распределяются по очередям по кругу.
+ */
+class WorkStealingPool {
+public:
+    using Task = std::function<void()>;
+
+    /**
+     * @brief Запускает пул.
+     *
+     * @param threadCount Количество потоков; 0 - по числу аппаратных потоков.
+     */
+    explicit WorkStealingPool(std::size_t threadCount = 0);
+
+    WorkStealingPool(const WorkStealingPool &) = delete;
+
+    WorkStealingPool &operator=(const WorkStealingPool &) = delete;
+
+    /**
+     * @brief Дожидается выполнения всех задач и останавливает потоки.
+     */
+    ~WorkStealingPool();
+
+    /**
+     * @brief Ставит задачу в очередь.
+     */
+    void submit(Task task);
+
+    /**
+     * @brief Ждёт завершения всех поставленных задач, помогая их выполнять.
+     *
+     * Не должен вызываться из задач пула: выполняемая задача сама считается незавершённой.
+     *
+     * @throws Первое исключение, выброшенное какой-либо задачей через submit() с момента предыдущего wait().
+     */
+    void wait();
+
+    /**
+     * @brief Выполняет @p fn(i) для всех i из [0, count) и ждёт завершения только этих вызовов.
+     *
+     * Вызывающий поток тоже выполняет задачи, поэтому вызов допустим и изнутри задачи пула.
+     *
+     * @throws Первое исключение, выброшенное каким-либо вызовом @p fn.
+     */
+    template<typename Fn>
+    void parallelFor(std::size_t count, Fn &&fn) {
+        std::atomic<std::size_t> remaining{count};
+        std::mutex errorMutex;
+        std::exception_ptr error;
+        for (std::size_t i = 0; i < count; ++i) {
+            submit([&, i] {
+                try {
+                    fn(i);
+                } catch (...) {
+                    std::lock_guard lock(errorMutex);
+                    if (!error) error = std::current_exception();
+                }
+                if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) notifyWaiters();
+            });
+        }
+        helpUntilDone(remaining);
+        if (error) std::rethrow_exception(error);
+    }
+
+    [[nodiscard]] std::size_t threadCount() const { return threads_.size(); }
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void workerLoop(std::size_t index);
+
+    void helpUntilDone(const std::atomic<std::size_t> &remaining);
+
+    /// Будит потоки, ждущие в wait() и helpUntilDone().
+    void notifyWaiters();
+
+    bool tryRunTask(std::size_t home);
+
+    bool popLocal(std::size_t index, Task &task);
+
+    bool steal(std::size_t thief, Task &task);
+
+    void run(Task &task);
+
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::vector<std::thread> threads_;
+
+    std::atomic<std::size_t> queued_{0};     ///< Задачи, лежащие в очередях
+    std::atomic<std::size_t> unfinished_{0}; ///< Поставленные, но ещё не выполненные задачи
+    std::atomic<std::size_t> nextQueue_{0};
+    bool stop_ = false;
+    std::size_t waiters_ = 0;                ///< Потоки, ждущие в wait() и helpUntilDone(); под sleepMutex_
+
+    std::mutex sleepMutex_;
+    std::condition_variable workAvailable_;
+    std::condition_variable allDone_;
+
+    std::mutex errorMutex_;
+    std::exception_ptr error_;
+};
+
+#endif //SLEEP_VISUALIZER_WORKSTEALINGPOOL_H
@@ -0,0 +1,240 @@
+#include "ReportWriter.h"
+#include <chrono>
+#include <format>
+#include <stdexcept>
+#include <nlohmann/json.hpp>
+#include "DateTimeParser.h"
+
+namespace {
+
+std::string formatDate(std::int64_t seconds) {
+    const std::chrono::sys_days day{std::chrono::days(DateTimeParser::localDayNumber(seconds))};
+    return std::format("{:%Y-%m-%d}", day);
+}
+
+nlohmann::json metricsToJson(const SleepMetrics &m) {
+    return {
+            {"timeInBed",          m.timeInBed},
+            {"totalSleepTime",     m.totalSleepTime},
+            {"sleepOnset",         m.sleepOnset},
+            {"awakeningsCount",    m.awakeningsCount},
+            {"awakeDuration",      m.awakeDuration},
+            {"deepSleepDuration",  m.deepSleepDuration},
+            {"remSleepDuration",   m.remSleepDuration},
+            {"lightSleepDuration", m.lightSleepDuration},
+            {"lightSleepPercent",  m.lightSleepPercent},
+            {"deepSleepPercent",   m.deepSleepPercent},
+            {"remSleepPercent",    m.remSleepPercent},
+            {"efficiency",         m.efficiency}
+    };
+}
+
+nlohmann::json architectureToJson(const SleepArchitecture &a) {
+    return {
+            {"sleepOnsetLatency",  a.sleepOnsetLatency},
+            {"remLatency",         a.remLatency},
+            {"waso",               a.waso},
+            {"cycleCount",         a.cycleCount},
+            {"meanCycleLength",    a.meanCycleLength()},
+            {"stageShifts",        a.stageShifts},
+            {"fragmentationIndex", a.fragmentationIndex}
+    };
+}
+
+nlohmann::json distributionToJson(const CohortDistribution &d) {
+    return {
+            {"count",  d.count},
+            {"mean",   d.mean},
+            {"min",    d.min},
+            {"p10",    d.p10},
+            {"p25",    d.p25},
+            {"median", d.median},
+            {"p75",    d.p75},
+            {"p90",    d.p90},
+            {"max",    d.max}
+    };
+}
+
+constexpr const char *kMetricColumns = "timeInBed,totalSleepTime,sleepOnset,awakeningsCount,awakeDuration,"
+                                       "deepSleepDuration,remSleepDuration,lightSleepDuration,lightSleepPercent,"
+                                       "deepSleepPercent,remSleepPercent,efficiency";
+
+constexpr const char *kArchitectureColumns = "sleepOnsetLatency,remLatency,waso,cycleCount,meanCycleLength,"
+                                             "stageShifts,fragmentationIndex";
+
+/// Пустые значения всех столбцов метрик и архитектуры сна
+constexpr const char *kEmptyNightColumns = ",,,,,,,,,,,,,,,,,,,";
+
+std::string csvQuote(const std::string &value) {
+    std::string quoted = "\"";
+    for (char c: value) {
+        if (c == '"') quoted += '"';
+        quoted += c;
+    }
+    quoted += '"';
+    return quoted;
+}
+
+std::string csvErrors(const std::vector<std::string> &errors) {
+    std::string joined;
+    for (const auto &error: errors) {
+        if (!joined.empty()) joined += "; ";
+        joined += error;
+    }
+    return joined.empty() ? joined : csvQuote(joined);
+}
+
+void appendCsvRow(std::string &out, const std::string &source, const std::string &date, const SleepMetrics &m,
+                  const SleepArchitecture *a, const std::string &recommendation, const std::string &errors) {
+    std::format_to(std::back_inserter(out), "{},{},{},{},{},{},{},{},{},{},{},{},{},{},",
+                   source, date, m.timeInBed, m.totalSleepTime, m.sleepOnset, m.awakeningsCount, m.awakeDuration,
+                   m.deepSleepDuration, m.remSleepDuration, m.lightSleepDuration, m.lightSleepPercent,
+                   m.deepSleepPercent, m.remSleepPercent, m.efficiency);
+    if (a) {
+        std::format_to(std::back_inserter(out), "{},{},{},{},{},{},{},", a->sleepOnsetLatency, a->remLatency,
+                       a->waso, a->cycleCount, a->meanCycleLength(), a->stageShifts, a->fragmentationIndex);
+    } else {
+        out += ",,,,,,,";
+    }
+    out += recommendation;
+    out += ',';
+    out += errors;
+    out += '\n';
+}
+
+std::string formatJson(const SourceReport &report, const RecommendationRules &rules) {
+    nlohmann::json nights = nlohmann::json::array();
+    for (std::size_t i = 0; i < report.nights.size(); ++i) {
+        nlohmann::json night = metricsToJson(report.nights[i]);
+        night["date"] = formatDate(report.dates[i]);
+        if (i < report.architecture.size()) night["architecture"] = architectureToJson(report.architecture[i]);
+        nights.push_back(std::move(night));
+    }
+
+    nlohmann::json source = {
+            {"path",   report.path},
+            {"nights", std::move(nights)},
+            {"errors", report.errors}
+    };
+    if (!report.nights.empty()) {
+        source["average"] = metricsToJson(report.average);
+        source["recommendation"] = rules.render(report.recommendations);
+    }
+    return source.dump();
+}
+
+std::string formatCsv(const SourceReport &report, const RecommendationRules &rules) {
+    const std::string source = csvQuote(report.path);
+    std::string out;
+    for (std::size_t i = 0; i < report.nights.size(); ++i) {
+        const SleepArchitecture *architecture = i < report.architecture.size() ? &report.architecture[i] : nullptr;
+        appendCsvRow(out, source, formatDate(report.dates[i]), report.nights[i], architecture, "", "");
+    }
+    const std::string errors = csvErrors(report.errors);
+    if (!report.nights.empty()) {
+        appendCsvRow(out, source, "average", report.average, nullptr, csvQuote(rules.render(report.recommendations)),
+                     errors);
+    } else if (!errors.empty()) {
+        // ночей нет, но ошибки загрузки должны попасть в отчёт, как и в JSON
+        out += source;
+        out += ",,";
+        out += kEmptyNightColumns;
+        out += ',';
+        out += errors;
+        out += '\n';
+    }
+    return out;
+}
+
+} // namespace
+
+ReportFormat ReportWriter::parseFormat(const std::string &name) {
+    if (name == "json") return ReportFormat::Json;
+    if (name == "csv") return ReportFormat::Csv;
+    throw std::invalid_argument("unknown report format: " + name);
+}
+
+std::string ReportWriter::format(const SourceReport &report, ReportFormat format, const RecommendationRules &rules) {
+    return format == ReportFormat::Json ? formatJson(report, rules) : formatCsv(report, rules);
+}
+
+void ReportWriter::write(std::ostream &out, std::span<const std::string> fragments, ReportFormat format) {
+    if (format == ReportFormat::Csv) {
+        out << "source,date," << kMetricColumns << ',' << kArchitectureColumns << ",recommendation,errors\n";
+        for (const auto &fragment: fragments) {
+            out << fragment;
+        }
+        return;
+    }
+
+    out << "{\"sources\":[";
+    for (std::size_t i = 0; i < fragments.size(); ++i) {
+        if (i > 0) out << ',';
+        out << fragments[i];
+    }
+    out << "]}\n";
+}
+
+void ReportWriter::writeCohort(std::ostream &out, const CohortSummary &cohort, ReportFormat format,
+                               const RecommendationRules &rules) {
+    const std::pair<const char *, double CohortDistribution::*> statistics[] = {
+            {"mean",   &CohortDistribution::mean},
+            {"min",    &CohortDistribution::min},
+            {"p10",    &CohortDistribution::p10},
+            {"p25",    &CohortDistribution::p25},
+            {"median", &CohortDistribution::median},
+            {"p75",    &CohortDistribution::p75},
+            {"p90",    &CohortDistribution::p90},
+            {"max",    &CohortDistribution::max}
+    };
+
+    if (format == ReportFormat::Csv) {
+        out << "id,path,nights," << kMetricColumns << ",recommendation,error\n";
+        for (const auto &member: cohort.members) {
+            const SleepMetrics &m = member.average;
+            const std::string recommendation = member.nights > 0 ? rules.render(member.recommendations) : "";
+            out << std::format("{},{},{},{},{},{},{},{},{},{},{},{},{},{},{},{},{}\n",
+                               csvQuote(member.id), csvQuote(member.path), member.nights, m.timeInBed,
+                               m.totalSleepTime, m.sleepOnset, m.awakeningsCount, m.awakeDuration,
+                               m.deepSleepDuration, m.remSleepDuration, m.lightSleepDuration, m.lightSleepPercent,
+                               m.deepSleepPercent, m.remSleepPercent, m.efficiency, csvQuote(recommendation),
+                               csvQuote(member.error));
+        }
+        for (const auto &[name, field]: statistics) {
+            out << std::format("cohort:{},,,,{},,,,,,,,{},{},{},,\n", name, cohort.totalSleepTime.*field,
+                               cohort.deepSleepPercent.*field, cohort.remSleepPercent.*field,
+                               cohort.efficiency.*field);
+        }
+        return;
+    }
+
+    nlohmann::json members = nlohmann::json::array();
+    for (const auto &member: cohort.members) {
+        nlohmann::json json = {
+                {"id",     member.id},
+                {"path",   member.path},
+                {"nights", member.nights}
+        };
+        if (member.nights > 0) {
+            json["average"] = metricsToJson(member.average);
+            json["recommendation"] = rules.render(member.recommendations);
+        }
+        if (!member.error.empty()) {
+            json["error"] = member.error;
+        }
+        members.push_back(std::move(json));
+    }
+
+    const nlohmann::json report = {
+            {"cohort",  {
+                                {"members", cohort.members.size()},
+                                {"nights", cohort.nights},
+                                {"efficiency", distributionToJson(cohort.efficiency)},
+                                {"deepSleepPercent", distributionToJson(cohort.deepSleepPercent)},
+                                {"remSleepPercent", distributionToJson(cohort.remSleepPercent)},
+                                {"totalSleepTime", distributionToJson(cohort.totalSleepTime)}
+                        }},
+            {"members", std::move(members)}
+    };
+    out << report.dump() << '\n';
+}
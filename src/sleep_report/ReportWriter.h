@@ -0,0 +1,82 @@
+/**
+ * @file ReportWriter.h
+ * @brief Форматирование результатов пакетного анализа в JSON и CSV.
+ */
+#ifndef SLEEP_VISUALIZER_REPORTWRITER_H
+#define SLEEP_VISUALIZER_REPORTWRITER_H
+
+#include <cstdint>
+#include <ostream>
+#include <span>
+#include <string>
+#include <vector>
+#include "CohortAnalyzer.h"
+#include "RecommendationRules.h"
+#include "SleepAnalyzer.h"
+
+/**
+ * @enum ReportFormat
+ * @brief Формат отчёта.
+ */
+enum class ReportFormat {
+    Json, ///< Один JSON-объект со списком источников
+    Csv   ///< Строка на ночь и строка со средними значениями на источник; у строки средних нет архитектуры сна,
+          ///< зато есть рекомендация и ошибки загрузки (у источника без ночей - отдельная строка без даты)
+};
+
+/**
+ * @struct SourceReport
+ * @brief Результат анализа одного источника (файла или каталога).
+ */
+struct SourceReport {
+    std::string path;                 ///< Путь к источнику, как он указан в командной строке
+    std::vector<std::int64_t> dates;  ///< Даты ночей, секунды от эпохи
+    std::vector<SleepMetrics> nights; ///< Метрики по ночам
+    std::vector<SleepArchitecture> architecture; ///< Архитектура сна по ночам
+    SleepMetrics average{};           ///< Средние метрики по всем ночам
+    RuleMask recommendations = 0;     ///< Правила, сработавшие по средним метрикам; 0, если ночей нет
+    std::vector<std::string> errors;  ///< Ошибки загрузки
+};
+
+/**
+ * @brief Форматирование отчёта.
+ *
+ * Каждый источник форматируется отдельно, поэтому это можно делать параллельно,
+ * а затем записать фрагменты в исходном порядке через write().
+ * Объекты этого класса создавать нельзя.
+ */
+class ReportWriter {
+public:
+    ReportWriter() = delete;
+
+    /**
+     * @brief Разбирает название формата ("json" или "csv").
+     *
+     * @throws std::invalid_argument Если формат неизвестен.
+     */
+    static ReportFormat parseFormat(const std::string &name);
+
+    /**
+     * @brief Форматирует отчёт по одному источнику.
+     *
+     * @param rules Правила, по которым рассчитаны рекомендации отчёта; нужны для их текста.
+     * @return Фрагмент отчёта для write().
+     */
+    static std::string format(const SourceReport &report, ReportFormat format, const RecommendationRules &rules);
+
+    /**
+     * @brief Записывает полный отчёт из фрагментов, полученных через format().
+     */
+    static void write(std::ostream &out, std::span<const std::string> fragments, ReportFormat format);
+
+    /**
+     * @brief Записывает отчёт по когорте: строку на участника и распределения по когорте.
+     *
+     * В CSV распределения записываются дополнительными строками с идентификаторами вида "cohort:median",
+     * в которых заполнены только столбцы, для которых распределение рассчитывается.
+     */
+    static void writeCohort(std::ostream &out, const CohortSummary &cohort, ReportFormat format,
+                            const RecommendationRules &rules);
+};
+
+#endif //SLEEP_VISUALIZER_REPORTWRITER_H
@@ -0,0 +1,125 @@
+#include "SourceAnalyzer.h"
+#include <algorithm>
+#include <filesystem>
+#include <stdexcept>
+#include <vector>
+#include "DataLoader.h"
+#include "SleepAnalyzer.h"
+#include "SleepPhaseStore.h"
+
+namespace {
+
+/// Количество ночей в одной задаче расчёта метрик
+constexpr std::size_t kNightsPerTask = 4096;
+
+/**
+ * Загружает источник в хранилище. Ошибки отдельных файлов каталога записываются в отчёт.
+ */
+void loadSource(const std::string &path, SleepPhaseStore &store, SourceReport &report, WorkStealingPool &pool) {
+    if (!std::filesystem::is_directory(path)) {
+        DataLoader::loadStoreFromJsonFile(path, store);
+        return;
+    }
+
+    const DirectoryLoadResult loaded = DataLoader::loadDirectory(path, pool);
+    for (const auto &file: loaded.files) {
+        if (!file.error.empty()) report.errors.push_back(file.path + ": " + file.error);
+    }
+    for (const auto &night: loaded.nights) {
+        store.append(night);
+    }
+}
+
+} // namespace
+
+void SourceAnalyzer::calculate(const std::string &path, SourceReport &report, WorkStealingPool &pool) {
+    SleepPhaseStore store;
+    loadSource(path, store, report, pool);
+
+    const SleepPhaseColumns history = store.columns();
+    const std::size_t nightCount = history.nightCount();
+    report.dates.assign(history.dates.begin(), history.dates.end());
+    report.nights.resize(nightCount);
+    report.architecture.resize(nightCount);
+
+    const std::span<SleepMetrics> nights(report.nights);
+    const std::span<SleepArchitecture> architecture(report.architecture);
+    pool.parallelFor((nightCount + kNightsPerTask - 1) / kNightsPerTask, [&](std::size_t task) {
+        const std::size_t first = task * kNightsPerTask;
+        const std::size_t count = std::min(kNightsPerTask, nightCount - first);
+        const SleepPhaseColumns slice = history.slice(first, count);
+        SleepAnalyzer::CalculateBatchMetrics(slice, nights.subspan(first, count));
+        SleepAnalyzer::CalculateBatchArchitecture(slice, architecture.subspan(first, count));
+    });
+}
+
+void SourceAnalyzer::calculateCached(const std::string &path, SleepMetricsCache &cache, SourceReport &report,
+                                     WorkStealingPool &pool) {
+    const bool directory = std::filesystem::is_directory(path);
+    const std::vector<std::string> files = directory ? DataLoader::findJsonFiles(path)
+                                                     : std::vector<std::string>{path};
+    std::vector<std::vector<NightMetrics>> perFile(files.size());
+    std::vector<std::string> errors(files.size());
+    pool.parallelFor(files.size(), [&](std::size_t i) {
+        try {
+            SleepAnalyzer::CalculateFileMetrics(files[i], cache, perFile[i]);
+        } catch (const std::exception &e) {
+            errors[i] = e.what();
+            perFile[i].clear();
+        }
+    });
+    if (!directory && !errors[0].empty()) throw std::runtime_error(errors[0]);
+
+    std::vector<NightOrigin> origins;
+    for (std::size_t f = 0; f < perFile.size(); ++f) {
+        if (!errors[f].empty()) report.errors.push_back(files[f] + ": " + errors[f]);
+        for (std::size_t n = 0; n < perFile[f].size(); ++n) {
+            const NightMetrics &night = perFile[f][n];
+            origins.push_back({f, n, night.date, night.bedtime, night.wakeTime});
+        }
+    }
+    std::vector<std::size_t> kept(origins.size());
+    if (directory) {
+        std::size_t dropped = 0;
+        kept = DataLoader::mergeNights(origins, dropped);
+    } else {
+        // ночи одного файла берутся как есть, в порядке записей
+        for (std::size_t i = 0; i < kept.size(); ++i) {
+            kept[i] = i;
+        }
+    }
+
+    for (const std::size_t k: kept) {
+        const NightMetrics &night = perFile[origins[k].file][origins[k].index];
+        report.dates.push_back(night.date);
+        report.nights.push_back(night.metrics);
+        report.architecture.push_back(night.architecture);
+    }
+}
+
+SourceReport SourceAnalyzer::analyze(const std::string &path, WorkStealingPool &pool, const RecommendationRules &rules,
+                                     SleepMetricsCache *cache) {
+    SourceReport report;
+    report.path = path;
+
+    try {
+        if (cache != nullptr) {
+            calculateCached(path, *cache, report, pool);
+        } else {
+            calculate(path, report, pool);
+        }
+    } catch (const std::exception &e) {
+        report.errors.emplace_back(e.what());
+        return report;
+    }
+
+    if (!report.nights.empty()) {
+        SleepMetricsTotals totals;
+        for (const auto &night: report.nights) {
+            totals.add(night);
+        }
+        report.average = totals.average();
+        report.recommendations = rules.evaluate(report.average);
+    }
+    return report;
+}
@@ -0,0 +1,56 @@
+/**
+ * @file SourceAnalyzer.h
+ * @brief Расчёт метрик всех ночей одного источника пакетного анализа.
+ */
+#ifndef SLEEP_VISUALIZER_SOURCEANALYZER_H
+#define SLEEP_VISUALIZER_SOURCEANALYZER_H
+
+#include <string>
+#include "RecommendationRules.h"
+#include "ReportWriter.h"
+#include "SleepMetricsCache.h"
+#include "WorkStealingPool.h"
+
+/**
+ * @brief Анализ источника (JSON-файла или каталога с ними) для отчёта sleep_report.
+ *
+ * Ночи рассчитываются одним из двух путей: разбором всего источника в SleepPhaseStore (calculate())
+ * или через кэш метрик, когда разбираются только записи суток, которых нет в кэше (calculateCached()).
+ * Оба пути дают одинаковые ночи, метрики и ошибки отдельных файлов каталога.
+ * Объекты этого класса создавать нельзя.
+ */
+class SourceAnalyzer {
+public:
+    SourceAnalyzer() = delete;
+
+    /**
+     * @brief Рассчитывает ночи источника, средние метрики и рекомендации.
+     *
+     * Ошибка загрузки источника не выбрасывается, а записывается в SourceReport::errors.
+     *
+     * @param cache Кэш метрик или nullptr, если источник нужно разобрать целиком.
+     */
+    static SourceReport analyze(const std::string &path, WorkStealingPool &pool, const RecommendationRules &rules,
+                                SleepMetricsCache *cache);
+
+    /**
+     * @brief Разбирает источник и рассчитывает метрики и архитектуру всех его ночей.
+     *
+     * Ошибки отдельных файлов каталога записываются в отчёт.
+     *
+     * @throws std::runtime_error Если файл-источник невозможно прочитать или он некорректен.
+     */
+    static void calculate(const std::string &path, SourceReport &report, WorkStealingPool &pool);
+
+    /**
+     * @brief Рассчитывает ночи источника через кэш метрик: неизменённые записи суток не разбираются.
+     *
+     * Из ночей каталога остаются те же, что и при загрузке через DataLoader::loadDirectory().
+     *
+     * @throws std::runtime_error Если файл-источник невозможно прочитать или он некорректен.
+     */
+    static void calculateCached(const std::string &path, SleepMetricsCache &cache, SourceReport &report,
+                                WorkStealingPool &pool);
+};
+
+#endif //SLEEP_VISUALIZER_SOURCEANALYZER_H
@@ -0,0 +1,257 @@
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "WorkStealingPool.h"
+#include "CohortAnalyzer.h"
+#include "SleepAnalyzer.h"
+#include "SleepMetricsCache.h"
+#include "SleepMetricsExporter.h"
+#include "RecommendationRules.h"
+#include "ReportWriter.h"
+#include "SourceAnalyzer.h"
+
+/**
+ * @file
+ * @brief Консольный пакетный анализ данных о сне без графического интерфейса.
+ *
+ * Загружает JSON-файлы и каталоги с ними, рассчитывает метрики и архитектуру сна по ночам, средние метрики
+ * и рекомендации и выводит отчёт в JSON или CSV. Источники, файлы внутри каталогов и расчёт
+ * метрик по ночам обрабатываются задачами общего пула потоков. Правила рекомендаций встроены
+ * или загружаются из файла (--rules).
+ *
+ * В режиме когорты (--cohort) участники перечисляются в манифесте, их ночи разбираются потоково
+ * и в отчёт попадают только средние метрики участников и распределения по когорте.
+ *
+ * С кэшем метрик (--cache) файлы делятся на записи суток без разбора, и разбираются только записи,
+ * которых нет в кэше, например новые ночи с прошлого запуска. Кэш перезаписывается после отчёта.
+ *
+ * Выгрузка (--export) записывает метрики и архитектуру каждой ночи каждого источника или участника
+ * в колоночный файл или CSV по мере расчёта, независимо от формата отчёта.
+ */
+
+namespace {
+
+struct Options {
+    std::vector<std::string> inputs;
+    std::string cohortManifest;
+    std::string output;
+    std::string rules;
+    std::string cache;
+    std::string exportFile;
+    ReportFormat format = ReportFormat::Json;
+    ExportFormat exportFormat = ExportFormat::Columnar;
+    std::size_t threads = 0;
+};
+
+void printUsage(std::ostream &out) {
+    out << "usage: sleep_report [--format json|csv] [--output FILE] [--threads N] [--rules FILE] [--cache FILE]\n"
+           "                    [--export FILE [--export-format columnar|csv]] PATH...\n"
+           "       sleep_report [--format json|csv] [--output FILE] [--threads N] [--rules FILE] [--cache FILE]\n"
+           "                    [--export FILE [--export-format columnar|csv]] --cohort MANIFEST\n"
+           "  PATH           JSON file or directory with JSON files\n"
+           "  -c, --cohort   analyze the users listed in MANIFEST, one \"id,path\" per line\n"
+           "  -f, --format   report format, json (default) or csv\n"
+           "  -o, --output   write the report to FILE instead of stdout\n"
+           "  -r, --rules    load recommendation rules from FILE instead of the built-in ones\n"
+           "      --cache    reuse metrics of unchanged nights from FILE and update it\n"
+           "  -e, --export   also write the metrics of every night to FILE\n"
+           "      --export-format  export format, columnar (default) or csv\n"
+           "  -j, --threads  worker threads, 0 (default) means one per hardware thread;\n"
+           "                 at most four per hardware thread\n";
+}
+
+/**
+ * Разбирает количество потоков: число без знака, не больше четырёх потоков на аппаратный поток.
+ *
+ * @throws std::invalid_argument Если значение некорректно или слишком велико.
+ */
+std::size_t parseThreadCount(const std::string &value) {
+    // std::stoul пропускает пробелы и принимает минус: "-1" превратился бы в ULONG_MAX потоков
+    std::size_t parsed = 0;
+    unsigned long threads = 0;
+    try {
+        threads = std::stoul(value, &parsed);
+    } catch (const std::exception &) {
+        parsed = 0;
+    }
+    if (parsed == 0 || parsed != value.size() || !std::isdigit(static_cast<unsigned char>(value[0]))) {
+        throw std::invalid_argument("invalid thread count: " + value);
+    }
+    const std::size_t limit = std::max(1u, std::thread::hardware_concurrency()) * std::size_t{4};
+    if (threads > limit) {
+        throw std::invalid_argument("too many threads: " + value + ", at most " + std::to_string(limit));
+    }
+    return threads;
+}
+
+/**
+ * Разбирает аргументы командной строки.
+ *
+ * @throws std::invalid_argument Если аргументы некорректны.
+ */
+Options parseOptions(int argc, char **argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        auto value = [&]() -> std::string {
+            if (i + 1 >= argc) throw std::invalid_argument("missing value for " + arg);
+            return argv[++i];
+        };
+
+        if (arg == "-f" || arg == "--format") {
+            options.format = ReportWriter::parseFormat(value());
+        } else if (arg == "-c" || arg == "--cohort") {
+            options.cohortManifest = value();
+        } else if (arg == "-o" || arg == "--output") {
+            options.output = value();
+        } else if (arg == "-r" || arg == "--rules") {
+            options.rules = value();
+        } else if (arg == "--cache") {
+            options.cache = value();
+        } else if (arg == "-e" || arg == "--export") {
+            options.exportFile = value();
+        } else if (arg == "--export-format") {
+            options.exportFormat = SleepMetricsExporter::parseFormat(value());
+        } else if (arg == "-j" || arg == "--threads") {
+            options.threads = parseThreadCount(value());
+        } else if (!arg.empty() && arg[0] == '-') {
+            throw std::invalid_argument("unknown option: " + arg);
+        } else {
+            options.inputs.push_back(arg);
+        }
+    }
+    if (!options.cohortManifest.empty() && !options.inputs.empty()) {
+        throw std::invalid_argument("input paths cannot be combined with --cohort");
+    }
+    if (options.inputs.empty() && options.cohortManifest.empty()) {
+        throw std::invalid_argument("no input files");
+    }
+    return options;
+}
+
+/**
+ * Создаёт выгрузку ночей, если она запрошена.
+ *
+ * @param users Имена источников или участников в порядке их индексов.
+ */
+std::unique_ptr<SleepMetricsExporter> openExport(const Options &options, std::vector<std::string> users) {
+    if (options.exportFile.empty()) return nullptr;
+    return std::make_unique<SleepMetricsExporter>(options.exportFile, options.exportFormat, std::move(users));
+}
+
+/**
+ * Анализирует источники из командной строки и записывает отчёт.
+ *
+ * @return false, если какой-либо источник загружен с ошибками.
+ */
+bool reportSources(const Options &options, const RecommendationRules &rules, SleepMetricsCache *cache,
+                   std::ostream &out) {
+    std::vector<std::string> fragments(options.inputs.size());
+    std::vector<std::vector<std::string>> errors(options.inputs.size());
+    const std::unique_ptr<SleepMetricsExporter> exporter = openExport(options, options.inputs);
+    {
+        WorkStealingPool pool(options.threads);
+        pool.parallelFor(options.inputs.size(), [&](std::size_t i) {
+            const SourceReport report = SourceAnalyzer::analyze(options.inputs[i], pool, rules, cache);
+            if (exporter) {
+                exporter->append(static_cast<std::uint32_t>(i), report.dates, report.nights, report.architecture);
+            }
+            fragments[i] = ReportWriter::format(report, options.format, rules);
+            errors[i] = report.errors;
+        });
+    }
+    if (exporter) exporter->close();
+
+    bool ok = true;
+    for (std::size_t i = 0; i < errors.size(); ++i) {
+        for (const auto &error: errors[i]) {
+            std::cerr << "error: " << options.inputs[i] << ": " << error << std::endl;
+            ok = false;
+        }
+    }
+    ReportWriter::write(out, fragments, options.format);
+    return ok;
+}
+
+/**
+ * Анализирует участников из манифеста когорты и записывает отчёт.
+ *
+ * @return false, если данные какого-либо участника загружены с ошибками.
+ *
+ * @throws std::runtime_error Если манифест невозможно прочитать.
+ */
+bool reportCohort(const Options &options, const RecommendationRules &rules, SleepMetricsCache *cache,
+                  std::ostream &out) {
+    const std::vector<CohortMember> members = CohortAnalyzer::loadManifest(options.cohortManifest);
+    std::vector<std::string> ids;
+    for (const auto &member: members) {
+        ids.push_back(member.id);
+    }
+    const std::unique_ptr<SleepMetricsExporter> exporter = openExport(options, std::move(ids));
+    CohortSummary cohort;
+    {
+        WorkStealingPool pool(options.threads);
+        cohort = CohortAnalyzer::analyze(members, pool, rules, cache, exporter.get());
+    }
+    if (exporter) exporter->close();
+
+    bool ok = true;
+    for (const auto &member: cohort.members) {
+        if (member.error.empty()) continue;
+        std::cerr << "error: " << member.id << ": " << member.error << std::endl;
+        ok = false;
+    }
+    ReportWriter::writeCohort(out, cohort, options.format, rules);
+    return ok;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    Options options;
+    try {
+        options = parseOptions(argc, argv);
+    } catch (const std::exception &e) {
+        std::cerr << "error: " << e.what() << std::endl;
+        printUsage(std::cerr);
+        return 2;
+    }
+
+    std::ofstream file;
+    if (!options.output.empty()) {
+        file.open(options.output, std::ios::binary);
+        if (!file) {
+            std::cerr << "error: unable to open " << options.output << std::endl;
+            return 1;
+        }
+    }
+    std::ostream &out = options.output.empty() ? std::cout : file;
+
+    bool ok;
+    try {
+        const RecommendationRules rules = options.rules.empty() ? RecommendationRules::Defaults()
+                                                                : RecommendationRules::Load(options.rules);
+        std::unique_ptr<SleepMetricsCache> cache;
+        if (!options.cache.empty()) cache = std::make_unique<SleepMetricsCache>(options.cache);
+        ok = options.cohortManifest.empty() ? reportSources(options, rules, cache.get(), out)
+                                            : reportCohort(options, rules, cache.get(), out);
+        if (cache) cache->save(options.cache);
+    } catch (const std::exception &e) {
+        std::cerr << "error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    out.flush();
+    if (!out) {
+        std::cerr << "error: failed to write the report" << std::endl;
+        return 1;
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,217 @@
+#include "Trace.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <format>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_map>
+
+namespace {
+
+/**
+ * Ячейка буфера. Запись: нечётная версия, поля, чётная версия; чтение считается удачным, если версия
+ * чётна и не изменилась за время чтения полей. Поля атомарны, чтобы одновременное чтение не было гонкой.
+ */
+struct TraceSlot {
+    std::atomic<std::uint64_t> version{0};
+    std::atomic<const char *> name{nullptr};
+    std::atomic<std::uint64_t> startNs{0};
+    std::atomic<std::uint64_t> durationNs{0};
+};
+
+/**
+ * Кольцевой буфер одного потока; пишет только поток-владелец.
+ */
+struct TraceBuffer {
+    explicit TraceBuffer(std::uint32_t id)
+            : threadId(id), slots(std::make_unique<TraceSlot[]>(Trace::kBufferCapacity)) {}
+
+    const std::uint32_t threadId;
+    std::atomic<const char *> threadName{nullptr};
+    std::atomic<std::uint64_t> written{0};  ///< Сколько событий записано за всё время
+    std::unique_ptr<TraceSlot[]> slots;
+};
+
+/**
+ * Буферы всех потоков, когда-либо писавших события. Буферы не удаляются при завершении потоков,
+ * чтобы их события попали в экспорт.
+ */
+struct TraceRegistry {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<TraceBuffer>> buffers;
+};
+
+TraceRegistry &registry() {
+    static TraceRegistry instance;
+    return instance;
+}
+
+std::chrono::steady_clock::time_point traceEpoch() {
+    static const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+    return epoch;
+}
+
+thread_local TraceBuffer *threadBuffer = nullptr;
+
+/// Имя, заданное до первой записи: буфер создаётся только для потоков, которые действительно пишут события
+thread_local const char *pendingThreadName = nullptr;
+
+TraceBuffer &currentBuffer() {
+    if (!threadBuffer) {
+        TraceRegistry &r = registry();
+        const std::lock_guard lock(r.mutex);
+        r.buffers.push_back(std::make_unique<TraceBuffer>(static_cast<std::uint32_t>(r.buffers.size() + 1)));
+        threadBuffer = r.buffers.back().get();
+        threadBuffer->threadName.store(pendingThreadName, std::memory_order_relaxed);
+    }
+    return *threadBuffer;
+}
+
+/**
+ * Экранирует строку для JSON; названия областей - литералы, но могут содержать кавычки.
+ */
+void writeJsonString(std::ostream &out, std::string_view text) {
+    out << '"';
+    for (const char c: text) {
+        if (c == '"' || c == '\\') {
+            out << '\\' << c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            out << std::format("\\u{:04x}", static_cast<unsigned>(c));
+        } else {
+            out << c;
+        }
+    }
+    out << '"';
+}
+
+double percentile(std::span<const std::uint64_t> sorted, double fraction) {
+    const auto index = static_cast<std::size_t>(std::ceil(fraction * static_cast<double>(sorted.size()))) - 1;
+    return static_cast<double>(sorted[std::min(index, sorted.size() - 1)]) / 1e6;
+}
+
+} // namespace
+
+std::uint64_t Trace::nowNs() {
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - traceEpoch()).count());
+}
+
+void Trace::record(const char *name, std::uint64_t startNs, std::uint64_t endNs) {
+    TraceBuffer &buffer = currentBuffer();
+    const std::uint64_t index = buffer.written.load(std::memory_order_relaxed);
+    TraceSlot &slot = buffer.slots[index & (kBufferCapacity - 1)];
+
+    const std::uint64_t version = slot.version.load(std::memory_order_relaxed);
+    slot.version.store(version + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.name.store(name, std::memory_order_relaxed);
+    slot.startNs.store(startNs, std::memory_order_relaxed);
+    slot.durationNs.store(endNs - startNs, std::memory_order_relaxed);
+    slot.version.store(version + 2, std::memory_order_release);
+
+    buffer.written.store(index + 1, std::memory_order_release);
+}
+
+void Trace::setThreadName(const char *name) {
+    if (threadBuffer) {
+        threadBuffer->threadName.store(name, std::memory_order_relaxed);
+    } else {
+        pendingThreadName = name;
+    }
+}
+
+std::vector<TraceEvent> Trace::collect() {
+    std::vector<TraceEvent> events;
+    TraceRegistry &r = registry();
+    const std::lock_guard lock(r.mutex);
+    for (const auto &buffer: r.buffers) {
+        const std::uint64_t written = buffer->written.load(std::memory_order_acquire);
+        const auto count = static_cast<std::size_t>(std::min<std::uint64_t>(written, kBufferCapacity));
+        events.reserve(events.size() + count);
+        for (std::size_t i = 0; i < count; ++i) {
+            const TraceSlot &slot = buffer->slots[i];
+            const std::uint64_t before = slot.version.load(std::memory_order_acquire);
+            if (before == 0 || before % 2 != 0) continue;
+            const TraceEvent event{slot.name.load(std::memory_order_relaxed), buffer->threadId,
+                                   slot.startNs.load(std::memory_order_relaxed),
+                                   slot.durationNs.load(std::memory_order_relaxed)};
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.version.load(std::memory_order_relaxed) != before) continue;
+            events.push_back(event);
+        }
+    }
+    std::sort(events.begin(), events.end(),
+              [](const TraceEvent &a, const TraceEvent &b) { return a.startNs < b.startNs; });
+    return events;
+}
+
+std::vector<TraceScopeStats> Trace::summarize(std::span<const TraceEvent> events) {
+    // одинаковые литералы из разных единиц трансляции могут иметь разные адреса, поэтому группировка по тексту
+    std::unordered_map<std::string_view, std::vector<std::uint64_t>> durations;
+    for (const TraceEvent &event: events) {
+        durations[event.name].push_back(event.durationNs);
+    }
+
+    std::vector<TraceScopeStats> stats;
+    stats.reserve(durations.size());
+    for (auto &[name, values]: durations) {
+        std::sort(values.begin(), values.end());
+        TraceScopeStats s;
+        s.name = std::string(name);
+        s.count = values.size();
+        for (const std::uint64_t value: values) s.totalMs += static_cast<double>(value) / 1e6;
+        s.p50Ms = percentile(values, 0.50);
+        s.p95Ms = percentile(values, 0.95);
+        s.p99Ms = percentile(values, 0.99);
+        s.maxMs = static_cast<double>(values.back()) / 1e6;
+        stats.push_back(std::move(s));
+    }
+    std::sort(stats.begin(), stats.end(),
+              [](const TraceScopeStats &a, const TraceScopeStats &b) { return a.totalMs > b.totalMs; });
+    return stats;
+}
+
+void Trace::writeChromeTrace(std::ostream &out) {
+    const std::vector<TraceEvent> events = collect();
+
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    {
+        TraceRegistry &r = registry();
+        const std::lock_guard lock(r.mutex);
+        for (const auto &buffer: r.buffers) {
+            const char *threadName = buffer->threadName.load(std::memory_order_relaxed);
+            if (!threadName) continue;
+            out << (first ? "\n" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+                << buffer->threadId << ",\"args\":{\"name\":";
+            writeJsonString(out, threadName);
+            out << "}}";
+            first = false;
+        }
+    }
+    for (const TraceEvent &event: events) {
+        out << (first ? "\n" : ",\n") << "{\"name\":";
+        writeJsonString(out, event.name);
+        out << std::format(",\"cat\":\"sleep\",\"ph\":\"X\",\"pid\":1,\"tid\":{},\"ts\":{:.3f},\"dur\":{:.3f}}}",
+                           event.threadId, static_cast<double>(event.startNs) / 1e3,
+                           static_cast<double>(event.durationNs) / 1e3);
+        first = false;
+    }
+    out << "\n]}\n";
+}
+
+void Trace::writeChromeTrace(const std::string &path) {
+    std::ofstream ofs(path, std::ios::binary);
+    if (!ofs.is_open()) {
+        throw std::runtime_error("unable to open file: " + path);
+    }
+    writeChromeTrace(ofs);
+    if (!ofs) {
+        throw std::runtime_error("unable to write trace: " + path);
+    }
+}
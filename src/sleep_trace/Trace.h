@@ -0,0 +1,142 @@
+/**
+ * @file Trace.h
+ * @brief Трассировка горячих участков кода: замер областей видимости, экспорт в формат Chrome trace_event.
+ */
+#ifndef SLEEP_VISUALIZER_TRACE_H
+#define SLEEP_VISUALIZER_TRACE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <span>
+#include <string>
+#include <vector>
+
+#ifndef SLEEP_TRACE_ENABLED
+#define SLEEP_TRACE_ENABLED 0
+#endif
+
+/**
+ * @brief Завершённая область трассировки.
+ */
+struct TraceEvent {
+    const char *name;          ///< Название области; строка должна жить до конца программы
+    std::uint32_t threadId;    ///< Номер потока в порядке первой записи, начиная с 1
+    std::uint64_t startNs;     ///< Начало от запуска программы, нс
+    std::uint64_t durationNs;  ///< Длительность, нс
+};
+
+/**
+ * @brief Статистика длительностей одной области за набор событий.
+ */
+struct TraceScopeStats {
+    std::string name;
+    std::size_t count = 0;
+    double totalMs = 0.0;
+    double p50Ms = 0.0;
+    double p95Ms = 0.0;
+    double p99Ms = 0.0;
+    double maxMs = 0.0;
+};
+
+/**
+ * @class Trace
+ * @brief Запись событий трассировки в кольцевые буферы потоков.
+ *
+ * Каждый поток при первой записи получает собственный кольцевой буфер на kBufferCapacity событий,
+ * поэтому запись не берёт блокировок и не выделяет память; при переполнении перезаписываются самые
+ * старые события. Каждая ячейка буфера защищена счётчиком версий (seqlock), поэтому collect() можно
+ * вызывать из любого потока во время записи: ячейки, которые в этот момент перезаписываются, пропускаются.
+ *
+ * Точки замера расставляются макросами SLEEP_TRACE_SCOPE и SLEEP_TRACE_THREAD_NAME. Без определения
+ * SLEEP_TRACE_ENABLED=1 (опция CMake SLEEP_VISUALIZER_TRACING) макросы не порождают кода.
+ */
+class Trace {
+public:
+    Trace() = delete;
+
+    /// Вставлены ли точки замера в эту сборку.
+    static constexpr bool kCompiledIn = SLEEP_TRACE_ENABLED != 0;
+
+    /// Вместимость буфера одного потока, событий.
+    static constexpr std::size_t kBufferCapacity = 1 << 14;
+
+    /**
+     * @brief Время от запуска программы по монотонным часам, нс.
+     */
+    static std::uint64_t nowNs();
+
+    /**
+     * @brief Записывает завершённую область в буфер текущего потока.
+     *
+     * @param name Название области; указатель сохраняется, поэтому обычно это строковый литерал.
+     */
+    static void record(const char *name, std::uint64_t startNs, std::uint64_t endNs);
+
+    /**
+     * @brief Задаёт имя текущего потока для экспорта.
+     *
+     * @param name Имя; указатель сохраняется, поэтому обычно это строковый литерал.
+     */
+    static void setThreadName(const char *name);
+
+    /**
+     * @brief Собирает события из буферов всех потоков.
+     *
+     * @return События, упорядоченные по началу.
+     */
+    static std::vector<TraceEvent> collect();
+
+    /**
+     * @brief Рассчитывает перцентили длительностей по областям.
+     *
+     * @return Статистика по областям в порядке убывания суммарного времени.
+     */
+    static std::vector<TraceScopeStats> summarize(std::span<const TraceEvent> events);
+
+    /**
+     * @brief Записывает все собранные события в формате Chrome trace_event (chrome://tracing, Perfetto).
+     */
+    static void writeChromeTrace(std::ostream &out);
+
+    /**
+     * @brief Записывает все собранные события в файл в формате Chrome trace_event.
+     *
+     * @throws std::runtime_error Если файл невозможно записать.
+     */
+    static void writeChromeTrace(const std::string &path);
+};
+
+/**
+ * @class TraceScope
+ * @brief Записывает область от создания объекта до его уничтожения.
+ */
+class TraceScope {
+public:
+    explicit TraceScope(const char *name) : name_(name), startNs_(Trace::nowNs()) {}
+
+    ~TraceScope() { Trace::record(name_, startNs_, Trace::nowNs()); }
+
+    TraceScope(const TraceScope &) = delete;
+
+    TraceScope &operator=(const TraceScope &) = delete;
+
+private:
+    const char *name_;
+    std::uint64_t startNs_;
+};
+
+#define SLEEP_TRACE_CONCAT_IMPL(a, b) a##b
+#define SLEEP_TRACE_CONCAT(a, b) SLEEP_TRACE_CONCAT_IMPL(a, b)
+
+#if SLEEP_TRACE_ENABLED
+/// Замеряет область видимости до её конца.
+#define SLEEP_TRACE_SCOPE(name) const TraceScope SLEEP_TRACE_CONCAT(sleepTraceScope, __LINE__)(name)
+/// Задаёт имя текущего потока в трассе.
+#define SLEEP_TRACE_THREAD_NAME(name) Trace::setThreadName(name)
+#else
+#define SLEEP_TRACE_SCOPE(name) static_cast<void>(0)
+#define SLEEP_TRACE_THREAD_NAME(name) static_cast<void>(0)
+#endif
+
+#endif //SLEEP_VISUALIZER_TRACE_H
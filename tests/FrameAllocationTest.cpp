@@ -0,0 +1,87 @@
+#include "doctest.h"
+#include "AllocationCounter.h"
+#include "SleepAnalyzer.h"
+#include "SyntheticHistory.h"
+#include "Visualization.h"
+#include "imgui.h"
+#include "implot.h"
+#include <vector>
+
+namespace {
+
+/**
+ * Контекст ImGui без окна и графического API, как в замерах кадра sleep_bench.
+ */
+class HeadlessGui {
+public:
+    HeadlessGui() {
+        ImGui::CreateContext();
+        ImPlot::CreateContext();
+
+        ImGuiIO &io = ImGui::GetIO();
+        io.IniFilename = nullptr;
+        io.DisplaySize = {1280.0f, 720.0f};
+        io.DeltaTime = 1.0f / 60.0f;
+        unsigned char *pixels = nullptr;
+        int width = 0, height = 0;
+        io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);
+
+        const ImVec4 colors[] = {
+                {0.42f, 0.79f, 0.47f, 1.0f},
+                {0.30f, 0.59f, 1.0f,  1.0f},
+                {0.65f, 0.42f, 1.0f,  1.0f},
+                {1.0f,  0.42f, 0.42f, 1.0f},
+        };
+        ImPlot::AddColormap("MySleepPalette", colors, 4);
+    }
+
+    ~HeadlessGui() {
+        ImPlot::DestroyContext();
+        ImGui::DestroyContext();
+    }
+
+    HeadlessGui(const HeadlessGui &) = delete;
+
+    HeadlessGui &operator=(const HeadlessGui &) = delete;
+
+    template<typename Draw>
+    void frame(Draw &&draw) {
+        ImGui::NewFrame();
+        draw();
+        ImGui::Render();
+    }
+};
+
+} // namespace
+
+TEST_CASE("steady-state Visualization frame does not allocate") {
+    SyntheticHistoryOptions options;
+    options.seed = 31;
+    options.nights = 2;
+    options.minPhases = 400;
+    options.maxPhases = 400;
+    options.minPhaseSeconds = 30;
+    options.maxPhaseSeconds = 120;
+    const std::vector<DailySleepData> nights = SyntheticHistory::generate(options);
+    const SleepMetrics metrics[] = {SleepAnalyzer::CalculateDailyMetrics(nights[0]),
+                                    SleepAnalyzer::CalculateDailyMetrics(nights[1])};
+
+    HeadlessGui gui;
+    constexpr int frames = 200;
+    const auto allocationsPerFrame = [&](bool alternate) {
+        const AllocationScope allocations;
+        for (int i = 0; i < frames; ++i) {
+            const int night = alternate ? i & 1 : 0;
+            gui.frame([&] {
+                Visualization::ShowDailyPhasesPlot(nights[night]);
+                Visualization::ShowMetricsSummary(metrics[night], false);
+            });
+        }
+        return allocations.allocations();
+    };
+
+    // прогрев: кэши графиков и буферы подписей получают нужный размер для обеих ночей
+    allocationsPerFrame(true);
+    CHECK(allocationsPerFrame(false) == 0);
+    CHECK(allocationsPerFrame(true) == 0);
+}
@@ -0,0 +1,89 @@
+#include "doctest.h"
+#include "DateTimeParser.h"
+#include "RollingMetrics.h"
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+constexpr std::int64_t kSecondsPerDay = 86400;
+
+DateTime noonOf(std::int64_t utcDay) {
+    return DateTime(std::chrono::seconds(utcDay * kSecondsPerDay + kSecondsPerDay / 2));
+}
+
+SleepMetrics randomMetrics(std::mt19937 &random) {
+    std::uniform_int_distribution<int> minutes(0, 600);
+    std::uniform_real_distribution<double> percent(0.0, 100.0);
+    return {minutes(random), minutes(random), minutes(random), minutes(random) % 20,
+            minutes(random), minutes(random), minutes(random), minutes(random),
+            percent(random), percent(random), percent(random), percent(random)};
+}
+
+/// Суммы окна, собранные заново по всем ночам с локальными датами из (latestDay - days, latestDay].
+SleepMetricsTotals recompute(const std::map<std::int64_t, SleepMetrics> &nights, std::int64_t latestDay, int days) {
+    SleepMetricsTotals totals;
+    for (const auto &[day, metrics]: nights) {
+        if (day > latestDay - days && day <= latestDay) totals.add(metrics);
+    }
+    return totals;
+}
+
+} // namespace
+
+TEST_CASE("RollingMetrics matches totals recomputed from scratch") {
+    const std::vector<int> windows{7, 30, 90, 365};
+    RollingMetrics rolling(windows);
+
+    // ночи по локальному номеру дня, как их видит RollingMetrics
+    std::map<std::int64_t, SleepMetrics> nights;
+    std::int64_t latestUtcDay = 20000;
+    std::int64_t latestDay = 0;
+    bool started = false;
+
+    std::mt19937 random(7);
+    std::uniform_int_distribution<int> operation(0, 9);
+    for (int step = 0; step < 20000; ++step) {
+        const int kind = operation(random);
+        std::int64_t utcDay;
+        if (kind < 5) {
+            // следующая ночь, иногда с пропуском дней
+            latestUtcDay += std::uniform_int_distribution<int>(1, kind == 0 ? 40 : 2)(random);
+            utcDay = latestUtcDay;
+        } else {
+            // исправление, удаление или ночь старше самого большого окна
+            utcDay = latestUtcDay - std::uniform_int_distribution<int>(0, 400)(random);
+        }
+        const DateTime date = noonOf(utcDay);
+        const std::int64_t day = DateTimeParser::localDayNumber(utcDay * kSecondsPerDay + kSecondsPerDay / 2);
+
+        if (kind < 8) {
+            const SleepMetrics metrics = randomMetrics(random);
+            rolling.push(date, metrics);
+            if (!started || day > latestDay) {
+                latestDay = day;
+                started = true;
+                nights.erase(nights.begin(), nights.lower_bound(latestDay - windows.back() + 1));
+            }
+            if (day > latestDay - windows.back()) nights[day] = metrics;
+        } else {
+            const bool present = nights.erase(day) > 0 && day > latestDay - windows.back();
+            CHECK(rolling.retract(date) == present);
+        }
+
+        for (std::size_t w = 0; w < windows.size(); ++w) {
+            const SleepMetricsTotals expected = recompute(nights, latestDay, windows[w]);
+            REQUIRE(rolling.totals(w).nights == expected.nights);
+            REQUIRE(rolling.average(w) == expected.average());
+        }
+    }
+}
+
+TEST_CASE("RollingMetrics rejects empty and non-positive windows") {
+    CHECK_THROWS_AS(RollingMetrics(std::vector<int>{}), std::invalid_argument);
+    CHECK_THROWS_AS(RollingMetrics(std::vector<int>{7, 0}), std::invalid_argument);
+}
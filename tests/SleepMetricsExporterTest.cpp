@@ -0,0 +1,301 @@
+#include "doctest.h"
+#include "SleepMetricsExporter.h"
+#include "SyntheticHistory.h"
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+/// Строка выгрузки в том виде, в каком её читает тест
+struct ExportRow {
+    std::uint32_t user = 0;
+    std::int64_t date = 0;
+    std::vector<std::int64_t> integers; ///< Целые колонки метрик и архитектуры в порядке файла
+    std::vector<double> reals;          ///< Вещественные колонки в порядке файла
+
+    bool operator==(const ExportRow &) const = default;
+};
+
+struct UserNights {
+    std::vector<std::int64_t> dates;
+    std::vector<SleepMetrics> nights;
+    std::vector<SleepArchitecture> architecture;
+};
+
+ExportRow expectedRow(std::uint32_t user, std::int64_t date, const SleepMetrics &m, const SleepArchitecture &a) {
+    return {user, date,
+            {m.timeInBed, m.totalSleepTime, m.sleepOnset, m.awakeningsCount, m.awakeDuration, m.deepSleepDuration,
+             m.remSleepDuration, m.lightSleepDuration, a.sleepOnsetLatency, a.remLatency, a.waso, a.cycleCount,
+             a.stageShifts},
+            {m.lightSleepPercent, m.deepSleepPercent, m.remSleepPercent, m.efficiency, a.meanCycleLength(),
+             a.fragmentationIndex}};
+}
+
+std::string readFile(const std::string &path) {
+    std::ifstream in(path, std::ios::binary);
+    return {std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+}
+
+template<typename T>
+T readAt(const std::string &file, std::uint64_t offset) {
+    REQUIRE(offset + sizeof(T) <= file.size());
+    T value;
+    std::memcpy(&value, file.data() + offset, sizeof(T));
+    return value;
+}
+
+struct ColumnarFile {
+    std::vector<std::string> users;
+    std::vector<std::uint64_t> groupRows;
+    std::vector<ExportRow> rows;
+};
+
+/**
+ * Читает колоночный файл, начиная с концевика, как описано в SleepMetricsExporter.h.
+ */
+ColumnarFile readColumnar(const std::string &path) {
+    const std::string file = readFile(path);
+    REQUIRE(file.size() >= 16 + 40);
+    REQUIRE(std::memcmp(file.data(), "SLPCOLS", 8) == 0);
+    const auto columnCount = readAt<std::uint32_t>(file, 12);
+    REQUIRE(columnCount == 21);
+
+    std::vector<std::string> names(columnCount);
+    std::vector<std::uint32_t> types(columnCount), widths(columnCount);
+    for (std::uint32_t c = 0; c < columnCount; ++c) {
+        const std::uint64_t descriptor = 16 + c * 32;
+        names[c] = std::string(file.data() + descriptor, strnlen(file.data() + descriptor, 24));
+        types[c] = readAt<std::uint32_t>(file, descriptor + 24);
+        widths[c] = readAt<std::uint32_t>(file, descriptor + 28);
+    }
+    CHECK(names[0] == "user");
+    CHECK(names[1] == "date");
+
+    const std::uint64_t trailer = file.size() - 40;
+    REQUIRE(std::memcmp(file.data() + trailer + 32, "SLPCOLS", 8) == 0);
+    const auto indexOffset = readAt<std::uint64_t>(file, trailer);
+    const auto groupCount = readAt<std::uint64_t>(file, trailer + 8);
+    const auto rowCount = readAt<std::uint64_t>(file, trailer + 16);
+    const auto userCount = readAt<std::uint64_t>(file, trailer + 24);
+
+    ColumnarFile result;
+    std::uint64_t cursor = indexOffset + groupCount * 16;
+    for (std::uint64_t u = 0; u < userCount; ++u) {
+        const auto length = readAt<std::uint32_t>(file, cursor);
+        REQUIRE(cursor + 4 + length <= trailer);
+        result.users.emplace_back(file.data() + cursor + 4, length);
+        cursor += 4 + length;
+    }
+
+    for (std::uint64_t g = 0; g < groupCount; ++g) {
+        const auto groupOffset = readAt<std::uint64_t>(file, indexOffset + g * 16);
+        const auto groupRows = readAt<std::uint64_t>(file, indexOffset + g * 16 + 8);
+        REQUIRE(readAt<std::uint64_t>(file, groupOffset) == groupRows);
+        result.groupRows.push_back(groupRows);
+
+        std::vector<std::uint64_t> columnOffsets(columnCount);
+        std::uint64_t offset = groupOffset + 8;
+        for (std::uint32_t c = 0; c < columnCount; ++c) {
+            columnOffsets[c] = offset;
+            offset += (groupRows * widths[c] + 7) / 8 * 8;
+        }
+        for (std::uint64_t r = 0; r < groupRows; ++r) {
+            ExportRow row;
+            for (std::uint32_t c = 0; c < columnCount; ++c) {
+                const std::uint64_t at = columnOffsets[c] + r * widths[c];
+                switch (types[c]) {
+                    case 1:
+                        row.user = readAt<std::uint32_t>(file, at);
+                        break;
+                    case 2:
+                        row.integers.push_back(readAt<std::int32_t>(file, at));
+                        break;
+                    case 3:
+                        row.date = readAt<std::int64_t>(file, at);
+                        break;
+                    default:
+                        row.reals.push_back(readAt<double>(file, at));
+                }
+            }
+            result.rows.push_back(std::move(row));
+        }
+    }
+    CHECK(result.rows.size() == rowCount);
+    return result;
+}
+
+std::vector<std::string> splitCsv(const std::string &line) {
+    std::vector<std::string> fields;
+    std::string field;
+    bool quoted = false;
+    for (std::size_t i = 0; i < line.size(); ++i) {
+        const char c = line[i];
+        if (quoted) {
+            if (c == '"' && i + 1 < line.size() && line[i + 1] == '"') {
+                field += '"';
+                ++i;
+            } else if (c == '"') {
+                quoted = false;
+            } else {
+                field += c;
+            }
+        } else if (c == '"') {
+            quoted = true;
+        } else if (c == ',') {
+            fields.push_back(std::move(field));
+            field.clear();
+        } else {
+            field += c;
+        }
+    }
+    fields.push_back(std::move(field));
+    return fields;
+}
+
+/// Локальная дата в виде ГГГГ-ММ-ДД через C-библиотеку, независимо от DateTimeParser
+std::string localDate(std::int64_t seconds) {
+    const auto time = static_cast<std::time_t>(seconds);
+    const std::tm local = *std::localtime(&time);
+    char text[16];
+    return {text, std::strftime(text, sizeof(text), "%Y-%m-%d", &local)};
+}
+
+template<typename T>
+T parseField(const std::string &field) {
+    T value{};
+    const auto [end, ec] = std::from_chars(field.data(), field.data() + field.size(), value);
+    CHECK(ec == std::errc());
+    CHECK(end == field.data() + field.size());
+    return value;
+}
+
+const std::vector<std::string> kUsers = {"alice", "bob \"the\" sleeper", "carol, jr"};
+
+/// Истории пользователей разной длины, чтобы группы строк не совпадали с границами вызовов append()
+std::vector<UserNights> userNights() {
+    std::vector<UserNights> users(kUsers.size());
+    for (std::size_t u = 0; u < users.size(); ++u) {
+        SyntheticHistoryOptions options;
+        options.seed = static_cast<std::uint32_t>(17 + u);
+        options.nights = 23 + 11 * u;
+        for (const DailySleepData &day: SyntheticHistory::generate(options)) {
+            users[u].dates.push_back(std::chrono::duration_cast<std::chrono::seconds>(
+                    day.date.time_since_epoch()).count());
+            users[u].nights.push_back(SleepAnalyzer::CalculateDailyMetrics(day));
+            users[u].architecture.push_back(SleepAnalyzer::CalculateArchitecture(day));
+        }
+    }
+    return users;
+}
+
+/// Добавляет ночи каждого пользователя двумя вызовами append()
+std::vector<ExportRow> appendAll(SleepMetricsExporter &exporter, const std::vector<UserNights> &users) {
+    std::vector<ExportRow> expected;
+    for (std::uint32_t u = 0; u < users.size(); ++u) {
+        const UserNights &user = users[u];
+        const std::size_t half = user.nights.size() / 2;
+        for (const auto &[first, count]: {std::pair{std::size_t{0}, half},
+                                          std::pair{half, user.nights.size() - half}}) {
+            exporter.append(u, std::span(user.dates).subspan(first, count),
+                            std::span(user.nights).subspan(first, count),
+                            std::span(user.architecture).subspan(first, count));
+            for (std::size_t i = first; i < first + count; ++i) {
+                expected.push_back(expectedRow(u, user.dates[i], user.nights[i], user.architecture[i]));
+            }
+        }
+    }
+    return expected;
+}
+
+std::string exportPath(const char *name) {
+    return (std::filesystem::temp_directory_path() / (std::string("sleep_tests_") + name)).string();
+}
+
+} // namespace
+
+TEST_CASE("columnar export round-trips through several row groups") {
+    const std::vector<UserNights> users = userNights();
+    const std::string path = exportPath("export.col");
+    constexpr std::size_t rowGroupSize = 8;
+
+    SleepMetricsExporter exporter(path, ExportFormat::Columnar, kUsers, rowGroupSize);
+    const std::vector<ExportRow> expected = appendAll(exporter, users);
+    exporter.close();
+    CHECK(exporter.rows() == expected.size());
+
+    const ColumnarFile file = readColumnar(path);
+    std::filesystem::remove(path);
+    CHECK(file.users == kUsers);
+    REQUIRE(file.groupRows.size() == (expected.size() + rowGroupSize - 1) / rowGroupSize);
+    for (std::size_t g = 0; g + 1 < file.groupRows.size(); ++g) {
+        CHECK(file.groupRows[g] == rowGroupSize);
+    }
+    REQUIRE(file.rows.size() == expected.size());
+    for (std::size_t i = 0; i < expected.size(); ++i) {
+        CHECK(file.rows[i] == expected[i]);
+    }
+}
+
+TEST_CASE("CSV export round-trips and keeps the rows of one append together") {
+    const std::vector<UserNights> users = userNights();
+    const std::string path = exportPath("export.csv");
+
+    SleepMetricsExporter exporter(path, ExportFormat::Csv, kUsers, 8);
+    // пользователи добавляются из разных потоков: порядок вызовов не определён, но строки вызова идут подряд
+    std::vector<std::thread> threads;
+    for (std::uint32_t u = 0; u < users.size(); ++u) {
+        threads.emplace_back([&, u] {
+            exporter.append(u, users[u].dates, users[u].nights, users[u].architecture);
+        });
+    }
+    for (auto &thread: threads) {
+        thread.join();
+    }
+    exporter.close();
+
+    std::istringstream csv(readFile(path));
+    std::filesystem::remove(path);
+    std::string line;
+    REQUIRE(std::getline(csv, line));
+    CHECK(line.rfind("user,date,timeInBed,", 0) == 0);
+
+    std::vector<std::size_t> nextNight(users.size(), 0);
+    std::size_t previousUser = users.size();
+    std::size_t rows = 0;
+    while (std::getline(csv, line)) {
+        const std::vector<std::string> fields = splitCsv(line);
+        REQUIRE(fields.size() == 21);
+        std::size_t u = 0;
+        while (u < kUsers.size() && kUsers[u] != fields[0]) ++u;
+        REQUIRE(u < kUsers.size());
+        // строки пользователя начинаются только после того, как закончились строки предыдущего
+        if (u != previousUser) CHECK(nextNight[u] == 0);
+        previousUser = u;
+
+        const std::size_t n = nextNight[u]++;
+        REQUIRE(n < users[u].nights.size());
+        CHECK(fields[1] == localDate(users[u].dates[n]));
+        const ExportRow expected = expectedRow(static_cast<std::uint32_t>(u), users[u].dates[n], users[u].nights[n],
+                                               users[u].architecture[n]);
+        ExportRow row{static_cast<std::uint32_t>(u), users[u].dates[n], {}, {}};
+        const std::size_t integerColumns[] = {2, 3, 4, 5, 6, 7, 8, 9, 14, 15, 16, 17, 19};
+        const std::size_t realColumns[] = {10, 11, 12, 13, 18, 20};
+        for (std::size_t c: integerColumns) row.integers.push_back(parseField<std::int64_t>(fields[c]));
+        for (std::size_t c: realColumns) row.reals.push_back(parseField<double>(fields[c]));
+        CHECK(row == expected);
+        ++rows;
+    }
+    for (std::size_t u = 0; u < users.size(); ++u) {
+        CHECK(nextNight[u] == users[u].nights.size());
+    }
+    CHECK(rows == exporter.rows());
+}
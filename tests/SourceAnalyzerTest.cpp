@@ -0,0 +1,301 @@
+#include "doctest.h"
+#include "SleepMetricsCache.h"
+#include "SourceAnalyzer.h"
+#include "SyntheticHistory.h"
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+/**
+ * Временный каталог с входными файлами; удаляется вместе с содержимым.
+ */
+class TempDirectory {
+public:
+    explicit TempDirectory(const std::string &name)
+            : path_(std::filesystem::temp_directory_path() / ("sleep_tests_" + name)) {
+        std::filesystem::remove_all(path_);
+        std::filesystem::create_directories(path_);
+    }
+
+    ~TempDirectory() {
+        std::error_code ec;
+        std::filesystem::remove_all(path_, ec);
+    }
+
+    TempDirectory(const TempDirectory &) = delete;
+
+    TempDirectory &operator=(const TempDirectory &) = delete;
+
+    std::string write(const std::string &name, const std::string &text) const {
+        const std::filesystem::path file = path_ / name;
+        std::ofstream(file, std::ios::binary) << text;
+        return file.string();
+    }
+
+    [[nodiscard]] std::string path() const { return path_.string(); }
+
+private:
+    std::filesystem::path path_;
+};
+
+std::string night(const std::string &date, const std::string &bedtime, const std::string &wakeTime,
+                  const std::string &deepEnd) {
+    return "{\"date\": \"" + date + "\", \"bedtime\": \"" + bedtime + "\", \"wake_time\": \"" + wakeTime +
+           "\", \"phases\": [{\"type\": \"Light\", \"start\": \"" + bedtime + "\", \"end\": \"" + deepEnd +
+           "\"}, {\"type\": \"Deep\", \"start\": \"" + deepEnd + "\", \"end\": \"" + wakeTime + "\"}]}";
+}
+
+/// Файл ошибки без текста сообщения: тексты ошибок разбора у двух путей различаются
+std::vector<std::string> erroredFiles(const SourceReport &report) {
+    std::vector<std::string> files;
+    for (const auto &error: report.errors) {
+        files.push_back(error.substr(0, error.find(": ")));
+    }
+    return files;
+}
+
+void checkSameNights(const SourceReport &plain, const SourceReport &cached) {
+    REQUIRE(plain.dates == cached.dates);
+    REQUIRE(plain.nights.size() == cached.nights.size());
+    REQUIRE(plain.architecture.size() == cached.architecture.size());
+    for (std::size_t i = 0; i < plain.nights.size(); ++i) {
+        CHECK(plain.nights[i] == cached.nights[i]);
+        CHECK(plain.architecture[i] == cached.architecture[i]);
+    }
+    CHECK(erroredFiles(plain) == erroredFiles(cached));
+}
+
+std::string readBytes(const std::string &path) {
+    std::ifstream in(path, std::ios::binary);
+    return {std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+}
+
+void writeBytes(const std::string &path, const std::string &bytes) {
+    std::ofstream(path, std::ios::binary | std::ios::trunc) << bytes;
+}
+
+/// Ночи синтетической истории с ключами по номеру записи
+std::vector<std::pair<std::uint64_t, NightMetrics>> cacheEntries() {
+    SyntheticHistoryOptions options;
+    options.seed = 41;
+    options.nights = 40;
+    std::vector<std::pair<std::uint64_t, NightMetrics>> entries;
+    for (const DailySleepData &day: SyntheticHistory::generate(options)) {
+        NightMetrics night;
+        night.date = std::chrono::duration_cast<std::chrono::seconds>(day.date.time_since_epoch()).count();
+        night.bedtime = std::chrono::duration_cast<std::chrono::seconds>(day.bedtime.time_since_epoch()).count();
+        night.wakeTime = std::chrono::duration_cast<std::chrono::seconds>(day.wakeTime.time_since_epoch()).count();
+        night.metrics = SleepAnalyzer::CalculateDailyMetrics(day);
+        night.architecture = SleepAnalyzer::CalculateArchitecture(day);
+        entries.emplace_back(SleepMetricsCache::Key("record " + std::to_string(entries.size())), night);
+    }
+    return entries;
+}
+
+void checkSameNight(const NightMetrics &expected, const NightMetrics &actual) {
+    CHECK(actual.date == expected.date);
+    CHECK(actual.bedtime == expected.bedtime);
+    CHECK(actual.wakeTime == expected.wakeTime);
+    CHECK(actual.metrics == expected.metrics);
+    CHECK(actual.architecture == expected.architecture);
+}
+
+/// Кэш из файла пуст и ничего не находит
+void checkEmptyCache(const std::string &path, const std::vector<std::pair<std::uint64_t, NightMetrics>> &entries) {
+    SleepMetricsCache cache(path);
+    CHECK(cache.size() == 0);
+    NightMetrics night;
+    for (const auto &[key, expected]: entries) {
+        CHECK_FALSE(cache.find(key, night));
+    }
+}
+
+/**
+ * Рассчитывает источник без кэша, затем через пустой и через заполненный кэш, и сравнивает ночи.
+ */
+void checkCachedMatchesPlain(const std::string &path) {
+    WorkStealingPool pool(2);
+    SourceReport plain;
+    SourceAnalyzer::calculate(path, plain, pool);
+
+    SleepMetricsCache cache;
+    for (int pass = 0; pass < 2; ++pass) {
+        SourceReport cached;
+        SourceAnalyzer::calculateCached(path, cache, cached, pool);
+        checkSameNights(plain, cached);
+    }
+    // второй проход берёт из кэша каждую ночь отчёта
+    CHECK(cache.hits() >= plain.nights.size());
+}
+
+} // namespace
+
+TEST_CASE("cached and plain source paths agree on valid input") {
+    TempDirectory directory("valid");
+    SyntheticHistoryOptions options;
+    options.seed = 5;
+    options.users = 3;
+    options.nights = 120;
+    SyntheticHistory::writeUsers(directory.path(), options);
+
+    checkCachedMatchesPlain(directory.path());
+    checkCachedMatchesPlain((std::filesystem::path(directory.path()) / "user_0.json").string());
+}
+
+TEST_CASE("cached and plain source paths agree on duplicate nights") {
+    TempDirectory directory("duplicates");
+    const std::string first = night("2024-03-01", "2024-03-01 23:00:00", "2024-03-02 07:00:00",
+                                    "2024-03-02 01:00:00");
+    const std::string second = night("2024-03-02", "2024-03-02 23:30:00", "2024-03-03 06:30:00",
+                                     "2024-03-03 02:00:00");
+    // та же дата с другими фазами, и ночь, перекрывающая ночь другого файла
+    const std::string sameDate = night("2024-03-01", "2024-03-01 22:00:00", "2024-03-02 06:00:00",
+                                       "2024-03-02 03:00:00");
+    const std::string overlapping = night("2024-03-03", "2024-03-03 05:00:00", "2024-03-03 09:00:00",
+                                          "2024-03-03 06:00:00");
+    directory.write("a.json", "[" + first + "," + second + "]");
+    directory.write("b.json", "[" + sameDate + "," + overlapping + "]");
+    checkCachedMatchesPlain(directory.path());
+
+    // в одном файле ночи берутся как есть, в том числе повторы
+    TempDirectory singleFile("duplicates_single");
+    checkCachedMatchesPlain(singleFile.write("night.json", "[" + first + "," + sameDate + "," + first + "]"));
+}
+
+TEST_CASE("cached and plain source paths agree on malformed input") {
+    TempDirectory directory("malformed");
+    const std::string valid = night("2024-04-01", "2024-04-01 23:00:00", "2024-04-02 07:00:00",
+                                    "2024-04-02 01:00:00");
+    const std::string badDate = night("2024-04-02", "garbage", "2024-04-03 07:00:00", "2024-04-03 01:00:00");
+    directory.write("good.json", "[" + valid + "]");
+    directory.write("broken.json", "[" + valid + ",");
+    directory.write("bad_record.json", "[" + valid + "," + badDate + "]");
+    directory.write("not_array.json", "{\"date\": \"2024-04-01\"}");
+
+    WorkStealingPool pool(2);
+    SourceReport plain;
+    SourceAnalyzer::calculate(directory.path(), plain, pool);
+    CHECK(plain.nights.size() == 1);
+    CHECK(plain.errors.size() == 3);
+    checkCachedMatchesPlain(directory.path());
+
+    // повреждённый файл-источник - ошибка обоих путей
+    for (const char *name: {"broken.json", "bad_record.json", "not_array.json"}) {
+        const std::string file = (std::filesystem::path(directory.path()) / name).string();
+        SourceReport report;
+        SleepMetricsCache cache;
+        CHECK_THROWS_AS(SourceAnalyzer::calculate(file, report, pool), std::runtime_error);
+        CHECK_THROWS_AS(SourceAnalyzer::calculateCached(file, cache, report, pool), std::runtime_error);
+    }
+}
+
+TEST_CASE("metrics cache round-trips through its file") {
+    const TempDirectory directory("metrics_cache");
+    const std::string path = directory.path() + "/metrics.cache";
+    const auto entries = cacheEntries();
+    {
+        SleepMetricsCache cache;
+        for (const auto &[key, night]: entries) {
+            cache.insert(key, night);
+        }
+        cache.save(path);
+    }
+
+    SleepMetricsCache loaded(path);
+    CHECK(loaded.size() == entries.size());
+    for (const auto &[key, expected]: entries) {
+        NightMetrics night;
+        REQUIRE(loaded.find(key, night));
+        checkSameNight(expected, night);
+    }
+    CHECK(loaded.hits() == entries.size());
+    NightMetrics night;
+    CHECK_FALSE(loaded.find(SleepMetricsCache::Key("missing record"), night));
+
+    // повторное сохранение записывает только найденные записи, и файл снова читается
+    SleepMetricsCache partial(path);
+    for (std::size_t i = 0; i < entries.size(); i += 2) {
+        REQUIRE(partial.find(entries[i].first, night));
+    }
+    partial.save(path);
+    SleepMetricsCache reloaded(path);
+    CHECK(reloaded.size() == (entries.size() + 1) / 2);
+    for (std::size_t i = 0; i < entries.size(); ++i) {
+        CHECK(reloaded.find(entries[i].first, night) == (i % 2 == 0));
+        if (i % 2 == 0) checkSameNight(entries[i].second, night);
+    }
+}
+
+TEST_CASE("metrics cache rejects files of another version or time zone and damaged files") {
+    const TempDirectory directory("metrics_cache_invalid");
+    const std::string path = directory.path() + "/metrics.cache";
+    const auto entries = cacheEntries();
+    {
+        SleepMetricsCache cache;
+        for (const auto &[key, night]: entries) {
+            cache.insert(key, night);
+        }
+        cache.save(path);
+    }
+    const std::string valid = readBytes(path);
+    REQUIRE(SleepMetricsCache(path).size() == entries.size());
+
+    // поля заголовка: магия (8 байт), версия формата, версия расчёта, размеры заголовка и записи (uint32),
+    // число записей, контрольная сумма и хеш правил часового пояса (uint64)
+    constexpr std::size_t analyzerVersionOffset = 12;
+    constexpr std::size_t entryCountOffset = 24;
+    constexpr std::size_t zoneFingerprintOffset = 40;
+    constexpr std::size_t headerSize = 48;
+    REQUIRE(valid.size() > headerSize);
+
+    auto patched = [&](std::size_t offset, const auto &value) {
+        std::string bytes = valid;
+        std::memcpy(bytes.data() + offset, &value, sizeof(value));
+        return bytes;
+    };
+
+    {
+        // другая версия расчёта
+        writeBytes(path, patched(analyzerVersionOffset, std::uint32_t{SleepAnalyzer::kVersion + 1}));
+        checkEmptyCache(path, entries);
+    }
+    {
+        // другой часовой пояс
+        std::uint64_t fingerprint = 0;
+        std::memcpy(&fingerprint, valid.data() + zoneFingerprintOffset, sizeof(fingerprint));
+        writeBytes(path, patched(zoneFingerprintOffset, fingerprint ^ 1));
+        checkEmptyCache(path, entries);
+    }
+    {
+        // обрезанный файл
+        for (const std::size_t size: {std::size_t{0}, std::size_t{5}, headerSize - 1, headerSize, valid.size() / 2,
+                                      valid.size() - 1}) {
+            writeBytes(path, valid.substr(0, size));
+            checkEmptyCache(path, entries);
+        }
+    }
+    {
+        // испорченная запись
+        std::string bytes = valid;
+        bytes[headerSize + (bytes.size() - headerSize) / 2] ^= 0x5A;
+        writeBytes(path, bytes);
+        checkEmptyCache(path, entries);
+    }
+    {
+        // число записей больше, чем в файле
+        writeBytes(path, patched(entryCountOffset, std::uint64_t{1} << 60));
+        checkEmptyCache(path, entries);
+    }
+    {
+        // файл не является кэшем
+        writeBytes(path, std::string(valid.size(), 'x'));
+        checkEmptyCache(path, entries);
+    }
+}
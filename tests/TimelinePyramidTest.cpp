@@ -0,0 +1,123 @@
+#include "doctest.h"
+#include "TimelinePyramid.h"
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace {
+
+/**
+ * Колонки ночей с одинаковым набором фаз; ночь i начинается в bedtimes[i].
+ */
+struct Nights {
+    std::vector<std::int64_t> bedtimes;
+    std::vector<std::int64_t> wakeTimes;
+    std::vector<std::uint32_t> offsets{0};
+    std::vector<std::uint8_t> types;
+    std::vector<std::int32_t> starts;
+    std::vector<std::int32_t> durations;
+
+    explicit Nights(std::vector<std::int64_t> nightBedtimes) : bedtimes(std::move(nightBedtimes)) {
+        const std::array<std::pair<SleepPhaseType, std::int32_t>, 6> phases = {{
+                {SleepPhaseType::Awake, 600}, {SleepPhaseType::Light, 3000}, {SleepPhaseType::Deep, 2400},
+                {SleepPhaseType::REM, 1500}, {SleepPhaseType::Light, 4200}, {SleepPhaseType::Awake, 900}}};
+        for (std::int64_t bedtime: bedtimes) {
+            std::int32_t start = 0;
+            for (const auto &[type, duration]: phases) {
+                types.push_back(static_cast<std::uint8_t>(type));
+                starts.push_back(start);
+                durations.push_back(duration);
+                start += duration;
+            }
+            wakeTimes.push_back(bedtime + start);
+            offsets.push_back(static_cast<std::uint32_t>(types.size()));
+        }
+    }
+
+    [[nodiscard]] SleepPhaseColumns columns() const {
+        SleepPhaseColumns columns;
+        columns.dates = bedtimes;
+        columns.bedtimes = bedtimes;
+        columns.wakeTimes = wakeTimes;
+        columns.nightOffsets = offsets;
+        columns.types = types;
+        columns.startOffsets = starts;
+        columns.durations = durations;
+        return columns;
+    }
+};
+
+using Series = std::array<PhaseSegmentSeries, TimelinePyramid::kPhaseCount>;
+
+} // namespace
+
+TEST_CASE("timeline pyramid stores only the nights, not the gap between them") {
+    // 2024-03-01 22:13:20 UTC и та же ночь с ошибочным годом на семь тысяч лет позже
+    constexpr std::int64_t firstNight = 1709331200;
+    constexpr std::int64_t yearsApart = 7000LL * 31556952;
+    const Nights both({firstNight, firstNight + yearsApart});
+    // для сравнения: та же ночь и ночь через месяц, чтобы конец истории не обрезал интервалы первой ночи
+    const Nights near({firstNight, firstNight + 30 * 86400});
+
+    TimelinePyramid timeline;
+    timeline.build(both.columns());
+    TimelinePyramid reference;
+    reference.build(near.columns());
+
+    REQUIRE_FALSE(timeline.empty());
+    CHECK(timeline.phaseCount() == 12);
+    CHECK(timeline.endTime() - timeline.startTime() > static_cast<double>(yearsApart));
+    // уровней столько, сколько удвоений нужно, чтобы покрыть промежуток, а не по интервалу на каждые 5 минут
+    CHECK(timeline.levelCount() < 64);
+
+    const double nightStart = static_cast<double>(firstNight);
+    const double nightEnd = static_cast<double>(near.wakeTimes[0]);
+    const double farStart = static_cast<double>(both.bedtimes[1]);
+
+    // во всей истории видны обе ночи и ничего между ними
+    Series all;
+    timeline.visibleSegments(timeline.startTime(), timeline.endTime(), 1000, all);
+    std::size_t points = 0;
+    bool sawFirst = false, sawFar = false;
+    for (const auto &series: all) {
+        points += series.xs.size();
+        for (double x: series.xs) {
+            sawFirst |= x <= nightEnd + 1e9;
+            sawFar |= x >= farStart - 1e9;
+            CHECK((x <= nightEnd + 1e9 || x >= farStart - 1e9));
+        }
+    }
+    CHECK(points > 0);
+    CHECK(sawFirst);
+    CHECK(sawFar);
+
+    // при приближении к одной ночи пирамида с далёкой ночью даёт те же отрезки, что и с близкой
+    for (std::size_t maxSegments: {1000, 20, 8, 4, 2}) {
+        Series expected, actual;
+        const std::size_t expectedLevel = reference.visibleSegments(nightStart, nightEnd, maxSegments, expected);
+        const std::size_t actualLevel = timeline.visibleSegments(nightStart, nightEnd, maxSegments, actual);
+        CHECK(actualLevel == expectedLevel);
+        for (std::size_t k = 0; k < TimelinePyramid::kPhaseCount; ++k) {
+            CHECK(actual[k].xs == expected[k].xs);
+            CHECK(actual[k].ys == expected[k].ys);
+        }
+
+        TimelineShares expectedShares, actualShares;
+        const double x = nightStart + 5000.0;
+        REQUIRE(reference.sharesAt(x, expectedLevel, expectedShares));
+        REQUIRE(timeline.sharesAt(x, actualLevel, actualShares));
+        CHECK(actualShares.start == expectedShares.start);
+        CHECK(actualShares.end == expectedShares.end);
+        CHECK(actualShares.percentages == expectedShares.percentages);
+    }
+
+    // в промежутке между ночами данных нет ни на одном уровне, кроме верхних, накрывающих обе ночи
+    TimelineShares shares;
+    const double gap = nightStart + static_cast<double>(yearsApart) / 2.0;
+    for (std::size_t level = 0; level < 20; ++level) {
+        CHECK_FALSE(timeline.sharesAt(gap, level, shares));
+    }
+    CHECK(timeline.sharesAt(farStart + 5000.0, 1, shares));
+    CHECK(shares.start <= farStart + 5000.0);
+    CHECK(shares.end > farStart + 5000.0);
+}
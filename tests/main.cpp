@@ -0,0 +1,6 @@
+/**
+ * @file
+ * @brief Точка входа модульных тестов.
+ */
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"